@@ -111,6 +111,7 @@ static uint8  gapRole_AdvertData[B_MAX_ADV_LEN] =
 };
 static uint8  gapRole_ScanRspDataLen = 0;
 static uint8  gapRole_ScanRspData[B_MAX_ADV_LEN] = {0};
+static uint8  gapRole_ScanRspPending = TRUE;   // Scan response not yet given to GAP
 static uint8  gapRole_AdvEventType;
 static uint8  gapRole_AdvDirectType;
 static uint8  gapRole_AdvDirectAddr[B_ADDR_LEN] = {0};
@@ -217,6 +218,9 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
         VOID osal_memset( gapRole_ScanRspData, 0, B_MAX_ADV_LEN );
         VOID osal_memcpy( gapRole_ScanRspData, pValue, len );
         gapRole_ScanRspDataLen = len;
+
+        // Goes to GAP after the next advertising data update
+        gapRole_ScanRspPending = TRUE;
       }
       else
       {
@@ -549,9 +553,11 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
 
         if ( pPkt->hdr.status == SUCCESS )
         {
-          if ( pPkt->adType )
+          if ( pPkt->adType && gapRole_ScanRspPending )
           {
-            // Setup the Response Data
+            // Setup the Response Data, only when it has changed so that
+            // rotating the advertising data costs a single update
+            gapRole_ScanRspPending = FALSE;
             pPkt->hdr.status = GAP_UpdateAdvertisingData( gapRole_TaskID,
                               FALSE, gapRole_ScanRspDataLen, gapRole_ScanRspData );
           }
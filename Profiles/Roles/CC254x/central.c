@@ -50,6 +50,7 @@
  */
 #include "bcomdef.h"
 #include "OSAL.h"
+#include "OSAL_Clock.h"
 #include "osal_cbtimer.h"
 #include "osal_snv.h"
 #include "hci_tl.h"
@@ -59,6 +60,7 @@
 #include "gatt.h"
 #include "gap.h"
 #include "gapbondmgr.h"
+#include "npi.h"
 #include "central.h"
 
 /*********************************************************************
@@ -77,6 +79,12 @@
 // Profile OSAL Message IDs
 #define GAPCENTRALROLE_RSSI_MSG_EVT   0xE0
 
+// RSSI monitor zones relative to the thresholds
+#define RSSI_ZONE_UNKNOWN             0
+#define RSSI_ZONE_LOW                 1
+#define RSSI_ZONE_INSIDE              2
+#define RSSI_ZONE_HIGH                3
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -87,6 +95,13 @@ typedef struct
   uint16        period;
   uint16        connHandle;
   uint8         timerId;
+  uint8         reportSamples;        // Samples per monitor report, 0 if not monitoring
+  int8          lowThresh;            // Monitor low threshold
+  int8          highThresh;           // Monitor high threshold
+  uint8         zone;                 // Zone of the moving average
+  int16         sum;                  // Sum of the samples since the last report
+  int16         ewma;                 // Moving average in 1/16 dB
+  gapCentralRoleRssiStats_t stats;
 } gapCentralRoleRssi_t;
 
 // OSAL event structure for RSSI timer events
@@ -131,6 +146,10 @@ static uint8  gapCentralRoleSRK[KEYLEN];
 static uint32 gapCentralRoleSignCounter;
 static uint8  gapCentralRoleBdAddr[B_ADDR_LEN];
 static uint8  gapCentralRoleMaxScanRes = 0;
+static uint32 gapCentralRoleLinkSetupTime = 0;
+
+// System clock when the pending link establishment was requested
+static uint32 gapCentralRoleLinkReqTime = 0;
 
 /*********************************************************************
  * LOCAL FUNCTIONS
@@ -141,6 +160,8 @@ static uint8 gapCentralRole_ProcessGAPMsg( gapEventHdr_t *pMsg );
 static gapCentralRoleRssi_t *gapCentralRole_RssiAlloc( uint16 connHandle );
 static gapCentralRoleRssi_t *gapCentralRole_RssiFind( uint16 connHandle );
 static void gapCentralRole_RssiFree( uint16 connHandle );
+static void gapCentralRole_RssiSample( gapCentralRoleRssi_t *pRssi, int8 rssi );
+static void gapCentralRole_RssiReport( gapCentralRoleRssi_t *pRssi, uint8 reason );
 static void gapCentralRole_timerCB( uint8 *pData );
 
 /*********************************************************************
@@ -259,6 +280,10 @@ bStatus_t GAPCentralRole_GetParameter( uint16 param, void *pValue )
       *((uint8*)pValue) = gapCentralRoleMaxScanRes;
       break;
 
+    case GAPCENTRALROLE_LINK_SETUP_TIME:
+      *((uint32*)pValue) = gapCentralRoleLinkSetupTime;
+      break;
+
     default:
       ret = INVALIDPARAMETER;
       break;
@@ -286,6 +311,7 @@ bStatus_t GAPCentralRole_EstablishLink( uint8 highDutyCycle, uint8 whiteList,
                                         uint8 addrTypePeer, uint8 *peerAddr )
 {
   gapEstLinkReq_t params;
+  bStatus_t status;
 
   params.taskID = gapCentralRoleTaskId;
   params.highDutyCycle = highDutyCycle;
@@ -293,7 +319,14 @@ bStatus_t GAPCentralRole_EstablishLink( uint8 highDutyCycle, uint8 whiteList,
   params.addrTypePeer = addrTypePeer;
   VOID osal_memcpy( params.peerAddr, peerAddr, B_ADDR_LEN );
 
-  return GAP_EstablishLinkReq( &params );
+  status = GAP_EstablishLinkReq( &params );
+  if ( status == SUCCESS )
+  {
+    // Start timing the link setup
+    gapCentralRoleLinkReqTime = osal_GetSystemClock();
+  }
+
+  return ( status );
 }
 
 /**
@@ -323,7 +356,7 @@ bStatus_t GAPCentralRole_StartDiscovery( uint8 mode, uint8 activeScan, uint8 whi
   params.mode = mode;
   params.activeScan = activeScan;
   params.whiteList = whiteList;
-  NPI_PrintString("Start scanning\r\n"); 
+  NPI_LOG2( GAPCENTRALROLE_LOG_DISCOVERY, mode, activeScan );
   return GAP_DeviceDiscoveryRequest( &params );
 }
 
@@ -369,6 +402,9 @@ bStatus_t GAPCentralRole_StartRssi( uint16 connHandle, uint16 period )
     return bleNoResources;
   }
 
+  // Report every sample
+  pRssi->reportSamples = 0;
+
   // Start timer
   osal_CbTimerStart( gapCentralRole_timerCB, (uint8 *) pRssi,
                      period, &pRssi->timerId );
@@ -400,6 +436,41 @@ bStatus_t GAPCentralRole_CancelRssi(uint16 connHandle )
   return bleIncorrectMode;
 }
 
+/**
+ * @brief   Start periodic RSSI reads on a link in monitor mode.
+ *
+ * Public function defined in central.h.
+ */
+bStatus_t GAPCentralRole_StartRssiMonitor( uint16 connHandle, uint16 period,
+                                           uint8 reportSamples, int8 lowThresh,
+                                           int8 highThresh )
+{
+  gapCentralRoleRssi_t  *pRssi;
+  bStatus_t status;
+
+  if ( reportSamples == 0 || lowThresh > highThresh )
+  {
+    return bleInvalidRange;
+  }
+
+  status = GAPCentralRole_StartRssi( connHandle, period );
+  if ( status != SUCCESS )
+  {
+    return status;
+  }
+
+  pRssi = gapCentralRole_RssiFind( connHandle );
+
+  pRssi->period = period;
+  pRssi->reportSamples = reportSamples;
+  pRssi->lowThresh = lowThresh;
+  pRssi->highThresh = highThresh;
+  pRssi->zone = RSSI_ZONE_UNKNOWN;
+  pRssi->stats.numSamples = 0;
+
+  return SUCCESS;
+}
+
 /**
  * @brief   Central Profile Task initialization function.
  *
@@ -494,9 +565,18 @@ static uint8 gapCentralRole_ProcessOSALMsg( osal_event_hdr_t *pMsg )
         {
           uint16 connHandle = BUILD_UINT16( pPkt->pReturnParam[1], pPkt->pReturnParam[2] );
           int8 rssi = (int8) pPkt->pReturnParam[3];
+          gapCentralRoleRssi_t *pRssi = gapCentralRole_RssiFind( connHandle );
 
+          if ( pRssi != NULL && pRssi->reportSamples > 0 )
+          {
+            // Monitor mode, aggregate the sample
+            if ( pPkt->pReturnParam[0] == SUCCESS )
+            {
+              gapCentralRole_RssiSample( pRssi, rssi );
+            }
+          }
           // Report RSSI to app
-          if ( pGapCentralRoleCB && pGapCentralRoleCB->rssiCB )
+          else if ( pGapCentralRoleCB && pGapCentralRoleCB->rssiCB )
           {
             pGapCentralRoleCB->rssiCB( connHandle, rssi );
           }
@@ -556,7 +636,11 @@ static void gapCentralRole_ProcessGattEvent(gattMsgEvent_t *pMsg)
       break;
       
     case ATT_MTU_UPDATED_EVENT:
-      // MTU size updated
+      // MTU size updated, report it to app
+      if ( pGapCentralRoleCB && pGapCentralRoleCB->mtuCB )
+      {
+        pGapCentralRoleCB->mtuCB( pMsg->connHandle, pMsg->msg.mtuEvt.MTU );
+      }
       break;
       
     default:
@@ -597,6 +681,9 @@ static uint8 gapCentralRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
       {
         gapEstLinkReqEvent_t *pPkt = (gapEstLinkReqEvent_t *) pMsg;
 
+        // Time from the request to its outcome, cancelled or not
+        gapCentralRoleLinkSetupTime = osal_GetSystemClock() - gapCentralRoleLinkReqTime;
+
         if (pPkt->hdr.status == SUCCESS)
         {
           // Notify the Bond Manager of the connection
@@ -712,6 +799,122 @@ static void gapCentralRole_RssiFree( uint16 connHandle )
   }
 }
 
+/*********************************************************************
+ * @fn      gapCentralRole_RssiSample
+ *
+ * @brief   Add an RSSI sample to a monitored link's statistics and
+ *          report a threshold crossing or a full report window.
+ *
+ * @param   pRssi - RSSI structure of the link
+ * @param   rssi - RSSI sample
+ *
+ * @return  none
+ */
+static void gapCentralRole_RssiSample( gapCentralRoleRssi_t *pRssi, int8 rssi )
+{
+  gapCentralRoleRssiStats_t *pStats = &pRssi->stats;
+  int8 avg;
+  uint8 zone;
+
+  // Window statistics
+  if ( pStats->numSamples == 0 )
+  {
+    pStats->min = rssi;
+    pStats->max = rssi;
+    pRssi->sum = 0;
+  }
+  else if ( rssi < pStats->min )
+  {
+    pStats->min = rssi;
+  }
+  else if ( rssi > pStats->max )
+  {
+    pStats->max = rssi;
+  }
+
+  pStats->numSamples++;
+  pStats->last = rssi;
+  pRssi->sum += rssi;
+
+  // Moving average, seeded with the first sample
+  if ( pRssi->zone == RSSI_ZONE_UNKNOWN )
+  {
+    pRssi->ewma = (int16)rssi * 16;
+  }
+  else
+  {
+    pRssi->ewma += ( (int16)rssi * 16 - pRssi->ewma ) / ( 1 << GAPCENTRALROLE_RSSI_EWMA_SHIFT );
+  }
+
+  avg = (int8)( pRssi->ewma / 16 );
+
+  // Find the zone of the average, with hysteresis on the way back
+  zone = pRssi->zone;
+
+  if ( avg < pRssi->lowThresh )
+  {
+    zone = RSSI_ZONE_LOW;
+  }
+  else if ( avg > pRssi->highThresh )
+  {
+    zone = RSSI_ZONE_HIGH;
+  }
+  else if ( ( zone == RSSI_ZONE_UNKNOWN ) ||
+            ( zone == RSSI_ZONE_LOW &&
+              avg >= pRssi->lowThresh + GAPCENTRALROLE_RSSI_HYSTERESIS ) ||
+            ( zone == RSSI_ZONE_HIGH &&
+              avg <= pRssi->highThresh - GAPCENTRALROLE_RSSI_HYSTERESIS ) )
+  {
+    zone = RSSI_ZONE_INSIDE;
+  }
+
+  if ( zone != pRssi->zone )
+  {
+    uint8 first = ( pRssi->zone == RSSI_ZONE_UNKNOWN );
+
+    pRssi->zone = zone;
+
+    // Starting out inside the thresholds is not a crossing
+    if ( !first || zone != RSSI_ZONE_INSIDE )
+    {
+      gapCentralRole_RssiReport( pRssi, ( zone == RSSI_ZONE_LOW ) ? GAPCENTRALROLE_RSSI_BELOW :
+                                        ( zone == RSSI_ZONE_HIGH ) ? GAPCENTRALROLE_RSSI_ABOVE :
+                                                                     GAPCENTRALROLE_RSSI_INSIDE );
+    }
+  }
+
+  if ( pStats->numSamples >= pRssi->reportSamples )
+  {
+    gapCentralRole_RssiReport( pRssi, GAPCENTRALROLE_RSSI_REPORT );
+
+    // Start a new window
+    pStats->numSamples = 0;
+  }
+}
+
+/*********************************************************************
+ * @fn      gapCentralRole_RssiReport
+ *
+ * @brief   Pass a monitored link's RSSI statistics to the app.
+ *
+ * @param   pRssi - RSSI structure of the link
+ * @param   reason - report reason
+ *
+ * @return  none
+ */
+static void gapCentralRole_RssiReport( gapCentralRoleRssi_t *pRssi, uint8 reason )
+{
+  gapCentralRoleRssiStats_t *pStats = &pRssi->stats;
+
+  pStats->mean = (int8)( pRssi->sum / (int16)pStats->numSamples );
+  pStats->ewma = (int8)( pRssi->ewma / 16 );
+
+  if ( pGapCentralRoleCB && pGapCentralRoleCB->rssiMonCB )
+  {
+    pGapCentralRoleCB->rssiMonCB( pRssi->connHandle, reason, pStats );
+  }
+}
+
 /*********************************************************************
  * @fn      gapCentralRole_timerCB
  *
@@ -78,8 +78,15 @@ extern "C"
 #define GAPCENTRALROLE_SIGNCOUNTER         0x402  //!< Sign Counter. Read/Write. Size is uint32. Default is 0.
 #define GAPCENTRALROLE_BD_ADDR             0x403  //!< Device's Address. Read Only. Size is uint8[B_ADDR_LEN]. This item is read from the controller.
 #define GAPCENTRALROLE_MAX_SCAN_RES        0x404  //!< Maximum number of discover scan results to receive. Default is 0 = unlimited.
+#define GAPCENTRALROLE_LINK_SETUP_TIME     0x405  //!< Time in ms from the last GAPCentralRole_EstablishLink to its GAP_LINK_ESTABLISHED_EVENT, whatever its status. Read Only. Size is uint32. Set before the event is passed to the application.
 /** @} End GAPCENTRALROLE_PROFILE_PARAMETERS */
 
+/** @defgroup GAPCENTRALROLE_LOG_IDS GAP Central Role NPI Log Format IDs
+ * @{
+ */
+#define GAPCENTRALROLE_LOG_DISCOVERY       0x0400  //!< "Start scanning, mode %u, active %u". Args: mode, activeScan.
+/** @} End GAPCENTRALROLE_LOG_IDS */
+
 /**
  * Number of simultaneous links with periodic RSSI reads
  */
@@ -87,6 +94,31 @@ extern "C"
 #define GAPCENTRALROLE_NUM_RSSI_LINKS     4
 #endif
 
+/** @defgroup GAPCENTRALROLE_RSSI_REASONS GAP Central Role RSSI Monitor Report Reasons
+ * @{
+ */
+#define GAPCENTRALROLE_RSSI_REPORT        0x00  //!< Periodic report of the samples since the last report.
+#define GAPCENTRALROLE_RSSI_BELOW         0x01  //!< Average RSSI fell below the low threshold.
+#define GAPCENTRALROLE_RSSI_ABOVE         0x02  //!< Average RSSI rose above the high threshold.
+#define GAPCENTRALROLE_RSSI_INSIDE        0x03  //!< Average RSSI is back between the thresholds.
+/** @} End GAPCENTRALROLE_RSSI_REASONS */
+
+/**
+ * Hysteresis in dB applied before the average RSSI is considered back
+ * between the thresholds
+ */
+#ifndef GAPCENTRALROLE_RSSI_HYSTERESIS
+#define GAPCENTRALROLE_RSSI_HYSTERESIS    2
+#endif
+
+/**
+ * Weight of a new sample in the RSSI moving average, as a power of two:
+ * each sample moves the average by 1/2^n of the difference
+ */
+#ifndef GAPCENTRALROLE_RSSI_EWMA_SHIFT
+#define GAPCENTRALROLE_RSSI_EWMA_SHIFT    3
+#endif
+
 /*********************************************************************
  * VARIABLES
  */
@@ -132,6 +164,38 @@ typedef uint8 (*pfnGapCentralRoleEventCB_t)
   gapCentralRoleEvent_t *pEvent         //!< Pointer to event structure.
 );
 
+/**
+ * RSSI Monitor Statistics
+ */
+typedef struct
+{
+  uint8 numSamples;                     //!< Samples since the last periodic report.
+  int8  last;                           //!< Last RSSI sample.
+  int8  min;                            //!< Lowest sample since the last periodic report.
+  int8  max;                            //!< Highest sample since the last periodic report.
+  int8  mean;                           //!< Mean of the samples since the last periodic report.
+  int8  ewma;                           //!< Exponentially weighted moving average.
+} gapCentralRoleRssiStats_t;
+
+/**
+ * RSSI Monitor Callback Function
+ */
+typedef void (*pfnGapCentralRoleRssiMonCB_t)
+(
+  uint16 connHandle,                    //!< Connection handle.
+  uint8  reason,                        //!< Report reason: @ref GAPCENTRALROLE_RSSI_REASONS
+  gapCentralRoleRssiStats_t *pStats     //!< RSSI statistics.
+);
+
+/**
+ * MTU Updated Callback Function
+ */
+typedef void (*pfnGapCentralRoleMtuCB_t)
+(
+  uint16 connHandle,                    //!< Connection handle.
+  uint16 mtu                            //!< New ATT MTU.
+);
+
 /**
  * Central Callback Structure
  */
@@ -139,6 +203,8 @@ typedef struct
 {
   pfnGapCentralRoleRssiCB_t   rssiCB;   //!< RSSI callback.
   pfnGapCentralRoleEventCB_t  eventCB;  //!< Event callback.
+  pfnGapCentralRoleMtuCB_t    mtuCB;    //!< MTU updated callback. May be NULL.
+  pfnGapCentralRoleRssiMonCB_t rssiMonCB; //!< RSSI monitor callback. May be NULL.
 } gapCentralRoleCB_t;
 
 /*********************************************************************
@@ -282,6 +348,28 @@ extern bStatus_t GAPCentralRole_StartRssi( uint16 connHandle, uint16 period );
  */
 extern bStatus_t GAPCentralRole_CancelRssi(uint16 connHandle );
 
+/**
+ * @brief   Start periodic RSSI reads on a link in monitor mode. Samples
+ *          are not reported one by one; the RSSI monitor callback gets
+ *          the min, max and mean every reportSamples samples, and a
+ *          report whenever the moving average crosses a threshold.
+ *          Use GAPCentralRole_CancelRssi to stop.
+ *
+ * @param   connHandle - connection handle of link
+ * @param   period - RSSI read period in ms
+ * @param   reportSamples - number of samples per periodic report
+ * @param   lowThresh - low RSSI threshold in dBm
+ * @param   highThresh - high RSSI threshold in dBm
+ *
+ * @return  SUCCESS: Monitor started.<BR>
+ *          bleInvalidRange: Invalid report count or thresholds.<BR>
+ *          bleIncorrectMode: No link.<BR>
+ *          bleNoResources: No resources.<BR>
+ */
+extern bStatus_t GAPCentralRole_StartRssiMonitor( uint16 connHandle, uint16 period,
+                                                  uint8 reportSamples, int8 lowThresh,
+                                                  int8 highThresh );
+
 /**
  * @}
  */
@@ -96,6 +96,11 @@
 
 #define MAX_TIMEOUT_VALUE             0xFFFF
 
+#define DEFAULT_PARAM_BACKOFF         1000    // 1 second
+
+// Largest shift applied to the parameter set back-off
+#define MAX_PARAM_BACKOFF_SHIFT       5
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -153,6 +158,7 @@ static uint16 gapRole_ConnectionHandle = INVALID_CONNHANDLE;
 static uint16 gapRole_RSSIReadRate = 0;
 
 static uint8  gapRole_ConnectedDevAddr[B_ADDR_LEN] = {0};
+static uint8  gapRole_ConnectedDevAddrType;
 
 static uint8  gapRole_ParamUpdateEnable = FALSE;
 static uint16 gapRole_MinConnInterval = DEFAULT_MIN_CONN_INTERVAL;
@@ -166,6 +172,15 @@ static uint16 gapRole_ConnTimeout = 0;
 
 static uint8 paramUpdateNoSuccessOption = GAPROLE_NO_ACTION;
 
+// Connection parameter set negotiation
+static gapRolesParamSet_t gapRole_ParamSets[GAPROLE_MAX_PARAM_SETS];
+static uint8  gapRole_NumParamSets = 0;
+static uint16 gapRole_ParamBackoff = DEFAULT_PARAM_BACKOFF;
+static uint8  gapRole_ParamSetIdx = 0;        // Set currently requested
+static uint8  gapRole_ParamAttempts = 0;      // Sets requested so far, 0 if not negotiating
+static uint8  gapRole_ParamAccepted = GAPROLE_PARAM_SET_NONE;
+static uint8  gapRole_ParamSaved = TRUE;      // Accepted set is stored for the bond
+
 // Application callbacks
 static gapRolesCBs_t *pGapRoles_AppCGs = NULL;
 static gapRolesParamUpdateCB_t *pGapRoles_ParamUpdateCB = NULL;
@@ -187,6 +202,15 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg );
 static void gapRole_SetupGAP( void );
 static void gapRole_HandleParamUpdateNoSuccess( void );
 static void gapRole_startConnUpdate( uint8 handleFailure );
+static void gapRole_requestParams( uint16 minInterval, uint16 maxInterval,
+                                   uint16 latency, uint16 timeout, uint8 handleFailure );
+static uint8 gapRole_matchParamSet( void );
+static void gapRole_startParamSets( void );
+static void gapRole_requestParamSet( void );
+static void gapRole_nextParamSet( void );
+static void gapRole_paramSetAccepted( uint8 idx );
+static uint8 gapRole_loadParamSet( void );
+static void gapRole_saveParamSet( void );
 
 /*********************************************************************
  * NETWORK LAYER CALLBACKS
@@ -519,11 +543,20 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
             // Update Response being received.
             if ( osal_get_timeoutEx( gapRole_TaskID, CONN_PARAM_TIMEOUT_EVT ) == 0 )
             {             
-              // Start connection update procedure
-              gapRole_startConnUpdate( GAPROLE_NO_ACTION );
-              
               // Connection update requested by app, cancel such pending procedure (if active)
               VOID osal_stop_timerEx( gapRole_TaskID, START_CONN_UPDATE_EVT );
+
+              if ( gapRole_NumParamSets > 0 )
+              {
+                // Negotiate through the configured parameter sets
+                gapRole_startParamSets();
+                gapRole_requestParamSet();
+              }
+              else
+              {
+                // Start connection update procedure
+                gapRole_startConnUpdate( GAPROLE_NO_ACTION );
+              }
             }
             else
             {
@@ -536,6 +569,54 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
           }
         }
         break;
+
+    case GAPROLE_PARAM_UPDATE_SETS:
+      if ( ( (len % sizeof ( gapRolesParamSet_t )) == 0 ) &&
+           ( len <= (GAPROLE_MAX_PARAM_SETS * sizeof ( gapRolesParamSet_t )) ) )
+      {
+        gapRolesParamSet_t *pSet = (gapRolesParamSet_t *)pValue;
+        uint8 numSets = len / sizeof ( gapRolesParamSet_t );
+        uint8 i;
+
+        for ( i = 0; i < numSets; i++, pSet++ )
+        {
+          if ( ( pSet->intervalMin < MIN_CONN_INTERVAL )       ||
+               ( pSet->intervalMax > MAX_CONN_INTERVAL )       ||
+               ( pSet->intervalMin > pSet->intervalMax )       ||
+               ( pSet->latency >= MAX_SLAVE_LATENCY )          ||
+               ( pSet->timeout < MIN_TIMEOUT_MULTIPLIER )      ||
+               ( pSet->timeout > MAX_TIMEOUT_MULTIPLIER ) )
+          {
+            break;
+          }
+        }
+
+        if ( i == numSets )
+        {
+          VOID osal_memcpy( gapRole_ParamSets, pValue, len );
+          gapRole_NumParamSets = numSets;
+        }
+        else
+        {
+          ret = bleInvalidRange;
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case GAPROLE_PARAM_UPDATE_BACKOFF:
+      if ( len == sizeof ( uint16 ) )
+      {
+        gapRole_ParamBackoff = *((uint16*)pValue);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
   
     default:
       // The param value isn't part of this profile, try the GAP.
@@ -670,6 +751,14 @@ bStatus_t GAPRole_GetParameter( uint16 param, void *pValue )
     case GAPROLE_STATE:
       *((uint8*)pValue) = gapRole_state;
       break;
+
+    case GAPROLE_PARAM_UPDATE_BACKOFF:
+      *((uint16*)pValue) = gapRole_ParamBackoff;
+      break;
+
+    case GAPROLE_PARAM_UPDATE_SET:
+      *((uint8*)pValue) = gapRole_ParamAccepted;
+      break;
     
     default:
       // The param value isn't part of this profile, try the GAP.
@@ -866,8 +955,16 @@ uint16 GAPRole_ProcessEvent( uint8 task_id, uint16 events )
 
   if ( events & START_CONN_UPDATE_EVT )
   {
-    // Start connection update procedure
-    gapRole_startConnUpdate( GAPROLE_NO_ACTION );
+    if ( gapRole_NumParamSets > 0 )
+    {
+      // Request the current parameter set
+      gapRole_requestParamSet();
+    }
+    else
+    {
+      // Start connection update procedure
+      gapRole_startConnUpdate( GAPROLE_NO_ACTION );
+    }
 
     return ( events ^ START_CONN_UPDATE_EVT );
   }
@@ -1139,6 +1236,7 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
         if ( pPkt->hdr.status == SUCCESS )
         {
           VOID osal_memcpy( gapRole_ConnectedDevAddr, pPkt->devAddr, B_ADDR_LEN );
+          gapRole_ConnectedDevAddrType = pPkt->devAddrType;
           gapRole_ConnectionHandle = pPkt->connectionHandle;
           gapRole_state = GAPROLE_CONNECTED;
 
@@ -1153,9 +1251,20 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
           gapRole_ConnSlaveLatency = pPkt->connLatency;
           gapRole_ConnTimeout = pPkt->connTimeout;
 
+          // Nothing accepted on this connection yet
+          gapRole_ParamAccepted = GAPROLE_PARAM_SET_NONE;
+          gapRole_ParamAttempts = 0;
+          gapRole_ParamSaved = TRUE;
+
           // Check whether update parameter request is enabled
           if ( gapRole_ParamUpdateEnable == TRUE )
           {
+            // Start with the set this central accepted last time
+            if ( gapRole_NumParamSets > 0 )
+            {
+              gapRole_startParamSets();
+            }
+
             // Get the minimum time upon connection establishment before the 
             // peripheral can start a connection update procedure.
             uint16 timeout = GAP_GetParamValue( TGAP_CONN_PAUSE_PERIPHERAL );
@@ -1187,6 +1296,12 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
       {
         gapTerminateLinkEvent_t *pPkt = (gapTerminateLinkEvent_t *)pMsg;
 
+        // Bonding may have completed after the parameter set was accepted
+        if ( gapRole_ParamSaved == FALSE )
+        {
+          gapRole_saveParamSet();
+        }
+
         VOID GAPBondMgr_ProcessGAPMsg( (gapEventHdr_t *)pMsg );
         osal_memset( gapRole_ConnectedDevAddr, 0, B_ADDR_LEN );
 
@@ -1198,6 +1313,8 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
         // Cancel all connection parameter update timers (if any active)
         VOID osal_stop_timerEx( gapRole_TaskID, START_CONN_UPDATE_EVT );
         VOID osal_stop_timerEx( gapRole_TaskID, CONN_PARAM_TIMEOUT_EVT );
+        gapRole_ParamAttempts = 0;
+        gapRole_ParamAccepted = GAPROLE_PARAM_SET_NONE;
 
         notify = TRUE;
         
@@ -1240,6 +1357,25 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
           gapRole_ConnInterval = pPkt->connInterval;
           gapRole_ConnSlaveLatency = pPkt->connLatency;
           gapRole_ConnTimeout = pPkt->connTimeout;
+
+          if ( gapRole_NumParamSets > 0 )
+          {
+            uint8 idx = gapRole_matchParamSet();
+
+            if ( idx != GAPROLE_PARAM_SET_NONE )
+            {
+              gapRole_paramSetAccepted( idx );
+            }
+            else if ( gapRole_ParamAttempts > 0 )
+            {
+              // The central picked parameters outside the requested set
+              gapRole_nextParamSet();
+            }
+            else
+            {
+              gapRole_ParamAccepted = GAPROLE_PARAM_SET_NONE;
+            }
+          }
           
           // Make sure there's no pending connection update procedure
           if ( osal_get_timeoutEx( gapRole_TaskID, START_CONN_UPDATE_EVT ) == 0 )
@@ -1253,6 +1389,11 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
             }
           }
         }
+        else if ( gapRole_ParamAttempts > 0 )
+        {
+          // Procedure failed, move on to the next parameter set
+          gapRole_nextParamSet();
+        }
       }
       break;
 
@@ -1299,6 +1440,13 @@ static void gapRole_SetupGAP( void )
  */
 static void gapRole_HandleParamUpdateNoSuccess( void )
 {
+  // Parameter set negotiation in progress, try the next set
+  if ( gapRole_ParamAttempts > 0 )
+  {
+    gapRole_nextParamSet();
+    return;
+  }
+
   // See which option was choosen for unsuccessful updates
   switch ( paramUpdateNoSuccessOption )
   {
@@ -1332,20 +1480,42 @@ static void gapRole_HandleParamUpdateNoSuccess( void )
  */
 static void gapRole_startConnUpdate( uint8 handleFailure )
 {
-  // First check the current connection parameters versus the configured parameters
-  if ( (gapRole_ConnInterval < gapRole_MinConnInterval)   ||
-       (gapRole_ConnInterval > gapRole_MaxConnInterval)   ||
-       (gapRole_ConnSlaveLatency != gapRole_SlaveLatency) ||
-       (gapRole_ConnTimeout  != gapRole_TimeoutMultiplier) )
+  gapRole_requestParams( gapRole_MinConnInterval, gapRole_MaxConnInterval,
+                         gapRole_SlaveLatency, gapRole_TimeoutMultiplier,
+                         handleFailure );
+}
+
+/********************************************************************
+ * @fn          gapRole_requestParams
+ *
+ * @brief       Send a connection parameter update request unless the
+ *              current connection parameters already match.
+ *
+ * @param       minInterval - minimum connection interval
+ * @param       maxInterval - maximum connection interval
+ * @param       latency - slave latency
+ * @param       timeout - supervision timeout
+ * @param       handleFailure - what to do if the update does not occur.
+ *
+ * @return      none
+ */
+static void gapRole_requestParams( uint16 minInterval, uint16 maxInterval,
+                                   uint16 latency, uint16 timeout, uint8 handleFailure )
+{
+  // First check the current connection parameters versus the requested parameters
+  if ( (gapRole_ConnInterval < minInterval)   ||
+       (gapRole_ConnInterval > maxInterval)   ||
+       (gapRole_ConnSlaveLatency != latency) ||
+       (gapRole_ConnTimeout  != timeout) )
   {
     gapUpdateLinkParamReq_t linkParams;
-    uint16 timeout = GAP_GetParamValue( TGAP_CONN_PARAM_TIMEOUT );
+    uint16 paramTimeout = GAP_GetParamValue( TGAP_CONN_PARAM_TIMEOUT );
 
     linkParams.connectionHandle = gapRole_ConnectionHandle;
-    linkParams.intervalMin = gapRole_MinConnInterval;
-    linkParams.intervalMax = gapRole_MaxConnInterval;
-    linkParams.connLatency = gapRole_SlaveLatency;
-    linkParams.connTimeout = gapRole_TimeoutMultiplier;
+    linkParams.intervalMin = minInterval;
+    linkParams.intervalMax = maxInterval;
+    linkParams.connLatency = latency;
+    linkParams.connTimeout = timeout;
             
     VOID GAP_UpdateLinkParamReq( &linkParams );
         
@@ -1353,7 +1523,220 @@ static void gapRole_startConnUpdate( uint8 handleFailure )
         
     // Let's wait either for L2CAP Connection Parameters Update Response or
     // for Controller to update connection parameters
-    VOID osal_start_timerEx( gapRole_TaskID, CONN_PARAM_TIMEOUT_EVT, timeout );
+    VOID osal_start_timerEx( gapRole_TaskID, CONN_PARAM_TIMEOUT_EVT, paramTimeout );
+  }
+}
+
+/********************************************************************
+ * @fn          gapRole_matchParamSet
+ *
+ * @brief       Find the first parameter set satisfied by the current
+ *              connection parameters.
+ *
+ * @param       none
+ *
+ * @return      set index, or GAPROLE_PARAM_SET_NONE
+ */
+static uint8 gapRole_matchParamSet( void )
+{
+  uint8 i;
+
+  for ( i = 0; i < gapRole_NumParamSets; i++ )
+  {
+    gapRolesParamSet_t *pSet = &gapRole_ParamSets[i];
+
+    if ( (gapRole_ConnInterval >= pSet->intervalMin)   &&
+         (gapRole_ConnInterval <= pSet->intervalMax)   &&
+         (gapRole_ConnSlaveLatency == pSet->latency)   &&
+         (gapRole_ConnTimeout == pSet->timeout) )
+    {
+      return ( i );
+    }
+  }
+
+  return ( GAPROLE_PARAM_SET_NONE );
+}
+
+/********************************************************************
+ * @fn          gapRole_startParamSets
+ *
+ * @brief       Start a new parameter set negotiation, beginning with
+ *              the set the connected central accepted last time.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void gapRole_startParamSets( void )
+{
+  gapRole_ParamSetIdx = gapRole_loadParamSet();
+  gapRole_ParamAttempts = 0;
+}
+
+/********************************************************************
+ * @fn          gapRole_requestParamSet
+ *
+ * @brief       Request the current parameter set, or finish the
+ *              negotiation if the connection already satisfies a set.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void gapRole_requestParamSet( void )
+{
+  gapRolesParamSet_t *pSet;
+  uint8 idx;
+
+  if ( gapRole_state != GAPROLE_CONNECTED )
+  {
+    return;
+  }
+
+  idx = gapRole_matchParamSet();
+  if ( idx != GAPROLE_PARAM_SET_NONE )
+  {
+    gapRole_paramSetAccepted( idx );
+    return;
+  }
+
+  pSet = &gapRole_ParamSets[gapRole_ParamSetIdx];
+  gapRole_ParamAttempts++;
+
+  gapRole_requestParams( pSet->intervalMin, pSet->intervalMax,
+                         pSet->latency, pSet->timeout, GAPROLE_NO_ACTION );
+}
+
+/********************************************************************
+ * @fn          gapRole_nextParamSet
+ *
+ * @brief       The current parameter set was not taken. Schedule the
+ *              next one after the back-off, or give up once every set
+ *              has been tried on this connection.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void gapRole_nextParamSet( void )
+{
+  if ( gapRole_ParamAttempts < gapRole_NumParamSets )
+  {
+    uint8 shift = gapRole_ParamAttempts - 1;
+    uint32 delay;
+
+    if ( shift > MAX_PARAM_BACKOFF_SHIFT )
+    {
+      shift = MAX_PARAM_BACKOFF_SHIFT;
+    }
+    delay = (uint32)gapRole_ParamBackoff << shift;
+
+    if ( ++gapRole_ParamSetIdx >= gapRole_NumParamSets )
+    {
+      gapRole_ParamSetIdx = 0;
+    }
+
+    // The back-off runs on top of TGAP(conn_param_timeout), which has
+    // already passed since the last response.
+    VOID osal_start_timerEx( gapRole_TaskID, START_CONN_UPDATE_EVT, delay ? delay : 1 );
+  }
+  else
+  {
+    // Every set refused, stay on the central's parameters
+    gapRole_ParamAttempts = 0;
+  }
+}
+
+/********************************************************************
+ * @fn          gapRole_paramSetAccepted
+ *
+ * @brief       Finish the negotiation on an accepted parameter set and
+ *              remember it for the connected central.
+ *
+ * @param       idx - accepted set index
+ *
+ * @return      none
+ */
+static void gapRole_paramSetAccepted( uint8 idx )
+{
+  VOID osal_stop_timerEx( gapRole_TaskID, START_CONN_UPDATE_EVT );
+  gapRole_ParamAttempts = 0;
+
+  if ( idx != gapRole_ParamAccepted )
+  {
+    gapRole_ParamAccepted = idx;
+    gapRole_ParamSaved = FALSE;
+    gapRole_saveParamSet();
+  }
+}
+
+/********************************************************************
+ * @fn          gapRole_loadParamSet
+ *
+ * @brief       Look up the parameter set last accepted by the connected
+ *              central.
+ *
+ * @param       none
+ *
+ * @return      set index, 0 if the central is not bonded or unknown
+ */
+static uint8 gapRole_loadParamSet( void )
+{
+  uint8 bondIdx = GAPBondMgr_ResolveAddr( gapRole_ConnectedDevAddrType,
+                                          gapRole_ConnectedDevAddr, NULL );
+
+  if ( bondIdx < GAP_BONDINGS_MAX )
+  {
+    uint8 sets[GAP_BONDINGS_MAX];
+
+    if ( ( osal_snv_read( GAPROLE_NVID_PARAM_SETS, GAP_BONDINGS_MAX, sets ) == SUCCESS ) &&
+         ( sets[bondIdx] < gapRole_NumParamSets ) )
+    {
+      return ( sets[bondIdx] );
+    }
+  }
+
+  return ( 0 );
+}
+
+/********************************************************************
+ * @fn          gapRole_saveParamSet
+ *
+ * @brief       Store the accepted parameter set for the connected
+ *              central. Left pending if the central is not bonded yet.
+ *
+ *              A bond record that is later reused by another central
+ *              only inherits the starting set, not the outcome.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void gapRole_saveParamSet( void )
+{
+  uint8 bondIdx = GAPBondMgr_ResolveAddr( gapRole_ConnectedDevAddrType,
+                                          gapRole_ConnectedDevAddr, NULL );
+
+  if ( bondIdx < GAP_BONDINGS_MAX )
+  {
+    uint8 sets[GAP_BONDINGS_MAX];
+
+    if ( osal_snv_read( GAPROLE_NVID_PARAM_SETS, GAP_BONDINGS_MAX, sets ) != SUCCESS )
+    {
+      VOID osal_memset( sets, GAPROLE_PARAM_SET_NONE, GAP_BONDINGS_MAX );
+    }
+
+    if ( sets[bondIdx] != gapRole_ParamAccepted )
+    {
+      sets[bondIdx] = gapRole_ParamAccepted;
+
+      if ( osal_snv_write( GAPROLE_NVID_PARAM_SETS, GAP_BONDINGS_MAX, sets ) != SUCCESS )
+      {
+        return;
+      }
+    }
+
+    gapRole_ParamSaved = TRUE;
   }
 }
 
@@ -1394,6 +1777,9 @@ bStatus_t GAPRole_SendUpdateParam( uint16 minConnInterval, uint16 maxConnInterva
     gapRole_SlaveLatency = latency;
     gapRole_TimeoutMultiplier = connTimeout;
 
+    // Explicit parameters from the app end any parameter set negotiation
+    gapRole_ParamAttempts = 0;
+
     // Start connection update procedure
     gapRole_startConnUpdate( handleFailure );
 
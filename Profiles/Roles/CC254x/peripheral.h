@@ -99,6 +99,9 @@ extern "C"
 #define GAPROLE_PARAM_UPDATE_REQ    0x319  //!< Slave Connection Parameter Update Request. Write. Size is uint8. If TRUE then connection parameter update request is sent.
 #define GAPROLE_STATE               0x31A  //!< Reading this parameter will return GAP Peripheral Role State. Read Only. Size is uint8.
 #define GAPROLE_ADV_NONCONN_ENABLED 0x31B  //!< Enable/Disable Non-Connectable Advertising.  Read/Write.  Size is uint8.  Default is FALSE=Disabled.
+#define GAPROLE_PARAM_UPDATE_SETS   0x31C  //!< Acceptable connection parameter sets, in order of preference. Write Only. Size is n * sizeof(gapRolesParamSet_t), n from 0 to GAPROLE_MAX_PARAM_SETS. Default is 0 sets, which means only the single set given by GAPROLE_MIN_CONN_INTERVAL to GAPROLE_TIMEOUT_MULTIPLIER is requested.
+#define GAPROLE_PARAM_UPDATE_BACKOFF 0x31D //!< Delay before requesting the next parameter set after a rejection (in milliseconds), doubled on every further attempt. Read/Write. Size is uint16. Default is 1000.
+#define GAPROLE_PARAM_UPDATE_SET    0x31E  //!< Index of the parameter set accepted on the current connection. Read Only. Size is uint8. GAPROLE_PARAM_SET_NONE if no set has been accepted.
 /** @} End GAPROLE_PROFILE_PARAMETERS */
 
 /*-------------------------------------------------------------------
@@ -132,6 +135,35 @@ typedef enum
 #define GAPROLE_RESEND_PARAM_UPDATE          1 // Continue to resend request until successful update
 #define GAPROLE_TERMINATE_LINK               2 // Terminate link upon unsuccessful parameter updates
 
+/**
+ * Maximum number of connection parameter sets that can be given with
+ * GAPROLE_PARAM_UPDATE_SETS.
+ */
+#if !defined ( GAPROLE_MAX_PARAM_SETS )
+  #define GAPROLE_MAX_PARAM_SETS             4
+#endif
+
+#define GAPROLE_PARAM_SET_NONE               0xFF // No parameter set accepted
+
+/**
+ * SNV item holding the parameter set last accepted by each bonded central,
+ * indexed by bond record.
+ */
+#if !defined ( GAPROLE_NVID_PARAM_SETS )
+  #define GAPROLE_NVID_PARAM_SETS            BLE_NVID_CUST_END
+#endif
+
+/**
+ * Connection parameter set used by GAPROLE_PARAM_UPDATE_SETS.
+ */
+typedef struct
+{
+  uint16 intervalMin;   //!< Minimum connection interval (n * 1.25ms)
+  uint16 intervalMax;   //!< Maximum connection interval (n * 1.25ms)
+  uint16 latency;       //!< Slave latency
+  uint16 timeout;       //!< Supervision timeout (n * 10ms)
+} gapRolesParamSet_t;
+
 /*-------------------------------------------------------------------
  * MACROS
  */
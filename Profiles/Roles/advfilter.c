@@ -0,0 +1,434 @@
+/******************************************************************************
+
+ @file  advfilter.c
+
+ @brief This file contains the advertisement filter used by the central and
+        observer roles. Filters are set at run time and evaluated in a single
+        pass over the AD structures of each report.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "att.h"
+#include "gap.h"
+#include "advfilter.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Filter criteria. A filter with no criteria is not in use.
+typedef struct
+{
+  uint8 criteria;                             // ADVFILTER_CRITERIA bit map
+  int8  rssiMin;                              // Minimum RSSI
+  uint8 addrPrefixLen;                        // Address prefix length
+  uint8 addrPrefix[B_ADDR_LEN];               // Address prefix, MSB first
+  uint16 manufId;                             // Manufacturer company ID
+  uint8 uuidLen;                              // ATT_BT_UUID_SIZE or ATT_UUID_SIZE
+  uint8 uuid[ATT_UUID_SIZE];                  // Service UUID
+  uint8 namePrefixLen;                        // Name prefix length
+  uint8 namePrefix[ADVFILTER_NAME_PREFIX_LEN];// Name prefix
+} advFilter_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Filter table
+static advFilter_t advFilterTable[ADVFILTER_MAX_FILTERS];
+
+// Bit map of filters in use
+static uint8 advFilterInUse = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 advFilterMatchAd( advFilter_t *pFilter, uint8 adType,
+                               uint8 *pValue, uint8 len );
+static uint8 advFilterFindUuid( uint8 *pList, uint8 listLen,
+                                uint8 *pUuid, uint8 uuidLen );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AdvFilter_SetCriterion
+ *
+ * @brief   Add a criterion to a filter, replacing any earlier value
+ *          of the same criterion.
+ *
+ * @param   filter - filter index
+ * @param   criterion - ADVFILTER_CRITERIA value
+ * @param   pValue - criterion value
+ * @param   len - length of the value
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleInvalidRange
+ */
+bStatus_t AdvFilter_SetCriterion( uint8 filter, uint8 criterion, uint8 *pValue, uint8 len )
+{
+  advFilter_t *pFilter;
+
+  if ( filter >= ADVFILTER_MAX_FILTERS )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  pFilter = &advFilterTable[filter];
+
+  switch ( criterion )
+  {
+    case ADVFILTER_RSSI:
+      if ( len != sizeof( int8 ) )
+      {
+        return ( bleInvalidRange );
+      }
+      pFilter->rssiMin = (int8)pValue[0];
+      break;
+
+    case ADVFILTER_ADDR_PREFIX:
+      if ( len == 0 || len > B_ADDR_LEN )
+      {
+        return ( bleInvalidRange );
+      }
+      pFilter->addrPrefixLen = len;
+      VOID osal_memcpy( pFilter->addrPrefix, pValue, len );
+      break;
+
+    case ADVFILTER_MANUF_ID:
+      if ( len != sizeof( uint16 ) )
+      {
+        return ( bleInvalidRange );
+      }
+      pFilter->manufId = BUILD_UINT16( pValue[0], pValue[1] );
+      break;
+
+    case ADVFILTER_UUID:
+      if ( len != ATT_BT_UUID_SIZE && len != ATT_UUID_SIZE )
+      {
+        return ( bleInvalidRange );
+      }
+      pFilter->uuidLen = len;
+      VOID osal_memcpy( pFilter->uuid, pValue, len );
+      break;
+
+    case ADVFILTER_NAME_PREFIX:
+      if ( len == 0 || len > ADVFILTER_NAME_PREFIX_LEN )
+      {
+        return ( bleInvalidRange );
+      }
+      pFilter->namePrefixLen = len;
+      VOID osal_memcpy( pFilter->namePrefix, pValue, len );
+      break;
+
+    default:
+      return ( INVALIDPARAMETER );
+  }
+
+  pFilter->criteria |= criterion;
+  advFilterInUse |= BV( filter );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      AdvFilter_Clear
+ *
+ * @brief   Remove every criterion from a filter.
+ *
+ * @param   filter - filter index, or ADVFILTER_ALL
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AdvFilter_Clear( uint8 filter )
+{
+  if ( filter == ADVFILTER_ALL )
+  {
+    VOID osal_memset( advFilterTable, 0, sizeof( advFilterTable ) );
+    advFilterInUse = 0;
+  }
+  else if ( filter < ADVFILTER_MAX_FILTERS )
+  {
+    VOID osal_memset( &advFilterTable[filter], 0, sizeof( advFilter_t ) );
+    advFilterInUse &= ~BV( filter );
+  }
+  else
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      AdvFilter_Active
+ *
+ * @brief   Check whether any filter is set.
+ *
+ * @return  TRUE if at least one filter has a criterion
+ */
+uint8 AdvFilter_Active( void )
+{
+  return ( advFilterInUse != 0 );
+}
+
+/*********************************************************************
+ * @fn      AdvFilter_Match
+ *
+ * @brief   Evaluate an advertising report against the filters. The
+ *          criteria that do not need the AD data are checked first,
+ *          then the AD structures are walked once, each structure
+ *          being offered to every filter still in the running.
+ *
+ * @param   rssi - report RSSI
+ * @param   pAddr - device address, least significant byte first
+ * @param   pData - advertising or scan response data
+ * @param   dataLen - length of the data
+ *
+ * @return  TRUE if no filter is set or the report meets every
+ *          criterion of at least one filter, FALSE otherwise
+ */
+uint8 AdvFilter_Match( int8 rssi, uint8 *pAddr, uint8 *pData, uint8 dataLen )
+{
+  uint8 met[ADVFILTER_MAX_FILTERS];
+  uint8 pending = 0;
+  uint8 *pEnd = pData + dataLen;
+  uint8 adLen;
+  uint8 i;
+  uint8 j;
+
+  if ( advFilterInUse == 0 )
+  {
+    return ( TRUE );
+  }
+
+  // Criteria carried in the report header
+  for ( i = 0; i < ADVFILTER_MAX_FILTERS; i++ )
+  {
+    advFilter_t *pFilter = &advFilterTable[i];
+
+    if ( !( advFilterInUse & BV( i ) ) )
+    {
+      continue;
+    }
+
+    met[i] = 0;
+
+    if ( pFilter->criteria & ADVFILTER_RSSI )
+    {
+      if ( rssi < pFilter->rssiMin )
+      {
+        continue;
+      }
+      met[i] |= ADVFILTER_RSSI;
+    }
+
+    if ( pFilter->criteria & ADVFILTER_ADDR_PREFIX )
+    {
+      for ( j = 0; j < pFilter->addrPrefixLen; j++ )
+      {
+        if ( pAddr[B_ADDR_LEN - 1 - j] != pFilter->addrPrefix[j] )
+        {
+          break;
+        }
+      }
+
+      if ( j < pFilter->addrPrefixLen )
+      {
+        continue;
+      }
+      met[i] |= ADVFILTER_ADDR_PREFIX;
+    }
+
+    if ( met[i] == pFilter->criteria )
+    {
+      return ( TRUE );
+    }
+
+    pending |= BV( i );
+  }
+
+  // Criteria carried in the AD structures
+  while ( pending != 0 && pData < pEnd )
+  {
+    adLen = *pData++;
+
+    // Zero length marks the end of significant data
+    if ( adLen == 0 || adLen > ( pEnd - pData ) )
+    {
+      break;
+    }
+
+    for ( i = 0; i < ADVFILTER_MAX_FILTERS; i++ )
+    {
+      if ( pending & BV( i ) )
+      {
+        met[i] |= advFilterMatchAd( &advFilterTable[i], pData[0], &pData[1], adLen - 1 );
+
+        if ( met[i] == advFilterTable[i].criteria )
+        {
+          return ( TRUE );
+        }
+      }
+    }
+
+    pData += adLen;
+  }
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+ * @fn      advFilterMatchAd
+ *
+ * @brief   Check one AD structure against the AD criteria of a filter.
+ *
+ * @param   pFilter - filter
+ * @param   adType - AD type
+ * @param   pValue - AD value
+ * @param   len - length of the AD value
+ *
+ * @return  ADVFILTER_CRITERIA bits met by this AD structure
+ */
+static uint8 advFilterMatchAd( advFilter_t *pFilter, uint8 adType,
+                               uint8 *pValue, uint8 len )
+{
+  switch ( adType )
+  {
+    case GAP_ADTYPE_MANUFACTURER_SPECIFIC:
+      if ( ( pFilter->criteria & ADVFILTER_MANUF_ID ) && len >= 2 &&
+           BUILD_UINT16( pValue[0], pValue[1] ) == pFilter->manufId )
+      {
+        return ( ADVFILTER_MANUF_ID );
+      }
+      break;
+
+    case GAP_ADTYPE_16BIT_MORE:
+    case GAP_ADTYPE_16BIT_COMPLETE:
+      if ( ( pFilter->criteria & ADVFILTER_UUID ) && pFilter->uuidLen == ATT_BT_UUID_SIZE &&
+           advFilterFindUuid( pValue, len, pFilter->uuid, ATT_BT_UUID_SIZE ) )
+      {
+        return ( ADVFILTER_UUID );
+      }
+      break;
+
+    case GAP_ADTYPE_128BIT_MORE:
+    case GAP_ADTYPE_128BIT_COMPLETE:
+      if ( ( pFilter->criteria & ADVFILTER_UUID ) && pFilter->uuidLen == ATT_UUID_SIZE &&
+           advFilterFindUuid( pValue, len, pFilter->uuid, ATT_UUID_SIZE ) )
+      {
+        return ( ADVFILTER_UUID );
+      }
+      break;
+
+    case GAP_ADTYPE_LOCAL_NAME_SHORT:
+    case GAP_ADTYPE_LOCAL_NAME_COMPLETE:
+      if ( ( pFilter->criteria & ADVFILTER_NAME_PREFIX ) && len >= pFilter->namePrefixLen &&
+           osal_memcmp( pValue, pFilter->namePrefix, pFilter->namePrefixLen ) )
+      {
+        return ( ADVFILTER_NAME_PREFIX );
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return ( 0 );
+}
+
+/*********************************************************************
+ * @fn      advFilterFindUuid
+ *
+ * @brief   Find a UUID in an AD service UUID list.
+ *
+ * @param   pList - UUID list
+ * @param   listLen - length of the list
+ * @param   pUuid - UUID to find
+ * @param   uuidLen - UUID size
+ *
+ * @return  TRUE if the UUID is in the list
+ */
+static uint8 advFilterFindUuid( uint8 *pList, uint8 listLen,
+                                uint8 *pUuid, uint8 uuidLen )
+{
+  while ( listLen >= uuidLen )
+  {
+    if ( osal_memcmp( pList, pUuid, uuidLen ) )
+    {
+      return ( TRUE );
+    }
+
+    pList += uuidLen;
+    listLen -= uuidLen;
+  }
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,152 @@
+/******************************************************************************
+
+ @file  advfilter.h
+
+ @brief This file contains the interface to the advertisement filter used by
+        the central and observer roles.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+#ifndef ADVFILTER_H
+#define ADVFILTER_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined ( ADVFILTER_MAX_FILTERS )
+  #define ADVFILTER_MAX_FILTERS      4    //!< Number of filters. A report passes if it meets every criterion of any one filter.
+#endif
+
+#if !defined ( ADVFILTER_NAME_PREFIX_LEN )
+  #define ADVFILTER_NAME_PREFIX_LEN  8    //!< Longest local name prefix that can be matched.
+#endif
+
+/** @defgroup ADVFILTER_CRITERIA Advertisement Filter Criteria
+ * @{
+ */
+#define ADVFILTER_RSSI             0x01  //!< Minimum RSSI. Size is int8.
+#define ADVFILTER_ADDR_PREFIX      0x02  //!< Device address prefix, most significant byte first. Size is 1 to B_ADDR_LEN.
+#define ADVFILTER_MANUF_ID         0x04  //!< Manufacturer specific data company ID. Size is uint16.
+#define ADVFILTER_UUID             0x08  //!< Service UUID in a 16-bit or 128-bit UUID list. Size is 2 or 16, in AD byte order.
+#define ADVFILTER_NAME_PREFIX      0x10  //!< Shortened or complete local name prefix. Size is 1 to ADVFILTER_NAME_PREFIX_LEN.
+/** @} End ADVFILTER_CRITERIA */
+
+#define ADVFILTER_ALL              0xFF  //!< Filter index that selects every filter in AdvFilter_Clear().
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * Profile Callbacks
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/**
+ * @brief       Add a criterion to a filter, replacing any earlier value
+ *              of the same criterion.
+ *
+ * @param       filter - filter index, 0 to ADVFILTER_MAX_FILTERS - 1
+ * @param       criterion - @ref ADVFILTER_CRITERIA
+ * @param       pValue - criterion value
+ * @param       len - length of the value
+ *
+ * @return      SUCCESS, INVALIDPARAMETER or bleInvalidRange
+ */
+extern bStatus_t AdvFilter_SetCriterion( uint8 filter, uint8 criterion, uint8 *pValue, uint8 len );
+
+/**
+ * @brief       Remove every criterion from a filter.
+ *
+ * @param       filter - filter index, or ADVFILTER_ALL
+ *
+ * @return      SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AdvFilter_Clear( uint8 filter );
+
+/**
+ * @brief       Check whether any filter is set.
+ *
+ * @return      TRUE if at least one filter has a criterion
+ */
+extern uint8 AdvFilter_Active( void );
+
+/**
+ * @brief       Evaluate an advertising report against the filters. The
+ *              AD structures are walked once for all filters.
+ *
+ * @param       rssi - report RSSI
+ * @param       pAddr - device address, least significant byte first
+ * @param       pData - advertising or scan response data
+ * @param       dataLen - length of the data
+ *
+ * @return      TRUE if no filter is set or the report meets every
+ *              criterion of at least one filter, FALSE otherwise
+ */
+extern uint8 AdvFilter_Match( int8 rssi, uint8 *pAddr, uint8 *pData, uint8 dataLen );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADVFILTER_H */
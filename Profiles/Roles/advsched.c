@@ -0,0 +1,374 @@
+/******************************************************************************
+
+ @file  advsched.c
+
+ @brief This file contains the advertising payload scheduler. It rotates the
+        advertising data through a set of weighted payload slots while
+        advertising stays on.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gap.h"
+#include "advsched.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Delay in ms before a payload the stack refused is tried again
+#define ADVSCHED_RETRY_DELAY                  10
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Payload slot. A slot with no weight is not in use.
+typedef struct
+{
+  uint8 *pData;                       // Advertising data, owned by the caller
+  uint8 len;                          // Length of the data
+  uint8 weight;                       // Share of the picks
+  uint16 dwell;                       // Time on air per pick in ms
+  int16 credit;                       // Weighted round robin credit
+  advSchedUpdateCB_t pfnUpdate;       // Refreshes the payload, or NULL
+} advSchedSlot_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task and event used to time the rotation
+static uint8 advSchedTaskId;
+static uint16 advSchedEvent;
+
+// Puts a payload on air
+static advSchedSetDataCB_t advSchedSetDataCB = NULL;
+
+// Payload slots
+static advSchedSlot_t advSchedSlots[ADVSCHED_MAX_SLOTS];
+
+// TRUE while rotating
+static uint8 advSchedOn = FALSE;
+
+// Slot on air, ADVSCHED_MAX_SLOTS if none
+static uint8 advSchedCurrent = ADVSCHED_MAX_SLOTS;
+
+// Slot picked but not yet taken by the stack, ADVSCHED_MAX_SLOTS if none
+static uint8 advSchedPending = ADVSCHED_MAX_SLOTS;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 advSchedPick( void );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      AdvSched_Init
+ *
+ * @brief   Initialize the advertising payload scheduler.
+ *
+ * @param   taskId - task that receives the scheduler event
+ * @param   event - event the task passes to AdvSched_ProcessEvent()
+ * @param   pfnSetData - puts a payload on air
+ *
+ * @return  none
+ */
+void AdvSched_Init( uint8 taskId, uint16 event, advSchedSetDataCB_t pfnSetData )
+{
+  advSchedTaskId = taskId;
+  advSchedEvent = event;
+  advSchedSetDataCB = pfnSetData;
+}
+
+/*********************************************************************
+ * @fn      AdvSched_SetSlot
+ *
+ * @brief   Fill a payload slot. The payload is not copied.
+ *
+ * @param   slot - slot index
+ * @param   pData - advertising data
+ * @param   len - length of the data
+ * @param   dwell - time in ms the payload stays on air per pick
+ * @param   weight - share of the picks
+ * @param   pfnUpdate - refreshes the payload before it goes on air
+ *
+ * @return  SUCCESS, INVALIDPARAMETER or bleInvalidRange
+ */
+bStatus_t AdvSched_SetSlot( uint8 slot, uint8 *pData, uint8 len, uint16 dwell,
+                            uint8 weight, advSchedUpdateCB_t pfnUpdate )
+{
+  advSchedSlot_t *pSlot;
+
+  if ( slot >= ADVSCHED_MAX_SLOTS || pData == NULL || weight == 0 || dwell == 0 )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  if ( len > B_MAX_ADV_LEN )
+  {
+    return ( bleInvalidRange );
+  }
+
+  pSlot = &advSchedSlots[slot];
+  pSlot->pData = pData;
+  pSlot->len = len;
+  pSlot->weight = weight;
+  pSlot->dwell = dwell;
+  pSlot->credit = 0;
+  pSlot->pfnUpdate = pfnUpdate;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      AdvSched_ClearSlot
+ *
+ * @brief   Empty a payload slot.
+ *
+ * @param   slot - slot index
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t AdvSched_ClearSlot( uint8 slot )
+{
+  if ( slot >= ADVSCHED_MAX_SLOTS )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  advSchedSlots[slot].weight = 0;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      AdvSched_Start
+ *
+ * @brief   Start rotating, putting the first payload on air now.
+ *
+ * @return  SUCCESS or bleIncorrectMode if no slot is filled
+ */
+bStatus_t AdvSched_Start( void )
+{
+  uint8 inUse = FALSE;
+  uint8 i;
+
+  for ( i = 0; i < ADVSCHED_MAX_SLOTS; i++ )
+  {
+    advSchedSlots[i].credit = 0;
+
+    if ( advSchedSlots[i].weight != 0 )
+    {
+      inUse = TRUE;
+    }
+  }
+
+  if ( !inUse )
+  {
+    return ( bleIncorrectMode );
+  }
+
+  advSchedOn = TRUE;
+  advSchedCurrent = ADVSCHED_MAX_SLOTS;
+  advSchedPending = ADVSCHED_MAX_SLOTS;
+
+  osal_set_event( advSchedTaskId, advSchedEvent );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      AdvSched_Stop
+ *
+ * @brief   Stop rotating. The payload on air stays there.
+ *
+ * @return  none
+ */
+void AdvSched_Stop( void )
+{
+  advSchedOn = FALSE;
+
+  VOID osal_stop_timerEx( advSchedTaskId, advSchedEvent );
+  VOID osal_clear_event( advSchedTaskId, advSchedEvent );
+}
+
+/*********************************************************************
+ * @fn      AdvSched_ProcessEvent
+ *
+ * @brief   Handle the scheduler event by putting the next payload on
+ *          air. The new data replaces the old between advertising
+ *          events, advertising is not stopped. A payload that is
+ *          picked twice in a row and has no update callback is left
+ *          as it is. If the stack is busy the payload is tried again
+ *          after a short delay.
+ *
+ * @return  none
+ */
+void AdvSched_ProcessEvent( void )
+{
+  advSchedSlot_t *pSlot;
+  uint8 slot;
+
+  if ( !advSchedOn )
+  {
+    return;
+  }
+
+  // A refused payload is retried before the rotation moves on
+  slot = advSchedPending;
+  if ( slot == ADVSCHED_MAX_SLOTS || advSchedSlots[slot].weight == 0 )
+  {
+    slot = advSchedPick();
+  }
+  advSchedPending = ADVSCHED_MAX_SLOTS;
+
+  if ( slot == ADVSCHED_MAX_SLOTS )
+  {
+    // Every slot was cleared
+    advSchedOn = FALSE;
+    return;
+  }
+
+  pSlot = &advSchedSlots[slot];
+
+  if ( pSlot->pfnUpdate != NULL )
+  {
+    pSlot->pfnUpdate( slot, pSlot->pData, pSlot->len );
+  }
+
+  if ( slot != advSchedCurrent || pSlot->pfnUpdate != NULL )
+  {
+    if ( advSchedSetDataCB( pSlot->len, pSlot->pData ) != SUCCESS )
+    {
+      advSchedPending = slot;
+      osal_start_timerEx( advSchedTaskId, advSchedEvent, ADVSCHED_RETRY_DELAY );
+      return;
+    }
+
+    advSchedCurrent = slot;
+  }
+
+  osal_start_timerEx( advSchedTaskId, advSchedEvent, pSlot->dwell );
+}
+
+/*********************************************************************
+ * @fn      AdvSched_GetCurrent
+ *
+ * @brief   Get the slot whose payload is on air.
+ *
+ * @return  slot index, or ADVSCHED_MAX_SLOTS if none
+ */
+uint8 AdvSched_GetCurrent( void )
+{
+  return ( advSchedCurrent );
+}
+
+/*********************************************************************
+ * @fn      advSchedPick
+ *
+ * @brief   Pick the next slot by smooth weighted round robin. Every
+ *          slot earns its weight in credit, the richest slot is picked
+ *          and pays back the total weight. Over a cycle each slot is
+ *          picked in proportion to its weight, spread out rather than
+ *          in runs.
+ *
+ * @return  slot index, or ADVSCHED_MAX_SLOTS if no slot is filled
+ */
+static uint8 advSchedPick( void )
+{
+  advSchedSlot_t *pSlot;
+  uint8 best = ADVSCHED_MAX_SLOTS;
+  int16 total = 0;
+  uint8 i;
+
+  for ( i = 0; i < ADVSCHED_MAX_SLOTS; i++ )
+  {
+    pSlot = &advSchedSlots[i];
+
+    if ( pSlot->weight == 0 )
+    {
+      continue;
+    }
+
+    pSlot->credit += pSlot->weight;
+    total += pSlot->weight;
+
+    if ( best == ADVSCHED_MAX_SLOTS || pSlot->credit > advSchedSlots[best].credit )
+    {
+      best = i;
+    }
+  }
+
+  if ( best != ADVSCHED_MAX_SLOTS )
+  {
+    advSchedSlots[best].credit -= total;
+  }
+
+  return ( best );
+}
+
+/*********************************************************************
+*********************************************************************/
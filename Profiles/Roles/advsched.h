@@ -0,0 +1,172 @@
+/******************************************************************************
+
+ @file  advsched.h
+
+ @brief This file contains the interface to the advertising payload scheduler,
+        which rotates the advertising data through a set of payload slots.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+#ifndef ADVSCHED_H
+#define ADVSCHED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined ( ADVSCHED_MAX_SLOTS )
+  #define ADVSCHED_MAX_SLOTS         4    //!< Number of payload slots.
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ * Callback that puts a payload on air, normally a wrapper around
+ * GAPRole_SetParameter( GAPROLE_ADVERT_DATA ) of the role in use.
+ */
+typedef bStatus_t (*advSchedSetDataCB_t)( uint8 len, uint8 *pData );
+
+/**
+ * Callback that refreshes a slot's payload in place just before it
+ * goes on air, for example to update counters in a telemetry frame.
+ */
+typedef void (*advSchedUpdateCB_t)( uint8 slot, uint8 *pData, uint8 len );
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * Profile Callbacks
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/**
+ * @brief       Initialize the advertising payload scheduler.
+ *
+ * @param       taskId - task that receives the scheduler event
+ * @param       event - event the task passes to AdvSched_ProcessEvent()
+ * @param       pfnSetData - puts a payload on air
+ *
+ * @return      none
+ */
+extern void AdvSched_Init( uint8 taskId, uint16 event, advSchedSetDataCB_t pfnSetData );
+
+/**
+ * @brief       Fill a payload slot. The payload is not copied, the
+ *              buffer must stay valid while the slot is in use.
+ *
+ * @param       slot - slot index, 0 to ADVSCHED_MAX_SLOTS - 1
+ * @param       pData - advertising data, at most B_MAX_ADV_LEN bytes
+ * @param       len - length of the data
+ * @param       dwell - time in ms the payload stays on air each time
+ *                      it is picked, longer than the advertising interval
+ * @param       weight - share of the picks relative to the other slots
+ * @param       pfnUpdate - refreshes the payload before it goes on air,
+ *                          or NULL
+ *
+ * @return      SUCCESS, INVALIDPARAMETER or bleInvalidRange
+ */
+extern bStatus_t AdvSched_SetSlot( uint8 slot, uint8 *pData, uint8 len, uint16 dwell,
+                                   uint8 weight, advSchedUpdateCB_t pfnUpdate );
+
+/**
+ * @brief       Empty a payload slot.
+ *
+ * @param       slot - slot index
+ *
+ * @return      SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t AdvSched_ClearSlot( uint8 slot );
+
+/**
+ * @brief       Start rotating, putting the first payload on air now.
+ *
+ * @return      SUCCESS or bleIncorrectMode if no slot is filled
+ */
+extern bStatus_t AdvSched_Start( void );
+
+/**
+ * @brief       Stop rotating. The payload on air stays there.
+ *
+ * @return      none
+ */
+extern void AdvSched_Stop( void );
+
+/**
+ * @brief       Handle the scheduler event by putting the next payload
+ *              on air.
+ *
+ * @return      none
+ */
+extern void AdvSched_ProcessEvent( void );
+
+/**
+ * @brief       Get the slot whose payload is on air.
+ *
+ * @return      slot index, or ADVSCHED_MAX_SLOTS if none
+ */
+extern uint8 AdvSched_GetCurrent( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ADVSCHED_H */
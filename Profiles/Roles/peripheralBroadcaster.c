@@ -72,6 +72,9 @@
 #define START_ADVERTISING_EVT         0x0001  
 #define RSSI_READ_EVT                 0x0002
 #define UPDATE_PARAMS_TIMEOUT_EVT     0x0004
+#define BEACON_EVT                    0x0008  // Time for the next in-connection beacon
+#define BEACON_CONN_EVT               0x0010  // Connection event ended, send the beacon
+#define BEACON_END_EVT                0x0020  // End of the beacon burst
 
 #define DEFAULT_ADVERT_OFF_TIME       30000   // 30 seconds
 
@@ -94,6 +97,11 @@
 
 #define MAX_TIMEOUT_VALUE             0xFFFF
 
+#define DEFAULT_BEACON_DURATION       10      // 10 milliseconds
+
+// Time kept free ahead of the next connection event (in milliseconds)
+#define BEACON_GUARD_TIME             2
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -158,6 +166,13 @@ static uint16 gapRole_MaxConnInterval = DEFAULT_MAX_CONN_INTERVAL;
 static uint16 gapRole_SlaveLatency = DEFAULT_SLAVE_LATENCY;
 static uint16 gapRole_TimeoutMultiplier = DEFAULT_TIMEOUT_MULTIPLIER;
 
+// In-connection beacon scheduler
+static uint16 gapRole_BeaconInterval = 0;
+static uint16 gapRole_BeaconDuration = DEFAULT_BEACON_DURATION;
+static uint16 gapRole_ConnInterval = 0;
+static uint8  gapRole_BeaconActive = FALSE;       // Beacon burst advertising
+static uint8  gapRole_BeaconDataUpdate = FALSE;   // Advertising data changed
+static uint8  gapRole_BeaconDataPending = FALSE;  // Advertising data update in progress
 
 /*********************************************************************
  * Profile Attributes - variables
@@ -174,6 +189,9 @@ static void gapRole_ProcessOSALMsg( osal_event_hdr_t *pMsg );
 static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg );
 static void gapRole_SetupGAP( void );
 static void gapRole_SendUpdateParam( uint16 connInterval, uint16 connLatency );
+static void gapRole_StartBeacon( void );
+static uint8 gapRole_ProcessBeaconDone( uint8 opcode, uint8 status );
+static uint16 gapRole_BeaconWindow( void );
 
 /*********************************************************************
  * NETWORK LAYER CALLBACKS
@@ -235,8 +253,16 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
 
           if ( (gapRole_state == GAPROLE_CONNECTED) && (advEnabled == TRUE) )
           {
-            // Turn on advertising
-            osal_set_event( gapRole_TaskID, START_ADVERTISING_EVT );
+            if ( gapRole_BeaconActive )
+            {
+              // A beacon burst is being started, try again later
+              ret = blePending;
+            }
+            else
+            {
+              // Turn on advertising
+              osal_set_event( gapRole_TaskID, START_ADVERTISING_EVT );
+            }
           }
           else if ( (gapRole_state == GAPROLE_CONNECTED_ADV) && (advEnabled == FALSE) )
           {
@@ -289,6 +315,9 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
         VOID osal_memset( gapRole_AdvertData, 0, B_MAX_ADV_LEN );
         VOID osal_memcpy( gapRole_AdvertData, pValue, len );
         gapRole_AdvertDataLen = len;
+
+        // Pushed to the controller with the next beacon
+        gapRole_BeaconDataUpdate = TRUE;
       }
       else
       {
@@ -453,6 +482,40 @@ bStatus_t GAPRole_SetParameter( uint16 param, uint8 len, void *pValue )
       }
       break;
 
+    case GAPROLE_BEACON_INTERVAL:
+      if ( len == sizeof ( uint16 ) )
+      {
+        gapRole_BeaconInterval = *((uint16*)pValue);
+
+        if ( gapRole_ConnectionHandle != INVALID_CONNHANDLE )
+        {
+          if ( gapRole_BeaconInterval )
+          {
+            VOID osal_start_timerEx( gapRole_TaskID, BEACON_EVT, gapRole_BeaconInterval );
+          }
+          else
+          {
+            VOID osal_stop_timerEx( gapRole_TaskID, BEACON_EVT );
+          }
+        }
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
+    case GAPROLE_BEACON_DURATION:
+      if ( (len == sizeof ( uint16 )) && (*((uint16*)pValue) != 0) )
+      {
+        gapRole_BeaconDuration = *((uint16*)pValue);
+      }
+      else
+      {
+        ret = bleInvalidRange;
+      }
+      break;
+
     default:
       // The param value isn't part of this profile, try the GAP.
       if ( (param < TGAP_PARAMID_MAX) && (len == sizeof ( uint16 )) )
@@ -567,6 +630,14 @@ bStatus_t GAPRole_GetParameter( uint16 param, void *pValue )
       VOID osal_memcpy( pValue, gapRole_ConnectedDevAddr, B_ADDR_LEN ) ;
       break;
 
+    case GAPROLE_BEACON_INTERVAL:
+      *((uint16*)pValue) = gapRole_BeaconInterval;
+      break;
+
+    case GAPROLE_BEACON_DURATION:
+      *((uint16*)pValue) = gapRole_BeaconDuration;
+      break;
+
     default:
       // The param value isn't part of this profile, try the GAP.
       if ( param < TGAP_PARAMID_MAX )
@@ -761,6 +832,52 @@ uint16 GAPRole_ProcessEvent( uint8 task_id, uint16 events )
     return ( events ^ UPDATE_PARAMS_TIMEOUT_EVT );
   }
 
+  if ( events & BEACON_EVT )
+  {
+    if ( gapRole_BeaconInterval )
+    {
+      if ( gapRole_state == GAPROLE_CONNECTED )
+      {
+        // Send the beacon right after the next connection event so it does
+        // not collide with the one after that
+        if ( HCI_EXT_ConnEventNoticeCmd( gapRole_TaskID, BEACON_CONN_EVT ) != SUCCESS )
+        {
+          VOID osal_set_event( gapRole_TaskID, BEACON_CONN_EVT );
+        }
+      }
+      else if ( gapRole_state == GAPROLE_CONNECTED_ADV )
+      {
+        // The application is advertising in the connection, check again later
+        VOID osal_start_timerEx( gapRole_TaskID, BEACON_EVT, gapRole_BeaconInterval );
+      }
+    }
+
+    return ( events ^ BEACON_EVT );
+  }
+
+  if ( events & BEACON_CONN_EVT )
+  {
+    // One notice is enough
+    VOID HCI_EXT_ConnEventNoticeCmd( gapRole_TaskID, 0 );
+
+    if ( (gapRole_state == GAPROLE_CONNECTED) && (gapRole_BeaconActive == FALSE) )
+    {
+      gapRole_StartBeacon();
+    }
+
+    return ( events ^ BEACON_CONN_EVT );
+  }
+
+  if ( events & BEACON_END_EVT )
+  {
+    if ( (gapRole_BeaconActive) && (gapRole_state == GAPROLE_CONNECTED_ADV) )
+    {
+      VOID GAP_EndDiscoverable( gapRole_TaskID );
+    }
+
+    return ( events ^ BEACON_END_EVT );
+  }
+
   // Discard unknown events
   return 0;
 }
@@ -876,6 +993,17 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
       {
         gapAdvDataUpdateEvent_t *pPkt = (gapAdvDataUpdateEvent_t *)pMsg;
 
+        if ( (pPkt->adType) && (gapRole_BeaconDataPending) )
+        {
+          // Beacon data refresh, advertising is started by the beacon itself
+          gapRole_BeaconDataPending = FALSE;
+          if ( pPkt->hdr.status != SUCCESS )
+          {
+            gapRole_BeaconDataUpdate = TRUE;
+          }
+          break;
+        }
+
         if ( pPkt->hdr.status == SUCCESS )
         {
           if ( pPkt->adType )
@@ -905,6 +1033,12 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
       {
         gapMakeDiscoverableRspEvent_t *pPkt = (gapMakeDiscoverableRspEvent_t *)pMsg;
 
+        if ( gapRole_BeaconActive )
+        {
+          notify = gapRole_ProcessBeaconDone( pMsg->opcode, pPkt->hdr.status );
+          break;
+        }
+
         if ( pPkt->hdr.status == SUCCESS )
         {
           if ( pMsg->opcode == GAP_MAKE_DISCOVERABLE_DONE_EVENT )
@@ -958,8 +1092,15 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
         {
           VOID osal_memcpy( gapRole_ConnectedDevAddr, pPkt->devAddr, B_ADDR_LEN );
           gapRole_ConnectionHandle = pPkt->connectionHandle;
+          gapRole_ConnInterval = pPkt->connInterval;
           gapRole_state = GAPROLE_CONNECTED;
 
+          if ( gapRole_BeaconInterval )
+          {
+            // Keep beaconing while connected
+            VOID osal_start_timerEx( gapRole_TaskID, BEACON_EVT, gapRole_BeaconInterval );
+          }
+
           if ( gapRole_RSSIReadRate )
           {
             // Start the RSSI Reads
@@ -991,8 +1132,22 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
       {
         VOID GAPBondMgr_ProcessGAPMsg( (gapEventHdr_t *)pMsg );
         osal_memset( gapRole_ConnectedDevAddr, 0, B_ADDR_LEN );
+
+        // Stop the beacon scheduler
+        VOID osal_stop_timerEx( gapRole_TaskID, BEACON_EVT );
+        VOID osal_stop_timerEx( gapRole_TaskID, BEACON_END_EVT );
+        VOID HCI_EXT_ConnEventNoticeCmd( gapRole_TaskID, 0 );
+        gapRole_ConnInterval = 0;
         
-        if ( gapRole_state == GAPROLE_CONNECTED_ADV )
+        if ( gapRole_BeaconActive )
+        {
+          // Advertising restarts once the beacon burst is over
+          if ( gapRole_state == GAPROLE_CONNECTED_ADV )
+          {
+            GAP_EndDiscoverable( gapRole_TaskID );
+          }
+        }
+        else if ( gapRole_state == GAPROLE_CONNECTED_ADV )
         {
           // End the non-connectable advertising
           GAP_EndDiscoverable( gapRole_TaskID );
@@ -1035,6 +1190,11 @@ static void gapRole_ProcessGAPMsg( gapEventHdr_t *pMsg )
           // All is good stop Update Parameters timeout
           VOID osal_stop_timerEx( gapRole_TaskID, UPDATE_PARAMS_TIMEOUT_EVT );
         }
+
+        if ( pPkt->hdr.status == SUCCESS )
+        {
+          gapRole_ConnInterval = pPkt->connInterval;
+        }
       }
       break;
       
@@ -1117,5 +1277,119 @@ static void gapRole_SendUpdateParam( uint16 connInterval, uint16 connLatency )
   VOID osal_start_timerEx( gapRole_TaskID, UPDATE_PARAMS_TIMEOUT_EVT, (uint16)(timeout) );
 }
 
+/*********************************************************************
+ * @fn      gapRole_StartBeacon
+ *
+ * @brief   Start a non-connectable advertising burst in the connection,
+ *          refreshing the advertising data first if it changed.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void gapRole_StartBeacon( void )
+{
+  gapAdvertisingParams_t params;
+
+  if ( gapRole_BeaconDataUpdate && (gapRole_BeaconDataPending == FALSE) )
+  {
+    if ( GAP_UpdateAdvertisingData( gapRole_TaskID, TRUE,
+                                    gapRole_AdvertDataLen, gapRole_AdvertData ) == SUCCESS )
+    {
+      gapRole_BeaconDataUpdate = FALSE;
+      gapRole_BeaconDataPending = TRUE;
+    }
+  }
+
+  // While in a connection, we can only advertise non-connectable undirected.
+  params.eventType = GAP_ADTYPE_ADV_NONCONN_IND;
+  params.channelMap = gapRole_AdvChanMap;
+  params.filterPolicy = gapRole_AdvFilterPolicy;
+
+  if ( GAP_MakeDiscoverable( gapRole_TaskID, &params ) == SUCCESS )
+  {
+    gapRole_BeaconActive = TRUE;
+  }
+  else
+  {
+    // Skip this beacon
+    VOID osal_start_timerEx( gapRole_TaskID, BEACON_EVT, gapRole_BeaconInterval );
+  }
+}
+
+/*********************************************************************
+ * @fn      gapRole_ProcessBeaconDone
+ *
+ * @brief   Process the start or end of a beacon burst.
+ *
+ * @param   opcode - GAP_MAKE_DISCOVERABLE_DONE_EVENT or
+ *                   GAP_END_DISCOVERABLE_DONE_EVENT
+ * @param   status - event status
+ *
+ * @return  TRUE if the application should be notified of a state change
+ */
+static uint8 gapRole_ProcessBeaconDone( uint8 opcode, uint8 status )
+{
+  if ( (opcode == GAP_MAKE_DISCOVERABLE_DONE_EVENT) && (status == SUCCESS) )
+  {
+    if ( gapRole_ConnectionHandle != INVALID_CONNHANDLE )
+    {
+      gapRole_state = GAPROLE_CONNECTED_ADV;
+      VOID osal_start_timerEx( gapRole_TaskID, BEACON_END_EVT, gapRole_BeaconWindow() );
+    }
+    else
+    {
+      // Link dropped before the beacon started
+      VOID GAP_EndDiscoverable( gapRole_TaskID );
+    }
+
+    return ( FALSE );
+  }
+
+  // Beacon burst over
+  gapRole_BeaconActive = FALSE;
+
+  if ( gapRole_ConnectionHandle != INVALID_CONNHANDLE )
+  {
+    gapRole_state = GAPROLE_CONNECTED;
+
+    if ( gapRole_BeaconInterval )
+    {
+      VOID osal_start_timerEx( gapRole_TaskID, BEACON_EVT, gapRole_BeaconInterval );
+    }
+
+    return ( FALSE );
+  }
+
+  // Link dropped during the beacon, go back to connectable advertising
+  gapRole_state = GAPROLE_WAITING;
+  VOID osal_set_event( gapRole_TaskID, START_ADVERTISING_EVT );
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      gapRole_BeaconWindow
+ *
+ * @brief   Length of a beacon burst, kept short enough to end before
+ *          the next connection event.
+ *
+ * @param   none
+ *
+ * @return  burst length in milliseconds
+ */
+static uint16 gapRole_BeaconWindow( void )
+{
+  uint16 window = gapRole_BeaconDuration;
+  uint16 connTime = (gapRole_ConnInterval * 5) / 4;
+
+  if ( (connTime > BEACON_GUARD_TIME) && (window > (connTime - BEACON_GUARD_TIME)) )
+  {
+    window = connTime - BEACON_GUARD_TIME;
+  }
+
+  return ( window );
+}
+
 /*********************************************************************
 *********************************************************************/
@@ -95,6 +95,8 @@ extern "C"
 #define GAPROLE_SLAVE_LATENCY       0x313  //!< Update Parameter Slave Latency. Range: 0 - 499. Read/Write. Size is uint16. Default is 0.
 #define GAPROLE_TIMEOUT_MULTIPLIER  0x314  //!< Update Parameter Timeout Multiplier (n * 10ms). Range: 100ms to 32 seconds (0x000a - 0x0c80). Read/Write. Size is uint16. Default is 1000.
 #define GAPROLE_CONN_BD_ADDR        0x315  //!< Address of connected device. Read only. Size is uint8[B_MAX_ADV_LEN]. Set to all zeros when not connected.
+#define GAPROLE_BEACON_INTERVAL     0x316  //!< How often to send a non-connectable advertising burst while in a connection (in milliseconds). Read/Write. Size is uint16. Default is 0 = OFF. The advertising data in use is GAPROLE_ADVERT_DATA.
+#define GAPROLE_BEACON_DURATION     0x317  //!< How long each burst advertises (in milliseconds). Capped to fit between two connection events. Read/Write. Size is uint16. Default is 10.
 /** @} End GAPROLE_PROFILE_PARAMETERS */
   
 /*-------------------------------------------------------------------
@@ -0,0 +1,396 @@
+/******************************************************************************
+
+ @file  scansched.c
+
+ @brief This file contains the duty-cycled scan scheduler used by the central
+        and observer roles.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gap.h"
+#include "scansched.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Size of the seen-device bit map. Devices are hashed to one bit, so a
+// new device that lands on a set bit is missed.
+#define SCANSCHED_SEEN_BITS               256
+
+// Number of set bits at which the bit map is cleared, before false
+// matches become common
+#define SCANSCHED_SEEN_LIMIT              ( SCANSCHED_SEEN_BITS / 2 )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task and event used to time the windows
+static uint8 scanSchedTaskId;
+static uint16 scanSchedEvent;
+
+// Starts a discovery window
+static scanSchedStartCB_t scanSchedStartCB = NULL;
+
+// TRUE while running
+static uint8 scanSchedOn = FALSE;
+
+// Window and interval range in ms
+static uint16 scanSchedWindow = SCANSCHED_DEFAULT_WINDOW;
+static uint16 scanSchedMinInterval = SCANSCHED_DEFAULT_MIN_INTERVAL;
+static uint16 scanSchedMaxInterval = SCANSCHED_DEFAULT_MAX_INTERVAL;
+
+// Current interval in ms
+static uint16 scanSchedInterval = SCANSCHED_DEFAULT_MIN_INTERVAL;
+
+// TRUE if the window in progress has heard a new device
+static uint8 scanSchedNewSeen = FALSE;
+
+// Devices seen since the bit map was last cleared
+static uint8 scanSchedSeen[SCANSCHED_SEEN_BITS / 8];
+static uint16 scanSchedSeenCount = 0;
+
+// Discovery durations in use before the scheduler took over
+static uint16 scanSchedSavedGenScan;
+static uint16 scanSchedSavedLimScan;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      ScanSched_Init
+ *
+ * @brief   Initialize the scan scheduler.
+ *
+ * @param   taskId - task that receives the scheduler event
+ * @param   event - event the task passes to ScanSched_ProcessEvent()
+ * @param   pfnStart - starts a discovery window
+ *
+ * @return  none
+ */
+void ScanSched_Init( uint8 taskId, uint16 event, scanSchedStartCB_t pfnStart )
+{
+  scanSchedTaskId = taskId;
+  scanSchedEvent = event;
+  scanSchedStartCB = pfnStart;
+}
+
+/*********************************************************************
+ * @fn      ScanSched_SetParams
+ *
+ * @brief   Set the scan window and the interval range.
+ *
+ * @param   window - scan window in ms
+ * @param   minInterval - interval in ms used while new devices appear
+ * @param   maxInterval - longest interval in ms
+ *
+ * @return  SUCCESS or INVALIDPARAMETER
+ */
+bStatus_t ScanSched_SetParams( uint16 window, uint16 minInterval, uint16 maxInterval )
+{
+  if ( window == 0 || minInterval < window || maxInterval < minInterval )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  scanSchedWindow = window;
+  scanSchedMinInterval = minInterval;
+  scanSchedMaxInterval = maxInterval;
+
+  if ( scanSchedInterval < minInterval )
+  {
+    scanSchedInterval = minInterval;
+  }
+  else if ( scanSchedInterval > maxInterval )
+  {
+    scanSchedInterval = maxInterval;
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      ScanSched_Start
+ *
+ * @brief   Start running scan windows, the first one immediately.
+ *
+ * @return  SUCCESS or the status of starting the first window
+ */
+bStatus_t ScanSched_Start( void )
+{
+  bStatus_t status;
+
+  if ( scanSchedOn )
+  {
+    return ( SUCCESS );
+  }
+
+  scanSchedSavedGenScan = GAP_GetParamValue( TGAP_GEN_DISC_SCAN );
+  scanSchedSavedLimScan = GAP_GetParamValue( TGAP_LIM_DISC_SCAN );
+
+  osal_memset( scanSchedSeen, 0, sizeof( scanSchedSeen ) );
+  scanSchedSeenCount = 0;
+  scanSchedInterval = scanSchedMinInterval;
+  scanSchedNewSeen = FALSE;
+
+  GAP_SetParamValue( TGAP_GEN_DISC_SCAN, scanSchedWindow );
+  GAP_SetParamValue( TGAP_LIM_DISC_SCAN, scanSchedWindow );
+
+  status = scanSchedStartCB();
+
+  // A window already in progress is adopted as the first one
+  if ( status == SUCCESS || status == bleAlreadyInRequestedMode )
+  {
+    scanSchedOn = TRUE;
+    status = SUCCESS;
+  }
+  else
+  {
+    GAP_SetParamValue( TGAP_GEN_DISC_SCAN, scanSchedSavedGenScan );
+    GAP_SetParamValue( TGAP_LIM_DISC_SCAN, scanSchedSavedLimScan );
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      ScanSched_Stop
+ *
+ * @brief   Stop scheduling windows and restore the discovery duration.
+ *
+ * @return  none
+ */
+void ScanSched_Stop( void )
+{
+  if ( !scanSchedOn )
+  {
+    return;
+  }
+
+  scanSchedOn = FALSE;
+
+  VOID osal_stop_timerEx( scanSchedTaskId, scanSchedEvent );
+  VOID osal_clear_event( scanSchedTaskId, scanSchedEvent );
+
+  GAP_SetParamValue( TGAP_GEN_DISC_SCAN, scanSchedSavedGenScan );
+  GAP_SetParamValue( TGAP_LIM_DISC_SCAN, scanSchedSavedLimScan );
+}
+
+/*********************************************************************
+ * @fn      ScanSched_Active
+ *
+ * @brief   Check whether the scheduler is running.
+ *
+ * @return  TRUE if running
+ */
+uint8 ScanSched_Active( void )
+{
+  return ( scanSchedOn );
+}
+
+/*********************************************************************
+ * @fn      ScanSched_Report
+ *
+ * @brief   Note an advertising report.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  TRUE if the device is new
+ */
+uint8 ScanSched_Report( uint8 *pAddr )
+{
+  uint8 hash = 0;
+  uint8 mask;
+  uint8 i;
+
+  if ( !scanSchedOn )
+  {
+    return ( FALSE );
+  }
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    hash = (uint8)( ( hash << 1 ) | ( hash >> 7 ) ) ^ pAddr[i];
+  }
+
+  mask = BV( hash & 0x07 );
+
+  if ( scanSchedSeen[hash >> 3] & mask )
+  {
+    return ( FALSE );
+  }
+
+  if ( scanSchedSeenCount >= SCANSCHED_SEEN_LIMIT )
+  {
+    // Start over rather than let most devices look known
+    osal_memset( scanSchedSeen, 0, sizeof( scanSchedSeen ) );
+    scanSchedSeenCount = 0;
+  }
+
+  scanSchedSeen[hash >> 3] |= mask;
+  scanSchedSeenCount++;
+  scanSchedNewSeen = TRUE;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      ScanSched_WindowDone
+ *
+ * @brief   Note the end of a discovery window and schedule the next
+ *          one. The interval drops to the minimum after a window that
+ *          heard a new device and doubles, up to the maximum, after
+ *          one that did not.
+ *
+ * @return  none
+ */
+void ScanSched_WindowDone( void )
+{
+  uint16 idle;
+
+  if ( !scanSchedOn )
+  {
+    return;
+  }
+
+  if ( scanSchedNewSeen )
+  {
+    scanSchedInterval = scanSchedMinInterval;
+  }
+  else if ( scanSchedInterval > scanSchedMaxInterval / 2 )
+  {
+    scanSchedInterval = scanSchedMaxInterval;
+  }
+  else
+  {
+    scanSchedInterval <<= 1;
+  }
+
+  scanSchedNewSeen = FALSE;
+
+  idle = scanSchedInterval - scanSchedWindow;
+
+  if ( idle == 0 )
+  {
+    osal_set_event( scanSchedTaskId, scanSchedEvent );
+  }
+  else
+  {
+    osal_start_timerEx( scanSchedTaskId, scanSchedEvent, idle );
+  }
+}
+
+/*********************************************************************
+ * @fn      ScanSched_ProcessEvent
+ *
+ * @brief   Handle the scheduler event by starting the next window. A
+ *          window that cannot start, for example while a link is
+ *          being set up, is tried again after the minimum interval.
+ *
+ * @return  none
+ */
+void ScanSched_ProcessEvent( void )
+{
+  bStatus_t status;
+
+  if ( !scanSchedOn )
+  {
+    return;
+  }
+
+  // The window may have been changed since the last one
+  GAP_SetParamValue( TGAP_GEN_DISC_SCAN, scanSchedWindow );
+  GAP_SetParamValue( TGAP_LIM_DISC_SCAN, scanSchedWindow );
+
+  status = scanSchedStartCB();
+
+  if ( status != SUCCESS && status != bleAlreadyInRequestedMode )
+  {
+    osal_start_timerEx( scanSchedTaskId, scanSchedEvent, scanSchedMinInterval );
+  }
+}
+
+/*********************************************************************
+ * @fn      ScanSched_GetInterval
+ *
+ * @brief   Get the interval the scheduler is currently using.
+ *
+ * @return  interval in ms
+ */
+uint16 ScanSched_GetInterval( void )
+{
+  return ( scanSchedInterval );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,185 @@
+/******************************************************************************
+
+ @file  scansched.h
+
+ @brief This file contains the interface to the duty-cycled scan scheduler used
+        by the central and observer roles.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+#ifndef SCANSCHED_H
+#define SCANSCHED_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "bcomdef.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined ( SCANSCHED_DEFAULT_WINDOW )
+  #define SCANSCHED_DEFAULT_WINDOW        1000  //!< Scan window in ms.
+#endif
+
+#if !defined ( SCANSCHED_DEFAULT_MIN_INTERVAL )
+  #define SCANSCHED_DEFAULT_MIN_INTERVAL  1000  //!< Window start to window start in ms while new devices appear. Equal to the window for continuous scanning.
+#endif
+
+#if !defined ( SCANSCHED_DEFAULT_MAX_INTERVAL )
+  #define SCANSCHED_DEFAULT_MAX_INTERVAL  8000  //!< Longest interval the scheduler backs off to in ms.
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/**
+ * Callback that starts one discovery window. The window length has
+ * already been set in TGAP_GEN_DISC_SCAN and TGAP_LIM_DISC_SCAN.
+ */
+typedef bStatus_t (*scanSchedStartCB_t)( void );
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * Profile Callbacks
+ */
+
+/*********************************************************************
+ * API FUNCTIONS
+ */
+
+/**
+ * @brief       Initialize the scan scheduler.
+ *
+ * @param       taskId - task that receives the scheduler event
+ * @param       event - event the task passes to ScanSched_ProcessEvent()
+ * @param       pfnStart - starts a discovery window
+ *
+ * @return      none
+ */
+extern void ScanSched_Init( uint8 taskId, uint16 event, scanSchedStartCB_t pfnStart );
+
+/**
+ * @brief       Set the scan window and the interval range. Takes effect
+ *              from the next window.
+ *
+ * @param       window - scan window in ms
+ * @param       minInterval - interval in ms used while new devices appear,
+ *                            at least the window
+ * @param       maxInterval - longest interval in ms, at least minInterval
+ *
+ * @return      SUCCESS or INVALIDPARAMETER
+ */
+extern bStatus_t ScanSched_SetParams( uint16 window, uint16 minInterval, uint16 maxInterval );
+
+/**
+ * @brief       Start running scan windows, the first one immediately.
+ *
+ * @return      SUCCESS or the status of starting the first window
+ */
+extern bStatus_t ScanSched_Start( void );
+
+/**
+ * @brief       Stop scheduling windows. A window in progress runs to
+ *              its end.
+ *
+ * @return      none
+ */
+extern void ScanSched_Stop( void );
+
+/**
+ * @brief       Check whether the scheduler is running.
+ *
+ * @return      TRUE if running
+ */
+extern uint8 ScanSched_Active( void );
+
+/**
+ * @brief       Note an advertising report. A device not seen before
+ *              makes the next window follow at the minimum interval.
+ *
+ * @param       pAddr - device address
+ *
+ * @return      TRUE if the device is new
+ */
+extern uint8 ScanSched_Report( uint8 *pAddr );
+
+/**
+ * @brief       Note the end of a discovery window and schedule the
+ *              next one.
+ *
+ * @return      none
+ */
+extern void ScanSched_WindowDone( void );
+
+/**
+ * @brief       Handle the scheduler event by starting the next window.
+ *
+ * @return      none
+ */
+extern void ScanSched_ProcessEvent( void );
+
+/**
+ * @brief       Get the interval the scheduler is currently using.
+ *
+ * @return      interval in ms
+ */
+extern uint16 ScanSched_GetInterval( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCANSCHED_H */
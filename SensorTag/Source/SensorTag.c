@@ -146,8 +146,10 @@
 // Supervision timeout value (units of 10ms, 1000=10s) if automatic parameter update request is enabled
 #define DEFAULT_DESIRED_CONN_TIMEOUT          1000
 
-// Whether to enable automatic parameter update request when a connection is formed
-#define DEFAULT_ENABLE_UPDATE_REQUEST         FALSE
+// Whether to enable automatic parameter update request when a connection is formed.
+// On, so a central that keeps its short default interval is asked in turn for
+// each of paramSets below
+#define DEFAULT_ENABLE_UPDATE_REQUEST         TRUE
 
 // Connection Pause Peripheral time value (in seconds)
 #define DEFAULT_CONN_PAUSE_PERIPHERAL         8
@@ -162,6 +164,12 @@
 
 #if defined ( PLUS_BROADCASTER )
   #define ADV_IN_CONN_WAIT                    500 // delay 500 ms
+
+  // How often to beacon while in a connection (in milliseconds)
+  #define DEFAULT_BEACON_INTERVAL             1000
+
+  // Offset of the IR temperature reading in the advertising data
+  #define ADV_IR_TEMP_OFFSET                  7
 #endif
 
 // Side key bit
@@ -242,8 +250,33 @@ static uint8 advertData[] =
   0x02,   // length of this data
   GAP_ADTYPE_FLAGS,
   DEFAULT_DISCOVERABLE_MODE | GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED,
+#if defined ( PLUS_BROADCASTER )
+  // Latest IR temperature reading, for listeners of the beacons sent
+  // while in a connection
+  0x07,   // length of this data
+  GAP_ADTYPE_MANUFACTURER_SPECIFIC,
+  LO_UINT16( TI_COMPANY_ID ),
+  HI_UINT16( TI_COMPANY_ID ),
+  0, 0, 0, 0
+#endif // PLUS_BROADCASTER
 };
 
+#if !defined ( PLUS_BROADCASTER )
+// Connection parameter sets requested in turn when automatic parameter
+// update is enabled, so a central that refuses the preferred set still
+// gets moved off its default interval
+static gapRolesParamSet_t paramSets[] =
+{
+  // Preferred: 100ms - 1s, no slave latency, 10s supervision timeout
+  { DEFAULT_DESIRED_MIN_CONN_INTERVAL, DEFAULT_DESIRED_MAX_CONN_INTERVAL,
+    DEFAULT_DESIRED_SLAVE_LATENCY, DEFAULT_DESIRED_CONN_TIMEOUT },
+  // 500ms - 520ms, slave latency 2, 6s supervision timeout
+  { 400, 416, 2, 600 },
+  // 100ms - 120ms, slave latency 4, 4s supervision timeout
+  { 80, 96, 4, 400 }
+};
+#endif // !PLUS_BROADCASTER
+
 // GAP GATT Attributes
 static uint8 attDeviceName[] = "TI BLE Sensor Tag";
 
@@ -424,6 +457,15 @@ void SensorTag_Init( uint8 task_id )
     GAPRole_SetParameter( GAPROLE_MAX_CONN_INTERVAL, sizeof( uint16 ), &desired_max_interval );
     GAPRole_SetParameter( GAPROLE_SLAVE_LATENCY, sizeof( uint16 ), &desired_slave_latency );
     GAPRole_SetParameter( GAPROLE_TIMEOUT_MULTIPLIER, sizeof( uint16 ), &desired_conn_timeout );
+#if !defined ( PLUS_BROADCASTER )
+    GAPRole_SetParameter( GAPROLE_PARAM_UPDATE_SETS, sizeof( paramSets ), paramSets );
+#else
+    {
+      uint16 beacon_interval = DEFAULT_BEACON_INTERVAL;
+
+      GAPRole_SetParameter( GAPROLE_BEACON_INTERVAL, sizeof( uint16 ), &beacon_interval );
+    }
+#endif // !PLUS_BROADCASTER
   }
 
   // Set the GAP Characteristics
@@ -1132,6 +1174,12 @@ static void readIrTempData( void )
   if (HalIRTempRead(tData))
   {
     IRTemp_SetParameter( SENSOR_DATA, IRTEMPERATURE_DATA_LEN, tData);
+
+#if defined ( PLUS_BROADCASTER )
+    // Send the reading with the next beacon
+    VOID osal_memcpy( &advertData[ADV_IR_TEMP_OFFSET], tData, IRTEMPERATURE_DATA_LEN );
+    GAPRole_SetParameter( GAPROLE_ADVERT_DATA, sizeof( advertData ), advertData );
+#endif // PLUS_BROADCASTER
   }
 }
 
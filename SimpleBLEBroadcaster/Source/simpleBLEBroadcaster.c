@@ -53,6 +53,7 @@
 #include "bcomdef.h"
 #include "OSAL.h"
 #include "OSAL_PwrMgr.h"
+#include "OSAL_Clock.h"
 
 #include "OnBoard.h"
 #include "hal_adc.h"
@@ -65,6 +66,7 @@
 
 #include "devinfoservice.h"
 #include "broadcaster.h"
+#include "advsched.h"
 
 #include "simpleBLEBroadcaster.h"
 
@@ -85,6 +87,30 @@
 // Length of bd addr as a string
 #define B_ADDR_STR_LEN                        15
 
+// Payload rotation: time on air per pick in ms and share of the picks
+#define SBP_ROTATE_DWELL                      300
+#define SBP_ROTATE_WEIGHT_ADV                 1
+#define SBP_ROTATE_WEIGHT_IBEACON             3
+#define SBP_ROTATE_WEIGHT_UID                 2
+#define SBP_ROTATE_WEIGHT_TLM                 1
+
+// Payload slots
+#define SBP_SLOT_ADV                          0
+#define SBP_SLOT_IBEACON                      1
+#define SBP_SLOT_UID                          2
+#define SBP_SLOT_TLM                          3
+
+// Measured power at 1m in dBm, carried by the beacon frames
+#define SBP_BEACON_TX_POWER                   0xC5  // -59 dBm
+
+// Eddystone service UUID
+#define SBP_EDDYSTONE_UUID                    0xFEAA
+
+// Offset of the TLM fields in tlmAdvertData
+#define SBP_TLM_VBATT_OFFSET                  13
+#define SBP_TLM_ADV_CNT_OFFSET                17
+#define SBP_TLM_SEC_CNT_OFFSET                21
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -158,6 +184,78 @@ static uint8 advertData[] =
   3
 };
 
+#if ( SBP_ADV_ROTATE == TRUE )
+// iBeacon-style frame
+static uint8 iBeaconAdvertData[] =
+{
+  0x02,   // length of this data
+  GAP_ADTYPE_FLAGS,
+  GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED,
+
+  0x1A,   // length of this data
+  GAP_ADTYPE_MANUFACTURER_SPECIFIC,
+  0x4C, 0x00,   // company ID, the frame format requires it
+  0x02, 0x15,   // beacon type and remaining length
+  // proximity UUID
+  0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+  0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB,
+  0x00, 0x01,   // major
+  0x00, 0x01,   // minor
+  SBP_BEACON_TX_POWER
+};
+
+// Eddystone-UID-style frame
+static uint8 uidAdvertData[] =
+{
+  0x02,   // length of this data
+  GAP_ADTYPE_FLAGS,
+  GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED,
+
+  0x03,   // length of this data
+  GAP_ADTYPE_16BIT_COMPLETE,
+  LO_UINT16( SBP_EDDYSTONE_UUID ), HI_UINT16( SBP_EDDYSTONE_UUID ),
+
+  0x17,   // length of this data
+  GAP_ADTYPE_SERVICE_DATA,
+  LO_UINT16( SBP_EDDYSTONE_UUID ), HI_UINT16( SBP_EDDYSTONE_UUID ),
+  0x00,   // frame type: UID
+  SBP_BEACON_TX_POWER + 41,   // ranging data, power at 0m
+  // namespace
+  0x54, 0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  // instance
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x00    // reserved
+};
+
+// Eddystone-TLM-style frame, counters are filled in before it goes on air
+static uint8 tlmAdvertData[] =
+{
+  0x02,   // length of this data
+  GAP_ADTYPE_FLAGS,
+  GAP_ADTYPE_FLAGS_BREDR_NOT_SUPPORTED,
+
+  0x03,   // length of this data
+  GAP_ADTYPE_16BIT_COMPLETE,
+  LO_UINT16( SBP_EDDYSTONE_UUID ), HI_UINT16( SBP_EDDYSTONE_UUID ),
+
+  0x11,   // length of this data
+  GAP_ADTYPE_SERVICE_DATA,
+  LO_UINT16( SBP_EDDYSTONE_UUID ), HI_UINT16( SBP_EDDYSTONE_UUID ),
+  0x20,   // frame type: TLM
+  0x00,   // version
+  0x00, 0x00,               // battery voltage in mV, 0 if not measured
+  0x80, 0x00,               // temperature, 0x8000 if not measured
+  0x00, 0x00, 0x00, 0x00,   // advertising PDU count, estimated
+  0x00, 0x00, 0x00, 0x00    // time since power up in 0.1s
+};
+
+// Estimated advertising events up to the last TLM update, the time of
+// that update, and the part of an event left over, in 1/8 ms
+static uint32 tlmAdvCount = 0;
+static uint32 tlmLastUpdate = 0;
+static uint16 tlmAdvRemainder = 0;
+#endif // SBP_ADV_ROTATE
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -168,6 +266,11 @@ static void peripheralStateNotificationCB( gaprole_States_t newState );
 static void simpleBLEBroadcaster_HandleKeys( uint8 shift, uint8 keys );
 #endif
 
+#if ( SBP_ADV_ROTATE == TRUE )
+static bStatus_t simpleBLEBroadcaster_SetAdvData( uint8 len, uint8 *pData );
+static void simpleBLEBroadcaster_UpdateTlm( uint8 slot, uint8 *pData, uint8 len );
+#endif // SBP_ADV_ROTATE
+
 #if (defined HAL_LCD) && (HAL_LCD == TRUE) 
 static char *bdAddr2Str ( uint8 *pAddr );
 #endif // (defined HAL_LCD) && (HAL_LCD == TRUE) 
@@ -242,6 +345,22 @@ void SimpleBLEBroadcaster_Init( uint8 task_id )
     GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MIN, advInt );
     GAP_SetParamValue( TGAP_GEN_DISC_ADV_INT_MAX, advInt );
   }
+
+#if ( SBP_ADV_ROTATE == TRUE )
+  // Setup the payload rotation, started once the device is up
+  AdvSched_Init( simpleBLEBroadcaster_TaskID, SBP_ADV_ROTATE_EVT,
+                 simpleBLEBroadcaster_SetAdvData );
+
+  VOID AdvSched_SetSlot( SBP_SLOT_ADV, advertData, sizeof( advertData ),
+                         SBP_ROTATE_DWELL, SBP_ROTATE_WEIGHT_ADV, NULL );
+  VOID AdvSched_SetSlot( SBP_SLOT_IBEACON, iBeaconAdvertData, sizeof( iBeaconAdvertData ),
+                         SBP_ROTATE_DWELL, SBP_ROTATE_WEIGHT_IBEACON, NULL );
+  VOID AdvSched_SetSlot( SBP_SLOT_UID, uidAdvertData, sizeof( uidAdvertData ),
+                         SBP_ROTATE_DWELL, SBP_ROTATE_WEIGHT_UID, NULL );
+  VOID AdvSched_SetSlot( SBP_SLOT_TLM, tlmAdvertData, sizeof( tlmAdvertData ),
+                         SBP_ROTATE_DWELL, SBP_ROTATE_WEIGHT_TLM,
+                         simpleBLEBroadcaster_UpdateTlm );
+#endif // SBP_ADV_ROTATE
   
 #if defined( CC2540_MINIDK )
  
@@ -321,6 +440,15 @@ uint16 SimpleBLEBroadcaster_ProcessEvent( uint8 task_id, uint16 events )
     
     return ( events ^ SBP_START_DEVICE_EVT );
   }
+
+#if ( SBP_ADV_ROTATE == TRUE )
+  if ( events & SBP_ADV_ROTATE_EVT )
+  {
+    AdvSched_ProcessEvent();
+
+    return ( events ^ SBP_ADV_ROTATE_EVT );
+  }
+#endif // SBP_ADV_ROTATE
   
   // Discard unknown events
   return 0;
@@ -372,7 +500,13 @@ static void simpleBLEBroadcaster_HandleKeys( uint8 shift, uint8 keys )
   {
     advertData[6]++;
     
-    GAPRole_SetParameter( GAPROLE_ADVERT_DATA, sizeof( advertData ), advertData );
+#if ( SBP_ADV_ROTATE == TRUE )
+    // Picked up the next time the slot goes on air
+    if ( AdvSched_GetCurrent() == SBP_SLOT_ADV )
+#endif // SBP_ADV_ROTATE
+    {
+      GAPRole_SetParameter( GAPROLE_ADVERT_DATA, sizeof( advertData ), advertData );
+    }
   }
   
   if ( keys & HAL_KEY_SW_2 )
@@ -423,6 +557,10 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
           HalLcdWriteString( bdAddr2Str( ownAddress ),  HAL_LCD_LINE_2 );
           HalLcdWriteString( "Initialized",  HAL_LCD_LINE_3 );
         #endif // (defined HAL_LCD) && (HAL_LCD == TRUE)    
+
+        #if ( SBP_ADV_ROTATE == TRUE )
+          VOID AdvSched_Start();
+        #endif // SBP_ADV_ROTATE
       }
       break;
       
@@ -460,6 +598,72 @@ static void peripheralStateNotificationCB( gaprole_States_t newState )
   }
 }
 
+#if ( SBP_ADV_ROTATE == TRUE )
+/*********************************************************************
+ * @fn      simpleBLEBroadcaster_SetAdvData
+ *
+ * @brief   Put a rotated payload on air. The role hands it to GAP
+ *          while advertising keeps running.
+ *
+ * @param   len - length of the data
+ * @param   pData - advertising data
+ *
+ * @return  status of the update
+ */
+static bStatus_t simpleBLEBroadcaster_SetAdvData( uint8 len, uint8 *pData )
+{
+  return ( GAPRole_SetParameter( GAPROLE_ADVERT_DATA, len, pData ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEBroadcaster_UpdateTlm
+ *
+ * @brief   Refresh the counters of the TLM frame in place before it
+ *          goes on air. The stack does not report advertising events,
+ *          so the PDU count is an estimate: the time since the last
+ *          update over the interval currently set, plus the 5 ms the
+ *          link layer's random advertising delay adds on average. It
+ *          follows changes of the interval, but counts time when
+ *          advertising is off as well.
+ *
+ * @param   slot - payload slot
+ * @param   pData - TLM frame
+ * @param   len - frame length
+ *
+ * @return  none
+ */
+static void simpleBLEBroadcaster_UpdateTlm( uint8 slot, uint8 *pData, uint8 len )
+{
+  uint32 now = osal_GetSystemClock();
+  uint32 elapsed;
+  uint16 period;
+  uint32 count;
+
+  VOID slot;
+  VOID len;
+
+  // Event period in 1/8 ms: the interval is in 0.625 ms units
+  period = GAP_GetParamValue( TGAP_GEN_DISC_ADV_INT_MIN ) * 5 + 5 * 8;
+
+  elapsed = ( now - tlmLastUpdate ) * 8 + tlmAdvRemainder;
+  tlmLastUpdate = now;
+  tlmAdvCount += elapsed / period;
+  tlmAdvRemainder = (uint16)( elapsed % period );
+
+  count = tlmAdvCount;
+  pData[SBP_TLM_ADV_CNT_OFFSET]     = BREAK_UINT32( count, 3 );
+  pData[SBP_TLM_ADV_CNT_OFFSET + 1] = BREAK_UINT32( count, 2 );
+  pData[SBP_TLM_ADV_CNT_OFFSET + 2] = BREAK_UINT32( count, 1 );
+  pData[SBP_TLM_ADV_CNT_OFFSET + 3] = BREAK_UINT32( count, 0 );
+
+  count = now / 100;
+  pData[SBP_TLM_SEC_CNT_OFFSET]     = BREAK_UINT32( count, 3 );
+  pData[SBP_TLM_SEC_CNT_OFFSET + 1] = BREAK_UINT32( count, 2 );
+  pData[SBP_TLM_SEC_CNT_OFFSET + 2] = BREAK_UINT32( count, 1 );
+  pData[SBP_TLM_SEC_CNT_OFFSET + 3] = BREAK_UINT32( count, 0 );
+}
+#endif // SBP_ADV_ROTATE
+
 #if (defined HAL_LCD) && (HAL_LCD == TRUE)
 /*********************************************************************
  * @fn      bdAddr2Str
@@ -66,6 +66,13 @@ extern "C"
 #define SBP_START_DEVICE_EVT                              0x0001
 #define SBP_PERIODIC_EVT                                  0x0002
 #define SBP_ADV_IN_CONNECTION_EVT                         0x0004
+#define SBP_ADV_ROTATE_EVT                                0x0008
+
+// TRUE to rotate the advertising data through the beacon payloads. Off by
+// default; the iBeacon payload carries Apple's company ID (0x004C).
+#if !defined( SBP_ADV_ROTATE )
+#define SBP_ADV_ROTATE                                    FALSE
+#endif
 
 /*********************************************************************
  * MACROS
@@ -64,20 +64,14 @@
 #include "gattservapp.h"
 #include "central.h"
 #include "gapbondmgr.h"
+#include "advfilter.h"
+#include "scansched.h"
 #include "simpleGATTprofile.h"
 #include "simpleBLECentral.h"
 #include "npi.h"
 /*********************************************************************
  * MACROS
  */
-#define SEEK_HEAD 0
-#define SEEK_LEN 1
-#define SEEK_TYPE 2
-#define RX_DATA  3
-#define ESC      4
-#define ESC_F0       5
-#define ESC_F5       6
-#define ESC_FA       7
 
 // Length of bd addr as a string
 #define B_ADDR_STR_LEN                        15
@@ -113,18 +107,6 @@
 // Whether to enable automatic parameter update request when a connection is formed
 #define DEFAULT_ENABLE_UPDATE_REQUEST         FALSE
 
-// Minimum connection interval (units of 1.25ms) if automatic parameter update request is enabled
-#define DEFAULT_UPDATE_MIN_CONN_INTERVAL      400
-
-// Maximum connection interval (units of 1.25ms) if automatic parameter update request is enabled
-#define DEFAULT_UPDATE_MAX_CONN_INTERVAL      800
-
-// Slave latency to use if automatic parameter update request is enabled
-#define DEFAULT_UPDATE_SLAVE_LATENCY          0
-
-// Supervision timeout value (units of 10ms) if automatic parameter update request is enabled
-#define DEFAULT_UPDATE_CONN_TIMEOUT           600
-
 // Default passcode
 #define DEFAULT_PASSCODE                      19655
 
@@ -146,23 +128,6 @@
 // TRUE to filter discovery results on desired service UUID
 #define DEFAULT_DEV_DISC_BY_SVC_UUID          FALSE
 
-// Application states
-enum
-{
-  BLE_STATE_IDLE,
-  BLE_STATE_CONNECTING,
-  BLE_STATE_CONNECTED,
-  BLE_STATE_DISCONNECTING
-};
-
-// Discovery states
-enum
-{
-  BLE_DISC_STATE_IDLE,                // Idle
-  BLE_DISC_STATE_SVC,                 // Service discovery
-  BLE_DISC_STATE_CHAR                 // Characteristic discovery
-};
-
 /*********************************************************************
  * TYPEDEFS
  */
@@ -199,24 +164,14 @@ static gapDevRec_t simpleBLEDevList[DEFAULT_MAX_SCAN_RES];
 // Scanning state
 static uint8 simpleBLEScanning = FALSE;
 
-// RSSI polling state
-static uint8 simpleBLERssi = FALSE;
-
-// Connection handle of current connection 
-static uint16 simpleBLEConnHandle = GAP_CONNHANDLE_INIT;
-
-// Application state
-static uint8 simpleBLEState = BLE_STATE_IDLE;
+// Per-link state, indexed by connection handle
+static simpleBLELink_t simpleBLELinks[SBC_MAX_LINKS];
 
-// Discovery state
-static uint8 simpleBLEDiscState = BLE_DISC_STATE_IDLE;
+// TRUE while a link is being established
+static uint8 simpleBLEConnecting = FALSE;
 
-// Discovered service start and end handle
-static uint16 simpleBLESvcStartHdl = 0;
-static uint16 simpleBLESvcEndHdl = 0;
-
-// Discovered characteristic handle
-static uint16 simpleBLECharHdl = 0;
+// Connection handle of the link controlled by the keys (last established)
+static uint16 simpleBLEConnHandle = GAP_CONNHANDLE_INIT;
 
 // Value to write
 static uint8 simpleBLECharVal = 0;
@@ -224,26 +179,30 @@ static uint8 simpleBLECharVal = 0;
 // Value read/write toggle
 static bool simpleBLEDoWrite = FALSE;
 
-// GATT read/write procedure state
-static bool simpleBLEProcedureInProgress = FALSE;
-
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
 static void simpleBLECentralProcessGATTMsg( gattMsgEvent_t *pMsg );
 static void simpleBLECentralRssiCB( uint16 connHandle, int8  rssi );
+static void simpleBLECentralMtuCB( uint16 connHandle, uint16 mtu );
+static void simpleBLECentralRssiMonCB( uint16 connHandle, uint8 reason,
+                                       gapCentralRoleRssiStats_t *pStats );
 static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent );
 static void simpleBLECentralPasscodeCB( uint8 *deviceAddr, uint16 connectionHandle,
                                         uint8 uiInputs, uint8 uiOutputs );
 static void simpleBLECentralPairStateCB( uint16 connHandle, uint8 state, uint8 status );
 static void simpleBLECentral_HandleKeys( uint8 shift, uint8 keys );
 static void simpleBLECentral_ProcessOSALMsg( osal_event_hdr_t *pMsg );
-static void simpleBLEGATTDiscoveryEvent( gattMsgEvent_t *pMsg );
-static void simpleBLECentralStartDiscovery( void );
+static void simpleBLEDiscDone( simpleBLELink_t *pLink, uint8 status, uint8 cached );
+static void simpleBLEResetLink( simpleBLELink_t *pLink );
+static void simpleBLESendLinkEstablished( uint8 status, uint16 connHandle,
+                                          uint8 addrType, uint8 *pAddr );
+static void simpleBLESendLinkTerminated( uint16 connHandle, uint8 reason );
+static void simpleBLESendScanComplete( void );
 static bool simpleBLEFindSvcUuid( uint16 uuid, uint8 *pData, uint8 dataLen );
 static void simpleBLEAddDeviceInfo( uint8 *pAddr, uint8 addrType );
 char *bdAddr2Str ( uint8 *pAddr );
-static void NpiSerialCallback( uint8 port, uint8 events );
+
 /*********************************************************************
  * PROFILE CALLBACKS
  */
@@ -252,7 +211,9 @@ static void NpiSerialCallback( uint8 port, uint8 events );
 static const gapCentralRoleCB_t simpleBLERoleCB =
 {
   simpleBLECentralRssiCB,       // RSSI callback
-  simpleBLECentralEventCB       // Event callback
+  simpleBLECentralEventCB,      // Event callback
+  simpleBLECentralMtuCB,        // MTU callback
+  simpleBLECentralRssiMonCB     // RSSI monitor callback
 };
 
 // Bond Manager Callbacks
@@ -282,8 +243,24 @@ static const gapBondCBs_t simpleBLEBondCB =
  */
 void SimpleBLECentral_Init( uint8 task_id )
 {
+  uint8 i;
+
   simpleBLETaskId = task_id;
 
+  // Read the handle cache index
+  simpleBLEDiscInit( simpleBLETaskId );
+  simpleBLEGattInit( simpleBLETaskId );
+  simpleBLEReconInit( simpleBLETaskId );
+  simpleBLEConnInit( simpleBLETaskId );
+  ScanSched_Init( simpleBLETaskId, SBC_SCAN_SCHED_EVT, simpleBLEStartScan );
+
+  // Initialize the link table
+  for ( i = 0; i < SBC_MAX_LINKS; i++ )
+  {
+    simpleBLELinks[i].connHandle = GAP_CONNHANDLE_INIT;
+    simpleBLEResetLink( &simpleBLELinks[i] );
+  }
+
   // Setup Central Profile
   {
     uint8 scanRes = DEFAULT_MAX_SCAN_RES;
@@ -328,24 +305,8 @@ void SimpleBLECentral_Init( uint8 task_id )
   // Setup a delayed profile startup
   osal_set_event( simpleBLETaskId, START_DEVICE_EVT );
   
-  //ʼ  
-NPI_InitTransport(NpiSerialCallback);     
-    /*
-// 2    
-NPI_WriteTransport("I'm coming\r\n", 20);    
-    
-// ַ    
-NPI_PrintString("SimpleBLETest_Init2\r\n");      
-    */
-#if 0
-// һֵ10Ʊʾ    
-NPI_PrintValue("Ĵ1 = ", 168, 10);    
-NPI_PrintString("\r\n");      
-    
-// һֵ16Ʊʾ    
-NPI_PrintValue("Ĵ2 = 0x", 0x88, 16);    
-NPI_PrintString("\r\n");   
-#endif
+  // Open the host command interface
+  simpleBLECmdInit( simpleBLETaskId );
 }
 
 /*********************************************************************
@@ -395,10 +356,62 @@ uint16 SimpleBLECentral_ProcessEvent( uint8 task_id, uint16 events )
 
   if ( events & START_DISCOVERY_EVT )
   {
-    simpleBLECentralStartDiscovery( );
+    uint8 i;
+
+    // Start service discovery on every link waiting for it
+    for ( i = 0; i < SBC_MAX_LINKS; i++ )
+    {
+      if ( simpleBLELinks[i].state == BLE_STATE_CONNECTED &&
+           simpleBLELinks[i].discState == BLE_DISC_STATE_PENDING &&
+           simpleBLELinks[i].pGattActive == NULL )
+      {
+        simpleBLEConnBusy( &simpleBLELinks[i] );
+        simpleBLELinks[i].discState = simpleBLEDiscStart( &simpleBLELinks[i] );
+
+        if ( simpleBLELinks[i].discState == BLE_DISC_STATE_IDLE )
+        {
+          simpleBLEDiscDone( &simpleBLELinks[i], FAILURE, FALSE );
+        }
+      }
+    }
     
     return ( events ^ START_DISCOVERY_EVT );
   }
+
+  if ( events & SBC_TX_FLUSH_EVT )
+  {
+    simpleBLECmdFlush();
+
+    return ( events ^ SBC_TX_FLUSH_EVT );
+  }
+
+  if ( events & SBC_GATT_RETRY_EVT )
+  {
+    simpleBLEGattRetry();
+
+    return ( events ^ SBC_GATT_RETRY_EVT );
+  }
+
+  if ( events & SBC_RECON_EVT )
+  {
+    simpleBLEReconProcess();
+
+    return ( events ^ SBC_RECON_EVT );
+  }
+
+  if ( events & SBC_CONN_IDLE_EVT )
+  {
+    simpleBLEConnIdleCheck();
+
+    return ( events ^ SBC_CONN_IDLE_EVT );
+  }
+
+  if ( events & SBC_SCAN_SCHED_EVT )
+  {
+    ScanSched_ProcessEvent();
+
+    return ( events ^ SBC_SCAN_SCHED_EVT );
+  }
   
   // Discard unknown events
   return 0;
@@ -442,12 +455,14 @@ static void simpleBLECentral_ProcessOSALMsg( osal_event_hdr_t *pMsg )
 uint8 gStatus;
 static void simpleBLECentral_HandleKeys( uint8 shift, uint8 keys )
 {
+  simpleBLELink_t *pLink = simpleBLEFindLink( simpleBLEConnHandle );
+
   (void)shift;  // Intentionally unreferenced parameter
 return;
   if ( keys & HAL_KEY_UP )
   {
     // Start or stop discovery
-    if ( simpleBLEState != BLE_STATE_CONNECTED )
+    if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
     {
       if ( !simpleBLEScanning )
       {
@@ -466,49 +481,27 @@ return;
         GAPCentralRole_CancelDiscovery();
       }
     }
-    else if ( simpleBLEState == BLE_STATE_CONNECTED &&
-              simpleBLECharHdl != 0 &&
-              simpleBLEProcedureInProgress == FALSE )
+    else if ( pLink->charHdl != 0 )
     {
       uint8 status;
       
-      // Do a read or write as long as no other read or write is in progress
+      // Queue a read or a write, they are issued one at a time
       if ( simpleBLEDoWrite )
       {
-        // Do a write
-        attWriteReq_t req;
-        
-        req.pValue = GATT_bm_alloc( simpleBLEConnHandle, ATT_WRITE_REQ, 1, NULL );
-        if ( req.pValue != NULL )
+        status = simpleBLEGattQueue( pLink, SBC_GATT_OP_WRITE, 0, pLink->charHdl, 0,
+                                     &simpleBLECharVal, 1 );
+        if ( status == SUCCESS )
         {
-          req.handle = simpleBLECharHdl;
-          req.len = 1;
-          req.pValue[0] = simpleBLECharVal;
-          req.sig = 0;
-          req.cmd = 0;
-          status = GATT_WriteCharValue( simpleBLEConnHandle, &req, simpleBLETaskId );
-          if ( status != SUCCESS )
-          {
-            GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_REQ );
-          }
-        }
-        else
-        {
-          status = bleMemAllocError;
+          simpleBLECharVal++;
         }
       }
       else
       {
-        // Do a read
-        attReadReq_t req;
-        
-        req.handle = simpleBLECharHdl;
-        status = GATT_ReadCharValue( simpleBLEConnHandle, &req, simpleBLETaskId );
+        status = simpleBLEGattQueue( pLink, SBC_GATT_OP_READ, 0, pLink->charHdl, 0, NULL, 0 );
       }
       
       if ( status == SUCCESS )
       {
-        simpleBLEProcedureInProgress = TRUE;
         simpleBLEDoWrite = !simpleBLEDoWrite;
       }
     }    
@@ -526,8 +519,6 @@ return;
           simpleBLEScanIdx = 0;
         }
         //
-        //NPI_PrintValue("device \r\n", simpleBLEScanIdx + 1, 10);
-        NPI_PrintString("bdAddr2Str( simpleBLEDevList[simpleBLEScanIdx].addr\r\n");
        /* LCD_WRITE_STRING_VALUE( "Device", simpleBLEScanIdx + 1,
                                 10, HAL_LCD_LINE_1 );
         LCD_WRITE_STRING( bdAddr2Str( simpleBLEDevList[simpleBLEScanIdx].addr ),
@@ -538,67 +529,53 @@ return;
   if ( keys & HAL_KEY_RIGHT )
   {
     // Connection update
-    if ( simpleBLEState == BLE_STATE_CONNECTED )
+    if ( pLink != NULL && pLink->state == BLE_STATE_CONNECTED )
     {
-      GAPCentralRole_UpdateLink( simpleBLEConnHandle,
-                                 DEFAULT_UPDATE_MIN_CONN_INTERVAL,
-                                 DEFAULT_UPDATE_MAX_CONN_INTERVAL,
-                                 DEFAULT_UPDATE_SLAVE_LATENCY,
-                                 DEFAULT_UPDATE_CONN_TIMEOUT );
+      VOID simpleBLEConnSetProfile( pLink, SBC_CONN_PROFILE_LOW_POWER, FALSE );
     }
   }
   
   if ( keys & HAL_KEY_CENTER )
   {
-    uint8 addrType;
-    uint8 *peerAddr;
-    
-    // Connect or disconnect
-    if ( simpleBLEState == BLE_STATE_IDLE )
+    // Connect, cancel the pending connect or disconnect
+    if ( simpleBLEConnecting )
     {
-      // if there is a scan result
-      if ( simpleBLEScanRes > 0 )
-      {
-        // connect to current device in scan result
-        peerAddr = simpleBLEDevList[simpleBLEScanIdx].addr;
-        addrType = simpleBLEDevList[simpleBLEScanIdx].addrType;
+      gStatus = simpleBLEDisconnect( GAP_CONNHANDLE_INIT );
       
-        simpleBLEState = BLE_STATE_CONNECTING;
-        
-        GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE,
-                                      DEFAULT_LINK_WHITE_LIST,
-                                      addrType, peerAddr );
-  
-        LCD_WRITE_STRING( "Connecting", HAL_LCD_LINE_1 );
-        LCD_WRITE_STRING( bdAddr2Str( peerAddr ), HAL_LCD_LINE_2 ); 
-      }
+      LCD_WRITE_STRING( "Disconnecting", HAL_LCD_LINE_1 ); 
     }
-    else if ( simpleBLEState == BLE_STATE_CONNECTING ||
-              simpleBLEState == BLE_STATE_CONNECTED )
+    else if ( pLink != NULL && pLink->state == BLE_STATE_CONNECTED )
     {
-      // disconnect
-      simpleBLEState = BLE_STATE_DISCONNECTING;
-
-      gStatus = GAPCentralRole_TerminateLink( simpleBLEConnHandle );
+      gStatus = simpleBLEDisconnect( pLink->connHandle );
       
       LCD_WRITE_STRING( "Disconnecting", HAL_LCD_LINE_1 ); 
     }
+    else if ( simpleBLEScanRes > 0 )
+    {
+      // connect to current device in scan result
+      if ( simpleBLEConnect( simpleBLEDevList[simpleBLEScanIdx].addrType,
+                             simpleBLEDevList[simpleBLEScanIdx].addr ) == SUCCESS )
+      {
+        LCD_WRITE_STRING( "Connecting", HAL_LCD_LINE_1 );
+        LCD_WRITE_STRING( bdAddr2Str( simpleBLEDevList[simpleBLEScanIdx].addr ), HAL_LCD_LINE_2 ); 
+      }
+    }
   }
   
   if ( keys & HAL_KEY_DOWN )
   {
     // Start or cancel RSSI polling
-    if ( simpleBLEState == BLE_STATE_CONNECTED )
+    if ( pLink != NULL && pLink->state == BLE_STATE_CONNECTED )
     {
-      if ( !simpleBLERssi )
+      if ( !pLink->rssiPolling )
       {
-        simpleBLERssi = TRUE;
-        GAPCentralRole_StartRssi( simpleBLEConnHandle, DEFAULT_RSSI_PERIOD );
+        pLink->rssiPolling = TRUE;
+        GAPCentralRole_StartRssi( pLink->connHandle, DEFAULT_RSSI_PERIOD );
       }
       else
       {
-        simpleBLERssi = FALSE;
-        GAPCentralRole_CancelRssi( simpleBLEConnHandle );
+        pLink->rssiPolling = FALSE;
+        GAPCentralRole_CancelRssi( pLink->connHandle );
         
         LCD_WRITE_STRING( "RSSI Cancelled", HAL_LCD_LINE_1 );
       }
@@ -615,127 +592,55 @@ return;
  */
 static void simpleBLECentralProcessGATTMsg( gattMsgEvent_t *pMsg )
 {
-  if ( simpleBLEState != BLE_STATE_CONNECTED )
+  simpleBLELink_t *pLink = simpleBLEFindLink( pMsg->connHandle );
+  
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
   {
     // In case a GATT message came after a connection has dropped,
     // ignore the message
+    GATT_bm_free( &pMsg->msg, pMsg->method );
     return;
   }
   
   
-  if ( ( pMsg->method == ATT_READ_RSP ) ||
-       ( ( pMsg->method == ATT_ERROR_RSP ) &&
-         ( pMsg->msg.errorRsp.reqOpcode == ATT_READ_REQ ) ) )
+  if ( ( pMsg->method == ATT_HANDLE_VALUE_NOTI ) ||
+            ( pMsg->method == ATT_HANDLE_VALUE_IND ) )
   {
-    if ( pMsg->method == ATT_ERROR_RSP )
-    {
-      uint8 status = pMsg->msg.errorRsp.errCode;
-      
-      LCD_WRITE_STRING_VALUE( "Read Error", status, 10, HAL_LCD_LINE_1 );
-    }
-    else
-    {
-      // After a successful read, display the read value
-      uint8 valueRead = pMsg->msg.readRsp.pValue[0];
+    // Forward the value to the host, tagged with the link it came from.
+    // It is framed into the UART ring directly from the message, which
+    // is freed below once handling is done.
+    simpleBLECmdSendNotification( pMsg->connHandle, &pMsg->msg.handleValueNoti );
+    simpleBLEStatsPhase( pLink, SBC_STATS_PHASE_NOTI );
 
-      LCD_WRITE_STRING_VALUE( "Read rsp:", valueRead, 10, HAL_LCD_LINE_1 );
-    }
-    
-    simpleBLEProcedureInProgress = FALSE;
-  }
-  else if(pMsg->method == ATT_READ_BY_GRP_TYPE_RSP)
-  {
-    uint8 handle[30];
-    attReadByGrpTypeRsp_t readByGrpTypeRsp;
-      readByGrpTypeRsp.numGrps = pMsg->msg.readByGrpTypeRsp.numGrps;
-      memcpy(handle,pMsg->msg.readByGrpTypeRsp.pDataList,pMsg->msg.readByGrpTypeRsp.len);//pMsg->msg.readByGrpTypeRsp.len
-      simpleBLESvcStartHdl = pMsg->msg.findByTypeValueRsp.pHandlesInfo[0];
-       simpleBLESvcEndHdl = pMsg->msg.findByTypeValueRsp.pHandlesInfo[1];
-    if(pMsg->msg.readByGrpTypeRsp.len > 0)
+    if ( pMsg->method == ATT_HANDLE_VALUE_IND )
     {
-      NPI_PrintString("svc: ");
-     for(uint8 i = 0;i< pMsg->msg.readByGrpTypeRsp.len;i++)
-     {
-      NPI_PrintValue(" ",handle[i],16);
-     }
-     NPI_PrintString("\r\n");
-    }
-      GATT_DiscAllChars( simpleBLEConnHandle, 0x0010,
-                                        0x002C, simpleBLETaskId );
-    // HalUARTWrite( NPI_UART_PORT, handle, pMsg->msg.readByGrpTypeRsp.len );
-  }
-  else if(pMsg->method == ATT_READ_BY_TYPE_RSP && pMsg->msg.readByTypeRsp.numPairs >0)
-  {
-     uint8 handle[20];
-    NPI_PrintString("CharacterUUID ");
-     memcpy(handle,pMsg->msg.readByGrpTypeRsp.pDataList,pMsg->msg.readByGrpTypeRsp.len);//pMsg->msg.readByGrpTypeRsp.len
-     for(uint8 i = 0;i< pMsg->msg.readByGrpTypeRsp.len;i++)
-     {
-      NPI_PrintValue(" ",handle[i],16);
-     }
-   // pMsg->msg.readByTypeRsp.pDataList 
-    NPI_PrintString("\r\n");
-  }
-  else if( ( pMsg->method == ATT_HANDLE_VALUE_NOTI)||
-           ( pMsg->method == ATT_ERROR_RSP ) ||
-           (pMsg->method == ATT_HANDLE_VALUE_IND))
-  {
-      volatile attHandleValueNoti_t noti;
+      ATT_HandleValueCfm( pMsg->connHandle );
 
-    if ( pMsg->method == ATT_ERROR_RSP )
-    {
-      uint8 status = pMsg->msg.errorRsp.errCode;
-      
-    }
-    else
-    {
-      static uint8 notifyData[20];
-      static uint8 handlestr[2];
-      
-      // After a successful read, display the read value
-      //uint8 valueRead = pMsg->msg.readRsp.value[0];
-      noti.handle = pMsg->msg.handleValueNoti.handle;
-      noti.len = pMsg->msg.handleValueNoti.len;
-      osal_memcpy(notifyData, pMsg->msg.handleValueNoti.pValue,noti.len);
-      NPI_PrintString("handle ");
-      _ltoa(noti.handle,handlestr,16);
-      NPI_PrintString(handlestr);
-       NPI_PrintString("  ");
-      for(uint8 i = 0;i< 20;i++)
+      // The peer's database changed, drop the cache and rediscover
+      if ( pLink->cache.svcChangedHdl != 0 &&
+           pMsg->msg.handleValueInd.handle == pLink->cache.svcChangedHdl &&
+           pLink->discState == BLE_DISC_STATE_IDLE )
       {
-       NPI_PrintValue("0x",(uint16)*(notifyData+i),16);
-      // sprintf(handlestr,"0x%X ",*(notifyData+i));
-       NPI_PrintString(" ");
+        simpleBLECacheInvalidate( pLink );
+
+        pLink->discState = BLE_DISC_STATE_PENDING;
+        osal_start_timerEx( simpleBLETaskId, START_DISCOVERY_EVT, DEFAULT_SVC_DISCOVERY_DELAY );
       }
-    //  HalUARTWrite( NPI_UART_PORT, notifyData, noti.len );
-      //NPI_PrintString(handlestr);
-      NPI_PrintString("  \r\n");
- //NPI_PrintString("notify\r\n");
     }
   }
-  else if ( ( pMsg->method == ATT_WRITE_RSP ) ||
-       ( ( pMsg->method == ATT_ERROR_RSP ) &&
-         ( pMsg->msg.errorRsp.reqOpcode == ATT_WRITE_REQ ) ) )
+  else if ( pLink->pGattActive != NULL )
   {
-    
-    if ( pMsg->method == ATT_ERROR_RSP == ATT_ERROR_RSP )
-    {
-      uint8 status = pMsg->msg.errorRsp.errCode;
-      
-      LCD_WRITE_STRING_VALUE( "Write Error", status, 10, HAL_LCD_LINE_1 );
-    }
-    else
-    {
-      // After a succesful write, display the value that was written and increment value
-      LCD_WRITE_STRING_VALUE( "Write sent:", simpleBLECharVal++, 10, HAL_LCD_LINE_1 );      
-    }
-    
-    simpleBLEProcedureInProgress = FALSE;    
-
+    // Response to a queued read or write
+    simpleBLEGattMsg( pLink, pMsg );
   }
-  else if ( simpleBLEDiscState != BLE_DISC_STATE_IDLE )
+  else if ( pLink->discState != BLE_DISC_STATE_IDLE )
   {
-    simpleBLEGATTDiscoveryEvent( pMsg );
+    pLink->discState = simpleBLEDiscGattMsg( pLink, pMsg );
+
+    if ( pLink->discState == BLE_DISC_STATE_IDLE )
+    {
+      simpleBLEDiscDone( pLink, pLink->discTruncated ? bleNoResources : SUCCESS, FALSE );
+    }
   }
   
   GATT_bm_free( &pMsg->msg, pMsg->method );
@@ -753,7 +658,71 @@ static void simpleBLECentralProcessGATTMsg( gattMsgEvent_t *pMsg )
  */
 static void simpleBLECentralRssiCB( uint16 connHandle, int8 rssi )
 {
-    LCD_WRITE_STRING_VALUE( "RSSI -dB:", (uint8) (-rssi), 10, HAL_LCD_LINE_1 );
+  simpleBLELink_t *pLink = simpleBLEFindLink( connHandle );
+
+  if ( pLink != NULL )
+  {
+    pLink->rssi = rssi;
+  }
+
+  LCD_WRITE_STRING_VALUE( "RSSI -dB:", (uint8) (-rssi), 10, HAL_LCD_LINE_1 );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECentralRssiMonCB
+ *
+ * @brief   RSSI monitor callback. Forward the statistics to the host.
+ *
+ * @param   connHandle - connection handle
+ * @param   reason - periodic report or threshold crossing
+ * @param   pStats - RSSI statistics
+ *
+ * @return  none
+ */
+static void simpleBLECentralRssiMonCB( uint16 connHandle, uint8 reason,
+                                       gapCentralRoleRssiStats_t *pStats )
+{
+  simpleBLELink_t *pLink = simpleBLEFindLink( connHandle );
+  uint8 buf[9];
+
+  if ( pLink == NULL )
+  {
+    return;
+  }
+
+  pLink->rssi = pStats->last;
+
+  buf[0] = LO_UINT16( connHandle );
+  buf[1] = HI_UINT16( connHandle );
+  buf[2] = reason;
+  buf[3] = pStats->numSamples;
+  buf[4] = (uint8)pStats->last;
+  buf[5] = (uint8)pStats->min;
+  buf[6] = (uint8)pStats->max;
+  buf[7] = (uint8)pStats->mean;
+  buf[8] = (uint8)pStats->ewma;
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_RSSI, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECentralMtuCB
+ *
+ * @brief   MTU callback. Called when either side exchanged the MTU.
+ *
+ * @param   connHandle - connection handle
+ * @param   mtu - new ATT MTU
+ *
+ * @return  none
+ */
+static void simpleBLECentralMtuCB( uint16 connHandle, uint16 mtu )
+{
+  simpleBLELink_t *pLink = simpleBLEFindLink( connHandle );
+
+  if ( pLink != NULL )
+  {
+    simpleBLELinkMtu( pLink, mtu );
+  }
 }
 
 /*********************************************************************
@@ -778,6 +747,16 @@ static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent )
 
     case GAP_DEVICE_INFO_EVENT:
       {
+        // Drop reports rejected by the host's advertisement filters
+        if ( !AdvFilter_Match( pEvent->deviceInfo.rssi, pEvent->deviceInfo.addr,
+                               pEvent->deviceInfo.pEvtData, pEvent->deviceInfo.dataLen ) )
+        {
+          break;
+        }
+
+        // Let the scan scheduler know what it is hearing
+        VOID ScanSched_Report( pEvent->deviceInfo.addr );
+
         // if filtering device discovery results based on service UUID
         if ( DEFAULT_DEV_DISC_BY_SVC_UUID == TRUE )
         {
@@ -788,6 +767,13 @@ static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent )
             simpleBLEAddDeviceInfo( pEvent->deviceInfo.addr, pEvent->deviceInfo.addrType );
           }
         }
+        else if ( AdvFilter_Active() )
+        {
+          simpleBLEAddDeviceInfo( pEvent->deviceInfo.addr, pEvent->deviceInfo.addrType );
+        }
+
+        // Forward the advertisement if streaming scan reports
+        simpleBLEScanReport( &pEvent->deviceInfo );
       }
       break;
       
@@ -796,8 +782,21 @@ static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent )
         // discovery complete
         simpleBLEScanning = FALSE;
 
-        // if not filtering device discovery results based on service UUID
-       if ( DEFAULT_DEV_DISC_BY_SVC_UUID == FALSE )
+        // The scan scheduler decides when the next window starts
+        ScanSched_WindowDone();
+
+        // In streaming mode discovery runs until the host stops it
+        if ( simpleBLEScanStreaming() )
+        {
+          if ( !ScanSched_Active() )
+          {
+            VOID simpleBLEStartScan();
+          }
+          break;
+        }
+
+        // if not filtering device discovery results
+        if ( DEFAULT_DEV_DISC_BY_SVC_UUID == FALSE && !AdvFilter_Active() )
         {
           // Copy results
           simpleBLEScanRes = pEvent->discCmpl.numDevs;
@@ -807,15 +806,8 @@ static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent )
         
         LCD_WRITE_STRING_VALUE( "Devices Found", simpleBLEScanRes,
                                 10, HAL_LCD_LINE_1 );
-          for(unsigned char i = 0;i<simpleBLEScanRes;i++)
-          {
-            NPI_PrintString("Devices ");
-          //  NPI_PrintValue("0x ",*simpleBLEDevList[i].addr,10);
-            NPI_PrintString(bdAddr2Str(simpleBLEDevList[i].addr));
-             NPI_PrintString("\r\n");
-          }
-     //   GAPCentralRole_CancelDiscovery();
-      //   NPI_PrintString("Devices Found\r\n");
+        simpleBLESendScanComplete();
+
         if ( simpleBLEScanRes > 0 )
         {
           LCD_WRITE_STRING( "<- To Select", HAL_LCD_LINE_2 );
@@ -829,52 +821,116 @@ static uint8 simpleBLECentralEventCB( gapCentralRoleEvent_t *pEvent )
 
     case GAP_LINK_ESTABLISHED_EVENT:
       {
-        if ( pEvent->gap.hdr.status == SUCCESS )
+        uint8 status = pEvent->gap.hdr.status;
+
+        simpleBLEConnecting = FALSE;
+
+        if ( status == SUCCESS &&
+             pEvent->linkCmpl.connectionHandle >= SBC_MAX_LINKS )
+        {
+          // No link table entry to run it from, so drop it again. Its
+          // termination is reported like any other.
+          VOID GAPCentralRole_TerminateLink( pEvent->linkCmpl.connectionHandle );
+          status = bleNoResources;
+        }
+
+        if ( status == SUCCESS )
         {          
-          simpleBLEState = BLE_STATE_CONNECTED;
-          simpleBLEConnHandle = pEvent->linkCmpl.connectionHandle;
-          simpleBLEProcedureInProgress = TRUE;    
+          simpleBLELink_t *pLink = &simpleBLELinks[pEvent->linkCmpl.connectionHandle];
+
+          simpleBLEResetLink( pLink );
+          pLink->connHandle = pEvent->linkCmpl.connectionHandle;
+          pLink->state = BLE_STATE_CONNECTED;
+          pLink->addrType = pEvent->linkCmpl.devAddrType;
+          osal_memcpy( pLink->addr, pEvent->linkCmpl.devAddr, B_ADDR_LEN );
+          pLink->connInterval = pEvent->linkCmpl.connInterval;
+          pLink->connLatency = pEvent->linkCmpl.connLatency;
+          pLink->connTimeout = pEvent->linkCmpl.connTimeout;
+          simpleBLEConnHandle = pLink->connHandle;
+          simpleBLEStatsLinkUp( pLink, SUCCESS );
+
+#if ( SBC_ATT_MTU > ATT_MTU_SIZE )
+          // Ask for a larger MTU before anything else goes over the link
+          VOID simpleBLEGattQueue( pLink, SBC_GATT_OP_EXCHANGE_MTU | SBC_GATT_OP_INTERNAL,
+                                   0, 0, 0, NULL, 0 );
+#endif
+
+#if ( SBC_INFO_DEFAULT_MASK != 0 )
+          // Identify the peer while discovery is held back
+          VOID simpleBLEInfoStart( pLink, SBC_INFO_DEFAULT_MASK );
+#endif
 
-          // If service discovery not performed initiate service discovery
-          if ( simpleBLECharHdl == 0 )
+          // Use the cached handles of a known peer, otherwise
+          // initiate service discovery
+          if ( simpleBLECacheLoad( pLink ) == SUCCESS )
+          {
+            simpleBLEDiscDone( pLink, SUCCESS, TRUE );
+          }
+          else
           {
+            pLink->discState = BLE_DISC_STATE_PENDING;
             osal_start_timerEx( simpleBLETaskId, START_DISCOVERY_EVT, DEFAULT_SVC_DISCOVERY_DELAY );
           }
-           NPI_PrintString("Connected device  ");     
-          NPI_PrintString(bdAddr2Str( pEvent->linkCmpl.devAddr));
-          NPI_PrintString("\r\n");
         }
         else
         {
-          simpleBLEState = BLE_STATE_IDLE;
-          simpleBLEConnHandle = GAP_CONNHANDLE_INIT;
-          simpleBLERssi = FALSE;
-          simpleBLEDiscState = BLE_DISC_STATE_IDLE;
-          NPI_PrintString("Connected Failed");
           LCD_WRITE_STRING( "Connect Failed", HAL_LCD_LINE_1 );
-          LCD_WRITE_STRING_VALUE( "Reason:", pEvent->gap.hdr.status, 10, HAL_LCD_LINE_2 );
+          LCD_WRITE_STRING_VALUE( "Reason:", status, 10, HAL_LCD_LINE_2 );
+
+          simpleBLEStatsLinkUp( NULL, status );
         }
+
+        simpleBLESendLinkEstablished( status,
+                                      pEvent->linkCmpl.connectionHandle,
+                                      pEvent->linkCmpl.devAddrType,
+                                      pEvent->linkCmpl.devAddr );
+
+        simpleBLEReconLinkUp( status, pEvent->linkCmpl.devAddr );
       }
       break;
 
     case GAP_LINK_TERMINATED_EVENT:
       {
-        simpleBLEState = BLE_STATE_IDLE;
-        simpleBLEConnHandle = GAP_CONNHANDLE_INIT;
-        simpleBLERssi = FALSE;
-        simpleBLEDiscState = BLE_DISC_STATE_IDLE;
-        simpleBLECharHdl = 0;
-        simpleBLEProcedureInProgress = FALSE;
-        NPI_PrintString("disconnected\r\n");  
-     /*   LCD_WRITE_STRING( "Disconnected", HAL_LCD_LINE_1 );
-        LCD_WRITE_STRING_VALUE( "Reason:", pEvent->linkTerminate.reason,
-                                10, HAL_LCD_LINE_2 );*/
-    //    SystemResetSoft();
+        simpleBLELink_t *pLink = simpleBLEFindLink( pEvent->linkTerminate.connectionHandle );
+
+        simpleBLEStatsLinkDown( pLink, pEvent->linkTerminate.reason );
+
+        if ( pLink != NULL )
+        {
+          simpleBLEGattFlush( pLink, bleNotConnected );
+          pLink->connHandle = GAP_CONNHANDLE_INIT;
+          simpleBLEResetLink( pLink );
+        }
+
+        if ( simpleBLEConnHandle == pEvent->linkTerminate.connectionHandle )
+        {
+          simpleBLEConnHandle = GAP_CONNHANDLE_INIT;
+        }
+
+        simpleBLESendLinkTerminated( pEvent->linkTerminate.connectionHandle,
+                                     pEvent->linkTerminate.reason );
+
+        // Reconnect if the peer is a supervised target
+        if ( pLink != NULL )
+        {
+          simpleBLEReconLinkDown( pLink->addr );
+        }
       }
       break;
 
     case GAP_LINK_PARAM_UPDATE_EVENT:
       {
+        simpleBLELink_t *pLink = simpleBLEFindLink( pEvent->linkUpdate.connectionHandle );
+
+        if ( pLink != NULL )
+        {
+          // Report what the controller settled on
+          simpleBLEConnUpdated( pLink, pEvent->gap.hdr.status,
+                                pEvent->linkUpdate.connInterval,
+                                pEvent->linkUpdate.connLatency,
+                                pEvent->linkUpdate.connTimeout );
+        }
+
         LCD_WRITE_STRING( "Param Update", HAL_LCD_LINE_1 );
       }
       break;
@@ -917,6 +973,18 @@ static void simpleBLECentralPairStateCB( uint16 connHandle, uint8 state, uint8 s
       LCD_WRITE_STRING( "Bonding success", HAL_LCD_LINE_1 );
     }
   }
+  else if ( state == GAPBOND_PAIRING_STATE_BOND_SAVED )
+  {
+    simpleBLELink_t *pLink = simpleBLEFindLink( connHandle );
+
+    // Discovery that finished before the bond was saved was not
+    // cached, as only bonded peers are
+    if ( status == SUCCESS && pLink != NULL &&
+         pLink->discState == BLE_DISC_STATE_IDLE && pLink->cache.numChars > 0 )
+    {
+      simpleBLECacheSave( pLink );
+    }
+  }
 }
 
 /*********************************************************************
@@ -950,95 +1018,6 @@ static void simpleBLECentralPasscodeCB( uint8 *deviceAddr, uint16 connectionHand
 #endif
 }
 
-/*********************************************************************
- * @fn      simpleBLECentralStartDiscovery
- *
- * @brief   Start service discovery.
- *
- * @return  none
- */
-static void simpleBLECentralStartDiscovery( void )
-{
-  /*uint8 uuid[ATT_BT_UUID_SIZE] = { LO_UINT16(SIMPLEPROFILE_SERV_UUID),
-                                   HI_UINT16(SIMPLEPROFILE_SERV_UUID) };*/
- 
-  // Initialize cached handles
-  simpleBLESvcStartHdl = simpleBLESvcEndHdl = simpleBLECharHdl = 0;
-
-  simpleBLEDiscState = BLE_DISC_STATE_SVC;
- // GATT_DiscAllChars(simpleBLEConnHandle,14,20,simpleBLETaskId);
-  // Discovery simple BLE service
- /* GATT_DiscPrimaryServiceByUUID( simpleBLEConnHandle,
-                                 uuid,
-                                 ATT_UUID_SIZE,
-                                 simpleBLETaskId );*/
-  
-  GATT_DiscAllPrimaryServices(simpleBLEConnHandle,simpleBLETaskId);
-}
-
-/*********************************************************************
- * @fn      simpleBLEGATTDiscoveryEvent
- *
- * @brief   Process GATT discovery event
- *
- * @return  none
- */
-static void simpleBLEGATTDiscoveryEvent( gattMsgEvent_t *pMsg )
-{
-  attReadByTypeReq_t req;
-  
-  if ( simpleBLEDiscState == BLE_DISC_STATE_SVC )
-  {
-    // Service found, store handles
-    if ( pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP &&
-         pMsg->msg.findByTypeValueRsp.numInfo > 0 )
-    {
-      simpleBLESvcStartHdl = ATT_ATTR_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
-      simpleBLESvcEndHdl = ATT_GRP_END_HANDLE(pMsg->msg.findByTypeValueRsp.pHandlesInfo, 0);
-    }
-    
-    // If procedure complete
-    if ( ( pMsg->method == ATT_FIND_BY_TYPE_VALUE_RSP  && 
-           pMsg->hdr.status == bleProcedureComplete ) ||
-         ( pMsg->method == ATT_ERROR_RSP ) )
-    {
-      if ( simpleBLESvcStartHdl != 0 )
-      {
-        // Discover characteristic
-        simpleBLEDiscState = BLE_DISC_STATE_CHAR;
-        
-        req.startHandle = simpleBLESvcStartHdl;
-        req.endHandle = simpleBLESvcEndHdl;
-        req.type.len = ATT_UUID_SIZE;
-        uint8 uuid_t[16] = {0x8b, 0xb9, 0xb1, 0xcd, 0x90, 0x4c, 0x4d, 0xe3, 0xbb, 0x7b, 0xbb, 0x27, 0xb2, 0x2e, 0xdd, 0xe6};
-        memcpy(req.type.uuid,uuid_t,16);
-     //   req.type.uuid ={0x8b, 0xb9, 0xb1, 0xcd, 0x90, 0x4c, 0x4d, 0xe3, 0xbb, 0x7b, 0xbb, 0x27, 0xb2, 0x2e, 0xdd, 0xe6};
-       // req.type.uuid[1] = HI_UINT16(SIMPLEPROFILE_CHAR1_UUID);
-
-        GATT_ReadUsingCharUUID( simpleBLEConnHandle, &req, simpleBLETaskId );
-      }
-    }
-  }
-  else if ( simpleBLEDiscState == BLE_DISC_STATE_CHAR )
-  {
-    // Characteristic found, store handle
-    if ( pMsg->method == ATT_READ_BY_TYPE_RSP && 
-         pMsg->msg.readByTypeRsp.numPairs > 0 )
-    {
-      simpleBLECharHdl = BUILD_UINT16(pMsg->msg.readByTypeRsp.pDataList[0],
-                                      pMsg->msg.readByTypeRsp.pDataList[1]);
-      
-      LCD_WRITE_STRING( "Simple Svc Found", HAL_LCD_LINE_1 );
-      simpleBLEProcedureInProgress = FALSE;
-    }
-    
-    simpleBLEDiscState = BLE_DISC_STATE_IDLE;
-
-    
-  }    
-}
-
-
 /*********************************************************************
  * @fn      simpleBLEFindSvcUuid
  *
@@ -1131,6 +1110,8 @@ static void simpleBLEAddDeviceInfo( uint8 *pAddr, uint8 addrType )
     
     // Increment scan result count
     simpleBLEScanRes++;
+    
+    NPI_LOG1( SBC_LOG_SCAN_RESULT, simpleBLEScanRes );
   }
 }
 
@@ -1166,396 +1147,397 @@ char *bdAddr2Str( uint8 *pAddr )
 }
 
 /*********************************************************************
- * @fn      
+ * @fn      simpleBLEResetLink
+ *
+ * @brief   Return a link table entry to its idle state. The
+ *          connection handle is left to the caller.
  *
- * @brief   ָmacַ豸
- * @param   macAddr   macַ    
+ * @param   pLink - link to reset
  *
  * @return  none
-/**********************************************************************/
-void ConnectMac(uint8 * macAddr)
+ */
+static void simpleBLEResetLink( simpleBLELink_t *pLink )
 {
-   char *peerAddr;
-   uint8 addrType;
-                                 
-     peerAddr[5] = macAddr[0];
-     peerAddr[4] = macAddr[1];
-     peerAddr[3] = macAddr[2];
-     peerAddr[2] = macAddr[3];
-     peerAddr[1] = macAddr[4];
-     peerAddr[0] = macAddr[5];
-                                
-     addrType = 0;
-     simpleBLEState = BLE_STATE_CONNECTING;
-     NPI_PrintString("Connecting...\r\n");
-                                
-    GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE,
-                                  DEFAULT_LINK_WHITE_LIST,
-                                  addrType, peerAddr );
+  pLink->state = BLE_STATE_IDLE;
+  pLink->discState = BLE_DISC_STATE_IDLE;
+  pLink->discTruncated = FALSE;
+  pLink->charHdl = 0;
+  VOID osal_memset( &pLink->cache, 0, sizeof( simpleBLEHdlCache_t ) );
+  pLink->pGattHead = NULL;
+  pLink->pGattTail = NULL;
+  pLink->pGattActive = NULL;
+  pLink->gattQueued = 0;
+  pLink->mtu = ATT_MTU_SIZE;
+  pLink->connProfile = SBC_CONN_PROFILE_NONE;
+  pLink->connIdleProfile = SBC_CONN_DEFAULT_IDLE_PROFILE;
+  pLink->connActivity = 0;
+  pLink->rssiPolling = FALSE;
+  pLink->rssi = 0;
+  pLink->infoMask = 0;
+  pLink->pInfo = NULL;
+  pLink->infoLen = 0;
+  pLink->subMask = 0;
+  pLink->subSelected = 0;
+  pLink->subWritten = 0;
+  pLink->subMode = SBC_SUB_OFF;
+  pLink->subChar = SBC_SUB_NONE;
+  pLink->statsUpTime = 0;
+
+  // Every phase back to SBC_STATS_NONE
+  VOID osal_memset( pLink->statsPhase, 0xFF, sizeof( pLink->statsPhase ) );
 }
 
-void WriteValue(unsigned short handle,unsigned char *value,unsigned char len)
+/*********************************************************************
+ * @fn      simpleBLEDiscDone
+ *
+ * @brief   Finish discovery of a link, whether from the cache or over
+ *          the air, and report it to the host.
+ *
+ * @param   pLink - link
+ * @param   status - discovery status, bleNoResources if the handle
+ *                   table overflowed
+ * @param   cached - TRUE if the handles came from the cache
+ *
+ * @return  none
+ */
+static void simpleBLEDiscDone( simpleBLELink_t *pLink, uint8 status, uint8 cached )
 {
-  char status;
-  attWriteReq_t req;
-        
- req.pValue = GATT_bm_alloc( simpleBLEConnHandle, ATT_WRITE_REQ, len, NULL );
-  if ( req.pValue != NULL )
+  simpleBLEChar_t *pChar = simpleBLECacheFindChar( pLink, SIMPLEPROFILE_CHAR1_UUID );
+  uint8 buf[6];
+
+  pLink->discState = BLE_DISC_STATE_IDLE;
+  pLink->charHdl = ( pChar != NULL ) ? pChar->valueHdl : 0;
+
+  // The entries that fit an overflowed table are still usable
+  if ( status == SUCCESS || status == bleNoResources )
+  {
+    simpleBLEStatsPhase( pLink, SBC_STATS_PHASE_DISC );
+
+    // Hear about database changes, or the cache goes stale
+    VOID simpleBLEDiscWatchSvcChanged( pLink );
+  }
+  else
+  {
+    simpleBLEStatsFailure( SBC_STATS_FAIL_DISC, status );
+  }
+
+  if ( pLink->charHdl != 0 )
   {
-   NPI_PrintString("writing...\r\n");
-                  
-   req.handle = handle;
-   req.len = len;
-   //req.pValue[0] = 0x01;
-  // req.pValue[1] = 0x00;
-   memcpy(req.pValue,value,len);
-                  
-   req.sig = 0;
-   req.cmd = 0;
-   status = GATT_WriteCharValue( simpleBLEConnHandle, &req, simpleBLETaskId );
-   if ( status != SUCCESS )
-   {
-     GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_REQ );
-   }
-   else
-   {
-     NPI_PrintString("write ok\r\n");
-   }
+    LCD_WRITE_STRING( "Simple Svc Found", HAL_LCD_LINE_1 );
   }
+
+  buf[0] = LO_UINT16( pLink->connHandle );
+  buf[1] = HI_UINT16( pLink->connHandle );
+  buf[2] = status;
+  buf[3] = cached;
+  buf[4] = pLink->cache.numSvcs;
+  buf[5] = pLink->cache.numChars;
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_DISC_COMPLETE, buf, sizeof( buf ) );
+
+  // Issue requests queued while discovery was running
+  simpleBLEGattService( pLink );
 }
-static uint8 rxData[100];
-static void NpiSerialCallback( uint8 port, uint8 events )  
-{  
-    (void)port;//Ӹ (void)δ˱澯ȷ߻  
-  
-    if (events & (HAL_UART_RX_TIMEOUT | HAL_UART_RX_FULL))   // 
-    {  
-        static uint8 numBytes = 0;  
-  
-        numBytes = NPI_RxBufLen();           //ڻжֽ  
-        if(numBytes == 0)  
-        {  
-            return;  
-        }  
-        else  
-        {  
-          static uint8 currState = SEEK_HEAD,rxlen = 0,index = 0,rxLEN,rxTYPE;
-            //뻺buffer  
-            uint8 *buffer = osal_mem_alloc(numBytes); 
-            uint8 rxByte,escFlag = 0;
-            
-            if(buffer)  
-            {  
-                //ȡȡڻݣͷŴ     
-                NPI_ReadTransport(buffer,numBytes); 
-                static uint8 rx_len = 0;
-                memcpy(rxData + rx_len,buffer,numBytes);
-                rx_len = numBytes;
-               // NPI_WriteTransport(buffer,numBytes);
-                // printf("len2 %d\n",numBytes);
-                //uint16 index = 0;
-              //  NPI_PrintString(rxData);
-             //   NPI_PrintString("\r\n");
-              //  NPI_PrintString(buffer);
-
-                if(strncmp(rxData,"connect Mac",11) == 0)
-                {
-                  uint8 macAddr[18] = {0};
-                  static uint8 macAddrHex[6];
-                  memcpy(macAddr,rxData+ 12,17);
-                  sscanf(macAddr,"%x:%x:%x:%x:%x:%x",macAddrHex,macAddrHex+1,macAddrHex+2,macAddrHex+3,macAddrHex+4,macAddrHex+5);
-                  
-                  NPI_PrintString("connecting Mac ");
-                  NPI_PrintString(macAddr);
-                  NPI_PrintString("\r\n");
-                  rx_len = 0;
-                 memset(rxData,0,50);
-             //     GAPCentralRole_CancelDiscovery();
-                 ConnectMac(macAddrHex);
-                }
-                else if(strncmp(rxData,"disconnect",10) == 0)
-                {
-                  GAPCentralRole_TerminateLink(simpleBLEConnHandle);
-                   rx_len = 0;
-                 memset(rxData,0,50);
-                }
-                else if(strncmp(rxData,"scan device",11) == 0)
-                {
-                   NPI_PrintString("scanning...\r\n");
-                   GAPCentralRole_StartDiscovery( DEFAULT_DISCOVERY_MODE,
-                                       DEFAULT_DISCOVERY_ACTIVE_SCAN,
-                                       DEFAULT_DISCOVERY_WHITE_LIST );
-                    rx_len = 0;
-                 memset(rxData,0,50);
-                }
-                else if(strncmp(rxData,"WriteHandle",11) == 0)
-                {
-                  static unsigned short handle,len;
-                  len = strlen(rxData);
-                  len = (len - 22)/3;
-                  static unsigned char writeValue[20]={0x00};
-                  sscanf(rxData,"WriteHandle: %x Value: %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x %x",
-                         &handle,
-                         writeValue,writeValue+1,writeValue+2,writeValue+3,writeValue+4,writeValue+5,
-                         writeValue+6,writeValue+7,writeValue+8,writeValue+9,writeValue+10,writeValue+11,
-                         writeValue+12,writeValue+13,writeValue+14,writeValue+15,writeValue+16,writeValue+17,
-                         writeValue+18,writeValue+19);
-                 // sscanf(rxData+15,"WriteHandle:%d",&handle);
-                 
-                   WriteValue(handle,writeValue,len);
-                 // WriteValue(0x15,writeValue,3);
-                    rx_len = 0;
-                 memset(rxData,0,50);
-                }
-                HalLcd_HW_WaitUs(5000);
-                  osal_mem_free(buffer); 
-           // }
-#if 0
-                for(uint8 i =0;i<numBytes;i++)
-                {
-                 
-                  rxByte = *(buffer+i);
-                  if(*(buffer+i) == 0xF0)
-                  {
-                    currState = SEEK_HEAD;
-                  }
-                  switch(currState)
-                  {
-                  case SEEK_HEAD:
-                    if(rxByte == 0xF0)
-                    currState = SEEK_TYPE;
-                    break;
-             
-                  case SEEK_TYPE:
-                     currState = SEEK_LEN;
-                     rxTYPE = rxByte; 
-                     break;
-                  case SEEK_LEN:
-                    currState = RX_DATA;
-                    rxLEN = rxByte;
-                    break;
-                  case RX_DATA:
-                       if(rxlen < rxLEN)
-                       {
-                         if(rxByte == 0xF5)
-                          {
-                            escFlag = 1;
-                            continue;
-                          }
-                          if(escFlag == 1)
-                          {
-                            escFlag = 0;
-                            switch(rxByte)
-                            {
-                            case 0x01:
-                             rxData[rxlen++] = 0xF0;
-                              break;
-                            case 0x02:
-                              rxData[rxlen++] = 0xF5;
-                              break;
-                            case 0x03:
-                              rxData[rxlen++] = 0xFA;
-                              break;
-                            default:
-                              break;
-                            }
-                           }
-                           else
-                           {
-                            rxData[rxlen++] = rxByte;
-                            if(rxlen == rxLEN)
-                            {
-                               uint8 checksum = 0;
-                               for(uint8 i = 0;i< rxLEN - 1;i++)
-                               {
-                                checksum = checksum + rxData[i];
-                               }
-                               checksum = checksum + rxLEN + rxTYPE;
-                               if(checksum == rxData[rxlen -1])
-                               {
-                                switch(rxTYPE)
-                                {
-                                case 0x01://ɨ
-                                  
-                                  NPI_PrintString("scanning...\r\n");
-                                  GAPCentralRole_StartDiscovery( DEFAULT_DISCOVERY_MODE,
-                                       DEFAULT_DISCOVERY_ACTIVE_SCAN,
-                                       DEFAULT_DISCOVERY_WHITE_LIST );
-                                  break;
-                                case 0x02://
-                                  char *peerAddr;
-                                  uint8 addrType;
-                                  // connect to current device in scan result
-                                 // peerAddr = {0x5F,0x15,0x00,0x01,0x35,0xEF};
-                                /*  peerAddr[0] = 0x5F;
-                                  peerAddr[1] = 0x15;
-                                  peerAddr[2] = 0x00;
-                                  peerAddr[3] = 0x01;
-                                  peerAddr[4] = 0x35;
-                                  peerAddr[5] = 0xEF;*/
-                                  peerAddr[5] = rxData[0];
-                                  peerAddr[4] = rxData[1];
-                                  peerAddr[3] = rxData[2];
-                                  peerAddr[2] = rxData[3];
-                                  peerAddr[1] = rxData[4];
-                                  peerAddr[0] = rxData[5];
-                                     // memcpy(peerAddr,rxData,6);
-                                  addrType = 0;
-                             //   static uint8 debugDisplay[6];
-                               // memcpy(debugDisplay,peerAddr,6);
-                                  simpleBLEState = BLE_STATE_CONNECTING;
-                                  NPI_PrintString("Connecting...\r\n");
-                                
-                                //NPI_PrintString("\r\n");
-                                  GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE,
-                                                                DEFAULT_LINK_WHITE_LIST,
-                                                                addrType, peerAddr );
-                                  break;
-                                case 0x03:
-                                  GAPCentralRole_TerminateLink(simpleBLEConnHandle);
-                                  break;
-                                case 0x04:
-                                  break;
-                                default:
-                                  break;
-                                }
-                               }
-                                 
-                               rxlen = 0;
-                                 rxLEN = 0;
-                                 index = 0;
-                                currState = SEEK_HEAD;
-                                //ͷĻ  
-                                osal_mem_free(buffer); 
-                            }
-                           }
-                       }
-                       else
-                       {
-                        
-                         rxlen = 0;
-                         rxLEN = 0;
-                        currState = SEEK_HEAD;
-                        index = 0;
-                        //ͷĻ  
-              
-                       }
-                    break;
-                    
-                  }
-                   
-                }
-#endif  
- 
-#if 0
-                 if(buffer[0] == 0x55 && buffer[1] == 0xAA)
-                {
-           //       NPI_PrintString("connecting...\r\n");
-                  NPI_WriteTransport(buffer,numBytes);
-                  char *peerAddr;
-                  uint8 addrType;
-                  // connect to current device in scan result
-                 // peerAddr = {0x5F,0x15,0x00,0x01,0x35,0xEF};
-                /*  peerAddr[0] = 0x5F;
-                  peerAddr[1] = 0x15;
-                  peerAddr[2] = 0x00;
-                  peerAddr[3] = 0x01;
-                  peerAddr[4] = 0x35;
-                  peerAddr[5] = 0xEF;*/
-                  peerAddr[5] = buffer[2];
-                  peerAddr[4] = buffer[3];
-                  peerAddr[3] = buffer[4];
-                  peerAddr[2] = buffer[5];
-                  peerAddr[1] = buffer[6];
-                  peerAddr[0] = buffer[7];
-                     // memcpy(peerAddr,buffer+2,6);
-        addrType = 0;
-   //   static uint8 debugDisplay[6];
-     // memcpy(debugDisplay,peerAddr,6);
-        simpleBLEState = BLE_STATE_CONNECTING;
-     //   NPI_PrintString("connecting mac ");
-     /* for(uint8 i  = 0;i<6;i++)
-       {
-         NPI_PrintValue("%x:",peerAddr[i],16);
-       }*/
-    //   NPI_PrintString("\r\n");
-        GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE,
-                                      DEFAULT_LINK_WHITE_LIST,
-                                      addrType, peerAddr );
-        
-        
-     //   GATT_DiscAllCharDescs(simpleBLEConnHandle,12,15,simpleBLETaskId);
-                }
-#endif
-        /*        
-                if(buffer[0] == 0x03)
-                {
-                  char status;
-                   attWriteReq_t req;
-        
-                req.pValue = GATT_bm_alloc( simpleBLEConnHandle, ATT_WRITE_REQ, 3, NULL );
-                if ( req.pValue != NULL )
-                {
-                  NPI_PrintString("writing...\r\n");
-                  
-                  
-                  req.handle = 0x12;
-                  req.len = 2;
-                  req.pValue[0] = 0x01;
-                  req.pValue[1] = 0x00;
-                  
-                  req.sig = 0;
-                  req.cmd = 0;
-                  status = GATT_WriteCharValue( simpleBLEConnHandle, &req, simpleBLETaskId );
-                  
-                  if ( status != SUCCESS )
-                  {
-                    GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_REQ );
-                  }
-                  else
-                  {
-                    NPI_PrintString("write ok\r\n");
-                  }
-                
-                }
-                }
-                if(buffer[0] == 0x04)
-                {
-                  char status;
-                   attWriteReq_t req;
-        
-                req.pValue = GATT_bm_alloc( simpleBLEConnHandle, ATT_WRITE_REQ, 3, NULL );
-                if ( req.pValue != NULL )
-                {
-                  NPI_PrintString("writing...\r\n");
-                  
-              
-                  req.handle = 0x15;
-                  req.len = 3;
-                  req.pValue[0] = 0x00;
-                  req.pValue[1] = 0x07;
-                  req.pValue[2] = 0x02;
-                  req.sig = 0;
-                  req.cmd = 0;
-                  status = GATT_WriteCharValue( simpleBLEConnHandle, &req, simpleBLETaskId );
-                  if ( status != SUCCESS )
-                  {
-                    GATT_bm_free( (gattMsg_t *)&req, ATT_WRITE_REQ );
-                  }
-                  else
-                  {
-                    NPI_PrintString("write ok\r\n");
-                  } 
-                }
-               
-                    //յݷ͵-ʵֻػ   
-               // NPI_WriteTransport(buffer, numBytes); 
-              }  */
-                 
-              
-       }  
-    } 
+
+/*********************************************************************
+ * @fn      simpleBLESendLinkEstablished
+ *
+ * @brief   Report the outcome of a link establishment to the host.
+ *
+ * @param   status - link establishment status
+ * @param   connHandle - connection handle
+ * @param   addrType - peer address type
+ * @param   pAddr - peer address, least significant byte first
+ *
+ * @return  none
+ */
+static void simpleBLESendLinkEstablished( uint8 status, uint16 connHandle,
+                                          uint8 addrType, uint8 *pAddr )
+{
+  uint8 buf[4 + B_ADDR_LEN];
+  uint8 i;
+
+  buf[0] = status;
+  buf[1] = LO_UINT16( connHandle );
+  buf[2] = HI_UINT16( connHandle );
+  buf[3] = addrType;
+
+  // Address is sent most significant byte first, as in SBC_CMD_CONNECT
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    buf[4 + i] = pAddr[B_ADDR_LEN - 1 - i];
+  }
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_LINK_ESTABLISHED, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLESendLinkTerminated
+ *
+ * @brief   Report a terminated link to the host.
+ *
+ * @param   connHandle - connection handle
+ * @param   reason - termination reason
+ *
+ * @return  none
+ */
+static void simpleBLESendLinkTerminated( uint16 connHandle, uint8 reason )
+{
+  uint8 buf[3];
+
+  buf[0] = LO_UINT16( connHandle );
+  buf[1] = HI_UINT16( connHandle );
+  buf[2] = reason;
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_LINK_TERMINATED, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLESendScanComplete
+ *
+ * @brief   Report the devices found by the last discovery to the host.
+ *
+ * @return  none
+ */
+static void simpleBLESendScanComplete( void )
+{
+  uint8 buf[1 + DEFAULT_MAX_SCAN_RES * (1 + B_ADDR_LEN)];
+  uint8 *pBuf = buf;
+  uint8 i;
+  uint8 j;
+
+  *pBuf++ = simpleBLEScanRes;
+
+  for ( i = 0; i < simpleBLEScanRes; i++ )
+  {
+    *pBuf++ = simpleBLEDevList[i].addrType;
+
+    for ( j = 0; j < B_ADDR_LEN; j++ )
+    {
+      *pBuf++ = simpleBLEDevList[i].addr[B_ADDR_LEN - 1 - j];
+    }
+  }
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_SCAN_COMPLETE, buf, (uint8)(pBuf - buf) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEFindLink
+ *
+ * @brief   Look up the context of an open link.
+ *
+ * @param   connHandle - connection handle
+ *
+ * @return  pointer to the link, or NULL if there is no such link
+ */
+simpleBLELink_t *simpleBLEFindLink( uint16 connHandle )
+{
+  if ( connHandle >= SBC_MAX_LINKS ||
+       simpleBLELinks[connHandle].state == BLE_STATE_IDLE )
+  {
+    return ( NULL );
+  }
+
+  return ( &simpleBLELinks[connHandle] );
+}
+
+/*********************************************************************
+ * @fn      simpleBLELinkMtu
+ *
+ * @brief   Set the ATT MTU of a link and report a change to the host.
+ *
+ * @param   pLink - link
+ * @param   mtu - new ATT MTU
+ *
+ * @return  none
+ */
+void simpleBLELinkMtu( simpleBLELink_t *pLink, uint16 mtu )
+{
+  uint8 buf[4];
+
+  if ( mtu < ATT_MTU_SIZE || mtu == pLink->mtu )
+  {
+    return;
+  }
+
+  pLink->mtu = mtu;
+
+  buf[0] = LO_UINT16( pLink->connHandle );
+  buf[1] = HI_UINT16( pLink->connHandle );
+  buf[2] = LO_UINT16( mtu );
+  buf[3] = HI_UINT16( mtu );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_MTU_UPDATED, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLERssiMonitor
+ *
+ * @brief   Start or stop RSSI monitoring on a link. Statistics are
+ *          sent to the host every reportSamples samples and when the
+ *          average crosses a threshold.
+ *
+ * @param   connHandle - connection handle
+ * @param   period - RSSI read period in ms, 0 to stop
+ * @param   reportSamples - samples per periodic report
+ * @param   lowThresh - low RSSI threshold in dBm
+ * @param   highThresh - high RSSI threshold in dBm
+ *
+ * @return  SUCCESS, bleNotConnected or the central role status
+ */
+bStatus_t simpleBLERssiMonitor( uint16 connHandle, uint16 period, uint8 reportSamples,
+                                int8 lowThresh, int8 highThresh )
+{
+  simpleBLELink_t *pLink = simpleBLEFindLink( connHandle );
+  bStatus_t status;
+
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
+  {
+    return ( bleNotConnected );
+  }
+
+  if ( period == 0 )
+  {
+    pLink->rssiPolling = FALSE;
+
+    return ( GAPCentralRole_CancelRssi( connHandle ) );
+  }
+
+  status = GAPCentralRole_StartRssiMonitor( connHandle, period, reportSamples,
+                                            lowThresh, highThresh );
+  if ( status == SUCCESS )
+  {
+    pLink->rssiPolling = TRUE;
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStartScan
+ *
+ * @brief   Start device discovery.
+ *
+ * @return  SUCCESS if discovery started, otherwise the GAP status
+ */
+bStatus_t simpleBLEStartScan( void )
+{
+  bStatus_t status;
+
+  if ( simpleBLEScanning )
+  {
+    return ( bleAlreadyInRequestedMode );
+  }
+
+  status = GAPCentralRole_StartDiscovery( DEFAULT_DISCOVERY_MODE,
+                                          DEFAULT_DISCOVERY_ACTIVE_SCAN,
+                                          DEFAULT_DISCOVERY_WHITE_LIST );
+  if ( status == SUCCESS )
+  {
+    simpleBLEScanning = TRUE;
+    simpleBLEScanRes = 0;
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnect
+ *
+ * @brief   Establish a link to a peer device. Only one link can be
+ *          in the process of being established at a time.
+ *
+ * @param   addrType - peer address type
+ * @param   pAddr - peer address, least significant byte first, or
+ *                  NULL to connect to any device in the white list
+ *
+ * @return  SUCCESS if link establishment started, otherwise error status
+ */
+bStatus_t simpleBLEConnect( uint8 addrType, uint8 *pAddr )
+{
+  uint8 anyAddr[B_ADDR_LEN] = { 0 };
+  bStatus_t status;
+
+  if ( simpleBLEConnecting )
+  {
+    return ( bleIncorrectMode );
+  }
+
+  if ( pAddr == NULL )
+  {
+    // The peer address is ignored when the white list is used
+    status = GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE, TRUE,
+                                           addrType, anyAddr );
+  }
+  else
+  {
+    status = GAPCentralRole_EstablishLink( DEFAULT_LINK_HIGH_DUTY_CYCLE,
+                                           DEFAULT_LINK_WHITE_LIST,
+                                           addrType, pAddr );
+  }
+  if ( status == SUCCESS )
+  {
+    simpleBLEConnecting = TRUE;
+    simpleBLEStatsConnect();
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDisconnect
+ *
+ * @brief   Terminate a link or cancel a pending connection.
+ *
+ * @param   connHandle - connection handle, or GAP_CONNHANDLE_INIT to
+ *                       cancel the pending connection
+ *
+ * @return  SUCCESS if termination started, otherwise error status
+ */
+bStatus_t simpleBLEDisconnect( uint16 connHandle )
+{
+  simpleBLELink_t *pLink;
+
+  if ( connHandle == GAP_CONNHANDLE_INIT )
+  {
+    if ( !simpleBLEConnecting )
+    {
+      return ( bleIncorrectMode );
+    }
+  }
+  else
+  {
+    pLink = simpleBLEFindLink( connHandle );
+    if ( pLink == NULL )
+    {
+      return ( bleNotConnected );
     }
-}  
+
+    pLink->state = BLE_STATE_DISCONNECTING;
+  }
+
+  return ( GAPCentralRole_TerminateLink( connHandle ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEWriteValue
+ *
+ * @brief   Queue a characteristic write on a link. The write is
+ *          reported to the host with SBC_EVT_GATT_COMPLETE and
+ *          request id 0 once the peer responds.
+ *
+ * @param   connHandle - connection handle
+ * @param   handle - attribute handle
+ * @param   pValue - value to write
+ * @param   len - value length
+ *
+ * @return  SUCCESS if the write was queued, otherwise error status
+ */
+bStatus_t simpleBLEWriteValue( uint16 connHandle, uint16 handle, uint8 *pValue, uint8 len )
+{
+  return ( simpleBLEGattQueue( simpleBLEFindLink( connHandle ), SBC_GATT_OP_WRITE, 0,
+                               handle, 0, pValue, len ) );
+}
+
 /*********************************************************************
-*********************************************************************/
+*********************************************************************/
\ No newline at end of file
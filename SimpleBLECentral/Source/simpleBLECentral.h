@@ -66,6 +66,284 @@ extern "C"
 // Simple BLE Central Task Events
 #define START_DEVICE_EVT                              0x0001
 #define START_DISCOVERY_EVT                           0x0002
+#define SBC_TX_FLUSH_EVT                              0x0004
+#define SBC_GATT_RETRY_EVT                            0x0008
+#define SBC_RECON_EVT                                 0x0010
+#define SBC_CONN_IDLE_EVT                             0x0020
+#define SBC_SCAN_SCHED_EVT                            0x0040
+
+// Maximum number of simultaneous links
+#if !defined( SBC_MAX_LINKS )
+#define SBC_MAX_LINKS                                 MAX_NUM_LL_CONN
+#endif
+
+// Link states
+enum
+{
+  BLE_STATE_IDLE,
+  BLE_STATE_CONNECTING,
+  BLE_STATE_CONNECTED,
+  BLE_STATE_DISCONNECTING
+};
+
+// Discovery states
+enum
+{
+  BLE_DISC_STATE_IDLE,                // Idle
+  BLE_DISC_STATE_PENDING,             // Waiting for discovery to start
+  BLE_DISC_STATE_SVC,                 // Service discovery
+  BLE_DISC_STATE_CHAR,                // Characteristic discovery
+  BLE_DISC_STATE_DESC                 // Descriptor (CCCD) discovery
+};
+
+// Handle cache size per peer. A peer with more services or
+// characteristics is reported with status bleNoResources and is not
+// cached, so it is discovered again on every connection.
+#if !defined( SBC_CACHE_MAX_SVCS )
+#define SBC_CACHE_MAX_SVCS                            8
+#endif
+
+#if !defined( SBC_CACHE_MAX_CHARS )
+#define SBC_CACHE_MAX_CHARS                           20
+#endif
+
+// Number of peers whose handle cache is kept in SNV. Each peer takes
+// one NV item starting at SBC_NVID_CACHE_START.
+#if !defined( SBC_CACHE_NV_PEERS )
+#define SBC_CACHE_NV_PEERS                            4
+#endif
+
+#define SBC_NVID_CACHE_START                          BLE_NVID_CUST_START
+
+// ATT MTU offered to each peer on connect. The stack caps it at
+// ATT_MAX_MTU_SIZE, MAX_PDU_SIZE less the L2CAP header. MAX_PDU_SIZE
+// defaults to 27, which leaves the link at 23 and compiles the exchange
+// out, so the project's buildConfig.cfg raises it. No larger than 253,
+// so that a notification with its header fits a frame.
+#if !defined( SBC_ATT_MTU )
+#define SBC_ATT_MTU                                   ATT_MAX_MTU_SIZE
+#endif
+
+// Longest attribute value that can be written with a long write
+#define SBC_GATT_MAX_VALUE_LEN                        512
+
+// Maximum number of GATT requests queued per link, including the one
+// in progress
+#if !defined( SBC_GATT_QUEUE_DEPTH )
+#define SBC_GATT_QUEUE_DEPTH                          8
+#endif
+
+// Number of peers the reconnect supervisor keeps connected
+#if !defined( SBC_RECON_MAX_TARGETS )
+#define SBC_RECON_MAX_TARGETS                         4
+#endif
+
+// Reconnect backoff limits in ms. The backoff doubles after each failed
+// attempt and is jittered by up to 25% either way.
+#if !defined( SBC_RECON_MIN_DELAY )
+#define SBC_RECON_MIN_DELAY                           250
+#endif
+
+#if !defined( SBC_RECON_MAX_DELAY )
+#define SBC_RECON_MAX_DELAY                           30000
+#endif
+
+// Time in ms a reconnect attempt may run before it counts as failed
+#if !defined( SBC_RECON_WINDOW )
+#define SBC_RECON_WINDOW                              10000
+#endif
+
+// Reconnect supervisor states
+#define SBC_RECON_IDLE                                0x00  // No target is down
+#define SBC_RECON_WAITING                             0x01  // Waiting to retry
+#define SBC_RECON_INITIATING                          0x02  // Connection attempt running
+#define SBC_RECON_CANCELING                           0x03  // Attempt being canceled
+
+// Connection parameter profiles
+#define SBC_CONN_PROFILE_NONE                         0x00  // No profile requested yet
+#define SBC_CONN_PROFILE_BULK                         0x01  // Short interval for discovery and transfers
+#define SBC_CONN_PROFILE_LOW_LATENCY                  0x02  // Shortest interval
+#define SBC_CONN_PROFILE_LOW_POWER                    0x03  // Long interval
+
+// Profile a link returns to when idle, SBC_CONN_PROFILE_NONE to leave
+// the parameters alone unless the host picks a profile
+#if !defined( SBC_CONN_DEFAULT_IDLE_PROFILE )
+#define SBC_CONN_DEFAULT_IDLE_PROFILE                 SBC_CONN_PROFILE_LOW_POWER
+#endif
+
+// Time in ms without GATT activity before a link counts as idle
+#if !defined( SBC_CONN_IDLE_DELAY )
+#define SBC_CONN_IDLE_DELAY                           2000
+#endif
+
+// GATT request operations
+#define SBC_GATT_OP_READ                              0x01  // Read
+#define SBC_GATT_OP_WRITE                             0x02  // Write with response
+#define SBC_GATT_OP_WRITE_NO_RSP                      0x03  // Write command
+#define SBC_GATT_OP_READ_LONG                         0x04  // Read blob from offset
+#define SBC_GATT_OP_WRITE_LONG                        0x05  // Prepare and execute write at offset
+#define SBC_GATT_OP_READ_MULTI                        0x06  // Read multiple
+#define SBC_GATT_OP_PREPARE_WRITE                     0x07  // Prepare write at offset
+#define SBC_GATT_OP_EXECUTE_WRITE                     0x08  // Execute write, data: flags
+#define SBC_GATT_OP_EXCHANGE_MTU                      0x09  // Exchange MTU, sent on connect
+#define SBC_GATT_OP_READ_BY_TYPE                      0x0A  // Read by type over every handle, handle: 16-bit UUID
+
+// Set on requests the central queues for itself: the MTU exchange, the
+// device info reads and the subscribe writes. Their values and
+// completion stay in the central instead of going to the host.
+#define SBC_GATT_OP_INTERNAL                          0x80
+
+// Id of the internal write turning on Service Changed indications
+#define SBC_GATT_ID_SVC_CHANGED                       0xFF
+
+// Device info items, read back to back on a new link and reported
+// together in one SBC_EVT_DEV_INFO. A mask has bit n set for item n.
+#define SBC_INFO_DEVICE_NAME                          0x00  // GAP device name
+#define SBC_INFO_APPEARANCE                           0x01  // GAP appearance
+#define SBC_INFO_MANUFACTURER                         0x02  // Manufacturer name string
+#define SBC_INFO_MODEL                                0x03  // Model number string
+#define SBC_INFO_SERIAL                               0x04  // Serial number string
+#define SBC_INFO_HW_REV                               0x05  // Hardware revision string
+#define SBC_INFO_FW_REV                               0x06  // Firmware revision string
+#define SBC_INFO_SW_REV                               0x07  // Software revision string
+#define SBC_INFO_SYSTEM_ID                            0x08  // System ID
+#define SBC_INFO_PNP_ID                               0x09  // PnP ID
+#define SBC_INFO_NUM_ITEMS                            10
+
+#define SBC_INFO_ALL                                  0x03FF
+
+// Items read on every new link, 0 to read them only on host request
+#if !defined( SBC_INFO_DEFAULT_MASK )
+#define SBC_INFO_DEFAULT_MASK                         SBC_INFO_ALL
+#endif
+
+// CCCD values written by SBC_CMD_SUBSCRIBE. Each selects the cached
+// characteristics whose properties allow it.
+#define SBC_SUB_OFF                                   0x00  // Turn notifications and indications off
+#define SBC_SUB_NOTIFY                                0x01  // Notify
+#define SBC_SUB_INDICATE                              0x02  // Indicate
+#define SBC_SUB_AUTO                                  0x03  // Notify, or indicate where notify is not allowed
+
+// Cache entry being configured when no subscribe is running
+#define SBC_SUB_NONE                                  0xFF
+
+// Connection lifecycle phases, each timed once per link in ms
+#define SBC_STATS_PHASE_SETUP                         0x00  // Connect request to link established
+#define SBC_STATS_PHASE_DISC                          0x01  // Link established to discovery complete
+#define SBC_STATS_PHASE_NOTI                          0x02  // Link established to first notification
+#define SBC_STATS_NUM_PHASES                          3
+
+// Phase duration of a phase the link has not reached yet. Longer
+// durations are reported as SBC_STATS_NONE - 1.
+#define SBC_STATS_NONE                                0xFFFF
+
+// Failure kinds, counted per kind and reason
+#define SBC_STATS_FAIL_ESTABLISH                      0x00  // Reason: link establishment status
+#define SBC_STATS_FAIL_DISC                           0x01  // Reason: discovery status
+#define SBC_STATS_FAIL_TERMINATE                      0x02  // Reason: termination reason
+
+// Number of distinct failure reasons counted, the rest are dropped
+#if !defined( SBC_STATS_MAX_REASONS )
+#define SBC_STATS_MAX_REASONS                         7
+#endif
+
+/*
+ * Host interface frame format, used in both directions:
+ *
+ *   SOF | TYPE | LEN | PAYLOAD[LEN] | FCS
+ *
+ * FCS is the 8-bit sum of TYPE, LEN and PAYLOAD. Any byte after SOF that
+ * equals SOF, ESC or EOF is sent as ESC followed by its escape code, so a
+ * raw SOF on the wire always starts a new frame.
+ */
+#define SBC_FRAME_SOF                                 0xF0
+#define SBC_FRAME_ESC                                 0xF5
+#define SBC_FRAME_EOF                                 0xFA
+
+#define SBC_FRAME_ESC_SOF                             0x01
+#define SBC_FRAME_ESC_ESC                             0x02
+#define SBC_FRAME_ESC_EOF                             0x03
+
+// Maximum frame payload length, at least a notification of a full
+// ATT MTU with its header. It may not exceed 255.
+#if !defined( SBC_FRAME_MAX_PAYLOAD )
+#if ( SBC_ATT_MTU + 2 > 64 )
+#define SBC_FRAME_MAX_PAYLOAD                         (SBC_ATT_MTU + 2)
+#else
+#define SBC_FRAME_MAX_PAYLOAD                         64
+#endif
+#endif
+
+// Frame lengths are carried in one byte
+#if ( SBC_FRAME_MAX_PAYLOAD > 255 )
+  #error "SBC_FRAME_MAX_PAYLOAD may not exceed 255"
+#endif
+
+// SBC_CMD_WRITE: connHandle[2], handle[2] and a value of up to MTU - 3
+#if ( 4 + SBC_ATT_MTU - 3 > 255 )
+  #error "SBC_ATT_MTU too large for an SBC_CMD_WRITE frame"
+#endif
+
+// Worst case encoded frame length: SOF + escaped TYPE, LEN, PAYLOAD and FCS
+#define SBC_FRAME_MAX_ENCODED                         (1 + 2 * (SBC_FRAME_MAX_PAYLOAD + 3))
+
+// Size of the ring that encoded frames are queued in until the UART
+// takes them. Frames queued in the same task pass go out in one write.
+#if !defined( SBC_TX_RING_SIZE )
+#if ( SBC_FRAME_MAX_ENCODED + 128 > 256 )
+#define SBC_TX_RING_SIZE                              (SBC_FRAME_MAX_ENCODED + 128)
+#else
+#define SBC_TX_RING_SIZE                              256
+#endif
+#endif
+
+// Host commands. Multi-byte fields are sent least significant byte first
+// unless noted otherwise.
+#define SBC_CMD_SCAN                                  0x01  // no payload
+#define SBC_CMD_CONNECT                               0x02  // addr[6] (MSB first), [addrType]
+#define SBC_CMD_DISCONNECT                            0x03  // connHandle[2], 0xFFFE cancels a pending connect
+#define SBC_CMD_WRITE                                 0x04  // connHandle[2], handle[2], value[1..MTU-3], queued as request id 0
+#define SBC_CMD_LINKS                                 0x05  // no payload, rsp: { connHandle[2], state, addrType, addr[6] }...
+#define SBC_CMD_COUNTERS                              0x06  // no payload, rsp: rxErrors[2], notiDropped[2]
+#define SBC_CMD_SCAN_STREAM                           0x07  // enable, [interval[2] (ms)]
+#define SBC_CMD_ADV_FILTER                            0x08  // filter, criterion, value[..], criterion 0 clears the filter
+#define SBC_CMD_GET_CHARS                             0x09  // connHandle[2], index, rsp: numChars, { uuid[2], valueHdl[2], cccdHdl[2], props }...
+#define SBC_CMD_CACHE_CLEAR                           0x0A  // no payload, erases every cached peer
+#define SBC_CMD_GATT                                  0x0B  // connHandle[2], id, op, handle[2], offset[2], data[..]
+#define SBC_CMD_RSSI_MONITOR                          0x0C  // connHandle[2], period[2] (ms), reportSamples, lowThresh, highThresh, period 0 stops
+#define SBC_CMD_RECON_ADD                             0x0D  // addr[6] (MSB first), [addrType]
+#define SBC_CMD_RECON_REMOVE                          0x0E  // [addr[6] (MSB first)], no payload removes every target
+#define SBC_CMD_CONN_PROFILE                          0x0F  // connHandle[2], profile, [auto], with auto the profile is used when idle
+#define SBC_CMD_SCAN_SCHED                            0x10  // enable, [window[2], minInterval[2], maxInterval[2]] (ms), rsp: interval[2]
+#define SBC_CMD_DEV_INFO                              0x11  // connHandle[2], [mask[2]], no mask reads every item
+#define SBC_CMD_CONN_STATS                            0x12  // [clear], rsp: attempts[2], { count[2], last[2], min[2], max[2], mean[2] } per phase, numReasons, { kind, reason, count[2] }...
+#define SBC_CMD_SUBSCRIBE                             0x13  // connHandle[2], mode, [uuid[2]...], no UUID selects every characteristic
+#define SBC_CMD_NPI_STATS                             0x14  // [clear], rsp: rxBytes[4], txBytes[4], rxFull[2], rxTimeouts[2], txShort[2], logDropped[2], rxMaxFill[2], { latency[2] } per log2 bin of 32 kHz ticks from start of frame to dispatch, see npiStats_t
+
+// Command responses are sent with the command type OR'ed with this flag.
+// The first payload byte is the command status.
+#define SBC_RSP_FLAG                                  0x80
+
+// Unsolicited events
+#define SBC_EVT_LINK_ESTABLISHED                      0x40  // status, connHandle[2], addrType, addr[6] (MSB first), status bleNoResources if the link table is full
+#define SBC_EVT_LINK_TERMINATED                       0x41  // connHandle[2], reason
+#define SBC_EVT_NOTIFICATION                          0x42  // connHandle[2], handle[2], len, value[len]
+#define SBC_EVT_ADV_REPORT                            0x43  // eventType, addrType, addr[6] (MSB first), rssi, len, data[len]
+#define SBC_EVT_SCAN_COMPLETE                         0x44  // numDevs, { addrType, addr[6] (MSB first) }...
+#define SBC_EVT_DISC_COMPLETE                         0x45  // connHandle[2], status, cached, numSvcs, numChars, status bleNoResources if the table overflowed
+#define SBC_EVT_GATT_DATA                             0x46  // connHandle[2], id, offset[2], len, value[len]
+#define SBC_EVT_GATT_COMPLETE                         0x47  // connHandle[2], id, op, status, errCode
+#define SBC_EVT_MTU_UPDATED                           0x48  // connHandle[2], mtu[2]
+#define SBC_EVT_RSSI                                  0x49  // connHandle[2], reason, numSamples, last, min, max, mean, ewma
+#define SBC_EVT_RECON                                 0x4A  // state, numDown, delay[2] (ms)
+#define SBC_EVT_CONN_PARAMS                           0x4B  // connHandle[2], status, profile, interval[2], latency[2], timeout[2]
+#define SBC_EVT_DEV_INFO                              0x4C  // connHandle[2], status, numItems, { item, len, value[len] }...
+#define SBC_EVT_CONN_TIMING                           0x4D  // connHandle[2], reason, { duration[2] } per phase, upTime[4] (ms)
+#define SBC_EVT_SUBSCRIBE                             0x4E  // connHandle[2], status, mode, selected[4], written[4], bit n for cache entry n
+#define SBC_EVT_LOG                                   0x4F  // NPI log records, see npi.h
+
+// NPI log format IDs
+#define SBC_LOG_SCAN_RESULT                           0x0100  // "Device %u", arg: scan result number of a new device
 
 /*********************************************************************
  * MACROS
@@ -82,6 +360,89 @@ extern "C"
 #define LCD_WRITE_STRING_VALUE(title, value, format, line)
 #endif
 
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Discovered service. For 128-bit UUIDs only bytes 12-13 are kept.
+typedef struct
+{
+  uint16 startHdl;                    // Service start handle
+  uint16 endHdl;                      // Service end handle
+  uint16 uuid;                        // Service UUID
+  uint8  uuid128;                     // TRUE if a 128-bit UUID
+} simpleBLESvc_t;
+
+// Discovered characteristic. For 128-bit UUIDs only bytes 12-13 are kept.
+typedef struct
+{
+  uint16 valueHdl;                    // Value handle
+  uint16 cccdHdl;                     // CCCD handle, 0 if none
+  uint16 uuid;                        // Characteristic UUID
+  uint8  props;                       // Characteristic properties
+  uint8  uuid128;                     // TRUE if a 128-bit UUID
+} simpleBLEChar_t;
+
+// Handle cache of a peer's attribute database
+typedef struct
+{
+  uint8  numSvcs;                     // Number of services
+  uint8  numChars;                    // Number of characteristics
+  uint16 svcChangedHdl;               // Service Changed value handle, 0 if none
+  simpleBLESvc_t  svc[SBC_CACHE_MAX_SVCS];
+  simpleBLEChar_t chr[SBC_CACHE_MAX_CHARS];
+} simpleBLEHdlCache_t;
+
+// Queued GATT request. Its value, or the remaining handles of a read
+// multiple, follow the request in the same allocation.
+typedef struct simpleBLEGattReq
+{
+  struct simpleBLEGattReq *pNext;     // Next request in the queue
+  uint8  op;                          // SBC_GATT_OP_*
+  uint8  id;                          // Host request id
+  uint8  internal;                    // TRUE if queued by the central itself
+  uint16 handle;                      // Attribute handle
+  uint16 offset;                      // Value offset of a long read or write
+  uint8  len;                         // Length of the data that follows
+} simpleBLEGattReq_t;
+
+// Per-link context, indexed by connection handle
+typedef struct
+{
+  uint16 connHandle;                  // Connection handle
+  uint8  state;                       // Link state
+  uint8  discState;                   // Discovery state
+  uint8  discIdx;                     // Service or characteristic being discovered
+  uint8  discTruncated;               // TRUE if entries did not fit the handle table
+  uint8  addrType;                    // Peer address type
+  uint8  addr[B_ADDR_LEN];            // Peer address
+  simpleBLEHdlCache_t cache;          // Discovered handles
+  uint16 charHdl;                     // Simple profile characteristic 1 handle
+  simpleBLEGattReq_t *pGattHead;      // First GATT request not yet issued
+  simpleBLEGattReq_t *pGattTail;      // Last queued GATT request
+  simpleBLEGattReq_t *pGattActive;    // GATT request waiting for its response
+  uint8  gattQueued;                  // Number of GATT requests held
+  uint16 mtu;                         // ATT MTU
+  uint8  connProfile;                 // Last requested parameter profile
+  uint8  connIdleProfile;             // Profile when idle, NONE if not switched automatically
+  uint32 connActivity;                // Time of the last GATT activity in ms
+  uint16 connInterval;                // Connection interval in 1.25ms units
+  uint16 connLatency;                 // Slave latency
+  uint16 connTimeout;                 // Supervision timeout in 10ms units
+  uint8  rssiPolling;                 // TRUE while RSSI polling is on
+  int8   rssi;                        // Last RSSI reading
+  uint16 infoMask;                    // Device info items still to read
+  uint8  *pInfo;                      // SBC_EVT_DEV_INFO being built, NULL if none
+  uint8  infoLen;                     // Length of SBC_EVT_DEV_INFO so far
+  uint32 statsUpTime;                 // System clock when the link was established
+  uint16 statsPhase[SBC_STATS_NUM_PHASES]; // Phase durations in ms, SBC_STATS_NONE until reached
+  uint32 subMask;                     // Cache entries whose CCCD is still to write
+  uint32 subSelected;                 // Cache entries selected by SBC_CMD_SUBSCRIBE
+  uint32 subWritten;                  // Cache entries whose CCCD was written
+  uint8  subMode;                     // SBC_SUB_* being applied
+  uint8  subChar;                     // Cache entry being written, SBC_SUB_NONE if idle
+} simpleBLELink_t;
+
 /*********************************************************************
  * FUNCTIONS
  */
@@ -96,6 +457,104 @@ extern void SimpleBLECentral_Init( uint8 task_id );
  */
 extern uint16 SimpleBLECentral_ProcessEvent( uint8 task_id, uint16 events );
 
+/*
+ * Link control functions used by the host command interface
+ */
+extern bStatus_t simpleBLEStartScan( void );
+extern bStatus_t simpleBLEConnect( uint8 addrType, uint8 *pAddr );
+extern bStatus_t simpleBLEDisconnect( uint16 connHandle );
+extern bStatus_t simpleBLEWriteValue( uint16 connHandle, uint16 handle, uint8 *pValue, uint8 len );
+extern simpleBLELink_t *simpleBLEFindLink( uint16 connHandle );
+extern void simpleBLELinkMtu( simpleBLELink_t *pLink, uint16 mtu );
+extern bStatus_t simpleBLERssiMonitor( uint16 connHandle, uint16 period, uint8 reportSamples,
+                                       int8 lowThresh, int8 highThresh );
+
+/*
+ * Discovery and handle cache functions
+ */
+extern void simpleBLEDiscInit( uint8 task_id );
+extern uint8 simpleBLEDiscStart( simpleBLELink_t *pLink );
+extern uint8 simpleBLEDiscGattMsg( simpleBLELink_t *pLink, gattMsgEvent_t *pMsg );
+extern bStatus_t simpleBLECacheLoad( simpleBLELink_t *pLink );
+extern void simpleBLECacheInvalidate( simpleBLELink_t *pLink );
+extern void simpleBLECacheClear( void );
+extern simpleBLEChar_t *simpleBLECacheFindChar( simpleBLELink_t *pLink, uint16 uuid );
+extern void simpleBLECacheSave( simpleBLELink_t *pLink );
+extern bStatus_t simpleBLEDiscWatchSvcChanged( simpleBLELink_t *pLink );
+
+/*
+ * GATT request queue functions
+ */
+extern void simpleBLEGattInit( uint8 task_id );
+extern bStatus_t simpleBLEGattQueue( simpleBLELink_t *pLink, uint8 op, uint8 id, uint16 handle,
+                                     uint16 offset, uint8 *pData, uint8 len );
+extern void simpleBLEGattService( simpleBLELink_t *pLink );
+extern void simpleBLEGattRetry( void );
+extern void simpleBLEGattMsg( simpleBLELink_t *pLink, gattMsgEvent_t *pMsg );
+extern void simpleBLEGattFlush( simpleBLELink_t *pLink, uint8 status );
+
+/*
+ * Reconnect supervisor functions
+ */
+extern void simpleBLEReconInit( uint8 task_id );
+extern bStatus_t simpleBLEReconAdd( uint8 addrType, uint8 *pAddr );
+extern bStatus_t simpleBLEReconRemove( uint8 *pAddr );
+extern void simpleBLEReconLinkUp( uint8 status, uint8 *pAddr );
+extern void simpleBLEReconLinkDown( uint8 *pAddr );
+extern void simpleBLEReconProcess( void );
+
+/*
+ * Connection parameter profile functions
+ */
+extern void simpleBLEConnInit( uint8 task_id );
+extern bStatus_t simpleBLEConnSetProfile( simpleBLELink_t *pLink, uint8 profile, uint8 autoSwitch );
+extern void simpleBLEConnBusy( simpleBLELink_t *pLink );
+extern void simpleBLEConnIdleCheck( void );
+extern void simpleBLEConnUpdated( simpleBLELink_t *pLink, uint8 status, uint16 interval,
+                                  uint16 latency, uint16 timeout );
+
+/*
+ * Device info pipeline functions
+ */
+extern bStatus_t simpleBLEInfoStart( simpleBLELink_t *pLink, uint16 mask );
+extern void simpleBLEInfoValue( simpleBLELink_t *pLink, uint8 item, uint8 *pValue, uint8 len );
+extern void simpleBLEInfoDone( simpleBLELink_t *pLink, uint8 status );
+
+/*
+ * Bulk subscribe functions
+ */
+extern bStatus_t simpleBLESubStart( simpleBLELink_t *pLink, uint8 mode, uint8 *pUuids, uint8 numUuids );
+extern void simpleBLESubDone( simpleBLELink_t *pLink, uint8 status );
+
+/*
+ * Connection lifecycle statistics functions
+ */
+extern void simpleBLEStatsConnect( void );
+extern void simpleBLEStatsLinkUp( simpleBLELink_t *pLink, uint8 status );
+extern void simpleBLEStatsPhase( simpleBLELink_t *pLink, uint8 phase );
+extern void simpleBLEStatsFailure( uint8 kind, uint8 reason );
+extern void simpleBLEStatsLinkDown( simpleBLELink_t *pLink, uint8 reason );
+extern uint8 simpleBLEStatsRead( uint8 *pBuf );
+extern void simpleBLEStatsClear( void );
+
+/*
+ * Streaming scan report functions
+ */
+extern bStatus_t simpleBLEScanStream( uint8 enable, uint16 interval );
+extern uint8 simpleBLEScanStreaming( void );
+extern void simpleBLEScanReport( gapDeviceInfoEvent_t *pInfo );
+
+/*
+ * Host command interface functions
+ */
+extern void simpleBLECmdInit( uint8 task_id );
+extern bStatus_t simpleBLECmdSendFrame( uint8 type, uint8 *pData, uint8 len );
+extern bStatus_t simpleBLECmdSendFrameParts( uint8 type, uint8 *pHdr, uint8 hdrLen,
+                                             uint8 *pData, uint8 len );
+extern void simpleBLECmdSendNotification( uint16 connHandle, attHandleValueNoti_t *pNoti );
+extern void simpleBLECmdFlush( void );
+extern uint8 simpleBLECmdTxBackedUp( void );
+
 /*********************************************************************
 *********************************************************************/
 
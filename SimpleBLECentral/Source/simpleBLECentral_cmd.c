@@ -0,0 +1,1362 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_cmd.c
+
+ @brief This file contains the host command interface of the Simple BLE
+        Central sample application. It frames and parses the binary protocol
+        carried over the NPI UART and dispatches host commands.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "hal_uart.h"
+#include "gap.h"
+#include "gatt.h"
+#include "ll.h"
+#include "advfilter.h"
+#include "scansched.h"
+#include "simpleBLECentral.h"
+#include "npi.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Number of bytes pulled from the UART per read
+#define SBC_RX_CHUNK_LEN                      16
+
+// Number of NPI writes the ring can be handed over in, one for each
+// side of the wrap
+#define SBC_TX_NUM_REQS                       2
+
+// Largest run of the ring handed to NPI in one write, so each run fits
+// the UART driver's transmit buffer in one go. The next run is handed
+// over as each one completes.
+#define SBC_TX_MAX_RUN                        64
+
+// Bytes handed to NPI and not yet taken by the UART at which droppable
+// traffic is held back, and at which it resumes. NPI only ever holds up
+// to SBC_TX_NUM_REQS runs, so it is full when the UART is at least that
+// far behind.
+#define SBC_TX_HIGH_WATER                     ( SBC_TX_NUM_REQS * SBC_TX_MAX_RUN )
+#define SBC_TX_LOW_WATER                      ( SBC_TX_MAX_RUN / 2 )
+
+#if ( SBC_TX_HIGH_WATER > SBC_TX_RING_SIZE )
+  #error "SBC_TX_RING_SIZE must hold SBC_TX_NUM_REQS runs of SBC_TX_MAX_RUN"
+#endif
+
+// Notification header: connHandle[2], handle[2], len
+#define SBC_NOTI_HDR_LEN                      5
+
+// SBC_CMD_GET_CHARS entry: uuid[2], valueHdl[2], cccdHdl[2], props
+#define SBC_CHAR_ENTRY_LEN                    7
+
+// SBC_CMD_GATT header: connHandle[2], id, op, handle[2], offset[2]
+#define SBC_GATT_CMD_HDR_LEN                  8
+
+// Frame receive states
+enum
+{
+  SBC_RX_SEEK_SOF,                    // Waiting for start of frame
+  SBC_RX_TYPE,                        // Frame type
+  SBC_RX_LEN,                         // Payload length
+  SBC_RX_DATA,                        // Payload
+  SBC_RX_FCS                          // Frame check sequence
+};
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Command handler. Returns the command status; any response data is
+// written to pRsp and its length to pRspLen.
+typedef uint8 (*simpleBLECmdHandler_t)( uint8 *pData, uint8 len,
+                                        uint8 *pRsp, uint8 *pRspLen );
+
+// Command table entry
+typedef struct
+{
+  uint8                 type;         // Command type
+  uint8                 minLen;       // Minimum payload length
+  uint8                 maxLen;       // Maximum payload length
+  simpleBLECmdHandler_t pfnHandler;   // Command handler
+} simpleBLECmd_t;
+
+// Frame receive context, kept across UART callbacks
+typedef struct
+{
+  uint8 state;                        // Receive state
+  uint8 esc;                          // TRUE if last byte was an escape
+  uint8 type;                         // Frame type
+  uint8 len;                          // Payload length
+  uint8 idx;                          // Payload bytes received
+  uint8 fcs;                          // Running frame check sequence
+  uint32 stamp;                       // Start of frame, see NPI_StatsStamp
+  uint8 data[SBC_FRAME_MAX_PAYLOAD];  // Payload
+} simpleBLECmdRx_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void simpleBLECmdSerialCB( uint8 port, uint8 events );
+static void simpleBLECmdLogCB( void );
+static void simpleBLECmdTxDone( npiTxReq_t *pReq );
+static void simpleBLECmdTxFlow( uint8 full );
+static void simpleBLECmdRxByte( uint8 rxByte );
+static void simpleBLECmdDispatch( uint8 type, uint8 *pData, uint8 len );
+static void simpleBLECmdTxPut( uint8 value );
+static void simpleBLECmdTxPutRaw( uint8 value );
+static uint8 simpleBLECmdEncodedLen( uint8 value );
+static uint16 simpleBLECmdSizeBlock( uint8 *pData, uint8 len, uint8 *pFcs );
+static void simpleBLECmdTxPutBlock( uint8 *pData, uint8 len );
+
+static uint8 simpleBLECmdScan( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdConnect( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdDisconnect( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdWrite( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdLinks( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdCounters( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdScanStream( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdAdvFilter( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdGetChars( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdCacheClear( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdGatt( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdRssiMonitor( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdReconAdd( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdReconRemove( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdConnProfile( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdScanSched( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdDevInfo( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdConnStats( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdSubscribe( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+static uint8 simpleBLECmdNpiStats( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen );
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Host command table
+static const simpleBLECmd_t simpleBLECmdTable[] =
+{
+  { SBC_CMD_SCAN,       0,              0,                  simpleBLECmdScan       },
+  { SBC_CMD_CONNECT,    B_ADDR_LEN,     B_ADDR_LEN + 1,     simpleBLECmdConnect    },
+  { SBC_CMD_DISCONNECT, 2,              2,                  simpleBLECmdDisconnect },
+  { SBC_CMD_WRITE,      5,              4 + SBC_ATT_MTU - 3, simpleBLECmdWrite     },
+  { SBC_CMD_LINKS,      0,              0,                  simpleBLECmdLinks      },
+  { SBC_CMD_COUNTERS,   0,              0,                  simpleBLECmdCounters   },
+  { SBC_CMD_SCAN_STREAM, 1,             3,                  simpleBLECmdScanStream },
+  { SBC_CMD_ADV_FILTER, 2,              2 + ATT_UUID_SIZE,  simpleBLECmdAdvFilter  },
+  { SBC_CMD_GET_CHARS,  3,              3,                  simpleBLECmdGetChars   },
+  { SBC_CMD_CACHE_CLEAR, 0,             0,                  simpleBLECmdCacheClear },
+  { SBC_CMD_GATT,       SBC_GATT_CMD_HDR_LEN, SBC_FRAME_MAX_PAYLOAD, simpleBLECmdGatt },
+  { SBC_CMD_RSSI_MONITOR, 4,            7,                  simpleBLECmdRssiMonitor },
+  { SBC_CMD_RECON_ADD,  B_ADDR_LEN,     B_ADDR_LEN + 1,     simpleBLECmdReconAdd   },
+  { SBC_CMD_RECON_REMOVE, 0,            B_ADDR_LEN,         simpleBLECmdReconRemove },
+  { SBC_CMD_CONN_PROFILE, 3,            4,                  simpleBLECmdConnProfile },
+  { SBC_CMD_SCAN_SCHED,   1,            7,                  simpleBLECmdScanSched },
+  { SBC_CMD_DEV_INFO,     2,            4,                  simpleBLECmdDevInfo   },
+  { SBC_CMD_CONN_STATS,   0,            1,                  simpleBLECmdConnStats },
+  { SBC_CMD_SUBSCRIBE,    3,            SBC_FRAME_MAX_PAYLOAD, simpleBLECmdSubscribe },
+  { SBC_CMD_NPI_STATS,    0,            1,                  simpleBLECmdNpiStats  }
+};
+
+// Frame receive context
+static simpleBLECmdRx_t simpleBLECmdRx;
+
+// UART read buffer
+static uint8 simpleBLECmdRxBuf[SBC_RX_CHUNK_LEN];
+
+// Task that flushes the transmit ring
+static uint8 simpleBLECmdTaskId;
+
+// Transmit ring of encoded frames
+static uint8 simpleBLECmdTxRing[SBC_TX_RING_SIZE];
+static uint16 simpleBLECmdTxHead = 0;
+static uint16 simpleBLECmdTxTail = 0;
+static uint16 simpleBLECmdTxCount = 0;
+
+// Response payload buffer
+static uint8 simpleBLECmdRspBuf[SBC_FRAME_MAX_PAYLOAD];
+
+// Number of frames dropped for a bad FCS, escape or length
+static uint16 simpleBLECmdRxErrors = 0;
+
+// Number of notifications dropped because the transmit ring was full
+static uint16 simpleBLECmdNotiDropped = 0;
+
+// NPI writes of the transmit ring, free if pBuf is NULL
+static npiTxReq_t simpleBLECmdTxReq[SBC_TX_NUM_REQS];
+
+// Bytes from the tail of the transmit ring handed to NPI
+static uint16 simpleBLECmdTxQueued = 0;
+
+// TRUE from the high water mark until back down to the low water mark
+static uint8 simpleBLECmdTxFull = FALSE;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLECmdInit
+ *
+ * @brief   Initialize the host command interface and open the NPI
+ *          transport.
+ *
+ * @param   task_id - task that receives SBC_TX_FLUSH_EVT
+ *
+ * @return  none
+ */
+void simpleBLECmdInit( uint8 task_id )
+{
+  simpleBLECmdTaskId = task_id;
+
+  simpleBLECmdRx.state = SBC_RX_SEEK_SOF;
+  simpleBLECmdRx.esc = FALSE;
+
+  NPI_InitTransport( simpleBLECmdSerialCB );
+  NPI_SetTxWatermarks( SBC_TX_HIGH_WATER, SBC_TX_LOW_WATER, simpleBLECmdTxFlow );
+  NPI_LogInit( simpleBLECmdLogCB );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSendFrame
+ *
+ * @brief   Encode a frame into the transmit ring and schedule a
+ *          flush. Frames queued before the flush runs are written
+ *          to the UART together.
+ *
+ * @param   type - frame type
+ * @param   pData - frame payload
+ * @param   len - payload length
+ *
+ * @return  SUCCESS, bleInvalidRange if the payload is too long or
+ *          bleMemAllocError if the transmit ring has no room.
+ */
+bStatus_t simpleBLECmdSendFrame( uint8 type, uint8 *pData, uint8 len )
+{
+  return ( simpleBLECmdSendFrameParts( type, pData, len, NULL, 0 ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSendFrameParts
+ *
+ * @brief   Encode a frame whose payload is a header followed by a
+ *          value straight into the transmit ring. The encoded size is
+ *          worked out first and that much of the ring is reserved, so
+ *          the value goes from the caller's buffer to the ring with no
+ *          copy in between. The caller keeps ownership of both buffers
+ *          and may free them as soon as this returns.
+ *
+ * @param   type - frame type
+ * @param   pHdr - payload header
+ * @param   hdrLen - header length
+ * @param   pData - payload value, may be NULL if len is 0
+ * @param   len - value length
+ *
+ * @return  SUCCESS, bleInvalidRange if the payload is too long or
+ *          bleMemAllocError if the transmit ring has no room.
+ */
+bStatus_t simpleBLECmdSendFrameParts( uint8 type, uint8 *pHdr, uint8 hdrLen,
+                                      uint8 *pData, uint8 len )
+{
+  uint8 payloadLen;
+  uint8 fcs;
+  uint16 frameLen;
+
+  if ( hdrLen > SBC_FRAME_MAX_PAYLOAD || len > SBC_FRAME_MAX_PAYLOAD - hdrLen )
+  {
+    return ( bleInvalidRange );
+  }
+
+  // Size the encoded frame first so it is queued whole or not at all
+  payloadLen = hdrLen + len;
+  fcs = type + payloadLen;
+  frameLen = 1 + simpleBLECmdEncodedLen( type ) + simpleBLECmdEncodedLen( payloadLen );
+  frameLen += simpleBLECmdSizeBlock( pHdr, hdrLen, &fcs );
+  frameLen += simpleBLECmdSizeBlock( pData, len, &fcs );
+  frameLen += simpleBLECmdEncodedLen( fcs );
+
+  if ( frameLen > SBC_TX_RING_SIZE - simpleBLECmdTxCount )
+  {
+    return ( bleMemAllocError );
+  }
+
+  simpleBLECmdTxPutRaw( SBC_FRAME_SOF );
+  simpleBLECmdTxPut( type );
+  simpleBLECmdTxPut( payloadLen );
+  simpleBLECmdTxPutBlock( pHdr, hdrLen );
+  simpleBLECmdTxPutBlock( pData, len );
+  simpleBLECmdTxPut( fcs );
+
+  osal_set_event( simpleBLECmdTaskId, SBC_TX_FLUSH_EVT );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxBackedUp
+ *
+ * @brief   Check whether the UART is behind. Producers of traffic that
+ *          may be dropped hold it back until it catches up, to keep
+ *          the transmit ring for notifications and responses.
+ *
+ * @return  TRUE from the high water mark until back at the low mark
+ */
+uint8 simpleBLECmdTxBackedUp( void )
+{
+  return ( simpleBLECmdTxFull );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSendNotification
+ *
+ * @brief   Forward a received notification or indication to the
+ *          host. The value is encoded into the transmit ring straight
+ *          from the GATT message, which the caller still owns and
+ *          frees afterwards. Values longer than a frame can carry are
+ *          truncated. If the transmit ring is full the notification
+ *          is dropped and counted.
+ *
+ * @param   connHandle - connection handle
+ * @param   pNoti - notification
+ *
+ * @return  none
+ */
+void simpleBLECmdSendNotification( uint16 connHandle, attHandleValueNoti_t *pNoti )
+{
+  uint8 hdr[SBC_NOTI_HDR_LEN];
+  uint8 len;
+
+  if ( pNoti->len > SBC_FRAME_MAX_PAYLOAD - SBC_NOTI_HDR_LEN )
+  {
+    len = SBC_FRAME_MAX_PAYLOAD - SBC_NOTI_HDR_LEN;
+  }
+  else
+  {
+    len = (uint8)pNoti->len;
+  }
+
+  hdr[0] = LO_UINT16( connHandle );
+  hdr[1] = HI_UINT16( connHandle );
+  hdr[2] = LO_UINT16( pNoti->handle );
+  hdr[3] = HI_UINT16( pNoti->handle );
+  hdr[4] = len;
+
+  if ( simpleBLECmdSendFrameParts( SBC_EVT_NOTIFICATION, hdr, SBC_NOTI_HDR_LEN,
+                                   pNoti->pValue, len ) != SUCCESS )
+  {
+    simpleBLECmdNotiDropped++;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdFlush
+ *
+ * @brief   Hand the part of the transmit ring not yet handed over to
+ *          NPI as queued writes, by reference. NPI sends them as the
+ *          UART takes them, and the ring space is freed as each write
+ *          completes, so nothing is lost when the UART is full. Once
+ *          the ring is empty, one SBC_EVT_LOG worth of NPI log records
+ *          is queued and another flush scheduled, so the log only goes
+ *          out when nothing else is waiting and other tasks run in
+ *          between.
+ *
+ * @return  none
+ */
+void simpleBLECmdFlush( void )
+{
+  npiTxReq_t *pReq;
+  uint16 start;
+  uint16 len;
+  uint8 i;
+
+  for ( i = 0; i < SBC_TX_NUM_REQS && simpleBLECmdTxQueued < simpleBLECmdTxCount; i++ )
+  {
+    pReq = &simpleBLECmdTxReq[i];
+    if ( pReq->pBuf != NULL )
+    {
+      continue;
+    }
+
+    // Largest contiguous block after what NPI already has
+    start = simpleBLECmdTxTail + simpleBLECmdTxQueued;
+    if ( start >= SBC_TX_RING_SIZE )
+    {
+      start -= SBC_TX_RING_SIZE;
+    }
+    len = simpleBLECmdTxCount - simpleBLECmdTxQueued;
+    if ( len > SBC_TX_RING_SIZE - start )
+    {
+      len = SBC_TX_RING_SIZE - start;
+    }
+    if ( len > SBC_TX_MAX_RUN )
+    {
+      len = SBC_TX_MAX_RUN;
+    }
+
+    simpleBLECmdTxQueued += len;
+
+    pReq->pBuf = &simpleBLECmdTxRing[start];
+    pReq->len = len;
+    pReq->pfnDone = simpleBLECmdTxDone;
+
+    // May complete at once
+    VOID NPI_QueueWrite( pReq );
+  }
+
+  if ( simpleBLECmdTxCount == 0 && NPI_LogPending() > 0 )
+  {
+    // The response buffer is free outside of command dispatch
+    uint8 len = NPI_LogRead( simpleBLECmdRspBuf, SBC_FRAME_MAX_PAYLOAD );
+
+    if ( len > 0 )
+    {
+      VOID simpleBLECmdSendFrame( SBC_EVT_LOG, simpleBLECmdRspBuf, len );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSerialCB
+ *
+ * @brief   NPI transport callback. Drains the UART receive buffer into
+ *          the frame parser. Partial frames are kept in the receive
+ *          context until the next callback.
+ *
+ * @param   port - UART port
+ * @param   events - UART events
+ *
+ * @return  none
+ */
+static void simpleBLECmdSerialCB( uint8 port, uint8 events )
+{
+  uint16 numBytes;
+  uint8 i;
+
+  (void)port;
+
+  if ( events & (HAL_UART_RX_TIMEOUT | HAL_UART_RX_ABOUT_FULL | HAL_UART_RX_FULL) )
+  {
+    while ( (numBytes = NPI_ReadTransport( simpleBLECmdRxBuf, SBC_RX_CHUNK_LEN )) > 0 )
+    {
+      for ( i = 0; i < numBytes; i++ )
+      {
+        simpleBLECmdRxByte( simpleBLECmdRxBuf[i] );
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdLogCB
+ *
+ * @brief   NPI log callback. Schedules a flush, which sends the log
+ *          once the transmit ring is empty.
+ *
+ * @return  none
+ */
+static void simpleBLECmdLogCB( void )
+{
+  osal_set_event( simpleBLECmdTaskId, SBC_TX_FLUSH_EVT );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxDone
+ *
+ * @brief   NPI write completion. Frees the part of the transmit ring
+ *          the write covered, writes complete in ring order, and
+ *          schedules a flush for whatever was queued meanwhile.
+ *
+ * @param   pReq - completed write
+ *
+ * @return  none
+ */
+static void simpleBLECmdTxDone( npiTxReq_t *pReq )
+{
+  simpleBLECmdTxTail += pReq->len;
+  if ( simpleBLECmdTxTail >= SBC_TX_RING_SIZE )
+  {
+    simpleBLECmdTxTail -= SBC_TX_RING_SIZE;
+  }
+  simpleBLECmdTxCount -= pReq->len;
+  simpleBLECmdTxQueued -= pReq->len;
+
+  pReq->pBuf = NULL;
+
+  osal_set_event( simpleBLECmdTaskId, SBC_TX_FLUSH_EVT );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxFlow
+ *
+ * @brief   NPI water mark callback.
+ *
+ * @param   full - TRUE at the high water mark, FALSE back at the low
+ *
+ * @return  none
+ */
+static void simpleBLECmdTxFlow( uint8 full )
+{
+  simpleBLECmdTxFull = full;
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdRxByte
+ *
+ * @brief   Run one received byte through the frame parser.
+ *
+ * @param   rxByte - received byte
+ *
+ * @return  none
+ */
+static void simpleBLECmdRxByte( uint8 rxByte )
+{
+  simpleBLECmdRx_t *pRx = &simpleBLECmdRx;
+
+  // A raw start of frame always restarts the parser
+  if ( rxByte == SBC_FRAME_SOF )
+  {
+    if ( pRx->state != SBC_RX_SEEK_SOF )
+    {
+      simpleBLECmdRxErrors++;
+    }
+
+    pRx->state = SBC_RX_TYPE;
+    pRx->esc = FALSE;
+    pRx->stamp = NPI_StatsStamp();
+    return;
+  }
+
+  if ( pRx->state == SBC_RX_SEEK_SOF )
+  {
+    return;
+  }
+
+  if ( pRx->esc )
+  {
+    pRx->esc = FALSE;
+
+    switch ( rxByte )
+    {
+      case SBC_FRAME_ESC_SOF:
+        rxByte = SBC_FRAME_SOF;
+        break;
+
+      case SBC_FRAME_ESC_ESC:
+        rxByte = SBC_FRAME_ESC;
+        break;
+
+      case SBC_FRAME_ESC_EOF:
+        rxByte = SBC_FRAME_EOF;
+        break;
+
+      default:
+        // Invalid escape sequence, drop the frame
+        simpleBLECmdRxErrors++;
+        pRx->state = SBC_RX_SEEK_SOF;
+        return;
+    }
+  }
+  else if ( rxByte == SBC_FRAME_ESC )
+  {
+    pRx->esc = TRUE;
+    return;
+  }
+  else if ( rxByte == SBC_FRAME_EOF )
+  {
+    // Reserved value may not appear unescaped
+    simpleBLECmdRxErrors++;
+    pRx->state = SBC_RX_SEEK_SOF;
+    return;
+  }
+
+  switch ( pRx->state )
+  {
+    case SBC_RX_TYPE:
+      pRx->type = rxByte;
+      pRx->fcs = rxByte;
+      pRx->state = SBC_RX_LEN;
+      break;
+
+    case SBC_RX_LEN:
+      if ( rxByte > SBC_FRAME_MAX_PAYLOAD )
+      {
+        simpleBLECmdRxErrors++;
+        pRx->state = SBC_RX_SEEK_SOF;
+        break;
+      }
+
+      pRx->len = rxByte;
+      pRx->idx = 0;
+      pRx->fcs += rxByte;
+      pRx->state = ( rxByte > 0 ) ? SBC_RX_DATA : SBC_RX_FCS;
+      break;
+
+    case SBC_RX_DATA:
+      pRx->data[pRx->idx++] = rxByte;
+      pRx->fcs += rxByte;
+
+      if ( pRx->idx == pRx->len )
+      {
+        pRx->state = SBC_RX_FCS;
+      }
+      break;
+
+    case SBC_RX_FCS:
+      if ( rxByte == pRx->fcs )
+      {
+        NPI_StatsLatency( pRx->stamp );
+        simpleBLECmdDispatch( pRx->type, pRx->data, pRx->len );
+      }
+      else
+      {
+        simpleBLECmdRxErrors++;
+      }
+
+      pRx->state = SBC_RX_SEEK_SOF;
+      break;
+
+    default:
+      pRx->state = SBC_RX_SEEK_SOF;
+      break;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdDispatch
+ *
+ * @brief   Look up a received command in the command table, run its
+ *          handler and send the response.
+ *
+ * @param   type - command type
+ * @param   pData - command payload
+ * @param   len - payload length
+ *
+ * @return  none
+ */
+static void simpleBLECmdDispatch( uint8 type, uint8 *pData, uint8 len )
+{
+  const simpleBLECmd_t *pCmd = NULL;
+  uint8 rspLen = 1;
+  uint8 i;
+
+  for ( i = 0; i < sizeof( simpleBLECmdTable ) / sizeof( simpleBLECmdTable[0] ); i++ )
+  {
+    if ( simpleBLECmdTable[i].type == type )
+    {
+      pCmd = &simpleBLECmdTable[i];
+      break;
+    }
+  }
+
+  if ( pCmd == NULL )
+  {
+    simpleBLECmdRspBuf[0] = INVALIDPARAMETER;
+  }
+  else if ( ( len < pCmd->minLen ) || ( len > pCmd->maxLen ) )
+  {
+    simpleBLECmdRspBuf[0] = bleInvalidRange;
+  }
+  else
+  {
+    uint8 dataLen = 0;
+
+    simpleBLECmdRspBuf[0] = pCmd->pfnHandler( pData, len, &simpleBLECmdRspBuf[1], &dataLen );
+    rspLen += dataLen;
+  }
+
+  VOID simpleBLECmdSendFrame( type | SBC_RSP_FLAG, simpleBLECmdRspBuf, rspLen );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxPut
+ *
+ * @brief   Write one byte to the transmit ring, escaping it if
+ *          needed. The caller has checked that there is room.
+ *
+ * @param   value - byte to write
+ *
+ * @return  none
+ */
+static void simpleBLECmdTxPut( uint8 value )
+{
+  uint8 code = 0;
+
+  switch ( value )
+  {
+    case SBC_FRAME_SOF:
+      code = SBC_FRAME_ESC_SOF;
+      break;
+
+    case SBC_FRAME_ESC:
+      code = SBC_FRAME_ESC_ESC;
+      break;
+
+    case SBC_FRAME_EOF:
+      code = SBC_FRAME_ESC_EOF;
+      break;
+
+    default:
+      break;
+  }
+
+  if ( code != 0 )
+  {
+    simpleBLECmdTxPutRaw( SBC_FRAME_ESC );
+    value = code;
+  }
+
+  simpleBLECmdTxPutRaw( value );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxPutRaw
+ *
+ * @brief   Write one byte to the transmit ring as is.
+ *
+ * @param   value - byte to write
+ *
+ * @return  none
+ */
+static void simpleBLECmdTxPutRaw( uint8 value )
+{
+  simpleBLECmdTxRing[simpleBLECmdTxHead] = value;
+  if ( ++simpleBLECmdTxHead == SBC_TX_RING_SIZE )
+  {
+    simpleBLECmdTxHead = 0;
+  }
+  simpleBLECmdTxCount++;
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdTxPutBlock
+ *
+ * @brief   Write a block to the transmit ring, escaping as needed.
+ *          The caller has checked that there is room.
+ *
+ * @param   pData - block
+ * @param   len - block length
+ *
+ * @return  none
+ */
+static void simpleBLECmdTxPutBlock( uint8 *pData, uint8 len )
+{
+  while ( len-- > 0 )
+  {
+    simpleBLECmdTxPut( *pData++ );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSizeBlock
+ *
+ * @brief   Encoded size of a block, adding its bytes to a frame FCS.
+ *
+ * @param   pData - block
+ * @param   len - block length
+ * @param   pFcs - FCS to update
+ *
+ * @return  number of bytes the block takes on the wire
+ */
+static uint16 simpleBLECmdSizeBlock( uint8 *pData, uint8 len, uint8 *pFcs )
+{
+  uint16 size = 0;
+
+  while ( len-- > 0 )
+  {
+    size += simpleBLECmdEncodedLen( *pData );
+    *pFcs += *pData++;
+  }
+
+  return ( size );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdEncodedLen
+ *
+ * @brief   Number of bytes a value takes on the wire.
+ *
+ * @param   value - byte to encode
+ *
+ * @return  1, or 2 if the value must be escaped
+ */
+static uint8 simpleBLECmdEncodedLen( uint8 value )
+{
+  if ( value == SBC_FRAME_SOF || value == SBC_FRAME_ESC || value == SBC_FRAME_EOF )
+  {
+    return ( 2 );
+  }
+
+  return ( 1 );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdScan
+ *
+ * @brief   SBC_CMD_SCAN handler. Start device discovery.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdScan( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  return ( simpleBLEStartScan() );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdConnect
+ *
+ * @brief   SBC_CMD_CONNECT handler. Connect to the device with the
+ *          given address. The address is sent most significant byte
+ *          first and is followed by an optional address type.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdConnect( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint8 peerAddr[B_ADDR_LEN];
+  uint8 addrType = ADDRTYPE_PUBLIC;
+  uint8 i;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    peerAddr[i] = pData[B_ADDR_LEN - 1 - i];
+  }
+
+  if ( len > B_ADDR_LEN )
+  {
+    addrType = pData[B_ADDR_LEN];
+  }
+
+  return ( simpleBLEConnect( addrType, peerAddr ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdDisconnect
+ *
+ * @brief   SBC_CMD_DISCONNECT handler. Terminate the given link, or
+ *          cancel the pending connection if the handle is
+ *          GAP_CONNHANDLE_INIT.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdDisconnect( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  return ( simpleBLEDisconnect( BUILD_UINT16( pData[0], pData[1] ) ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdWrite
+ *
+ * @brief   SBC_CMD_WRITE handler. Write a characteristic value on
+ *          the given link.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdWrite( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  return ( simpleBLEWriteValue( BUILD_UINT16( pData[0], pData[1] ),
+                                BUILD_UINT16( pData[2], pData[3] ),
+                                &pData[4], len - 4 ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdLinks
+ *
+ * @brief   SBC_CMD_LINKS handler. Report every open link.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdLinks( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  simpleBLELink_t *pLink;
+  uint16 connHandle;
+  uint8 i;
+
+  for ( connHandle = 0; connHandle < SBC_MAX_LINKS; connHandle++ )
+  {
+    if ( (pLink = simpleBLEFindLink( connHandle )) != NULL )
+    {
+      *pRsp++ = LO_UINT16( connHandle );
+      *pRsp++ = HI_UINT16( connHandle );
+      *pRsp++ = pLink->state;
+      *pRsp++ = pLink->addrType;
+
+      for ( i = 0; i < B_ADDR_LEN; i++ )
+      {
+        *pRsp++ = pLink->addr[B_ADDR_LEN - 1 - i];
+      }
+
+      *pRspLen += 4 + B_ADDR_LEN;
+    }
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdCounters
+ *
+ * @brief   SBC_CMD_COUNTERS handler. Report the receive error and
+ *          dropped notification counters.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdCounters( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  pRsp[0] = LO_UINT16( simpleBLECmdRxErrors );
+  pRsp[1] = HI_UINT16( simpleBLECmdRxErrors );
+  pRsp[2] = LO_UINT16( simpleBLECmdNotiDropped );
+  pRsp[3] = HI_UINT16( simpleBLECmdNotiDropped );
+  *pRspLen = 4;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdScanStream
+ *
+ * @brief   SBC_CMD_SCAN_STREAM handler. Turn streaming scan reports
+ *          on or off. Without an interval every advertisement is
+ *          reported.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdScanStream( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint16 interval = 0;
+
+  if ( len == 3 )
+  {
+    interval = BUILD_UINT16( pData[1], pData[2] );
+  }
+  else if ( len != 1 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  return ( simpleBLEScanStream( pData[0], interval ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdAdvFilter
+ *
+ * @brief   SBC_CMD_ADV_FILTER handler. Add a criterion to an
+ *          advertisement filter, or clear the filter if the criterion
+ *          is 0. Filter ADVFILTER_ALL clears every filter.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdAdvFilter( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  if ( pData[1] == 0 )
+  {
+    return ( AdvFilter_Clear( pData[0] ) );
+  }
+
+  return ( AdvFilter_SetCriterion( pData[0], pData[1], &pData[2], len - 2 ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdGetChars
+ *
+ * @brief   SBC_CMD_GET_CHARS handler. Report the cached
+ *          characteristics of a link, starting at the given index and
+ *          as many as fit in one frame.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdGetChars( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  simpleBLELink_t *pLink = simpleBLEFindLink( BUILD_UINT16( pData[0], pData[1] ) );
+  uint8 idx = pData[2];
+  uint8 n = 0;
+
+  if ( pLink == NULL )
+  {
+    return ( bleNotConnected );
+  }
+
+  if ( pLink->discState != BLE_DISC_STATE_IDLE )
+  {
+    return ( blePending );
+  }
+
+  *pRsp++ = pLink->cache.numChars;
+
+  while ( idx < pLink->cache.numChars &&
+          ( n + 1 ) * SBC_CHAR_ENTRY_LEN <= SBC_FRAME_MAX_PAYLOAD - 2 )
+  {
+    simpleBLEChar_t *pChar = &pLink->cache.chr[idx++];
+
+    *pRsp++ = LO_UINT16( pChar->uuid );
+    *pRsp++ = HI_UINT16( pChar->uuid );
+    *pRsp++ = LO_UINT16( pChar->valueHdl );
+    *pRsp++ = HI_UINT16( pChar->valueHdl );
+    *pRsp++ = LO_UINT16( pChar->cccdHdl );
+    *pRsp++ = HI_UINT16( pChar->cccdHdl );
+    *pRsp++ = pChar->props;
+    n++;
+  }
+
+  *pRspLen = 1 + n * SBC_CHAR_ENTRY_LEN;
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdCacheClear
+ *
+ * @brief   SBC_CMD_CACHE_CLEAR handler. Drop every cached peer.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdCacheClear( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  simpleBLECacheClear();
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdGatt
+ *
+ * @brief   SBC_CMD_GATT handler. Queue a GATT request on a link. The
+ *          response only says whether the request was queued; the
+ *          outcome follows in SBC_EVT_GATT_COMPLETE with the same id.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdGatt( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  if ( pData[3] & SBC_GATT_OP_INTERNAL )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  return ( simpleBLEGattQueue( simpleBLEFindLink( BUILD_UINT16( pData[0], pData[1] ) ),
+                               pData[3], pData[2],
+                               BUILD_UINT16( pData[4], pData[5] ),
+                               BUILD_UINT16( pData[6], pData[7] ),
+                               &pData[SBC_GATT_CMD_HDR_LEN], len - SBC_GATT_CMD_HDR_LEN ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdRssiMonitor
+ *
+ * @brief   SBC_CMD_RSSI_MONITOR handler. Start RSSI monitoring on a
+ *          link, or stop it if the period is 0.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdRssiMonitor( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint16 period = BUILD_UINT16( pData[2], pData[3] );
+
+  if ( period != 0 && len != 7 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  return ( simpleBLERssiMonitor( BUILD_UINT16( pData[0], pData[1] ), period,
+                                 pData[4], (int8)pData[5], (int8)pData[6] ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdReconAdd
+ *
+ * @brief   SBC_CMD_RECON_ADD handler. Add a peer to the reconnect
+ *          supervisor's targets. The address is sent most significant
+ *          byte first and is followed by an optional address type.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdReconAdd( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint8 peerAddr[B_ADDR_LEN];
+  uint8 addrType = ADDRTYPE_PUBLIC;
+  uint8 i;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    peerAddr[i] = pData[B_ADDR_LEN - 1 - i];
+  }
+
+  if ( len > B_ADDR_LEN )
+  {
+    addrType = pData[B_ADDR_LEN];
+  }
+
+  return ( simpleBLEReconAdd( addrType, peerAddr ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdReconRemove
+ *
+ * @brief   SBC_CMD_RECON_REMOVE handler. Remove a peer from the
+ *          reconnect supervisor's targets, or every peer if no address
+ *          is given.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdReconRemove( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint8 peerAddr[B_ADDR_LEN];
+  uint8 i;
+
+  if ( len == 0 )
+  {
+    return ( simpleBLEReconRemove( NULL ) );
+  }
+
+  if ( len != B_ADDR_LEN )
+  {
+    return ( bleInvalidRange );
+  }
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    peerAddr[i] = pData[B_ADDR_LEN - 1 - i];
+  }
+
+  return ( simpleBLEReconRemove( peerAddr ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdConnProfile
+ *
+ * @brief   SBC_CMD_CONN_PROFILE handler. Apply a connection parameter
+ *          profile to a link, or make it the link's idle profile with
+ *          automatic switching.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdConnProfile( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint8 autoSwitch = ( len > 3 ) ? pData[3] : FALSE;
+
+  return ( simpleBLEConnSetProfile( simpleBLEFindLink( BUILD_UINT16( pData[0], pData[1] ) ),
+                                    pData[2], autoSwitch ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdScanSched
+ *
+ * @brief   SBC_CMD_SCAN_SCHED handler. Turn duty-cycled scanning on or
+ *          off, optionally setting the window and interval range. The
+ *          response carries the interval in use.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdScanSched( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint8 status = SUCCESS;
+
+  if ( len == 7 )
+  {
+    status = ScanSched_SetParams( BUILD_UINT16( pData[1], pData[2] ),
+                                  BUILD_UINT16( pData[3], pData[4] ),
+                                  BUILD_UINT16( pData[5], pData[6] ) );
+  }
+  else if ( len != 1 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  if ( status == SUCCESS )
+  {
+    if ( pData[0] )
+    {
+      status = ScanSched_Start();
+    }
+    else
+    {
+      ScanSched_Stop();
+    }
+  }
+
+  pRsp[0] = LO_UINT16( ScanSched_GetInterval() );
+  pRsp[1] = HI_UINT16( ScanSched_GetInterval() );
+  *pRspLen = 2;
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdDevInfo
+ *
+ * @brief   SBC_CMD_DEV_INFO handler. Read the peer's name, appearance
+ *          and device information. The values follow in one
+ *          SBC_EVT_DEV_INFO.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdDevInfo( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  uint16 mask = ( len == 4 ) ? BUILD_UINT16( pData[2], pData[3] ) : SBC_INFO_ALL;
+
+  if ( len == 3 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  return ( simpleBLEInfoStart( simpleBLEFindLink( BUILD_UINT16( pData[0], pData[1] ) ), mask ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdConnStats
+ *
+ * @brief   SBC_CMD_CONN_STATS handler. Report the connection lifecycle
+ *          statistics, and clear them once read if asked to.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdConnStats( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  *pRspLen = simpleBLEStatsRead( pRsp );
+
+  if ( len == 1 && pData[0] )
+  {
+    simpleBLEStatsClear();
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdSubscribe
+ *
+ * @brief   SBC_CMD_SUBSCRIBE handler. Write the CCCD of every cached
+ *          characteristic, or of those with the given UUIDs, in one
+ *          go. The outcome follows in one SBC_EVT_SUBSCRIBE.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdSubscribe( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  // Whole UUIDs only
+  if ( ( ( len - 3 ) & 0x01 ) != 0 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  return ( simpleBLESubStart( simpleBLEFindLink( BUILD_UINT16( pData[0], pData[1] ) ),
+                              pData[2], &pData[3], ( len - 3 ) / 2 ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECmdNpiStats
+ *
+ * @brief   SBC_CMD_NPI_STATS handler. Report the serial transport
+ *          statistics, and clear them once read if asked to.
+ *
+ * @return  command status
+ */
+static uint8 simpleBLECmdNpiStats( uint8 *pData, uint8 len, uint8 *pRsp, uint8 *pRspLen )
+{
+  npiStats_t stats;
+  uint16 counters[5];
+  uint8 *p = pRsp;
+  uint8 i;
+
+  NPI_GetStats( &stats );
+
+  *p++ = BREAK_UINT32( stats.rxBytes, 0 );
+  *p++ = BREAK_UINT32( stats.rxBytes, 1 );
+  *p++ = BREAK_UINT32( stats.rxBytes, 2 );
+  *p++ = BREAK_UINT32( stats.rxBytes, 3 );
+  *p++ = BREAK_UINT32( stats.txBytes, 0 );
+  *p++ = BREAK_UINT32( stats.txBytes, 1 );
+  *p++ = BREAK_UINT32( stats.txBytes, 2 );
+  *p++ = BREAK_UINT32( stats.txBytes, 3 );
+
+  counters[0] = stats.rxFullEvts;
+  counters[1] = stats.rxTimeouts;
+  counters[2] = stats.txShortWrites;
+  counters[3] = stats.logDropped;
+  counters[4] = stats.rxMaxFill;
+
+  for ( i = 0; i < sizeof( counters ) / sizeof( uint16 ); i++ )
+  {
+    *p++ = LO_UINT16( counters[i] );
+    *p++ = HI_UINT16( counters[i] );
+  }
+
+  for ( i = 0; i < NPI_STATS_LAT_BINS; i++ )
+  {
+    *p++ = LO_UINT16( stats.rxLatency[i] );
+    *p++ = HI_UINT16( stats.rxLatency[i] );
+  }
+
+  *pRspLen = (uint8)( p - pRsp );
+
+  if ( len == 1 && pData[0] )
+  {
+    NPI_ResetStats();
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,313 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_conn.c
+
+ @brief This file contains the connection parameter profiles of the Simple BLE
+        Central sample application. The host picks a profile per link, or lets
+        the central switch a link to the bulk transfer profile while discovery
+        or GATT requests are running and back to an idle profile afterwards.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "gap.h"
+#include "central.h"
+#include "ll.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Connection parameter profile
+typedef struct
+{
+  uint16 minInterval;                 // Minimum connection interval in 1.25ms units
+  uint16 maxInterval;                 // Maximum connection interval in 1.25ms units
+  uint16 latency;                     // Slave latency in connection events
+  uint16 timeout;                     // Supervision timeout in 10ms units
+} simpleBLEConnProfile_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Profiles, indexed by SBC_CONN_PROFILE_* - 1
+static const simpleBLEConnProfile_t simpleBLEConnProfiles[] =
+{
+  { 8,   16,  0, 200 },                 // SBC_CONN_PROFILE_BULK: 10-20ms
+  { 6,   12,  0, 100 },                 // SBC_CONN_PROFILE_LOW_LATENCY: 7.5-15ms
+  { 400, 800, 0, 600 }                  // SBC_CONN_PROFILE_LOW_POWER: 0.5-1s
+};
+
+// Task that receives SBC_CONN_IDLE_EVT
+static uint8 simpleBLEConnTaskId;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t simpleBLEConnApply( simpleBLELink_t *pLink, uint8 profile );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEConnInit
+ *
+ * @brief   Initialize the connection parameter profiles.
+ *
+ * @param   task_id - task that receives SBC_CONN_IDLE_EVT
+ *
+ * @return  none
+ */
+void simpleBLEConnInit( uint8 task_id )
+{
+  simpleBLEConnTaskId = task_id;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnSetProfile
+ *
+ * @brief   Select the connection parameter profile of a link. With
+ *          automatic switching the profile is the one used while the
+ *          link is idle, and SBC_CONN_PROFILE_BULK is used while it is
+ *          busy. Without it the profile is applied as is.
+ *
+ * @param   pLink - link
+ * @param   profile - SBC_CONN_PROFILE_*
+ * @param   autoSwitch - TRUE for automatic switching
+ *
+ * @return  SUCCESS, bleNotConnected, INVALIDPARAMETER or the status of
+ *          the update request
+ */
+bStatus_t simpleBLEConnSetProfile( simpleBLELink_t *pLink, uint8 profile, uint8 autoSwitch )
+{
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
+  {
+    return ( bleNotConnected );
+  }
+
+  if ( profile == SBC_CONN_PROFILE_NONE || profile > SBC_CONN_PROFILE_LOW_POWER )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  if ( autoSwitch )
+  {
+    pLink->connIdleProfile = profile;
+
+    // Switch when the link is next found idle
+    osal_start_timerEx( simpleBLEConnTaskId, SBC_CONN_IDLE_EVT, SBC_CONN_IDLE_DELAY );
+
+    return ( SUCCESS );
+  }
+
+  pLink->connIdleProfile = SBC_CONN_PROFILE_NONE;
+
+  return ( simpleBLEConnApply( pLink, profile ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnBusy
+ *
+ * @brief   Note activity on a link. With automatic switching the link
+ *          is moved to SBC_CONN_PROFILE_BULK until it has been idle for
+ *          SBC_CONN_IDLE_DELAY ms.
+ *
+ * @param   pLink - link
+ *
+ * @return  none
+ */
+void simpleBLEConnBusy( simpleBLELink_t *pLink )
+{
+  if ( pLink->connIdleProfile == SBC_CONN_PROFILE_NONE )
+  {
+    return;
+  }
+
+  pLink->connActivity = osal_GetSystemClock();
+
+  if ( pLink->connProfile != SBC_CONN_PROFILE_BULK )
+  {
+    VOID simpleBLEConnApply( pLink, SBC_CONN_PROFILE_BULK );
+  }
+
+  osal_start_timerEx( simpleBLEConnTaskId, SBC_CONN_IDLE_EVT, SBC_CONN_IDLE_DELAY );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnIdleCheck
+ *
+ * @brief   Handle SBC_CONN_IDLE_EVT. Move every automatically switched
+ *          link that has gone idle to its idle profile.
+ *
+ * @return  none
+ */
+void simpleBLEConnIdleCheck( void )
+{
+  simpleBLELink_t *pLink;
+  uint16 connHandle;
+  uint8 pending = FALSE;
+
+  for ( connHandle = 0; connHandle < SBC_MAX_LINKS; connHandle++ )
+  {
+    if ( (pLink = simpleBLEFindLink( connHandle )) == NULL ||
+         pLink->state != BLE_STATE_CONNECTED ||
+         pLink->connIdleProfile == SBC_CONN_PROFILE_NONE ||
+         pLink->connProfile == pLink->connIdleProfile )
+    {
+      continue;
+    }
+
+    if ( pLink->discState == BLE_DISC_STATE_IDLE &&
+         pLink->pGattHead == NULL && pLink->pGattActive == NULL &&
+         osal_GetSystemClock() - pLink->connActivity >= SBC_CONN_IDLE_DELAY &&
+         simpleBLEConnApply( pLink, pLink->connIdleProfile ) == SUCCESS )
+    {
+      continue;
+    }
+
+    // Still busy, or the controller did not take the update
+    pending = TRUE;
+  }
+
+  if ( pending )
+  {
+    osal_start_timerEx( simpleBLEConnTaskId, SBC_CONN_IDLE_EVT, SBC_CONN_IDLE_DELAY );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnUpdated
+ *
+ * @brief   Record the connection parameters of a link and report them
+ *          to the host.
+ *
+ * @param   pLink - link
+ * @param   status - update status
+ * @param   interval - connection interval in 1.25ms units
+ * @param   latency - slave latency
+ * @param   timeout - supervision timeout in 10ms units
+ *
+ * @return  none
+ */
+void simpleBLEConnUpdated( simpleBLELink_t *pLink, uint8 status, uint16 interval,
+                           uint16 latency, uint16 timeout )
+{
+  uint8 buf[10];
+
+  if ( status == SUCCESS )
+  {
+    pLink->connInterval = interval;
+    pLink->connLatency = latency;
+    pLink->connTimeout = timeout;
+  }
+
+  buf[0] = LO_UINT16( pLink->connHandle );
+  buf[1] = HI_UINT16( pLink->connHandle );
+  buf[2] = status;
+  buf[3] = pLink->connProfile;
+  buf[4] = LO_UINT16( pLink->connInterval );
+  buf[5] = HI_UINT16( pLink->connInterval );
+  buf[6] = LO_UINT16( pLink->connLatency );
+  buf[7] = HI_UINT16( pLink->connLatency );
+  buf[8] = LO_UINT16( pLink->connTimeout );
+  buf[9] = HI_UINT16( pLink->connTimeout );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_CONN_PARAMS, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEConnApply
+ *
+ * @brief   Request the parameters of a profile on a link.
+ *
+ * @param   pLink - link
+ * @param   profile - SBC_CONN_PROFILE_*
+ *
+ * @return  status of the update request
+ */
+static bStatus_t simpleBLEConnApply( simpleBLELink_t *pLink, uint8 profile )
+{
+  const simpleBLEConnProfile_t *pProfile = &simpleBLEConnProfiles[profile - 1];
+  bStatus_t status;
+
+  status = GAPCentralRole_UpdateLink( pLink->connHandle,
+                                      pProfile->minInterval, pProfile->maxInterval,
+                                      pProfile->latency, pProfile->timeout );
+  if ( status == SUCCESS )
+  {
+    pLink->connProfile = profile;
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,741 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_disc.c
+
+ @brief This file contains the GATT discovery and handle cache of the Simple
+        BLE Central sample application. Discovered service ranges,
+        characteristic value handles and CCCD handles are kept in SNV per peer
+        so a reconnect to a known peer can skip discovery.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "osal_snv.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "gapbondmgr.h"
+#include "ll.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Length of a primary service entry with a 16-bit and 128-bit UUID
+#define SVC_UUID16_LEN                        (4 + ATT_BT_UUID_SIZE)
+#define SVC_UUID128_LEN                       (4 + ATT_UUID_SIZE)
+
+// Length of a characteristic declaration with a 16-bit and 128-bit UUID
+#define CHAR_UUID16_LEN                       (5 + ATT_BT_UUID_SIZE)
+#define CHAR_UUID128_LEN                      (5 + ATT_UUID_SIZE)
+
+// Offset of the 16 bits kept from a 128-bit UUID
+#define UUID128_SHORT_IDX                     12
+
+// An SNV item holds at most 255 bytes: the address, the counts, the
+// Service Changed handle and the entries
+#if ( B_ADDR_LEN + 4 + 7 * SBC_CACHE_MAX_SVCS + 8 * SBC_CACHE_MAX_CHARS > 255 )
+  #error "SBC_CACHE_MAX_SVCS and SBC_CACHE_MAX_CHARS too large for an SNV item"
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Handle cache NV record
+typedef struct
+{
+  uint8 addr[B_ADDR_LEN];             // Peer address, all zero if unused
+  simpleBLEHdlCache_t cache;          // Cached handles
+} simpleBLECacheRec_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task that receives the discovery responses
+static uint8 simpleBLEDiscTaskId;
+
+// Address of the peer held in each NV slot, all zero if the slot is free
+static uint8 simpleBLECacheAddr[SBC_CACHE_NV_PEERS][B_ADDR_LEN];
+
+// Slot to replace when every slot is in use
+static uint8 simpleBLECacheNextSlot = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 simpleBLEDiscNextSvc( simpleBLELink_t *pLink );
+static uint8 simpleBLEDiscNextDesc( simpleBLELink_t *pLink );
+static uint16 simpleBLEDiscCharEnd( simpleBLEHdlCache_t *pCache, uint8 idx );
+static uint8 simpleBLECacheIdentity( simpleBLELink_t *pLink, uint8 *pAddr );
+static uint8 simpleBLECacheFindSlot( uint8 *pAddr );
+static bStatus_t simpleBLECacheWrite( uint8 slot, uint8 *pAddr, simpleBLEHdlCache_t *pCache );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEDiscInit
+ *
+ * @brief   Initialize discovery and read the addresses of the cached
+ *          peers from SNV.
+ *
+ * @param   task_id - task that receives the discovery responses
+ *
+ * @return  none
+ */
+void simpleBLEDiscInit( uint8 task_id )
+{
+  uint8 i;
+
+  simpleBLEDiscTaskId = task_id;
+
+  for ( i = 0; i < SBC_CACHE_NV_PEERS; i++ )
+  {
+    if ( osal_snv_read( SBC_NVID_CACHE_START + i, B_ADDR_LEN,
+                        simpleBLECacheAddr[i] ) != SUCCESS )
+    {
+      VOID osal_memset( simpleBLECacheAddr[i], 0, B_ADDR_LEN );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscStart
+ *
+ * @brief   Start discovery of a peer's services, characteristics and
+ *          CCCDs.
+ *
+ * @param   pLink - link to discover
+ *
+ * @return  new discovery state, BLE_DISC_STATE_IDLE if discovery
+ *          could not be started
+ */
+uint8 simpleBLEDiscStart( simpleBLELink_t *pLink )
+{
+  VOID osal_memset( &pLink->cache, 0, sizeof( simpleBLEHdlCache_t ) );
+  pLink->discIdx = 0;
+  pLink->discTruncated = FALSE;
+
+  if ( GATT_DiscAllPrimaryServices( pLink->connHandle, simpleBLEDiscTaskId ) != SUCCESS )
+  {
+    return ( BLE_DISC_STATE_IDLE );
+  }
+
+  return ( BLE_DISC_STATE_SVC );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscGattMsg
+ *
+ * @brief   Handle a GATT discovery response. When discovery finishes
+ *          the handles are saved to the peer's cache.
+ *
+ * @param   pLink - link the response belongs to
+ * @param   pMsg - GATT message
+ *
+ * @return  new discovery state, BLE_DISC_STATE_IDLE when done
+ */
+uint8 simpleBLEDiscGattMsg( simpleBLELink_t *pLink, gattMsgEvent_t *pMsg )
+{
+  simpleBLEHdlCache_t *pCache = &pLink->cache;
+  uint8 *p;
+  uint8 i;
+
+  switch ( pLink->discState )
+  {
+    case BLE_DISC_STATE_SVC:
+      // Services found
+      if ( pMsg->method == ATT_READ_BY_GRP_TYPE_RSP &&
+           pMsg->msg.readByGrpTypeRsp.numGrps > 0 &&
+           ( pMsg->msg.readByGrpTypeRsp.len == SVC_UUID16_LEN ||
+             pMsg->msg.readByGrpTypeRsp.len == SVC_UUID128_LEN ) )
+      {
+        p = pMsg->msg.readByGrpTypeRsp.pDataList;
+
+        for ( i = pMsg->msg.readByGrpTypeRsp.numGrps; i > 0; i-- )
+        {
+          if ( pCache->numSvcs < SBC_CACHE_MAX_SVCS )
+          {
+            simpleBLESvc_t *pSvc = &pCache->svc[pCache->numSvcs++];
+
+            pSvc->startHdl = BUILD_UINT16( p[0], p[1] );
+            pSvc->endHdl = BUILD_UINT16( p[2], p[3] );
+
+            if ( pMsg->msg.readByGrpTypeRsp.len == SVC_UUID16_LEN )
+            {
+              pSvc->uuid = BUILD_UINT16( p[4], p[5] );
+              pSvc->uuid128 = FALSE;
+            }
+            else
+            {
+              pSvc->uuid = BUILD_UINT16( p[4 + UUID128_SHORT_IDX], p[5 + UUID128_SHORT_IDX] );
+              pSvc->uuid128 = TRUE;
+            }
+          }
+          else
+          {
+            pLink->discTruncated = TRUE;
+          }
+
+          p += pMsg->msg.readByGrpTypeRsp.len;
+        }
+      }
+
+      // If procedure complete
+      if ( ( pMsg->method == ATT_READ_BY_GRP_TYPE_RSP &&
+             pMsg->hdr.status == bleProcedureComplete ) ||
+           ( pMsg->method == ATT_ERROR_RSP ) )
+      {
+        pLink->discIdx = 0;
+
+        return ( simpleBLEDiscNextSvc( pLink ) );
+      }
+      break;
+
+    case BLE_DISC_STATE_CHAR:
+      // Characteristics found
+      if ( pMsg->method == ATT_READ_BY_TYPE_RSP &&
+           pMsg->msg.readByTypeRsp.numPairs > 0 &&
+           ( pMsg->msg.readByTypeRsp.len == CHAR_UUID16_LEN ||
+             pMsg->msg.readByTypeRsp.len == CHAR_UUID128_LEN ) )
+      {
+        p = pMsg->msg.readByTypeRsp.pDataList;
+
+        for ( i = pMsg->msg.readByTypeRsp.numPairs; i > 0; i-- )
+        {
+          if ( pCache->numChars < SBC_CACHE_MAX_CHARS )
+          {
+            simpleBLEChar_t *pChar = &pCache->chr[pCache->numChars++];
+
+            pChar->props = p[2];
+            pChar->valueHdl = BUILD_UINT16( p[3], p[4] );
+            pChar->cccdHdl = 0;
+
+            if ( pMsg->msg.readByTypeRsp.len == CHAR_UUID16_LEN )
+            {
+              pChar->uuid = BUILD_UINT16( p[5], p[6] );
+              pChar->uuid128 = FALSE;
+
+              if ( pChar->uuid == SERVICE_CHANGED_UUID )
+              {
+                pCache->svcChangedHdl = pChar->valueHdl;
+              }
+            }
+            else
+            {
+              pChar->uuid = BUILD_UINT16( p[5 + UUID128_SHORT_IDX], p[6 + UUID128_SHORT_IDX] );
+              pChar->uuid128 = TRUE;
+            }
+          }
+          else
+          {
+            pLink->discTruncated = TRUE;
+          }
+
+          p += pMsg->msg.readByTypeRsp.len;
+        }
+      }
+
+      // If procedure complete
+      if ( ( pMsg->method == ATT_READ_BY_TYPE_RSP &&
+             pMsg->hdr.status == bleProcedureComplete ) ||
+           ( pMsg->method == ATT_ERROR_RSP ) )
+      {
+        pLink->discIdx++;
+
+        return ( simpleBLEDiscNextSvc( pLink ) );
+      }
+      break;
+
+    case BLE_DISC_STATE_DESC:
+      // Characteristic descriptors found
+      if ( pMsg->method == ATT_FIND_INFO_RSP &&
+           pMsg->msg.findInfoRsp.numInfo > 0 &&
+           pMsg->msg.findInfoRsp.format == ATT_HANDLE_BT_UUID_TYPE )
+      {
+        // For each handle/uuid pair
+        for ( i = 0; i < pMsg->msg.findInfoRsp.numInfo; i++ )
+        {
+          // Look for CCCD
+          if ( ATT_BT_PAIR_UUID( pMsg->msg.findInfoRsp.pInfo, i ) ==
+                                                   GATT_CLIENT_CHAR_CFG_UUID )
+          {
+            pCache->chr[pLink->discIdx].cccdHdl =
+                           ATT_BT_PAIR_HANDLE( pMsg->msg.findInfoRsp.pInfo, i );
+            break;
+          }
+        }
+      }
+
+      // If procedure complete
+      if ( ( pMsg->method == ATT_FIND_INFO_RSP &&
+             pMsg->hdr.status == bleProcedureComplete ) ||
+           ( pMsg->method == ATT_ERROR_RSP ) )
+      {
+        pLink->discIdx++;
+
+        return ( simpleBLEDiscNextDesc( pLink ) );
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return ( pLink->discState );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheLoad
+ *
+ * @brief   Load a peer's handles from SNV into its link. Only
+ *          bonded peers are cached, so any other peer is always
+ *          discovered again.
+ *
+ * @param   pLink - link, with the peer address filled in
+ *
+ * @return  SUCCESS if the peer was cached, FAILURE otherwise
+ */
+bStatus_t simpleBLECacheLoad( simpleBLELink_t *pLink )
+{
+  simpleBLECacheRec_t *pRec;
+  uint8 addr[B_ADDR_LEN];
+  uint8 slot;
+  bStatus_t status = FAILURE;
+
+  if ( !simpleBLECacheIdentity( pLink, addr ) ||
+       (slot = simpleBLECacheFindSlot( addr )) == SBC_CACHE_NV_PEERS )
+  {
+    return ( FAILURE );
+  }
+
+  pRec = (simpleBLECacheRec_t *)osal_mem_alloc( sizeof( simpleBLECacheRec_t ) );
+  if ( pRec == NULL )
+  {
+    return ( bleMemAllocError );
+  }
+
+  if ( osal_snv_read( SBC_NVID_CACHE_START + slot, sizeof( simpleBLECacheRec_t ), pRec ) == SUCCESS &&
+       osal_memcmp( pRec->addr, addr, B_ADDR_LEN ) )
+  {
+    VOID osal_memcpy( &pLink->cache, &pRec->cache, sizeof( simpleBLEHdlCache_t ) );
+    status = SUCCESS;
+  }
+
+  osal_mem_free( pRec );
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheInvalidate
+ *
+ * @brief   Drop a peer's cached handles, e.g. after it indicated
+ *          Service Changed.
+ *
+ * @param   pLink - link of the peer
+ *
+ * @return  none
+ */
+void simpleBLECacheInvalidate( simpleBLELink_t *pLink )
+{
+  uint8 addr[B_ADDR_LEN];
+  uint8 slot;
+
+  if ( !simpleBLECacheIdentity( pLink, addr ) )
+  {
+    VOID osal_memcpy( addr, pLink->addr, B_ADDR_LEN );
+  }
+
+  slot = simpleBLECacheFindSlot( addr );
+
+  if ( slot < SBC_CACHE_NV_PEERS )
+  {
+    VOID simpleBLECacheWrite( slot, NULL, NULL );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheClear
+ *
+ * @brief   Drop the cached handles of every peer.
+ *
+ * @return  none
+ */
+void simpleBLECacheClear( void )
+{
+  uint8 i;
+
+  for ( i = 0; i < SBC_CACHE_NV_PEERS; i++ )
+  {
+    VOID simpleBLECacheWrite( i, NULL, NULL );
+  }
+
+  simpleBLECacheNextSlot = 0;
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheFindChar
+ *
+ * @brief   Find a characteristic with a 16-bit UUID in a link's cache.
+ *
+ * @param   pLink - link
+ * @param   uuid - characteristic UUID
+ *
+ * @return  pointer to the characteristic, or NULL if not found
+ */
+simpleBLEChar_t *simpleBLECacheFindChar( simpleBLELink_t *pLink, uint16 uuid )
+{
+  uint8 i;
+
+  for ( i = 0; i < pLink->cache.numChars; i++ )
+  {
+    if ( pLink->cache.chr[i].uuid == uuid && !pLink->cache.chr[i].uuid128 )
+    {
+      return ( &pLink->cache.chr[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheSave
+ *
+ * @brief   Save a link's handles to SNV. Only bonded peers are cached:
+ *          a server keeps Service Changed state for bonded clients
+ *          only, so for any other peer a stale cache could never be
+ *          invalidated. Peers are stored under their identity address.
+ *          When every slot is in use the slots are reused in turn.
+ *
+ * @param   pLink - link
+ *
+ * @return  none
+ */
+void simpleBLECacheSave( simpleBLELink_t *pLink )
+{
+  uint8 addr[B_ADDR_LEN];
+  uint8 slot;
+
+  if ( !simpleBLECacheIdentity( pLink, addr ) )
+  {
+    return;
+  }
+
+  slot = simpleBLECacheFindSlot( addr );
+
+  if ( slot == SBC_CACHE_NV_PEERS )
+  {
+    uint8 freeAddr[B_ADDR_LEN] = { 0 };
+
+    // Look for a free slot
+    slot = simpleBLECacheFindSlot( freeAddr );
+
+    if ( slot == SBC_CACHE_NV_PEERS )
+    {
+      slot = simpleBLECacheNextSlot;
+
+      if ( ++simpleBLECacheNextSlot == SBC_CACHE_NV_PEERS )
+      {
+        simpleBLECacheNextSlot = 0;
+      }
+    }
+  }
+
+  VOID simpleBLECacheWrite( slot, addr, &pLink->cache );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscWatchSvcChanged
+ *
+ * @brief   Turn on Service Changed indications, so the cache is
+ *          dropped when the peer's database changes. The write is
+ *          queued as an internal request, and its outcome is not
+ *          reported.
+ *
+ * @param   pLink - link
+ *
+ * @return  SUCCESS, FAILURE if the peer has no Service Changed
+ *          descriptor, or the simpleBLEGattQueue status
+ */
+bStatus_t simpleBLEDiscWatchSvcChanged( simpleBLELink_t *pLink )
+{
+  simpleBLEHdlCache_t *pCache = &pLink->cache;
+  uint8 value[2] = { LO_UINT16( GATT_CLIENT_CFG_INDICATE ),
+                     HI_UINT16( GATT_CLIENT_CFG_INDICATE ) };
+  uint8 i;
+
+  for ( i = 0; i < pCache->numChars; i++ )
+  {
+    if ( pCache->svcChangedHdl != 0 &&
+         pCache->chr[i].valueHdl == pCache->svcChangedHdl &&
+         pCache->chr[i].cccdHdl != 0 )
+    {
+      return ( simpleBLEGattQueue( pLink, SBC_GATT_OP_WRITE | SBC_GATT_OP_INTERNAL,
+                                   SBC_GATT_ID_SVC_CHANGED, pCache->chr[i].cccdHdl,
+                                   0, value, sizeof( value ) ) );
+    }
+  }
+
+  return ( FAILURE );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscNextSvc
+ *
+ * @brief   Discover the characteristics of the next service, or move
+ *          on to descriptor discovery after the last one.
+ *
+ * @param   pLink - link
+ *
+ * @return  new discovery state
+ */
+static uint8 simpleBLEDiscNextSvc( simpleBLELink_t *pLink )
+{
+  simpleBLEHdlCache_t *pCache = &pLink->cache;
+
+  while ( pLink->discIdx < pCache->numSvcs )
+  {
+    if ( GATT_DiscAllChars( pLink->connHandle,
+                            pCache->svc[pLink->discIdx].startHdl,
+                            pCache->svc[pLink->discIdx].endHdl,
+                            simpleBLEDiscTaskId ) == SUCCESS )
+    {
+      return ( BLE_DISC_STATE_CHAR );
+    }
+
+    pLink->discIdx++;
+  }
+
+  pLink->discIdx = 0;
+
+  return ( simpleBLEDiscNextDesc( pLink ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscNextDesc
+ *
+ * @brief   Look for the CCCD of the next characteristic that can
+ *          notify or indicate. After the last one the cache is saved,
+ *          unless entries were dropped, and discovery ends.
+ *
+ * @param   pLink - link
+ *
+ * @return  new discovery state
+ */
+static uint8 simpleBLEDiscNextDesc( simpleBLELink_t *pLink )
+{
+  simpleBLEHdlCache_t *pCache = &pLink->cache;
+  uint16 endHdl;
+
+  while ( pLink->discIdx < pCache->numChars )
+  {
+    simpleBLEChar_t *pChar = &pCache->chr[pLink->discIdx];
+
+    if ( pChar->props & ( GATT_PROP_NOTIFY | GATT_PROP_INDICATE ) )
+    {
+      endHdl = simpleBLEDiscCharEnd( pCache, pLink->discIdx );
+
+      if ( pChar->valueHdl < endHdl &&
+           GATT_DiscAllCharDescs( pLink->connHandle, pChar->valueHdl + 1,
+                                  endHdl, simpleBLEDiscTaskId ) == SUCCESS )
+      {
+        return ( BLE_DISC_STATE_DESC );
+      }
+    }
+
+    pLink->discIdx++;
+  }
+
+  // A partial table would hide the rest of the peer on every later
+  // connection
+  if ( !pLink->discTruncated )
+  {
+    simpleBLECacheSave( pLink );
+  }
+
+  return ( BLE_DISC_STATE_IDLE );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEDiscCharEnd
+ *
+ * @brief   Find the last handle of a characteristic: the handle before
+ *          the next characteristic declaration, or the end of its
+ *          service.
+ *
+ * @param   pCache - handle cache
+ * @param   idx - characteristic index
+ *
+ * @return  last handle of the characteristic
+ */
+static uint16 simpleBLEDiscCharEnd( simpleBLEHdlCache_t *pCache, uint8 idx )
+{
+  uint16 valueHdl = pCache->chr[idx].valueHdl;
+  uint16 endHdl = 0xFFFF;
+  uint8 i;
+
+  for ( i = 0; i < pCache->numSvcs; i++ )
+  {
+    if ( valueHdl >= pCache->svc[i].startHdl && valueHdl <= pCache->svc[i].endHdl )
+    {
+      endHdl = pCache->svc[i].endHdl;
+      break;
+    }
+  }
+
+  // The next declaration directly precedes the next value handle
+  if ( idx + 1 < pCache->numChars &&
+       pCache->chr[idx + 1].valueHdl - 2 < endHdl )
+  {
+    endHdl = pCache->chr[idx + 1].valueHdl - 2;
+  }
+
+  return ( endHdl );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheIdentity
+ *
+ * @brief   Look a link's peer up in the bond records.
+ *
+ * @param   pLink - link
+ * @param   pAddr - filled with the peer's identity address if bonded
+ *
+ * @return  TRUE if the peer is bonded
+ */
+static uint8 simpleBLECacheIdentity( simpleBLELink_t *pLink, uint8 *pAddr )
+{
+  return ( GAPBondMgr_ResolveAddr( pLink->addrType, pLink->addr, pAddr ) < GAP_BONDINGS_MAX );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheFindSlot
+ *
+ * @brief   Find the NV slot holding a peer address.
+ *
+ * @param   pAddr - peer address
+ *
+ * @return  slot index, or SBC_CACHE_NV_PEERS if not found
+ */
+static uint8 simpleBLECacheFindSlot( uint8 *pAddr )
+{
+  uint8 i;
+
+  for ( i = 0; i < SBC_CACHE_NV_PEERS; i++ )
+  {
+    if ( osal_memcmp( simpleBLECacheAddr[i], pAddr, B_ADDR_LEN ) )
+    {
+      break;
+    }
+  }
+
+  return ( i );
+}
+
+/*********************************************************************
+ * @fn      simpleBLECacheWrite
+ *
+ * @brief   Write an NV slot. A NULL address frees the slot.
+ *
+ * @param   slot - slot index
+ * @param   pAddr - peer address, or NULL
+ * @param   pCache - handles to store, or NULL
+ *
+ * @return  SUCCESS, bleMemAllocError or the SNV status
+ */
+static bStatus_t simpleBLECacheWrite( uint8 slot, uint8 *pAddr, simpleBLEHdlCache_t *pCache )
+{
+  simpleBLECacheRec_t *pRec;
+  bStatus_t status;
+
+  pRec = (simpleBLECacheRec_t *)osal_mem_alloc( sizeof( simpleBLECacheRec_t ) );
+  if ( pRec == NULL )
+  {
+    return ( bleMemAllocError );
+  }
+
+  VOID osal_memset( pRec, 0, sizeof( simpleBLECacheRec_t ) );
+
+  if ( pAddr != NULL )
+  {
+    VOID osal_memcpy( pRec->addr, pAddr, B_ADDR_LEN );
+    VOID osal_memcpy( &pRec->cache, pCache, sizeof( simpleBLEHdlCache_t ) );
+  }
+
+  status = osal_snv_write( SBC_NVID_CACHE_START + slot, sizeof( simpleBLECacheRec_t ), pRec );
+  if ( status == SUCCESS )
+  {
+    VOID osal_memcpy( simpleBLECacheAddr[slot], pRec->addr, B_ADDR_LEN );
+  }
+
+  osal_mem_free( pRec );
+
+  return ( status );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,785 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_gatt.c
+
+ @brief This file contains the GATT request queue of the Simple BLE Central
+        sample application. Requests from the host are queued per link and
+        issued in order, one request at a time. Write commands are passed to
+        the stack as soon as they reach the head of the queue, for as long as
+        the stack has buffers for them. Value lengths are checked against the
+        MTU of each link.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gatt.h"
+#include "ll.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Data of a queued request, stored right after its header
+#define GATT_REQ_DATA( pReq )                 ((uint8 *)((pReq) + 1))
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Delay in ms before retrying a request the stack had no buffer for
+#define SBC_GATT_RETRY_DELAY                  10
+
+// SBC_EVT_GATT_DATA header: connHandle[2], id, offset[2], len
+#define SBC_GATT_DATA_HDR_LEN                 6
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task that receives the GATT responses
+static uint8 simpleBLEGattTaskId;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t simpleBLEGattIssue( simpleBLELink_t *pLink, simpleBLEGattReq_t *pReq );
+static uint8 simpleBLEGattRetryable( bStatus_t status );
+static void simpleBLEGattDone( simpleBLELink_t *pLink, simpleBLEGattReq_t *pReq,
+                               uint8 status, uint8 errCode );
+static void simpleBLEGattSendData( simpleBLELink_t *pLink, uint8 id, uint16 offset,
+                                   uint8 *pData, uint16 len );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEGattInit
+ *
+ * @brief   Initialize the GATT request queue.
+ *
+ * @param   task_id - task that receives the GATT responses and
+ *                    SBC_GATT_RETRY_EVT
+ *
+ * @return  none
+ */
+void simpleBLEGattInit( uint8 task_id )
+{
+  simpleBLEGattTaskId = task_id;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattQueue
+ *
+ * @brief   Add a GATT request to the end of a link's queue and issue
+ *          it if nothing is ahead of it. Completion is reported to the
+ *          host with SBC_EVT_GATT_COMPLETE carrying the request id, or
+ *          to the device info pipeline for internal requests.
+ *
+ * @param   pLink - link
+ * @param   op - SBC_GATT_OP_*, with SBC_GATT_OP_INTERNAL for requests
+ *               the central makes for itself
+ * @param   id - request id, echoed in the completion
+ * @param   handle - attribute handle, first handle for a read multiple
+ * @param   offset - value offset of a long read or write
+ * @param   pData - value to write, or the remaining handles of a read
+ *                  multiple (LSB first)
+ * @param   len - length of pData
+ *
+ * @return  SUCCESS if queued, bleNotConnected, bleInvalidRange,
+ *          INVALIDPARAMETER, bleNoResources if the queue is full or
+ *          bleMemAllocError
+ */
+bStatus_t simpleBLEGattQueue( simpleBLELink_t *pLink, uint8 op, uint8 id, uint16 handle,
+                              uint16 offset, uint8 *pData, uint8 len )
+{
+  simpleBLEGattReq_t *pReq;
+  uint8 internal = ( op & SBC_GATT_OP_INTERNAL ) ? TRUE : FALSE;
+
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
+  {
+    return ( bleNotConnected );
+  }
+
+  op &= ~SBC_GATT_OP_INTERNAL;
+
+  switch ( op )
+  {
+    case SBC_GATT_OP_READ:
+    case SBC_GATT_OP_READ_LONG:
+    case SBC_GATT_OP_READ_BY_TYPE:
+    case SBC_GATT_OP_EXCHANGE_MTU:
+      if ( len != 0 )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    case SBC_GATT_OP_WRITE:
+    case SBC_GATT_OP_WRITE_NO_RSP:
+      // Opcode and handle
+      if ( len == 0 || len > pLink->mtu - 3 )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    case SBC_GATT_OP_PREPARE_WRITE:
+      // Opcode, handle and offset
+      if ( len == 0 || len > pLink->mtu - 5 )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    case SBC_GATT_OP_WRITE_LONG:
+      if ( len == 0 || (uint32)offset + len > SBC_GATT_MAX_VALUE_LEN )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    case SBC_GATT_OP_EXECUTE_WRITE:
+      // Flags only, the handle is not used
+      if ( len != 1 )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    case SBC_GATT_OP_READ_MULTI:
+      // At least one more handle, and whole handles only
+      if ( len == 0 || ( len & 0x01 ) != 0 )
+      {
+        return ( bleInvalidRange );
+      }
+      break;
+
+    default:
+      return ( INVALIDPARAMETER );
+  }
+
+  if ( handle == 0 &&
+       op != SBC_GATT_OP_EXECUTE_WRITE && op != SBC_GATT_OP_EXCHANGE_MTU )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  if ( pLink->gattQueued >= SBC_GATT_QUEUE_DEPTH )
+  {
+    return ( bleNoResources );
+  }
+
+  pReq = (simpleBLEGattReq_t *)osal_mem_alloc( sizeof( simpleBLEGattReq_t ) + len );
+  if ( pReq == NULL )
+  {
+    return ( bleMemAllocError );
+  }
+
+  pReq->pNext = NULL;
+  pReq->op = op;
+  pReq->id = id;
+  pReq->internal = internal;
+  pReq->handle = handle;
+  pReq->offset = offset;
+  pReq->len = len;
+  osal_memcpy( GATT_REQ_DATA( pReq ), pData, len );
+
+  if ( pLink->pGattTail == NULL )
+  {
+    pLink->pGattHead = pReq;
+  }
+  else
+  {
+    pLink->pGattTail->pNext = pReq;
+  }
+  pLink->pGattTail = pReq;
+  pLink->gattQueued++;
+
+  simpleBLEGattService( pLink );
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattService
+ *
+ * @brief   Issue queued requests of a link, in order. Write commands
+ *          are issued until the stack runs out of buffers; a request
+ *          waits for the one in progress and for a running discovery.
+ *          Requests the stack had no buffer for are retried on
+ *          SBC_GATT_RETRY_EVT.
+ *
+ * @param   pLink - link
+ *
+ * @return  none
+ */
+void simpleBLEGattService( simpleBLELink_t *pLink )
+{
+  simpleBLEGattReq_t *pReq;
+  bStatus_t status;
+
+  if ( pLink->state != BLE_STATE_CONNECTED )
+  {
+    return;
+  }
+
+  while ( (pReq = pLink->pGattHead) != NULL )
+  {
+    if ( pReq->op != SBC_GATT_OP_WRITE_NO_RSP &&
+         ( pLink->pGattActive != NULL || pLink->discState > BLE_DISC_STATE_PENDING ) )
+    {
+      // Only one request may be outstanding on a link
+      break;
+    }
+
+    status = simpleBLEGattIssue( pLink, pReq );
+
+    if ( simpleBLEGattRetryable( status ) )
+    {
+      osal_start_timerEx( simpleBLEGattTaskId, SBC_GATT_RETRY_EVT, SBC_GATT_RETRY_DELAY );
+      break;
+    }
+
+    // Take the request off the queue
+    pLink->pGattHead = pReq->pNext;
+    if ( pLink->pGattHead == NULL )
+    {
+      pLink->pGattTail = NULL;
+    }
+
+    if ( status == SUCCESS )
+    {
+      simpleBLEConnBusy( pLink );
+    }
+
+    if ( status == SUCCESS && pReq->op != SBC_GATT_OP_WRITE_NO_RSP )
+    {
+      // Completes when the response arrives
+      pLink->pGattActive = pReq;
+    }
+    else
+    {
+      // Write commands are done once the stack has them
+      simpleBLEGattDone( pLink, pReq, status, 0 );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattRetry
+ *
+ * @brief   Retry the queued requests of every link. Called on
+ *          SBC_GATT_RETRY_EVT.
+ *
+ * @return  none
+ */
+void simpleBLEGattRetry( void )
+{
+  simpleBLELink_t *pLink;
+  uint16 connHandle;
+
+  for ( connHandle = 0; connHandle < SBC_MAX_LINKS; connHandle++ )
+  {
+    if ( (pLink = simpleBLEFindLink( connHandle )) != NULL &&
+         pLink->pGattHead != NULL )
+    {
+      simpleBLEGattService( pLink );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattMsg
+ *
+ * @brief   Handle a response to the request in progress on a link.
+ *          Read values are sent to the host with SBC_EVT_GATT_DATA.
+ *          When the request is complete the next one is issued, or
+ *          pending discovery is started.
+ *
+ * @param   pLink - link the response belongs to
+ * @param   pMsg - GATT message
+ *
+ * @return  none
+ */
+void simpleBLEGattMsg( simpleBLELink_t *pLink, gattMsgEvent_t *pMsg )
+{
+  simpleBLEGattReq_t *pReq = pLink->pGattActive;
+  uint8 done = FALSE;
+  uint8 status = SUCCESS;
+  uint8 errCode = 0;
+
+  if ( pMsg->method == ATT_ERROR_RSP )
+  {
+    done = TRUE;
+    status = FAILURE;
+    errCode = pMsg->msg.errorRsp.errCode;
+  }
+  else if ( pMsg->hdr.status == bleTimeout )
+  {
+    done = TRUE;
+    status = bleTimeout;
+  }
+  else
+  {
+    switch ( pMsg->method )
+    {
+      case ATT_READ_RSP:
+        simpleBLEGattSendData( pLink, pReq->id, 0,
+                               pMsg->msg.readRsp.pValue, pMsg->msg.readRsp.len );
+        done = TRUE;
+        break;
+
+      case ATT_READ_BLOB_RSP:
+        // The last response of a long read carries no value
+        if ( pMsg->msg.readBlobRsp.len > 0 )
+        {
+          simpleBLEGattSendData( pLink, pReq->id, pReq->offset,
+                                 pMsg->msg.readBlobRsp.pValue, pMsg->msg.readBlobRsp.len );
+          pReq->offset += pMsg->msg.readBlobRsp.len;
+        }
+        done = ( pMsg->hdr.status == bleProcedureComplete );
+        break;
+
+      case ATT_READ_MULTI_RSP:
+        simpleBLEGattSendData( pLink, pReq->id, 0,
+                               pMsg->msg.readMultiRsp.pValues, pMsg->msg.readMultiRsp.len );
+        done = TRUE;
+        break;
+
+      case ATT_READ_BY_TYPE_RSP:
+        // Only the value of the first attribute found is kept
+        if ( pMsg->msg.readByTypeRsp.numPairs > 0 && pMsg->msg.readByTypeRsp.len > 2 )
+        {
+          uint8 *pValue = &pMsg->msg.readByTypeRsp.pDataList[2];
+          uint8 len = pMsg->msg.readByTypeRsp.len - 2;
+
+          if ( pReq->internal )
+          {
+            simpleBLEInfoValue( pLink, pReq->id, pValue, len );
+          }
+          else
+          {
+            simpleBLEGattSendData( pLink, pReq->id, 0, pValue, len );
+          }
+        }
+        done = ( pMsg->hdr.status == bleProcedureComplete );
+        break;
+
+      case ATT_WRITE_RSP:
+      case ATT_EXECUTE_WRITE_RSP:
+        done = TRUE;
+        break;
+
+      case ATT_PREPARE_WRITE_RSP:
+        // Each segment of a long write is answered as well
+        done = ( pReq->op == SBC_GATT_OP_PREPARE_WRITE );
+        break;
+
+      case ATT_EXCHANGE_MTU_RSP:
+        simpleBLELinkMtu( pLink, MIN( SBC_ATT_MTU, pMsg->msg.exchangeMTURsp.serverRxMTU ) );
+        done = TRUE;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if ( done )
+  {
+    pLink->pGattActive = NULL;
+    simpleBLEGattDone( pLink, pReq, status, errCode );
+
+    if ( pLink->discState == BLE_DISC_STATE_PENDING )
+    {
+      // Discovery was held back by this request
+      osal_set_event( simpleBLEGattTaskId, START_DISCOVERY_EVT );
+    }
+    else
+    {
+      simpleBLEGattService( pLink );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattFlush
+ *
+ * @brief   Drop every request of a link, including the one in
+ *          progress, and report each to the host with the given status.
+ *          Called when the link goes down.
+ *
+ * @param   pLink - link
+ * @param   status - completion status to report
+ *
+ * @return  none
+ */
+void simpleBLEGattFlush( simpleBLELink_t *pLink, uint8 status )
+{
+  simpleBLEGattReq_t *pReq;
+
+  if ( pLink->pGattActive != NULL )
+  {
+    pReq = pLink->pGattActive;
+    pLink->pGattActive = NULL;
+    simpleBLEGattDone( pLink, pReq, status, 0 );
+  }
+
+  while ( (pReq = pLink->pGattHead) != NULL )
+  {
+    pLink->pGattHead = pReq->pNext;
+    simpleBLEGattDone( pLink, pReq, status, 0 );
+  }
+
+  pLink->pGattTail = NULL;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattIssue
+ *
+ * @brief   Hand a queued request to the stack.
+ *
+ * @param   pLink - link
+ * @param   pReq - request
+ *
+ * @return  status of the GATT call
+ */
+static bStatus_t simpleBLEGattIssue( simpleBLELink_t *pLink, simpleBLEGattReq_t *pReq )
+{
+  uint16 connHandle = pLink->connHandle;
+  bStatus_t status;
+
+  switch ( pReq->op )
+  {
+    case SBC_GATT_OP_READ:
+      {
+        attReadReq_t req;
+
+        req.handle = pReq->handle;
+        status = GATT_ReadCharValue( connHandle, &req, simpleBLEGattTaskId );
+      }
+      break;
+
+    case SBC_GATT_OP_READ_LONG:
+      {
+        attReadBlobReq_t req;
+
+        req.handle = pReq->handle;
+        req.offset = pReq->offset;
+        status = GATT_ReadLongCharValue( connHandle, &req, simpleBLEGattTaskId );
+      }
+      break;
+
+    case SBC_GATT_OP_READ_BY_TYPE:
+      {
+        attReadByTypeReq_t req;
+
+        req.startHandle = GATT_MIN_HANDLE;
+        req.endHandle = GATT_MAX_HANDLE;
+        req.type.len = ATT_BT_UUID_SIZE;
+        req.type.uuid[0] = LO_UINT16( pReq->handle );
+        req.type.uuid[1] = HI_UINT16( pReq->handle );
+        status = GATT_ReadUsingCharUUID( connHandle, &req, simpleBLEGattTaskId );
+      }
+      break;
+
+    case SBC_GATT_OP_READ_MULTI:
+      {
+        attReadMultiReq_t req;
+
+        req.pHandles = GATT_bm_alloc( connHandle, ATT_READ_MULTI_REQ, 2 + pReq->len, NULL );
+        if ( req.pHandles == NULL )
+        {
+          return ( bleMemAllocError );
+        }
+
+        req.pHandles[0] = LO_UINT16( pReq->handle );
+        req.pHandles[1] = HI_UINT16( pReq->handle );
+        osal_memcpy( &req.pHandles[2], GATT_REQ_DATA( pReq ), pReq->len );
+        req.numHandles = 1 + ( pReq->len >> 1 );
+
+        status = GATT_ReadMultiCharValues( connHandle, &req, simpleBLEGattTaskId );
+        if ( status != SUCCESS )
+        {
+          GATT_bm_free( (gattMsg_t *)&req, ATT_READ_MULTI_REQ );
+        }
+      }
+      break;
+
+    case SBC_GATT_OP_WRITE:
+    case SBC_GATT_OP_WRITE_NO_RSP:
+      {
+        attWriteReq_t req;
+        uint8 opcode = ( pReq->op == SBC_GATT_OP_WRITE ) ? ATT_WRITE_REQ : ATT_WRITE_CMD;
+
+        req.pValue = GATT_bm_alloc( connHandle, opcode, pReq->len, NULL );
+        if ( req.pValue == NULL )
+        {
+          return ( bleMemAllocError );
+        }
+
+        req.handle = pReq->handle;
+        req.len = pReq->len;
+        osal_memcpy( req.pValue, GATT_REQ_DATA( pReq ), pReq->len );
+        req.sig = FALSE;
+        req.cmd = ( opcode == ATT_WRITE_CMD );
+
+        if ( opcode == ATT_WRITE_REQ )
+        {
+          status = GATT_WriteCharValue( connHandle, &req, simpleBLEGattTaskId );
+        }
+        else
+        {
+          status = GATT_WriteNoRsp( connHandle, &req );
+        }
+
+        if ( status != SUCCESS )
+        {
+          GATT_bm_free( (gattMsg_t *)&req, opcode );
+        }
+      }
+      break;
+
+    case SBC_GATT_OP_WRITE_LONG:
+    case SBC_GATT_OP_PREPARE_WRITE:
+      {
+        attPrepareWriteReq_t req;
+
+        req.pValue = GATT_bm_alloc( connHandle, ATT_PREPARE_WRITE_REQ, pReq->len, NULL );
+        if ( req.pValue == NULL )
+        {
+          return ( bleMemAllocError );
+        }
+
+        req.handle = pReq->handle;
+        req.offset = pReq->offset;
+        req.len = pReq->len;
+        osal_memcpy( req.pValue, GATT_REQ_DATA( pReq ), pReq->len );
+
+        if ( pReq->op == SBC_GATT_OP_WRITE_LONG )
+        {
+          status = GATT_WriteLongCharValue( connHandle, &req, simpleBLEGattTaskId );
+        }
+        else
+        {
+          status = GATT_PrepareWriteReq( connHandle, &req, simpleBLEGattTaskId );
+        }
+
+        if ( status != SUCCESS )
+        {
+          GATT_bm_free( (gattMsg_t *)&req, ATT_PREPARE_WRITE_REQ );
+        }
+      }
+      break;
+
+    case SBC_GATT_OP_EXECUTE_WRITE:
+      {
+        attExecuteWriteReq_t req;
+
+        req.flags = GATT_REQ_DATA( pReq )[0];
+        status = GATT_ExecuteWriteReq( connHandle, &req, simpleBLEGattTaskId );
+      }
+      break;
+
+    case SBC_GATT_OP_EXCHANGE_MTU:
+      {
+        attExchangeMTUReq_t req;
+
+        req.clientRxMTU = SBC_ATT_MTU;
+        status = GATT_ExchangeMTU( connHandle, &req, simpleBLEGattTaskId );
+      }
+      break;
+
+    default:
+      status = INVALIDPARAMETER;
+      break;
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattRetryable
+ *
+ * @brief   Check whether a request failed only because the stack was
+ *          out of buffers or busy, and should stay queued.
+ *
+ * @param   status - status of the GATT call
+ *
+ * @return  TRUE if the request should be retried later
+ */
+static uint8 simpleBLEGattRetryable( bStatus_t status )
+{
+  return ( status == MSG_BUFFER_NOT_AVAIL || status == bleMemAllocError ||
+           status == bleNoResources || status == blePending );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattDone
+ *
+ * @brief   Report a finished request to the host, or if internal to
+ *          the bulk subscribe for a write and to the device info
+ *          pipeline for a read, and free it. The request must already
+ *          be off the queue.
+ *
+ * @param   pLink - link
+ * @param   pReq - request
+ * @param   status - completion status, FAILURE if the peer returned
+ *                   an error response
+ * @param   errCode - ATT error code of the error response, else 0
+ *
+ * @return  none
+ */
+static void simpleBLEGattDone( simpleBLELink_t *pLink, simpleBLEGattReq_t *pReq,
+                               uint8 status, uint8 errCode )
+{
+  uint8 buf[6];
+
+  if ( pReq->internal )
+  {
+    uint8 op = pReq->op;
+    uint8 id = pReq->id;
+
+    pLink->gattQueued--;
+    osal_mem_free( pReq );
+
+    // May queue the next write or item
+    if ( op == SBC_GATT_OP_EXCHANGE_MTU )
+    {
+      // The host hears of a new MTU through SBC_EVT_MTU_UPDATED, a
+      // refused exchange leaves the link at the default
+    }
+    else if ( op == SBC_GATT_OP_WRITE && id == SBC_GATT_ID_SVC_CHANGED )
+    {
+      // Nothing waits on it, a peer that refuses is rediscovered
+      // on its next connection anyway
+    }
+    else if ( op == SBC_GATT_OP_WRITE )
+    {
+      simpleBLESubDone( pLink, status );
+    }
+    else
+    {
+      simpleBLEInfoDone( pLink, status );
+    }
+    return;
+  }
+
+  buf[0] = LO_UINT16( pLink->connHandle );
+  buf[1] = HI_UINT16( pLink->connHandle );
+  buf[2] = pReq->id;
+  buf[3] = pReq->op;
+  buf[4] = status;
+  buf[5] = errCode;
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_GATT_COMPLETE, buf, sizeof( buf ) );
+
+  pLink->gattQueued--;
+  osal_mem_free( pReq );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEGattSendData
+ *
+ * @brief   Send a read value to the host, split over as many
+ *          SBC_EVT_GATT_DATA frames as it takes.
+ *
+ * @param   pLink - link
+ * @param   id - request id
+ * @param   offset - offset of the data in the attribute value
+ * @param   pData - value
+ * @param   len - value length
+ *
+ * @return  none
+ */
+static void simpleBLEGattSendData( simpleBLELink_t *pLink, uint8 id, uint16 offset,
+                                   uint8 *pData, uint16 len )
+{
+  uint8 hdr[SBC_GATT_DATA_HDR_LEN];
+  uint8 n;
+
+  do
+  {
+    n = ( len > SBC_FRAME_MAX_PAYLOAD - SBC_GATT_DATA_HDR_LEN ) ?
+        SBC_FRAME_MAX_PAYLOAD - SBC_GATT_DATA_HDR_LEN : (uint8)len;
+
+    hdr[0] = LO_UINT16( pLink->connHandle );
+    hdr[1] = HI_UINT16( pLink->connHandle );
+    hdr[2] = id;
+    hdr[3] = LO_UINT16( offset );
+    hdr[4] = HI_UINT16( offset );
+    hdr[5] = n;
+
+    // Encoded straight from the response, which is freed after this
+    VOID simpleBLECmdSendFrameParts( SBC_EVT_GATT_DATA, hdr, SBC_GATT_DATA_HDR_LEN, pData, n );
+
+    pData += n;
+    offset += n;
+    len -= n;
+  } while ( len > 0 );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,328 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_info.c
+
+ @brief This file contains the device info pipeline of the Simple BLE Central
+        sample application. Right after connecting, the peer's GAP name and
+        appearance and its Device Information characteristics are read back to
+        back with Read By Type requests and reported to the host in one frame.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gatt.h"
+#include "gatt_uuid.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// SBC_EVT_DEV_INFO header: connHandle[2], status, numItems
+#define SBC_INFO_HDR_LEN                      4
+
+// Item header: item, len
+#define SBC_INFO_ITEM_HDR_LEN                 2
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Characteristic UUIDs, indexed by SBC_INFO_*
+static const uint16 simpleBLEInfoUuids[SBC_INFO_NUM_ITEMS] =
+{
+  DEVICE_NAME_UUID,
+  APPEARANCE_UUID,
+  MANUFACTURER_NAME_UUID,
+  MODEL_NUMBER_UUID,
+  SERIAL_NUMBER_UUID,
+  HARDWARE_REV_UUID,
+  FIRMWARE_REV_UUID,
+  SOFTWARE_REV_UUID,
+  SYSTEM_ID_UUID,
+  PNP_ID_UUID
+};
+
+// TRUE while an item is being queued, so a request that fails at once
+// does not queue the next item from within the queue
+static uint8 simpleBLEInfoQueuing = FALSE;
+
+// Set if the item being queued already completed
+static uint8 simpleBLEInfoFailed = FALSE;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static bStatus_t simpleBLEInfoNext( simpleBLELink_t *pLink );
+static void simpleBLEInfoFinish( simpleBLELink_t *pLink, uint8 status );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEInfoStart
+ *
+ * @brief   Start reading device info items from a peer. The requests
+ *          go through the link's GATT queue one after the other, each
+ *          issued as soon as the previous response is in, and the
+ *          values are reported in one SBC_EVT_DEV_INFO at the end.
+ *          Items the peer does not have are left out.
+ *
+ * @param   pLink - link
+ * @param   mask - items to read, bit n for SBC_INFO_* item n
+ *
+ * @return  SUCCESS, bleNotConnected, bleInvalidRange, blePending if
+ *          a read is already running on the link, or the status of
+ *          queuing the first request
+ */
+bStatus_t simpleBLEInfoStart( simpleBLELink_t *pLink, uint16 mask )
+{
+  bStatus_t status;
+
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
+  {
+    return ( bleNotConnected );
+  }
+
+  mask &= SBC_INFO_ALL;
+  if ( mask == 0 )
+  {
+    return ( bleInvalidRange );
+  }
+
+  if ( pLink->pInfo != NULL )
+  {
+    return ( blePending );
+  }
+
+  pLink->pInfo = osal_mem_alloc( SBC_FRAME_MAX_PAYLOAD );
+  if ( pLink->pInfo == NULL )
+  {
+    return ( bleMemAllocError );
+  }
+
+  pLink->pInfo[0] = LO_UINT16( pLink->connHandle );
+  pLink->pInfo[1] = HI_UINT16( pLink->connHandle );
+  pLink->pInfo[2] = SUCCESS;
+  pLink->pInfo[3] = 0;
+  pLink->infoLen = SBC_INFO_HDR_LEN;
+  pLink->infoMask = mask;
+
+  status = simpleBLEInfoNext( pLink );
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEInfoValue
+ *
+ * @brief   Add a value read from the peer. Values are cut short when
+ *          the frame is full.
+ *
+ * @param   pLink - link
+ * @param   item - SBC_INFO_* item
+ * @param   pValue - value
+ * @param   len - value length
+ *
+ * @return  none
+ */
+void simpleBLEInfoValue( simpleBLELink_t *pLink, uint8 item, uint8 *pValue, uint8 len )
+{
+  uint8 *p;
+
+  if ( pLink->pInfo == NULL ||
+       pLink->infoLen + SBC_INFO_ITEM_HDR_LEN > SBC_FRAME_MAX_PAYLOAD )
+  {
+    return;
+  }
+
+  if ( len > SBC_FRAME_MAX_PAYLOAD - SBC_INFO_ITEM_HDR_LEN - pLink->infoLen )
+  {
+    len = SBC_FRAME_MAX_PAYLOAD - SBC_INFO_ITEM_HDR_LEN - pLink->infoLen;
+  }
+
+  p = &pLink->pInfo[pLink->infoLen];
+  p[0] = item;
+  p[1] = len;
+  osal_memcpy( &p[SBC_INFO_ITEM_HDR_LEN], pValue, len );
+
+  pLink->infoLen += SBC_INFO_ITEM_HDR_LEN + len;
+  pLink->pInfo[3]++;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEInfoDone
+ *
+ * @brief   An item's request completed. Queue the next one, or report
+ *          the values if it was the last. A peer without the item
+ *          answers with an error response, which is not an error here.
+ *
+ * @param   pLink - link
+ * @param   status - request status, bleNotConnected if the link went
+ *                   down
+ *
+ * @return  none
+ */
+void simpleBLEInfoDone( simpleBLELink_t *pLink, uint8 status )
+{
+  if ( pLink->pInfo == NULL )
+  {
+    return;
+  }
+
+  if ( status == bleNotConnected )
+  {
+    // Nobody left to report on
+    osal_mem_free( pLink->pInfo );
+    pLink->pInfo = NULL;
+    pLink->infoMask = 0;
+    return;
+  }
+
+  if ( simpleBLEInfoQueuing )
+  {
+    simpleBLEInfoFailed = TRUE;
+    return;
+  }
+
+  VOID simpleBLEInfoNext( pLink );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEInfoNext
+ *
+ * @brief   Queue the request for the next item still to read, or
+ *          finish if there is none.
+ *
+ * @param   pLink - link
+ *
+ * @return  SUCCESS if a request is pending, otherwise the status the
+ *          read finished with
+ */
+static bStatus_t simpleBLEInfoNext( simpleBLELink_t *pLink )
+{
+  bStatus_t status = SUCCESS;
+  uint8 item;
+
+  while ( pLink->infoMask != 0 )
+  {
+    for ( item = 0; ( pLink->infoMask & ( 1 << item ) ) == 0; item++ )
+    {
+      ;
+    }
+    pLink->infoMask &= ~( 1 << item );
+
+    simpleBLEInfoQueuing = TRUE;
+    simpleBLEInfoFailed = FALSE;
+
+    status = simpleBLEGattQueue( pLink, SBC_GATT_OP_READ_BY_TYPE | SBC_GATT_OP_INTERNAL,
+                                 item, simpleBLEInfoUuids[item], 0, NULL, 0 );
+
+    simpleBLEInfoQueuing = FALSE;
+
+    if ( status != SUCCESS )
+    {
+      break;
+    }
+
+    if ( simpleBLEInfoFailed == FALSE )
+    {
+      // Completes when the response arrives
+      return ( SUCCESS );
+    }
+  }
+
+  simpleBLEInfoFinish( pLink, status );
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEInfoFinish
+ *
+ * @brief   Send SBC_EVT_DEV_INFO with the values read so far and end
+ *          the read.
+ *
+ * @param   pLink - link
+ * @param   status - status to report
+ *
+ * @return  none
+ */
+static void simpleBLEInfoFinish( simpleBLELink_t *pLink, uint8 status )
+{
+  pLink->pInfo[2] = status;
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_DEV_INFO, pLink->pInfo, pLink->infoLen );
+
+  osal_mem_free( pLink->pInfo );
+  pLink->pInfo = NULL;
+  pLink->infoMask = 0;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,546 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_recon.c
+
+ @brief This file contains the reconnect supervisor of the Simple BLE Central
+        sample application. The host gives it a list of target peers. Whenever
+        a target is not connected the supervisor puts the down targets in the
+        white list and initiates a connection to any of them. Failed attempts
+        are retried with an exponential, jittered backoff.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "hci.h"
+#include "gap.h"
+#include "ll.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Reconnect target
+typedef struct
+{
+  uint8 inUse;                        // TRUE if the entry holds a target
+  uint8 connected;                    // TRUE while a link to the target is up
+  uint8 addrType;                     // Target address type
+  uint8 addr[B_ADDR_LEN];             // Target address
+} simpleBLEReconTarget_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task that receives SBC_RECON_EVT
+static uint8 simpleBLEReconTaskId;
+
+// Target list
+static simpleBLEReconTarget_t simpleBLEReconTargets[SBC_RECON_MAX_TARGETS];
+
+// Supervisor state
+static uint8 simpleBLEReconState = SBC_RECON_IDLE;
+
+// Backoff before the next attempt in ms, without jitter
+static uint16 simpleBLEReconDelay = SBC_RECON_MIN_DELAY;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static simpleBLEReconTarget_t *simpleBLEReconFind( uint8 *pAddr );
+static uint8 simpleBLEReconNumDown( void );
+static void simpleBLEReconSchedule( uint16 delay );
+static void simpleBLEReconBackoff( void );
+static void simpleBLEReconStart( void );
+static void simpleBLEReconCancel( void );
+static void simpleBLEReconReport( uint16 delay );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEReconInit
+ *
+ * @brief   Initialize the reconnect supervisor with an empty target
+ *          list.
+ *
+ * @param   task_id - task that receives SBC_RECON_EVT
+ *
+ * @return  none
+ */
+void simpleBLEReconInit( uint8 task_id )
+{
+  simpleBLEReconTaskId = task_id;
+
+  VOID osal_memset( simpleBLEReconTargets, 0, sizeof( simpleBLEReconTargets ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconAdd
+ *
+ * @brief   Add a peer to the target list. A target that is not
+ *          connected is reconnected right away.
+ *
+ * @param   addrType - target address type
+ * @param   pAddr - target address, least significant byte first
+ *
+ * @return  SUCCESS, bleAlreadyInRequestedMode if already a target or
+ *          bleNoResources if the list is full
+ */
+bStatus_t simpleBLEReconAdd( uint8 addrType, uint8 *pAddr )
+{
+  simpleBLEReconTarget_t *pTarget;
+  simpleBLELink_t *pLink;
+  uint16 connHandle;
+  uint8 i;
+
+  if ( simpleBLEReconFind( pAddr ) != NULL )
+  {
+    return ( bleAlreadyInRequestedMode );
+  }
+
+  for ( i = 0; i < SBC_RECON_MAX_TARGETS; i++ )
+  {
+    if ( !simpleBLEReconTargets[i].inUse )
+    {
+      break;
+    }
+  }
+
+  if ( i == SBC_RECON_MAX_TARGETS )
+  {
+    return ( bleNoResources );
+  }
+
+  pTarget = &simpleBLEReconTargets[i];
+  pTarget->inUse = TRUE;
+  pTarget->connected = FALSE;
+  pTarget->addrType = addrType;
+  VOID osal_memcpy( pTarget->addr, pAddr, B_ADDR_LEN );
+
+  // The target may already be connected
+  for ( connHandle = 0; connHandle < SBC_MAX_LINKS; connHandle++ )
+  {
+    if ( (pLink = simpleBLEFindLink( connHandle )) != NULL &&
+         osal_memcmp( pLink->addr, pAddr, B_ADDR_LEN ) )
+    {
+      pTarget->connected = TRUE;
+    }
+  }
+
+  if ( !pTarget->connected )
+  {
+    // Restart the attempt with the new target in the white list
+    simpleBLEReconCancel();
+    simpleBLEReconDelay = SBC_RECON_MIN_DELAY;
+    simpleBLEReconSchedule( 0 );
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconRemove
+ *
+ * @brief   Remove a peer from the target list. An existing link to it
+ *          is kept.
+ *
+ * @param   pAddr - target address, least significant byte first, or
+ *                  NULL to remove every target
+ *
+ * @return  SUCCESS or INVALIDPARAMETER if the peer is not a target
+ */
+bStatus_t simpleBLEReconRemove( uint8 *pAddr )
+{
+  simpleBLEReconTarget_t *pTarget = NULL;
+
+  if ( pAddr == NULL )
+  {
+    VOID osal_memset( simpleBLEReconTargets, 0, sizeof( simpleBLEReconTargets ) );
+  }
+  else if ( (pTarget = simpleBLEReconFind( pAddr )) != NULL )
+  {
+    pTarget->inUse = FALSE;
+  }
+  else
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  if ( pTarget == NULL || !pTarget->connected )
+  {
+    // The white list no longer matches the targets that are down
+    simpleBLEReconCancel();
+    simpleBLEReconSchedule( 0 );
+  }
+
+  return ( SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconLinkUp
+ *
+ * @brief   Track the outcome of a link establishment. Called for every
+ *          GAP_LINK_ESTABLISHED_EVENT, whoever started it.
+ *
+ * @param   status - link establishment status
+ * @param   pAddr - peer address, least significant byte first
+ *
+ * @return  none
+ */
+void simpleBLEReconLinkUp( uint8 status, uint8 *pAddr )
+{
+  simpleBLEReconTarget_t *pTarget;
+  uint8 initiating = ( simpleBLEReconState == SBC_RECON_INITIATING );
+
+  if ( initiating || simpleBLEReconState == SBC_RECON_CANCELING )
+  {
+    // The supervisor's attempt is over
+    VOID osal_stop_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT );
+    simpleBLEReconState = SBC_RECON_IDLE;
+  }
+
+  if ( status == SUCCESS )
+  {
+    if ( (pTarget = simpleBLEReconFind( pAddr )) != NULL )
+    {
+      pTarget->connected = TRUE;
+    }
+
+    // Go straight for any other target that is down
+    simpleBLEReconDelay = SBC_RECON_MIN_DELAY;
+    simpleBLEReconSchedule( 0 );
+  }
+  else if ( initiating )
+  {
+    simpleBLEReconBackoff();
+  }
+  else
+  {
+    // Canceled by the supervisor or a host connection failed, the
+    // initiator is free again
+    simpleBLEReconSchedule( 0 );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconLinkDown
+ *
+ * @brief   Start reconnecting when a link to a target goes down.
+ *
+ * @param   pAddr - peer address, least significant byte first
+ *
+ * @return  none
+ */
+void simpleBLEReconLinkDown( uint8 *pAddr )
+{
+  simpleBLEReconTarget_t *pTarget = simpleBLEReconFind( pAddr );
+
+  if ( pTarget != NULL )
+  {
+    pTarget->connected = FALSE;
+
+    // First attempt right away, the peer is most likely still near
+    simpleBLEReconCancel();
+    simpleBLEReconDelay = SBC_RECON_MIN_DELAY;
+    simpleBLEReconSchedule( 0 );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconProcess
+ *
+ * @brief   Handle SBC_RECON_EVT. Starts a connection attempt when the
+ *          backoff has run out, or gives up an attempt that has run
+ *          for SBC_RECON_WINDOW ms.
+ *
+ * @return  none
+ */
+void simpleBLEReconProcess( void )
+{
+  if ( simpleBLEReconState == SBC_RECON_INITIATING )
+  {
+    // Attempt window is over, the failed establishment backs off
+    VOID simpleBLEDisconnect( GAP_CONNHANDLE_INIT );
+  }
+  else
+  {
+    simpleBLEReconStart();
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconFind
+ *
+ * @brief   Find a target by address.
+ *
+ * @param   pAddr - address, least significant byte first
+ *
+ * @return  target, or NULL if the peer is not a target
+ */
+static simpleBLEReconTarget_t *simpleBLEReconFind( uint8 *pAddr )
+{
+  uint8 i;
+
+  for ( i = 0; i < SBC_RECON_MAX_TARGETS; i++ )
+  {
+    if ( simpleBLEReconTargets[i].inUse &&
+         osal_memcmp( simpleBLEReconTargets[i].addr, pAddr, B_ADDR_LEN ) )
+    {
+      return ( &simpleBLEReconTargets[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconNumDown
+ *
+ * @brief   Count the targets that are not connected.
+ *
+ * @return  number of targets down
+ */
+static uint8 simpleBLEReconNumDown( void )
+{
+  uint8 num = 0;
+  uint8 i;
+
+  for ( i = 0; i < SBC_RECON_MAX_TARGETS; i++ )
+  {
+    if ( simpleBLEReconTargets[i].inUse && !simpleBLEReconTargets[i].connected )
+    {
+      num++;
+    }
+  }
+
+  return ( num );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconSchedule
+ *
+ * @brief   Schedule the next connection attempt if any target is down
+ *          and no attempt is running.
+ *
+ * @param   delay - delay in ms
+ *
+ * @return  none
+ */
+static void simpleBLEReconSchedule( uint16 delay )
+{
+  if ( simpleBLEReconState == SBC_RECON_INITIATING ||
+       simpleBLEReconState == SBC_RECON_CANCELING )
+  {
+    // Scheduled again when the attempt ends
+    return;
+  }
+
+  if ( simpleBLEReconNumDown() == 0 )
+  {
+    VOID osal_stop_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT );
+    simpleBLEReconState = SBC_RECON_IDLE;
+    return;
+  }
+
+  simpleBLEReconState = SBC_RECON_WAITING;
+
+  if ( delay == 0 )
+  {
+    VOID osal_stop_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT );
+    osal_set_event( simpleBLEReconTaskId, SBC_RECON_EVT );
+  }
+  else
+  {
+    osal_start_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT, delay );
+  }
+
+  simpleBLEReconReport( delay );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconBackoff
+ *
+ * @brief   Schedule a retry after the current backoff with up to 25%
+ *          jitter either way, then double the backoff.
+ *
+ * @return  none
+ */
+static void simpleBLEReconBackoff( void )
+{
+  uint16 delay = simpleBLEReconDelay;
+  uint16 jitter = delay >> 2;
+
+  if ( jitter > 0 )
+  {
+    // Spread retries so targets lost together do not retry in step
+    delay = delay - jitter + ( osal_rand() % ( 2 * jitter + 1 ) );
+  }
+
+  if ( simpleBLEReconDelay < SBC_RECON_MAX_DELAY / 2 )
+  {
+    simpleBLEReconDelay <<= 1;
+  }
+  else
+  {
+    simpleBLEReconDelay = SBC_RECON_MAX_DELAY;
+  }
+
+  simpleBLEReconSchedule( delay );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconStart
+ *
+ * @brief   Load the targets that are down into the white list and
+ *          initiate a connection to whichever of them is seen first.
+ *
+ * @return  none
+ */
+static void simpleBLEReconStart( void )
+{
+  uint8 i;
+
+  if ( simpleBLEReconNumDown() == 0 )
+  {
+    simpleBLEReconState = SBC_RECON_IDLE;
+    return;
+  }
+
+  VOID HCI_LE_ClearWhiteListCmd();
+
+  for ( i = 0; i < SBC_RECON_MAX_TARGETS; i++ )
+  {
+    if ( simpleBLEReconTargets[i].inUse && !simpleBLEReconTargets[i].connected )
+    {
+      VOID HCI_LE_AddWhiteListCmd( simpleBLEReconTargets[i].addrType,
+                                   simpleBLEReconTargets[i].addr );
+    }
+  }
+
+  if ( simpleBLEConnect( ADDRTYPE_PUBLIC, NULL ) == SUCCESS )
+  {
+    simpleBLEReconState = SBC_RECON_INITIATING;
+    osal_start_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT, SBC_RECON_WINDOW );
+    simpleBLEReconReport( 0 );
+  }
+  else
+  {
+    // Scanning or a host connection in progress, try again later
+    simpleBLEReconBackoff();
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconCancel
+ *
+ * @brief   Cancel a running connection attempt or pending retry. A
+ *          running attempt ends with a failed link establishment,
+ *          which schedules the next attempt.
+ *
+ * @return  none
+ */
+static void simpleBLEReconCancel( void )
+{
+  VOID osal_stop_timerEx( simpleBLEReconTaskId, SBC_RECON_EVT );
+
+  if ( simpleBLEReconState == SBC_RECON_INITIATING &&
+       simpleBLEDisconnect( GAP_CONNHANDLE_INIT ) == SUCCESS )
+  {
+    simpleBLEReconState = SBC_RECON_CANCELING;
+  }
+  else if ( simpleBLEReconState != SBC_RECON_CANCELING )
+  {
+    simpleBLEReconState = SBC_RECON_IDLE;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEReconReport
+ *
+ * @brief   Report the supervisor state to the host.
+ *
+ * @param   delay - delay before the next attempt in ms, if waiting
+ *
+ * @return  none
+ */
+static void simpleBLEReconReport( uint16 delay )
+{
+  uint8 buf[4];
+
+  buf[0] = simpleBLEReconState;
+  buf[1] = simpleBLEReconNumDown();
+  buf[2] = LO_UINT16( delay );
+  buf[3] = HI_UINT16( delay );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_RECON, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,351 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_scan.c
+
+ @brief This file contains the streaming scan report mode of the Simple BLE
+        Central sample application. Advertisements are forwarded to the host as
+        they arrive, with duplicate suppression keyed by device address.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "gap.h"
+#include "gatt.h"
+#include "ll.h"
+#include "central.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Number of slots of the duplicate suppression table. Advertisements
+// and scan responses of a device take one slot each.
+#if !defined( SBC_SCAN_DUP_TABLE_SIZE )
+#define SBC_SCAN_DUP_TABLE_SIZE               64
+#endif
+
+#if ( SBC_SCAN_DUP_TABLE_SIZE & ( SBC_SCAN_DUP_TABLE_SIZE - 1 ) ) || ( SBC_SCAN_DUP_TABLE_SIZE > 256 )
+#error "SBC_SCAN_DUP_TABLE_SIZE must be a power of 2 no larger than 256"
+#endif
+
+// Slots searched from a device's home slot. A device is only ever stored
+// within this window so a lookup never needs to look further.
+#if !defined( SBC_SCAN_DUP_PROBES )
+#define SBC_SCAN_DUP_PROBES                   8
+#endif
+
+#if ( SBC_SCAN_DUP_PROBES > SBC_SCAN_DUP_TABLE_SIZE )
+#error "SBC_SCAN_DUP_PROBES must not exceed SBC_SCAN_DUP_TABLE_SIZE"
+#endif
+
+// Advertising report header: eventType, addrType, addr[6], rssi, dataLen
+#define SBC_ADV_REPORT_HDR_LEN                (4 + B_ADDR_LEN)
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Duplicate suppression entry
+typedef struct
+{
+  uint8  inUse;                       // TRUE if the entry is valid
+  uint8  scanRsp;                     // TRUE if tracking scan responses
+  uint8  addr[B_ADDR_LEN];            // Device address
+  uint32 lastReport;                  // System clock of the last report
+} simpleBLEScanDup_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// TRUE while streaming scan reports
+static uint8 simpleBLEScanStreamOn = FALSE;
+
+// Minimum time in ms between reports for the same device, 0 to report
+// every advertisement
+static uint16 simpleBLEScanInterval = 0;
+
+// Recently reported devices
+static simpleBLEScanDup_t simpleBLEScanDupTable[SBC_SCAN_DUP_TABLE_SIZE];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 simpleBLEScanIsDuplicate( gapDeviceInfoEvent_t *pInfo );
+static uint8 simpleBLEScanDupHash( uint8 *pAddr, uint8 scanRsp );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEScanStream
+ *
+ * @brief   Turn the streaming scan report mode on or off. While on,
+ *          device discovery is restarted as soon as it completes and
+ *          every advertisement is forwarded to the host, except
+ *          repeats of a device within the re-report interval.
+ *
+ * @param   enable - TRUE to start streaming, FALSE to stop
+ * @param   interval - minimum time in ms between reports for the same
+ *                     device, 0 to report every advertisement
+ *
+ * @return  SUCCESS or the status of starting discovery
+ */
+bStatus_t simpleBLEScanStream( uint8 enable, uint16 interval )
+{
+  bStatus_t status = SUCCESS;
+
+  osal_memset( simpleBLEScanDupTable, 0, sizeof( simpleBLEScanDupTable ) );
+  simpleBLEScanInterval = interval;
+
+  if ( enable )
+  {
+    // Duplicates are suppressed here, on a time basis, so the
+    // controller must pass every report up
+    GAP_SetParamValue( TGAP_FILTER_ADV_REPORTS, FALSE );
+
+    simpleBLEScanStreamOn = TRUE;
+
+    status = simpleBLEStartScan();
+    if ( status == bleAlreadyInRequestedMode )
+    {
+      // The running discovery will be restarted in streaming mode
+      status = SUCCESS;
+    }
+    else if ( status != SUCCESS )
+    {
+      simpleBLEScanStreamOn = FALSE;
+    }
+  }
+  else if ( simpleBLEScanStreamOn )
+  {
+    simpleBLEScanStreamOn = FALSE;
+
+    GAP_SetParamValue( TGAP_FILTER_ADV_REPORTS, TRUE );
+    VOID GAPCentralRole_CancelDiscovery();
+  }
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEScanStreaming
+ *
+ * @brief   Check whether the streaming scan report mode is on.
+ *
+ * @return  TRUE if streaming
+ */
+uint8 simpleBLEScanStreaming( void )
+{
+  return ( simpleBLEScanStreamOn );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEScanReport
+ *
+ * @brief   Forward an advertisement or scan response to the host,
+ *          unless it repeats a recent report or the UART is behind.
+ *
+ * @param   pInfo - device information event
+ *
+ * @return  none
+ */
+void simpleBLEScanReport( gapDeviceInfoEvent_t *pInfo )
+{
+  uint8 buf[SBC_ADV_REPORT_HDR_LEN + B_MAX_ADV_LEN];
+  uint8 dataLen;
+  uint8 i;
+
+  // Reports are not recorded as sent while the UART is behind
+  if ( !simpleBLEScanStreamOn || simpleBLECmdTxBackedUp() ||
+       simpleBLEScanIsDuplicate( pInfo ) )
+  {
+    return;
+  }
+
+  dataLen = ( pInfo->dataLen > B_MAX_ADV_LEN ) ? B_MAX_ADV_LEN : pInfo->dataLen;
+
+  buf[0] = pInfo->eventType;
+  buf[1] = pInfo->addrType;
+
+  // Address is sent most significant byte first, as in SBC_CMD_CONNECT
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    buf[2 + i] = pInfo->addr[B_ADDR_LEN - 1 - i];
+  }
+
+  buf[2 + B_ADDR_LEN] = (uint8)pInfo->rssi;
+  buf[3 + B_ADDR_LEN] = dataLen;
+  osal_memcpy( &buf[SBC_ADV_REPORT_HDR_LEN], pInfo->pEvtData, dataLen );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_ADV_REPORT, buf, SBC_ADV_REPORT_HDR_LEN + dataLen );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEScanIsDuplicate
+ *
+ * @brief   Check a report against the duplicate table and record it.
+ *          Advertisements and scan responses of a device are tracked
+ *          separately so the scan response data is not suppressed by
+ *          the advertisement that preceded it. The table is hashed on
+ *          the address and a device is kept within SBC_SCAN_DUP_PROBES
+ *          slots of its home slot. A new device takes a free slot of
+ *          that window, or else the least recently reported one, so a
+ *          crowd of devices only evicts entries that share its window.
+ *
+ * @param   pInfo - device information event
+ *
+ * @return  TRUE if the device was reported within the interval
+ */
+static uint8 simpleBLEScanIsDuplicate( gapDeviceInfoEvent_t *pInfo )
+{
+  simpleBLEScanDup_t *pEntry = NULL;
+  simpleBLEScanDup_t *pOldest = NULL;
+  uint8 scanRsp = ( pInfo->eventType == GAP_ADRPT_SCAN_RSP );
+  uint32 now = osal_GetSystemClock();
+  uint8 idx;
+  uint8 i;
+
+  if ( simpleBLEScanInterval == 0 )
+  {
+    return ( FALSE );
+  }
+
+  idx = simpleBLEScanDupHash( pInfo->addr, scanRsp );
+
+  for ( i = 0; i < SBC_SCAN_DUP_PROBES; i++ )
+  {
+    simpleBLEScanDup_t *pDup = &simpleBLEScanDupTable[idx];
+
+    if ( !pDup->inUse )
+    {
+      // Free slots are taken before any used one
+      if ( pOldest == NULL || pOldest->inUse )
+      {
+        pOldest = pDup;
+      }
+    }
+    else if ( pDup->scanRsp == scanRsp &&
+              osal_memcmp( pDup->addr, pInfo->addr, B_ADDR_LEN ) )
+    {
+      pEntry = pDup;
+      break;
+    }
+    else if ( pOldest == NULL ||
+              ( pOldest->inUse &&
+                ( now - pDup->lastReport ) > ( now - pOldest->lastReport ) ) )
+    {
+      pOldest = pDup;
+    }
+
+    idx = ( idx + 1 ) & ( SBC_SCAN_DUP_TABLE_SIZE - 1 );
+  }
+
+  if ( pEntry != NULL )
+  {
+    if ( ( now - pEntry->lastReport ) < simpleBLEScanInterval )
+    {
+      return ( TRUE );
+    }
+  }
+  else
+  {
+    pEntry = pOldest;
+    pEntry->inUse = TRUE;
+    pEntry->scanRsp = scanRsp;
+    osal_memcpy( pEntry->addr, pInfo->addr, B_ADDR_LEN );
+  }
+
+  pEntry->lastReport = now;
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEScanDupHash
+ *
+ * @brief   Home slot of a device in the duplicate table.
+ *
+ * @param   pAddr - device address
+ * @param   scanRsp - TRUE for the scan response entry
+ *
+ * @return  table index
+ */
+static uint8 simpleBLEScanDupHash( uint8 *pAddr, uint8 scanRsp )
+{
+  uint8 hash = scanRsp;
+  uint8 i;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    hash = (uint8)( ( hash << 1 ) | ( hash >> 7 ) ) ^ pAddr[i];
+  }
+
+  return ( hash & ( SBC_SCAN_DUP_TABLE_SIZE - 1 ) );
+}
+
+/*********************************************************************
+*********************************************************************/
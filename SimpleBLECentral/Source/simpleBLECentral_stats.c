@@ -0,0 +1,404 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_stats.c
+
+ @brief This file contains the connection lifecycle statistics of the
+        Simple BLE Central sample application: how long each link takes
+        to be established, discovered and to deliver its first
+        notification, and why links fail, for CC2540 and CC2541.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "gap.h"
+#include "central.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// SBC_EVT_CONN_TIMING length: connHandle[2], reason, durations, upTime[4]
+#define SBC_STATS_TIMING_LEN                  ( 3 + 2 * SBC_STATS_NUM_PHASES + 4 )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Durations of one phase over every link
+typedef struct
+{
+  uint16 count;                       // Links that reached the phase
+  uint16 last;                        // Last duration in ms
+  uint16 min;                         // Shortest duration in ms
+  uint16 max;                         // Longest duration in ms
+  uint32 sum;                         // Sum of the durations in ms
+} simpleBLEStatsPhase_t;
+
+// Failure counter
+typedef struct
+{
+  uint8  kind;                        // SBC_STATS_FAIL_*
+  uint8  reason;                      // Status or reason code
+  uint16 count;                       // Failures seen
+} simpleBLEStatsReason_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Link establishment requests accepted by the stack
+static uint16 simpleBLEStatsAttempts = 0;
+
+// Phase durations, indexed by SBC_STATS_PHASE_*
+static simpleBLEStatsPhase_t simpleBLEStatsPhases[SBC_STATS_NUM_PHASES];
+
+// Failure counters, in the order the reasons were first seen
+static simpleBLEStatsReason_t simpleBLEStatsReasons[SBC_STATS_MAX_REASONS];
+static uint8 simpleBLEStatsNumReasons = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void simpleBLEStatsRecord( simpleBLELink_t *pLink, uint8 phase, uint32 duration );
+static uint8 *simpleBLEStatsPut16( uint8 *pBuf, uint16 value );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEStatsConnect
+ *
+ * @brief   Count a link establishment request the stack accepted.
+ *
+ * @return  none
+ */
+void simpleBLEStatsConnect( void )
+{
+  simpleBLEStatsAttempts++;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsLinkUp
+ *
+ * @brief   Record the outcome of a link establishment. The setup
+ *          time is the one the central role measured from the
+ *          request, and the link's other phases are timed from now.
+ *
+ * @param   pLink - established link, NULL if none
+ * @param   status - link establishment status
+ *
+ * @return  none
+ */
+void simpleBLEStatsLinkUp( simpleBLELink_t *pLink, uint8 status )
+{
+  uint32 setupTime;
+  uint8 i;
+
+  if ( status != SUCCESS )
+  {
+    simpleBLEStatsFailure( SBC_STATS_FAIL_ESTABLISH, status );
+  }
+  else if ( pLink != NULL )
+  {
+    pLink->statsUpTime = osal_GetSystemClock();
+
+    for ( i = 0; i < SBC_STATS_NUM_PHASES; i++ )
+    {
+      pLink->statsPhase[i] = SBC_STATS_NONE;
+    }
+
+    if ( GAPCentralRole_GetParameter( GAPCENTRALROLE_LINK_SETUP_TIME, &setupTime ) == SUCCESS )
+    {
+      simpleBLEStatsRecord( pLink, SBC_STATS_PHASE_SETUP, setupTime );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsPhase
+ *
+ * @brief   Time a phase of a link from its establishment, the first
+ *          time the link reaches it.
+ *
+ * @param   pLink - link
+ * @param   phase - SBC_STATS_PHASE_DISC or SBC_STATS_PHASE_NOTI
+ *
+ * @return  none
+ */
+void simpleBLEStatsPhase( simpleBLELink_t *pLink, uint8 phase )
+{
+  if ( pLink->statsPhase[phase] == SBC_STATS_NONE )
+  {
+    simpleBLEStatsRecord( pLink, phase, osal_GetSystemClock() - pLink->statsUpTime );
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsFailure
+ *
+ * @brief   Count a failure. Once SBC_STATS_MAX_REASONS distinct
+ *          reasons are counted, new ones are dropped.
+ *
+ * @param   kind - SBC_STATS_FAIL_*
+ * @param   reason - status or reason code
+ *
+ * @return  none
+ */
+void simpleBLEStatsFailure( uint8 kind, uint8 reason )
+{
+  simpleBLEStatsReason_t *pReason;
+  uint8 i;
+
+  for ( i = 0; i < simpleBLEStatsNumReasons; i++ )
+  {
+    pReason = &simpleBLEStatsReasons[i];
+
+    if ( pReason->kind == kind && pReason->reason == reason )
+    {
+      if ( pReason->count < 0xFFFF )
+      {
+        pReason->count++;
+      }
+
+      return;
+    }
+  }
+
+  if ( simpleBLEStatsNumReasons < SBC_STATS_MAX_REASONS )
+  {
+    pReason = &simpleBLEStatsReasons[simpleBLEStatsNumReasons++];
+    pReason->kind = kind;
+    pReason->reason = reason;
+    pReason->count = 1;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsLinkDown
+ *
+ * @brief   Count the termination reason of a link and report its
+ *          phase durations and up time to the host in one
+ *          SBC_EVT_CONN_TIMING. Must be called before the link is
+ *          reset.
+ *
+ * @param   pLink - terminated link, NULL if unknown
+ * @param   reason - termination reason
+ *
+ * @return  none
+ */
+void simpleBLEStatsLinkDown( simpleBLELink_t *pLink, uint8 reason )
+{
+  uint8 buf[SBC_STATS_TIMING_LEN];
+  uint8 *p = buf;
+  uint32 upTime;
+  uint8 i;
+
+  simpleBLEStatsFailure( SBC_STATS_FAIL_TERMINATE, reason );
+
+  if ( pLink == NULL )
+  {
+    return;
+  }
+
+  upTime = osal_GetSystemClock() - pLink->statsUpTime;
+
+  p = simpleBLEStatsPut16( p, pLink->connHandle );
+  *p++ = reason;
+
+  for ( i = 0; i < SBC_STATS_NUM_PHASES; i++ )
+  {
+    p = simpleBLEStatsPut16( p, pLink->statsPhase[i] );
+  }
+
+  *p++ = BREAK_UINT32( upTime, 0 );
+  *p++ = BREAK_UINT32( upTime, 1 );
+  *p++ = BREAK_UINT32( upTime, 2 );
+  *p++ = BREAK_UINT32( upTime, 3 );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_CONN_TIMING, buf, sizeof( buf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsRead
+ *
+ * @brief   Build the SBC_CMD_CONN_STATS record: the request count,
+ *          the count, last, min, max and mean duration of each phase,
+ *          and the failure counters.
+ *
+ * @param   pBuf - buffer of at least 3 + 10 * SBC_STATS_NUM_PHASES +
+ *                 4 * SBC_STATS_MAX_REASONS bytes
+ *
+ * @return  record length
+ */
+uint8 simpleBLEStatsRead( uint8 *pBuf )
+{
+  simpleBLEStatsPhase_t *pPhase;
+  uint8 *p = pBuf;
+  uint8 i;
+
+  p = simpleBLEStatsPut16( p, simpleBLEStatsAttempts );
+
+  for ( i = 0; i < SBC_STATS_NUM_PHASES; i++ )
+  {
+    pPhase = &simpleBLEStatsPhases[i];
+
+    p = simpleBLEStatsPut16( p, pPhase->count );
+    p = simpleBLEStatsPut16( p, pPhase->last );
+    p = simpleBLEStatsPut16( p, pPhase->min );
+    p = simpleBLEStatsPut16( p, pPhase->max );
+    p = simpleBLEStatsPut16( p, ( pPhase->count != 0 ) ?
+                                (uint16)( pPhase->sum / pPhase->count ) : 0 );
+  }
+
+  *p++ = simpleBLEStatsNumReasons;
+
+  for ( i = 0; i < simpleBLEStatsNumReasons; i++ )
+  {
+    *p++ = simpleBLEStatsReasons[i].kind;
+    *p++ = simpleBLEStatsReasons[i].reason;
+    p = simpleBLEStatsPut16( p, simpleBLEStatsReasons[i].count );
+  }
+
+  return ( (uint8)( p - pBuf ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsClear
+ *
+ * @brief   Clear every counter and phase duration. Links that are up
+ *          keep their own timing.
+ *
+ * @return  none
+ */
+void simpleBLEStatsClear( void )
+{
+  simpleBLEStatsAttempts = 0;
+  simpleBLEStatsNumReasons = 0;
+  VOID osal_memset( simpleBLEStatsPhases, 0, sizeof( simpleBLEStatsPhases ) );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEStatsRecord
+ *
+ * @brief   Record a phase duration on a link and in the totals.
+ *
+ * @param   pLink - link
+ * @param   phase - SBC_STATS_PHASE_*
+ * @param   duration - duration in ms
+ *
+ * @return  none
+ */
+static void simpleBLEStatsRecord( simpleBLELink_t *pLink, uint8 phase, uint32 duration )
+{
+  simpleBLEStatsPhase_t *pPhase = &simpleBLEStatsPhases[phase];
+  uint16 ms = ( duration < SBC_STATS_NONE ) ? (uint16)duration : SBC_STATS_NONE - 1;
+
+  pLink->statsPhase[phase] = ms;
+
+  if ( pPhase->count == 0xFFFF )
+  {
+    return;
+  }
+
+  if ( pPhase->count == 0 || ms < pPhase->min )
+  {
+    pPhase->min = ms;
+  }
+
+  if ( ms > pPhase->max )
+  {
+    pPhase->max = ms;
+  }
+
+  pPhase->last = ms;
+  pPhase->sum += ms;
+  pPhase->count++;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEStatsPut16
+ *
+ * @brief   Write a 16-bit value, least significant byte first.
+ *
+ * @param   pBuf - where to write
+ * @param   value - value
+ *
+ * @return  pointer past the value
+ */
+static uint8 *simpleBLEStatsPut16( uint8 *pBuf, uint16 value )
+{
+  *pBuf++ = LO_UINT16( value );
+  *pBuf++ = HI_UINT16( value );
+
+  return ( pBuf );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,379 @@
+/******************************************************************************
+
+ @file  simpleBLECentral_sub.c
+
+ @brief This file contains the bulk subscribe of the Simple BLE Central
+        sample application, which writes the CCCD of every cached
+        characteristic, or of a selection of them, in one host command
+        for CC2540 and CC2541.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "gatt.h"
+#include "gattservapp.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Cache entries are tracked in 32-bit masks
+#if ( SBC_CACHE_MAX_CHARS > 32 )
+  #error "SBC_CACHE_MAX_CHARS may not exceed 32 with the bulk subscribe"
+#endif
+
+// SBC_EVT_SUBSCRIBE length: connHandle[2], status, mode, selected[4], written[4]
+#define SBC_SUB_EVT_LEN                       12
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// TRUE while a write is being queued, so a request that fails at once
+// does not queue the next write from within the queue
+static uint8 simpleBLESubQueuing = FALSE;
+
+// Set if the write being queued already completed
+static uint8 simpleBLESubFailed = FALSE;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 simpleBLESubSelect( simpleBLEChar_t *pChar, uint8 mode,
+                                 uint8 *pUuids, uint8 numUuids );
+static bStatus_t simpleBLESubNext( simpleBLELink_t *pLink );
+static void simpleBLESubFinish( simpleBLELink_t *pLink, uint8 status );
+static uint8 *simpleBLESubPut32( uint8 *pBuf, uint32 value );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLESubStart
+ *
+ * @brief   Write the CCCD of every cached characteristic the mode
+ *          applies to, optionally only those with one of the given
+ *          UUIDs. The writes go through the link's GATT queue, each
+ *          issued as soon as the previous response is in, and the
+ *          outcome is reported in one SBC_EVT_SUBSCRIBE at the end.
+ *
+ * @param   pLink - link
+ * @param   mode - SBC_SUB_*
+ * @param   pUuids - UUIDs to select, least significant byte first
+ * @param   numUuids - number of UUIDs, 0 to select every characteristic
+ *
+ * @return  SUCCESS, bleNotConnected, INVALIDPARAMETER, blePending if
+ *          discovery or a subscribe is running on the link, or the
+ *          status of queuing the first write
+ */
+bStatus_t simpleBLESubStart( simpleBLELink_t *pLink, uint8 mode, uint8 *pUuids, uint8 numUuids )
+{
+  uint8 i;
+
+  if ( pLink == NULL || pLink->state != BLE_STATE_CONNECTED )
+  {
+    return ( bleNotConnected );
+  }
+
+  if ( mode > SBC_SUB_AUTO )
+  {
+    return ( INVALIDPARAMETER );
+  }
+
+  // The CCCD handles come from discovery
+  if ( pLink->subChar != SBC_SUB_NONE || pLink->discState != BLE_DISC_STATE_IDLE )
+  {
+    return ( blePending );
+  }
+
+  pLink->subMask = 0;
+
+  for ( i = 0; i < pLink->cache.numChars; i++ )
+  {
+    if ( simpleBLESubSelect( &pLink->cache.chr[i], mode, pUuids, numUuids ) )
+    {
+      pLink->subMask |= (uint32)1 << i;
+    }
+  }
+
+  pLink->subSelected = pLink->subMask;
+  pLink->subWritten = 0;
+  pLink->subMode = mode;
+
+  return ( simpleBLESubNext( pLink ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLESubDone
+ *
+ * @brief   A CCCD write completed. Queue the next one, or report the
+ *          outcome if it was the last.
+ *
+ * @param   pLink - link
+ * @param   status - write status, bleNotConnected if the link went
+ *                   down
+ *
+ * @return  none
+ */
+void simpleBLESubDone( simpleBLELink_t *pLink, uint8 status )
+{
+  if ( pLink->subChar == SBC_SUB_NONE )
+  {
+    return;
+  }
+
+  if ( status == bleNotConnected )
+  {
+    // Nobody left to report on
+    pLink->subChar = SBC_SUB_NONE;
+    pLink->subMask = 0;
+    return;
+  }
+
+  if ( status == SUCCESS )
+  {
+    pLink->subWritten |= (uint32)1 << pLink->subChar;
+  }
+
+  if ( simpleBLESubQueuing )
+  {
+    simpleBLESubFailed = TRUE;
+    return;
+  }
+
+  VOID simpleBLESubNext( pLink );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLESubSelect
+ *
+ * @brief   Check whether a subscribe applies to a characteristic.
+ *
+ * @param   pChar - cached characteristic
+ * @param   mode - SBC_SUB_*
+ * @param   pUuids - UUIDs to select, least significant byte first
+ * @param   numUuids - number of UUIDs, 0 to select any
+ *
+ * @return  TRUE if its CCCD is to be written
+ */
+static uint8 simpleBLESubSelect( simpleBLEChar_t *pChar, uint8 mode,
+                                 uint8 *pUuids, uint8 numUuids )
+{
+  uint8 i;
+
+  if ( pChar->cccdHdl == 0 )
+  {
+    return ( FALSE );
+  }
+
+  if ( ( mode == SBC_SUB_NOTIFY && !( pChar->props & GATT_PROP_NOTIFY ) ) ||
+       ( mode == SBC_SUB_INDICATE && !( pChar->props & GATT_PROP_INDICATE ) ) ||
+       ( mode == SBC_SUB_AUTO && !( pChar->props & ( GATT_PROP_NOTIFY | GATT_PROP_INDICATE ) ) ) )
+  {
+    return ( FALSE );
+  }
+
+  if ( numUuids == 0 )
+  {
+    return ( TRUE );
+  }
+
+  for ( i = 0; i < numUuids; i++ )
+  {
+    if ( BUILD_UINT16( pUuids[2 * i], pUuids[2 * i + 1] ) == pChar->uuid )
+    {
+      return ( TRUE );
+    }
+  }
+
+  return ( FALSE );
+}
+
+/*********************************************************************
+ * @fn      simpleBLESubNext
+ *
+ * @brief   Queue the write of the next CCCD still to write, or finish
+ *          if there is none.
+ *
+ * @param   pLink - link
+ *
+ * @return  SUCCESS if a write is pending, otherwise the status the
+ *          subscribe finished with
+ */
+static bStatus_t simpleBLESubNext( simpleBLELink_t *pLink )
+{
+  simpleBLEChar_t *pChar;
+  bStatus_t status = SUCCESS;
+  uint16 cfg;
+  uint8 value[2];
+  uint8 i;
+
+  while ( pLink->subMask != 0 )
+  {
+    for ( i = 0; ( pLink->subMask & ( (uint32)1 << i ) ) == 0; i++ )
+    {
+      ;
+    }
+    pLink->subMask &= ~( (uint32)1 << i );
+    pLink->subChar = i;
+
+    pChar = &pLink->cache.chr[i];
+
+    if ( pLink->subMode == SBC_SUB_AUTO )
+    {
+      cfg = ( pChar->props & GATT_PROP_NOTIFY ) ? GATT_CLIENT_CFG_NOTIFY
+                                                : GATT_CLIENT_CFG_INDICATE;
+    }
+    else
+    {
+      cfg = pLink->subMode;
+    }
+
+    value[0] = LO_UINT16( cfg );
+    value[1] = HI_UINT16( cfg );
+
+    simpleBLESubQueuing = TRUE;
+    simpleBLESubFailed = FALSE;
+
+    status = simpleBLEGattQueue( pLink, SBC_GATT_OP_WRITE | SBC_GATT_OP_INTERNAL,
+                                 i, pChar->cccdHdl, 0, value, sizeof( value ) );
+
+    simpleBLESubQueuing = FALSE;
+
+    if ( status != SUCCESS )
+    {
+      break;
+    }
+
+    if ( simpleBLESubFailed == FALSE )
+    {
+      // Completes when the response arrives
+      return ( SUCCESS );
+    }
+  }
+
+  simpleBLESubFinish( pLink, status );
+
+  return ( status );
+}
+
+/*********************************************************************
+ * @fn      simpleBLESubFinish
+ *
+ * @brief   Send SBC_EVT_SUBSCRIBE and end the subscribe.
+ *
+ * @param   pLink - link
+ * @param   status - status to report
+ *
+ * @return  none
+ */
+static void simpleBLESubFinish( simpleBLELink_t *pLink, uint8 status )
+{
+  uint8 buf[SBC_SUB_EVT_LEN];
+  uint8 *p = buf;
+
+  *p++ = LO_UINT16( pLink->connHandle );
+  *p++ = HI_UINT16( pLink->connHandle );
+  *p++ = status;
+  *p++ = pLink->subMode;
+  p = simpleBLESubPut32( p, pLink->subSelected );
+  VOID simpleBLESubPut32( p, pLink->subWritten );
+
+  VOID simpleBLECmdSendFrame( SBC_EVT_SUBSCRIBE, buf, sizeof( buf ) );
+
+  pLink->subChar = SBC_SUB_NONE;
+  pLink->subMask = 0;
+}
+
+/*********************************************************************
+ * @fn      simpleBLESubPut32
+ *
+ * @brief   Write a 32-bit value, least significant byte first.
+ *
+ * @param   pBuf - where to write
+ * @param   value - value
+ *
+ * @return  pointer past the value
+ */
+static uint8 *simpleBLESubPut32( uint8 *pBuf, uint32 value )
+{
+  *pBuf++ = BREAK_UINT32( value, 0 );
+  *pBuf++ = BREAK_UINT32( value, 1 );
+  *pBuf++ = BREAK_UINT32( value, 2 );
+  *pBuf++ = BREAK_UINT32( value, 3 );
+
+  return ( pBuf );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,257 @@
+/******************************************************************************
+
+ @file  bench_advfilter.c
+
+ @brief Host benchmark of AdvFilter_Match, the per-advertisement cost of
+        the scan filters. Each criterion is timed on its own, passing and
+        failing, against a full 31 byte advertisement with the matching
+        AD structure last, followed by the worst case of every filter in
+        use and none passing, and by reports with a malformed AD length.
+        The result of every case is checked as well, so a wrong answer
+        fails the run.
+
+        Times are host nanoseconds per call. They rank the criteria and
+        show how the cost grows with the AD data; they do not predict
+        8051 cycle counts.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+// clock_gettime
+#define _POSIX_C_SOURCE                       199309L
+
+#include <stdlib.h>
+#include <time.h>
+#include "host_test.h"
+#include "advfilter.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if !defined( BENCH_ITERATIONS )
+#define BENCH_ITERATIONS                      2000000UL
+#endif
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Benchmark case
+typedef struct
+{
+  const char  *name;
+  int8        rssi;
+  const uint8 *pAddr;
+  const uint8 *pData;
+  uint8       dataLen;
+  uint8       expect;                 // Expected AdvFilter_Match result
+} benchCase_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Address, least significant byte first
+static const uint8 benchAddr[B_ADDR_LEN] = { 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
+
+// Full advertisement: flags, complete 16-bit UUID list, complete
+// 128-bit UUID list, name, manufacturer data
+static const uint8 benchAdv[31] =
+{
+  0x02, 0x01, 0x06,
+  0x07, GAP_ADTYPE_16BIT_COMPLETE, 0x0A, 0x18, 0x0F, 0x18, 0xF0, 0xFF,
+  0x03, GAP_ADTYPE_128BIT_COMPLETE, 0x00, 0x00,   // too short for a UUID
+  0x06, GAP_ADTYPE_LOCAL_NAME_COMPLETE, 'S', 'e', 'n', 's', 'e',
+  0x05, GAP_ADTYPE_MANUFACTURER_SPECIFIC, 0x0D, 0x00, 0x01, 0x02,
+  0x00, 0x00, 0x00
+};
+
+// Scan response with a 128-bit UUID list
+static const uint8 benchRsp[31] =
+{
+  0x11, GAP_ADTYPE_128BIT_COMPLETE,
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+  0x0B, GAP_ADTYPE_LOCAL_NAME_SHORT, 'S', 'e', 'n', 's', 'o', 'r', 'T', 'a', 'g', 'X',
+  0x00
+};
+
+// AD structure whose length runs past the end of the data
+static const uint8 benchOverrun[31] =
+{
+  0x02, 0x01, 0x06,
+  0x1E, GAP_ADTYPE_MANUFACTURER_SPECIFIC, 0x0D, 0x00
+};
+
+// Zero length AD structure ahead of the matching one
+static const uint8 benchZeroLen[31] =
+{
+  0x02, 0x01, 0x06,
+  0x00,
+  0x05, GAP_ADTYPE_MANUFACTURER_SPECIFIC, 0x0D, 0x00, 0x01, 0x02
+};
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      benchRun
+ *
+ * @brief   Check and time one case against the filters in place.
+ */
+static void benchRun( const benchCase_t *pCase )
+{
+  struct timespec start;
+  struct timespec end;
+  unsigned long i;
+  unsigned matches = 0;
+  double ns;
+
+  CHECK( AdvFilter_Match( pCase->rssi, (uint8 *)pCase->pAddr,
+                          (uint8 *)pCase->pData, pCase->dataLen ) == pCase->expect );
+
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  for ( i = 0; i < BENCH_ITERATIONS; i++ )
+  {
+    matches += AdvFilter_Match( pCase->rssi, (uint8 *)pCase->pAddr,
+                                (uint8 *)pCase->pData, pCase->dataLen );
+  }
+  clock_gettime( CLOCK_MONOTONIC, &end );
+
+  CHECK( matches == ( pCase->expect ? BENCH_ITERATIONS : 0 ) );
+
+  ns = ( end.tv_sec - start.tv_sec ) * 1e9 + ( end.tv_nsec - start.tv_nsec );
+  printf( "  %-34s %-5s %7.1f ns\n", pCase->name,
+          pCase->expect ? "pass" : "fail", ns / BENCH_ITERATIONS );
+}
+
+/*********************************************************************
+ * @fn      benchPair
+ *
+ * @brief   Time a criterion on a report that meets it and on one that
+ *          does not.
+ */
+static void benchPair( const char *name, int8 rssi, const uint8 *pData,
+                       int8 badRssi, const uint8 *pBadData )
+{
+  benchCase_t pass = { name, rssi, benchAddr, pData, 31, TRUE };
+  benchCase_t fail = { name, badRssi, benchAddr, pBadData, 31, FALSE };
+
+  benchRun( &pass );
+  benchRun( &fail );
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main( void )
+{
+  static const uint8 empty[31] = { 0 };
+  uint8 value[ATT_UUID_SIZE];
+  uint8 i;
+
+  printf( "AdvFilter_Match, %lu calls per case\n", (unsigned long)BENCH_ITERATIONS );
+
+  // No filter set
+  {
+    benchCase_t none = { "no filter", -90, benchAddr, benchAdv, 31, TRUE };
+
+    VOID AdvFilter_Clear( ADVFILTER_ALL );
+    benchRun( &none );
+  }
+
+  // RSSI, header only
+  value[0] = (uint8)-60;
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_RSSI, value, 1 ) == SUCCESS );
+  benchPair( "rssi >= -60", -40, benchAdv, -80, benchAdv );
+
+  // Address prefix, header only
+  value[0] = 0x11;
+  value[1] = 0x22;
+  value[2] = 0x33;
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_ADDR_PREFIX, value, 3 ) == SUCCESS );
+  {
+    static const uint8 otherAddr[B_ADDR_LEN] = { 0x66, 0x55, 0x44, 0x33, 0x22, 0x12 };
+    benchCase_t pass = { "address prefix 11:22:33", -40, benchAddr, benchAdv, 31, TRUE };
+    benchCase_t fail = { "address prefix 11:22:33", -40, otherAddr, benchAdv, 31, FALSE };
+
+    benchRun( &pass );
+    benchRun( &fail );
+  }
+
+  // Manufacturer ID, last AD structure of the advertisement
+  value[0] = 0x0D;
+  value[1] = 0x00;
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_MANUF_ID, value, 2 ) == SUCCESS );
+  benchPair( "manufacturer 0x000D", -40, benchAdv, -40, benchRsp );
+
+  // 16-bit UUID, last in its list
+  value[0] = 0xF0;
+  value[1] = 0xFF;
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_UUID, value, ATT_BT_UUID_SIZE ) == SUCCESS );
+  benchPair( "16-bit uuid 0xFFF0", -40, benchAdv, -40, benchRsp );
+
+  // 128-bit UUID
+  for ( i = 0; i < ATT_UUID_SIZE; i++ )
+  {
+    value[i] = i;
+  }
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_UUID, value, ATT_UUID_SIZE ) == SUCCESS );
+  benchPair( "128-bit uuid", -40, benchRsp, -40, benchAdv );
+
+  // Name prefix
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_NAME_PREFIX, (uint8 *)"Sensor", 6 ) == SUCCESS );
+  benchPair( "name prefix \"Sensor\"", -40, benchRsp, -40, benchAdv );
+
+  // Every filter in use with every AD criterion, no report passes, so
+  // each AD structure is offered to every filter
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  for ( i = 0; i < ADVFILTER_MAX_FILTERS; i++ )
+  {
+    value[0] = 0x0D;
+    value[1] = 0x00;
+    CHECK( AdvFilter_SetCriterion( i, ADVFILTER_MANUF_ID, value, 2 ) == SUCCESS );
+    value[0] = 0xF0;
+    value[1] = 0xFF;
+    CHECK( AdvFilter_SetCriterion( i, ADVFILTER_UUID, value, ATT_BT_UUID_SIZE ) == SUCCESS );
+    CHECK( AdvFilter_SetCriterion( i, ADVFILTER_NAME_PREFIX, (uint8 *)"Other", 5 ) == SUCCESS );
+  }
+  {
+    benchCase_t worst = { "all filters, none passing", -40, benchAddr, benchAdv, 31, FALSE };
+
+    benchRun( &worst );
+  }
+
+  // Malformed AD data stops the walk
+  VOID AdvFilter_Clear( ADVFILTER_ALL );
+  value[0] = 0x0D;
+  value[1] = 0x00;
+  CHECK( AdvFilter_SetCriterion( 0, ADVFILTER_MANUF_ID, value, 2 ) == SUCCESS );
+  {
+    benchCase_t overrun = { "AD length past the end", -40, benchAddr, benchOverrun, 31, FALSE };
+    benchCase_t zeroLen = { "zero AD length ahead of match", -40, benchAddr, benchZeroLen, 31, FALSE };
+    benchCase_t noData = { "all zero data", -40, benchAddr, empty, 31, FALSE };
+    benchCase_t cut = { "data cut inside an AD header", -40, benchAddr, benchAdv, 4, FALSE };
+
+    benchRun( &overrun );
+    benchRun( &zeroLen );
+    benchRun( &noData );
+    benchRun( &cut );
+  }
+
+  return ( hostReport( "bench_advfilter" ) );
+}
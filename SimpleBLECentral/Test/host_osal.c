@@ -0,0 +1,143 @@
+/******************************************************************************
+
+ @file  host_osal.c
+
+ @brief OSAL stand-ins for the Simple BLE Central host tests. Memory comes
+        from the C library and is counted so leaks show up. Events and
+        timers are only recorded.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+unsigned hostChecks = 0;
+unsigned hostFailures = 0;
+int      hostMemBlocks = 0;
+uint16   hostMemFailAfter = 0xFFFF;
+uint16   hostEvents = 0;
+uint16   hostTimers = 0;
+uint32   hostClock = 0;
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+void hostReset( void )
+{
+  hostMemFailAfter = 0xFFFF;
+  hostEvents = 0;
+  hostTimers = 0;
+  hostClock = 0;
+}
+
+int hostReport( const char *name )
+{
+  printf( "%s: %u checks, %u failed\n", name, hostChecks, hostFailures );
+
+  return ( hostFailures == 0 ) ? 0 : 1;
+}
+
+void *osal_mem_alloc( uint16 size )
+{
+  if ( hostMemFailAfter == 0 )
+  {
+    return ( NULL );
+  }
+
+  if ( hostMemFailAfter != 0xFFFF )
+  {
+    hostMemFailAfter--;
+  }
+
+  hostMemBlocks++;
+
+  return ( malloc( size ) );
+}
+
+void osal_mem_free( void *ptr )
+{
+  if ( ptr != NULL )
+  {
+    hostMemBlocks--;
+    free( ptr );
+  }
+}
+
+uint8 osal_set_event( uint8 task_id, uint16 event_flag )
+{
+  (void)task_id;
+  hostEvents |= event_flag;
+
+  return ( SUCCESS );
+}
+
+uint8 osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value )
+{
+  (void)task_id;
+  (void)timeout_value;
+  hostTimers |= event_id;
+
+  return ( SUCCESS );
+}
+
+void *osal_memcpy( void *dst, const void *src, unsigned int len )
+{
+  memcpy( dst, src, len );
+
+  // OSAL returns the end of the copy
+  return ( (uint8 *)dst + len );
+}
+
+void *osal_memset( void *dest, uint8 value, int len )
+{
+  return ( memset( dest, value, len ) );
+}
+
+uint8 osal_memcmp( const void *src1, const void *src2, unsigned int len )
+{
+  // OSAL returns TRUE when equal
+  return ( memcmp( src1, src2, len ) == 0 );
+}
+
+uint32 osal_GetSystemClock( void )
+{
+  return ( hostClock );
+}
+
+int osal_strlen( char *pString )
+{
+  return ( (int)strlen( pString ) );
+}
+
+uint8 *_ltoa( uint32 value, uint8 *buf, uint8 radix )
+{
+  uint8 tmp[33];
+  uint8 i = 0;
+  uint8 j = 0;
+
+  do
+  {
+    tmp[i++] = "0123456789ABCDEF"[value % radix];
+    value /= radix;
+  } while ( value != 0 );
+
+  while ( i > 0 )
+  {
+    buf[j++] = tmp[--i];
+  }
+  buf[j] = '\0';
+
+  return ( buf );
+}
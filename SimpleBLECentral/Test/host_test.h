@@ -0,0 +1,54 @@
+/******************************************************************************
+
+ @file  host_test.h
+
+ @brief Checks and OSAL stand-ins shared by the Simple BLE Central host
+        tests. See host_osal.c.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+#include "host_ble.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Record a failed check and carry on with the test
+#define CHECK( cond )                                                   \
+  st( hostChecks++;                                                     \
+      if ( !(cond) )                                                    \
+      {                                                                 \
+        hostFailures++;                                                 \
+        printf( "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond ); \
+      } )
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+extern unsigned hostChecks;           // Checks run
+extern unsigned hostFailures;         // Checks failed
+extern int      hostMemBlocks;        // osal_mem_alloc blocks not yet freed
+extern uint16   hostMemFailAfter;     // Allocations left before osal_mem_alloc fails, 0xFFFF never
+extern uint16   hostEvents;           // Events set with osal_set_event
+extern uint16   hostTimers;           // Events started with osal_start_timerEx
+extern uint32   hostClock;            // Value of osal_GetSystemClock
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+// Reset the OSAL stand-ins
+extern void hostReset( void );
+
+// Print the check totals, returns the exit status of the test
+extern int hostReport( const char *name );
+
+#endif /* HOST_TEST_H */
@@ -0,0 +1,522 @@
+/******************************************************************************
+
+ @file  host_ble.h
+
+ @brief Host build stand-ins for the parts of the BLE stack, OSAL and HAL
+        headers that the Simple BLE Central sources under test use. The
+        stack headers named in the sources (bcomdef.h, OSAL.h, gatt.h and
+        so on) are one line forwards to this file.
+
+        Only declarations live here. The test programs define the
+        functions they exercise, mostly as recording fakes.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+#ifndef HOST_BLE_H
+#define HOST_BLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/*********************************************************************
+ * TYPES
+ */
+
+typedef uint8_t   uint8;
+typedef int8_t    int8;
+typedef uint16_t  uint16;
+typedef int16_t   int16;
+typedef uint32_t  uint32;
+typedef int32_t   int32;
+typedef uint8     bool;
+typedef uint8     halIntState_t;
+typedef uint8     bStatus_t;
+typedef uint8     Status_t;
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define TRUE                                  1
+#define FALSE                                 0
+#define VOID                                  (void)
+#define CODE
+#define XDATA
+
+#define BV(n)                                 (1 << (n))
+#define st(x)                                 do { x } while (0)
+#define MIN(a, b)                             (((a) < (b)) ? (a) : (b))
+#define MAX(a, b)                             (((a) > (b)) ? (a) : (b))
+
+#define BUILD_UINT16(lo, hi)                  ((uint16)(((lo) & 0xFF) + (((hi) & 0xFF) << 8)))
+#define HI_UINT16(a)                          (((a) >> 8) & 0xFF)
+#define LO_UINT16(a)                          ((a) & 0xFF)
+#define BREAK_UINT32(var, ByteNum)            (uint8)((uint32)(((var) >> ((ByteNum) * 8)) & 0x00FF))
+
+#define HAL_ENTER_CRITICAL_SECTION(x)         st( x = 0; )
+#define HAL_EXIT_CRITICAL_SECTION(x)          st( (void)x; )
+
+/*********************************************************************
+ * STATUS CODES
+ */
+
+#define SUCCESS                               0x00
+#define FAILURE                               0x01
+#define INVALIDPARAMETER                      0x02
+#define MSG_BUFFER_NOT_AVAIL                  0x04
+#define bleNotReady                           0x10
+#define bleAlreadyInRequestedMode             0x11
+#define bleIncorrectMode                      0x12
+#define bleMemAllocError                      0x13
+#define bleNotConnected                       0x14
+#define bleNoResources                        0x15
+#define blePending                            0x16
+#define bleTimeout                            0x17
+#define bleInvalidRange                       0x18
+#define bleProcedureComplete                  0x1A
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define B_ADDR_LEN                            6
+#define ATT_BT_UUID_SIZE                      2
+#define ATT_UUID_SIZE                         16
+#define ATT_MTU_SIZE                          23
+#define ATT_MAX_MTU_SIZE                      160
+#define MAX_NUM_LL_CONN                       3
+#define SYS_EVENT_MSG                         0x8000
+
+#define GATT_MIN_HANDLE                       0x0001
+#define GATT_MAX_HANDLE                       0xFFFF
+
+#define ADDRTYPE_PUBLIC                       0x00
+
+#define GAP_ADRPT_SCAN_RSP                    0x04
+
+#define GAP_ADTYPE_16BIT_MORE                 0x02
+#define GAP_ADTYPE_16BIT_COMPLETE             0x03
+#define GAP_ADTYPE_128BIT_MORE                0x06
+#define GAP_ADTYPE_128BIT_COMPLETE            0x07
+#define GAP_ADTYPE_LOCAL_NAME_SHORT           0x08
+#define GAP_ADTYPE_LOCAL_NAME_COMPLETE        0x09
+#define GAP_ADTYPE_MANUFACTURER_SPECIFIC      0xFF
+
+#define TGAP_FILTER_ADV_REPORTS               35
+
+#define ATT_ERROR_RSP                         0x01
+#define ATT_EXCHANGE_MTU_RSP                  0x03
+#define ATT_READ_BY_TYPE_RSP                  0x09
+#define ATT_READ_REQ                          0x0A
+#define ATT_READ_RSP                          0x0B
+#define ATT_READ_BLOB_RSP                     0x0D
+#define ATT_READ_MULTI_REQ                    0x0E
+#define ATT_READ_MULTI_RSP                    0x0F
+#define ATT_WRITE_REQ                         0x12
+#define ATT_WRITE_RSP                         0x13
+#define ATT_PREPARE_WRITE_REQ                 0x16
+#define ATT_PREPARE_WRITE_RSP                 0x17
+#define ATT_EXECUTE_WRITE_RSP                 0x19
+#define ATT_HANDLE_VALUE_NOTI                 0x1B
+#define ATT_HANDLE_VALUE_IND                  0x1D
+#define ATT_WRITE_CMD                         0x52
+
+#define HAL_UART_PORT_0                       0
+#define HAL_UART_BR_115200                    4
+#define HAL_UART_RX_FULL                      0x01
+#define HAL_UART_RX_ABOUT_FULL                0x02
+#define HAL_UART_RX_TIMEOUT                   0x04
+#define HAL_UART_TX_FULL                      0x08
+#define HAL_UART_TX_EMPTY                     0x10
+
+/*********************************************************************
+ * OSAL
+ */
+
+typedef struct
+{
+  uint8 event;
+  uint8 status;
+} osal_event_hdr_t;
+
+extern void  *osal_mem_alloc( uint16 size );
+extern void   osal_mem_free( void *ptr );
+extern uint8  osal_set_event( uint8 task_id, uint16 event_flag );
+extern uint8  osal_start_timerEx( uint8 task_id, uint16 event_id, uint32 timeout_value );
+extern void  *osal_memcpy( void *dst, const void *src, unsigned int len );
+extern void  *osal_memset( void *dest, uint8 value, int len );
+extern uint8  osal_memcmp( const void *src1, const void *src2, unsigned int len );
+extern uint32 osal_GetSystemClock( void );
+extern int    osal_strlen( char *pString );
+extern uint8 *_ltoa( uint32 value, uint8 *buf, uint8 radix );
+
+/*********************************************************************
+ * HAL UART
+ */
+
+typedef void (*halUARTCBack_t)( uint8 port, uint8 event );
+
+typedef struct
+{
+  uint16 bufferHead;
+  uint16 bufferTail;
+  uint16 maxBufSize;
+  uint8  *pBuffer;
+} halUARTBufControl_t;
+
+typedef struct
+{
+  bool                configured;
+  uint8               baudRate;
+  bool                flowControl;
+  uint16              flowControlThreshold;
+  uint8               idleTimeout;
+  halUARTBufControl_t rx;
+  halUARTBufControl_t tx;
+  bool                intEnable;
+  uint32              rxChRvdTime;
+  halUARTCBack_t      callBackFunc;
+} halUARTCfg_t;
+
+extern uint8  HalUARTOpen( uint8 port, halUARTCfg_t *config );
+extern uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len );
+extern uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len );
+extern uint16 Hal_UART_RxBufLen( uint8 port );
+
+// Sleep timer registers
+extern uint8 ST0;
+extern uint8 ST1;
+extern uint8 ST2;
+
+/*********************************************************************
+ * GAP
+ */
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint8  eventType;
+  uint8  addrType;
+  uint8  addr[B_ADDR_LEN];
+  int8   rssi;
+  uint8  dataLen;
+  uint8  *pEvtData;
+} gapDeviceInfoEvent_t;
+
+extern bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue );
+
+/*********************************************************************
+ * ATT / GATT
+ */
+
+typedef struct
+{
+  uint8  reqOpcode;
+  uint16 handle;
+  uint8  errCode;
+} attErrorRsp_t;
+
+typedef struct
+{
+  uint16 clientRxMTU;
+} attExchangeMTUReq_t;
+
+typedef struct
+{
+  uint16 serverRxMTU;
+} attExchangeMTURsp_t;
+
+typedef struct
+{
+  uint8 len;
+  uint8 uuid[ATT_UUID_SIZE];
+} attAttrType_t;
+
+typedef struct
+{
+  uint16 startHandle;
+  uint16 endHandle;
+  attAttrType_t type;
+} attReadByTypeReq_t;
+
+typedef struct
+{
+  uint16 numPairs;
+  uint16 len;
+  uint8  *pDataList;
+} attReadByTypeRsp_t;
+
+typedef struct
+{
+  uint16 handle;
+} attReadReq_t;
+
+typedef struct
+{
+  uint16 len;
+  uint8  *pValue;
+} attReadRsp_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 offset;
+} attReadBlobReq_t;
+
+typedef struct
+{
+  uint16 len;
+  uint8  *pValue;
+} attReadBlobRsp_t;
+
+typedef struct
+{
+  uint8  *pHandles;
+  uint16 numHandles;
+} attReadMultiReq_t;
+
+typedef struct
+{
+  uint16 len;
+  uint8  *pValues;
+} attReadMultiRsp_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 len;
+  uint8  *pValue;
+  uint8  sig;
+  uint8  cmd;
+} attWriteReq_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 offset;
+  uint16 len;
+  uint8  *pValue;
+} attPrepareWriteReq_t;
+
+typedef struct
+{
+  uint8 flags;
+} attExecuteWriteReq_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 len;
+  uint8  *pValue;
+} attHandleValueNoti_t;
+
+typedef struct
+{
+  uint16 handle;
+  uint16 len;
+  uint8  *pValue;
+} attHandleValueInd_t;
+
+typedef union
+{
+  attErrorRsp_t        errorRsp;
+  attExchangeMTURsp_t  exchangeMTURsp;
+  attReadByTypeRsp_t   readByTypeRsp;
+  attReadRsp_t         readRsp;
+  attReadBlobRsp_t     readBlobRsp;
+  attReadMultiReq_t    readMultiReq;
+  attReadMultiRsp_t    readMultiRsp;
+  attWriteReq_t        writeReq;
+  attPrepareWriteReq_t prepareWriteReq;
+  attHandleValueNoti_t handleValueNoti;
+  attHandleValueInd_t  handleValueInd;
+} gattMsg_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint16 connHandle;
+  uint8  method;
+  gattMsg_t msg;
+} gattMsgEvent_t;
+
+extern void *GATT_bm_alloc( uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc );
+extern void  GATT_bm_free( gattMsg_t *pMsg, uint8 opcode );
+extern bStatus_t GATT_ExchangeMTU( uint16 connHandle, attExchangeMTUReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_ReadCharValue( uint16 connHandle, attReadReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_ReadLongCharValue( uint16 connHandle, attReadBlobReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_ReadUsingCharUUID( uint16 connHandle, attReadByTypeReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_ReadMultiCharValues( uint16 connHandle, attReadMultiReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_WriteCharValue( uint16 connHandle, attWriteReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_WriteNoRsp( uint16 connHandle, attWriteReq_t *pReq );
+extern bStatus_t GATT_WriteLongCharValue( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_PrepareWriteReq( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_ExecuteWriteReq( uint16 connHandle, attExecuteWriteReq_t *pReq, uint8 taskId );
+extern bStatus_t GATT_InitClient( void );
+extern void      GATT_RegisterForInd( uint8 taskId );
+extern void      ATT_HandleValueCfm( uint16 connHandle );
+
+/*********************************************************************
+ * GAP ROLE EVENTS
+ */
+
+#define GAP_DEVICE_INIT_DONE_EVENT            0x00
+#define GAP_DEVICE_DISCOVERY_EVENT            0x01
+#define GAP_LINK_ESTABLISHED_EVENT            0x05
+#define GAP_LINK_TERMINATED_EVENT             0x06
+#define GAP_LINK_PARAM_UPDATE_EVENT           0x07
+#define GAP_DEVICE_INFO_EVENT                 0x0D
+
+#define GAP_CONNHANDLE_INIT                   0xFFFE
+#define GAP_DEVICE_NAME_LEN                   21
+#define DEVDISC_MODE_ALL                      0x03
+#define TGAP_GEN_DISC_SCAN                    2
+#define TGAP_LIM_DISC_SCAN                    3
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+} gapEventHdr_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint8  devAddr[B_ADDR_LEN];
+  uint16 dataPktLen;
+  uint8  numDataPkts;
+} gapDeviceInitDoneEvent_t;
+
+typedef struct
+{
+  uint8 eventType;
+  uint8 addrType;
+  uint8 addr[B_ADDR_LEN];
+} gapDevRec_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint8  numDevs;
+  gapDevRec_t *pDevList;
+} gapDevDiscEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint8  devAddrType;
+  uint8  devAddr[B_ADDR_LEN];
+  uint16 connectionHandle;
+  uint16 connInterval;
+  uint16 connLatency;
+  uint16 connTimeout;
+  uint8  clockAccuracy;
+} gapEstLinkReqEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint16 connectionHandle;
+  uint16 connInterval;
+  uint16 connLatency;
+  uint16 connTimeout;
+} gapLinkUpdateEvent_t;
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8  opcode;
+  uint16 connectionHandle;
+  uint8  reason;
+} gapTerminateLinkEvent_t;
+
+/*********************************************************************
+ * GAP BOND MANAGER
+ */
+
+#define GAPBOND_PAIRING_MODE                  0x400
+#define GAPBOND_MITM_PROTECTION               0x402
+#define GAPBOND_IO_CAPABILITIES               0x403
+#define GAPBOND_BONDING_ENABLED               0x406
+#define GAPBOND_DEFAULT_PASSCODE              0x408
+
+#define GAPBOND_PAIRING_MODE_WAIT_FOR_REQ     0x01
+#define GAPBOND_IO_CAP_DISPLAY_ONLY           0x00
+
+#define GAPBOND_PAIRING_STATE_STARTED         0x00
+#define GAPBOND_PAIRING_STATE_COMPLETE        0x01
+#define GAPBOND_PAIRING_STATE_BONDED          0x02
+#define GAPBOND_PAIRING_STATE_BOND_SAVED      0x03
+
+typedef void (*pfnPasscodeCB_t)( uint8 *deviceAddr, uint16 connectionHandle,
+                                 uint8 uiInputs, uint8 uiOutputs );
+typedef void (*pfnPairStateCB_t)( uint16 connectionHandle, uint8 state, uint8 status );
+
+typedef struct
+{
+  pfnPasscodeCB_t  passcodeCB;
+  pfnPairStateCB_t pairStateCB;
+} gapBondCBs_t;
+
+extern bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue );
+extern void      GAPBondMgr_Register( gapBondCBs_t *pCB );
+extern bStatus_t GAPBondMgr_PasscodeRsp( uint16 connectionHandle, uint8 status, uint32 passcode );
+
+/*********************************************************************
+ * GATT SERVER
+ */
+
+#define GATT_ALL_SERVICES                     0xFFFFFFFF
+#define GGS_DEVICE_NAME_ATT                   0
+
+#define SIMPLEPROFILE_SERV_UUID               0xFFF0
+#define SIMPLEPROFILE_CHAR1_UUID              0xFFF1
+
+extern bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value );
+extern bStatus_t GGS_AddService( uint32 services );
+extern bStatus_t GATTServApp_AddService( uint32 services );
+
+/*********************************************************************
+ * OSAL MESSAGES, KEYS, LEDS AND LCD
+ */
+
+#define GATT_MSG_EVENT                        0xB3
+#define KEY_CHANGE                            0xC0
+
+#define HAL_KEY_UP                            0x01
+#define HAL_KEY_RIGHT                         0x02
+#define HAL_KEY_CENTER                        0x04
+#define HAL_KEY_LEFT                          0x08
+#define HAL_KEY_DOWN                          0x10
+
+#define HAL_LED_1                             0x01
+#define HAL_LED_2                             0x02
+#define HAL_LED_MODE_OFF                      0x00
+
+#define HAL_LCD_LINE_1                        0x01
+#define HAL_LCD_LINE_2                        0x02
+
+#define LCD_WRITE_STRING(str, option)
+#define LCD_WRITE_STRING_VALUE(title, value, format, line)
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 state;
+  uint8 keys;
+} keyChange_t;
+
+extern uint8 *osal_msg_receive( uint8 task_id );
+extern uint8  osal_msg_deallocate( uint8 *msg_ptr );
+extern uint8  RegisterForKeys( uint8 task_id );
+extern uint8  HalLedSet( uint8 led, uint8 mode );
+
+#endif /* HOST_BLE_H */
@@ -0,0 +1,2 @@
+/* Host build, see host_ble.h */
+#include "host_ble.h"
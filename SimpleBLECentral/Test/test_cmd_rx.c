@@ -0,0 +1,493 @@
+/******************************************************************************
+
+ @file  test_cmd_rx.c
+
+ @brief Host test of the Simple BLE Central host interface frame parser.
+        Frames are fed through the NPI receive callback whole, one byte at
+        a time, split at every offset, back to back in one read, and
+        corrupted in each way the parser guards against. Responses are
+        taken from the transmit side and decoded.
+
+        The module under test is included so its static parser state can
+        be reset and its counters read.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "host_test.h"
+#include "../Source/simpleBLECentral_cmd.c"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Command type with no handler
+#define TEST_CMD_UNKNOWN                      0x3E
+
+#define TEST_RX_MAX                           512
+#define TEST_TX_MAX                           2048
+#define TEST_MAX_RSPS                         16
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Decoded response frame
+typedef struct
+{
+  uint8 type;
+  uint8 len;
+  uint8 data[SBC_FRAME_MAX_PAYLOAD];
+} testFrame_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Bytes waiting in the fake UART receive buffer
+static uint8  testRxBuf[TEST_RX_MAX];
+static uint16 testRxLen;
+static uint16 testRxPos;
+
+// Bytes taken by the fake UART
+static uint8  testTxBuf[TEST_TX_MAX];
+static uint16 testTxLen;
+
+static npiCBack_t testSerialCB;
+static uint16 testDispatched;
+
+// Responses decoded from testTxBuf
+static testFrame_t testRsp[TEST_MAX_RSPS];
+static uint8 testNumRsps;
+
+/*********************************************************************
+ * NPI STAND-INS
+ */
+
+void NPI_InitTransport( npiCBack_t npiCBack )
+{
+  testSerialCB = npiCBack;
+}
+
+uint16 NPI_ReadTransport( uint8 *buf, uint16 len )
+{
+  uint16 n = testRxLen - testRxPos;
+
+  if ( n > len )
+  {
+    n = len;
+  }
+
+  memcpy( buf, &testRxBuf[testRxPos], n );
+  testRxPos += n;
+
+  return ( n );
+}
+
+uint8 NPI_QueueWrite( npiTxReq_t *pReq )
+{
+  memcpy( &testTxBuf[testTxLen], pReq->pBuf, pReq->len );
+  testTxLen += pReq->len;
+  pReq->sent = pReq->len;
+
+  // The UART takes everything at once
+  pReq->pfnDone( pReq );
+
+  return ( SUCCESS );
+}
+
+void NPI_SetTxWatermarks( uint16 high, uint16 low, npiTxFlowCBack_t pfnFlow )
+{
+  (void)high;
+  (void)low;
+  (void)pfnFlow;
+}
+
+void NPI_LogInit( npiLogCBack_t npiLogCBack )
+{
+  (void)npiLogCBack;
+}
+
+uint8 NPI_LogPending( void )
+{
+  return ( 0 );
+}
+
+uint8 NPI_LogRead( uint8 *buf, uint8 maxLen )
+{
+  (void)buf;
+  (void)maxLen;
+
+  return ( 0 );
+}
+
+void NPI_GetStats( npiStats_t *pStats )
+{
+  memset( pStats, 0, sizeof( npiStats_t ) );
+}
+
+void NPI_ResetStats( void )
+{
+}
+
+uint32 NPI_StatsStamp( void )
+{
+  return ( 0 );
+}
+
+void NPI_StatsLatency( uint32 stamp )
+{
+  (void)stamp;
+  testDispatched++;
+}
+
+/*********************************************************************
+ * APPLICATION STAND-INS, not reached by the commands sent here
+ */
+
+bStatus_t AdvFilter_Clear( uint8 filter ) { (void)filter; return ( SUCCESS ); }
+bStatus_t AdvFilter_SetCriterion( uint8 filter, uint8 criterion, uint8 *pValue, uint8 len )
+{ (void)filter; (void)criterion; (void)pValue; (void)len; return ( SUCCESS ); }
+bStatus_t ScanSched_SetParams( uint16 window, uint16 minInterval, uint16 maxInterval )
+{ (void)window; (void)minInterval; (void)maxInterval; return ( SUCCESS ); }
+bStatus_t ScanSched_Start( void ) { return ( SUCCESS ); }
+void ScanSched_Stop( void ) { }
+uint16 ScanSched_GetInterval( void ) { return ( 0 ); }
+bStatus_t simpleBLEStartScan( void ) { return ( SUCCESS ); }
+bStatus_t simpleBLEConnect( uint8 addrType, uint8 *pAddr ) { (void)addrType; (void)pAddr; return ( SUCCESS ); }
+bStatus_t simpleBLEDisconnect( uint16 connHandle ) { (void)connHandle; return ( SUCCESS ); }
+bStatus_t simpleBLEWriteValue( uint16 connHandle, uint16 handle, uint8 *pValue, uint8 len )
+{ (void)connHandle; (void)handle; (void)pValue; (void)len; return ( SUCCESS ); }
+simpleBLELink_t *simpleBLEFindLink( uint16 connHandle ) { (void)connHandle; return ( NULL ); }
+bStatus_t simpleBLERssiMonitor( uint16 connHandle, uint16 period, uint8 reportSamples,
+                                int8 lowThresh, int8 highThresh )
+{ (void)connHandle; (void)period; (void)reportSamples; (void)lowThresh; (void)highThresh; return ( SUCCESS ); }
+void simpleBLECacheClear( void ) { }
+bStatus_t simpleBLEGattQueue( simpleBLELink_t *pLink, uint8 op, uint8 id, uint16 handle,
+                              uint16 offset, uint8 *pData, uint8 len )
+{ (void)pLink; (void)op; (void)id; (void)handle; (void)offset; (void)pData; (void)len; return ( SUCCESS ); }
+bStatus_t simpleBLEReconAdd( uint8 addrType, uint8 *pAddr ) { (void)addrType; (void)pAddr; return ( SUCCESS ); }
+bStatus_t simpleBLEReconRemove( uint8 *pAddr ) { (void)pAddr; return ( SUCCESS ); }
+bStatus_t simpleBLEConnSetProfile( simpleBLELink_t *pLink, uint8 profile, uint8 autoSwitch )
+{ (void)pLink; (void)profile; (void)autoSwitch; return ( SUCCESS ); }
+bStatus_t simpleBLEInfoStart( simpleBLELink_t *pLink, uint16 mask ) { (void)pLink; (void)mask; return ( SUCCESS ); }
+uint8 simpleBLEStatsRead( uint8 *pBuf ) { (void)pBuf; return ( 0 ); }
+void simpleBLEStatsClear( void ) { }
+bStatus_t simpleBLESubStart( simpleBLELink_t *pLink, uint8 mode, uint8 *pUuids, uint8 numUuids )
+{ (void)pLink; (void)mode; (void)pUuids; (void)numUuids; return ( SUCCESS ); }
+bStatus_t simpleBLEScanStream( uint8 enable, uint16 interval ) { (void)enable; (void)interval; return ( SUCCESS ); }
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      testReset
+ *
+ * @brief   Start a test case with a fresh parser, empty buffers and
+ *          cleared counters.
+ */
+static void testReset( void )
+{
+  hostReset();
+  simpleBLECmdInit( 0 );
+
+  simpleBLECmdRxErrors = 0;
+  testRxLen = testRxPos = 0;
+  testTxLen = 0;
+  testDispatched = 0;
+  testNumRsps = 0;
+}
+
+/*********************************************************************
+ * @fn      testEncode
+ *
+ * @brief   Encode a frame the way the host does.
+ *
+ * @return  encoded length
+ */
+static uint16 testEncode( uint8 *pOut, uint8 type, const uint8 *pData, uint8 len )
+{
+  uint8 raw[SBC_FRAME_MAX_PAYLOAD + 3];
+  uint16 n = 0;
+  uint8 fcs = 0;
+  uint8 i;
+
+  raw[0] = type;
+  raw[1] = len;
+  memcpy( &raw[2], pData, len );
+  for ( i = 0; i < len + 2; i++ )
+  {
+    fcs += raw[i];
+  }
+  raw[len + 2] = fcs;
+
+  pOut[n++] = SBC_FRAME_SOF;
+  for ( i = 0; i < len + 3; i++ )
+  {
+    switch ( raw[i] )
+    {
+      case SBC_FRAME_SOF: pOut[n++] = SBC_FRAME_ESC; pOut[n++] = SBC_FRAME_ESC_SOF; break;
+      case SBC_FRAME_ESC: pOut[n++] = SBC_FRAME_ESC; pOut[n++] = SBC_FRAME_ESC_ESC; break;
+      case SBC_FRAME_EOF: pOut[n++] = SBC_FRAME_ESC; pOut[n++] = SBC_FRAME_ESC_EOF; break;
+      default:            pOut[n++] = raw[i];                                      break;
+    }
+  }
+
+  return ( n );
+}
+
+/*********************************************************************
+ * @fn      testFeed
+ *
+ * @brief   Deliver bytes through the UART callback, one read of them.
+ */
+static void testFeed( const uint8 *pData, uint16 len )
+{
+  memcpy( &testRxBuf[testRxLen], pData, len );
+  testRxLen += len;
+  testSerialCB( HAL_UART_PORT_0, HAL_UART_RX_TIMEOUT );
+}
+
+/*********************************************************************
+ * @fn      testCollect
+ *
+ * @brief   Run the flush events the parser raised and decode what went
+ *          out into testRsp.
+ */
+static void testCollect( void )
+{
+  uint16 i;
+  uint8 raw[SBC_FRAME_MAX_PAYLOAD + 3];
+  uint16 n = 0;
+  uint8 esc = FALSE;
+  uint8 inFrame = FALSE;
+
+  while ( hostEvents & SBC_TX_FLUSH_EVT )
+  {
+    hostEvents &= ~SBC_TX_FLUSH_EVT;
+    simpleBLECmdFlush();
+  }
+
+  for ( i = 0; i <= testTxLen; i++ )
+  {
+    uint8 b = ( i < testTxLen ) ? testTxBuf[i] : SBC_FRAME_SOF;
+
+    if ( b == SBC_FRAME_SOF )
+    {
+      if ( inFrame && n >= 3 && testNumRsps < TEST_MAX_RSPS )
+      {
+        uint8 fcs = 0;
+        uint16 j;
+
+        for ( j = 0; j < n - 1u; j++ )
+        {
+          fcs += raw[j];
+        }
+
+        CHECK( raw[1] + 3u == n );
+        CHECK( fcs == raw[n - 1] );
+
+        testRsp[testNumRsps].type = raw[0];
+        testRsp[testNumRsps].len = raw[1];
+        memcpy( testRsp[testNumRsps].data, &raw[2], raw[1] );
+        testNumRsps++;
+      }
+
+      inFrame = TRUE;
+      n = 0;
+      esc = FALSE;
+    }
+    else if ( b == SBC_FRAME_ESC )
+    {
+      esc = TRUE;
+    }
+    else if ( n < sizeof( raw ) )
+    {
+      if ( esc )
+      {
+        b = ( b == SBC_FRAME_ESC_SOF ) ? SBC_FRAME_SOF :
+            ( b == SBC_FRAME_ESC_ESC ) ? SBC_FRAME_ESC : SBC_FRAME_EOF;
+        esc = FALSE;
+      }
+      raw[n++] = b;
+    }
+  }
+
+  testTxLen = 0;
+}
+
+/*********************************************************************
+ * @fn      testCountersRsp
+ *
+ * @brief   Check that a response is SBC_CMD_COUNTERS reporting the
+ *          given number of receive errors.
+ */
+static void testCountersRsp( const testFrame_t *pRsp, uint16 rxErrors )
+{
+  CHECK( pRsp->type == ( SBC_CMD_COUNTERS | SBC_RSP_FLAG ) );
+  CHECK( pRsp->len == 5 );
+  CHECK( pRsp->data[0] == SUCCESS );
+  CHECK( BUILD_UINT16( pRsp->data[1], pRsp->data[2] ) == rxErrors );
+}
+
+/*********************************************************************
+ * TEST CASES
+ */
+
+static void testWhole( void )
+{
+  uint8 frame[16];
+  uint16 n;
+
+  testReset();
+  n = testEncode( frame, SBC_CMD_COUNTERS, NULL, 0 );
+  testFeed( frame, n );
+  testCollect();
+
+  CHECK( testNumRsps == 1 );
+  testCountersRsp( &testRsp[0], 0 );
+  CHECK( testDispatched == 1 );
+}
+
+static void testFragmented( void )
+{
+  // Payload bytes that all need escaping, for an unknown command
+  static const uint8 payload[] = { SBC_FRAME_SOF, 0x11, SBC_FRAME_ESC, SBC_FRAME_EOF, 0x22 };
+  uint8 frame[32];
+  uint16 n;
+  uint16 split;
+  uint16 i;
+
+  n = testEncode( frame, TEST_CMD_UNKNOWN, payload, sizeof( payload ) );
+
+  // One byte per UART callback
+  testReset();
+  for ( i = 0; i < n; i++ )
+  {
+    testFeed( &frame[i], 1 );
+  }
+  testCollect();
+
+  CHECK( testNumRsps == 1 );
+  CHECK( testRsp[0].type == ( TEST_CMD_UNKNOWN | SBC_RSP_FLAG ) );
+  CHECK( testRsp[0].data[0] == INVALIDPARAMETER );
+
+  // Two reads, split at every offset, including inside an escape
+  for ( split = 1; split < n; split++ )
+  {
+    testReset();
+    testFeed( frame, split );
+    CHECK( testDispatched == 0 );
+    testFeed( &frame[split], n - split );
+    testCollect();
+
+    CHECK( testNumRsps == 1 );
+    CHECK( testDispatched == 1 );
+    CHECK( simpleBLECmdRxErrors == 0 );
+  }
+}
+
+static void testBackToBack( void )
+{
+  static const uint8 payload[] = { 0x01, 0x02, 0x03 };
+  uint8 stream[64];
+  uint16 n = 0;
+
+  // More than one receive chunk, so frames straddle the reads
+  testReset();
+  n += testEncode( &stream[n], SBC_CMD_COUNTERS, NULL, 0 );
+  n += testEncode( &stream[n], TEST_CMD_UNKNOWN, payload, sizeof( payload ) );
+  n += testEncode( &stream[n], SBC_CMD_COUNTERS, payload, 1 );
+  n += testEncode( &stream[n], SBC_CMD_COUNTERS, NULL, 0 );
+  CHECK( n > SBC_RX_CHUNK_LEN );
+  testFeed( stream, n );
+  testCollect();
+
+  CHECK( testNumRsps == 4 );
+  testCountersRsp( &testRsp[0], 0 );
+  CHECK( testRsp[1].type == ( TEST_CMD_UNKNOWN | SBC_RSP_FLAG ) );
+  CHECK( testRsp[1].data[0] == INVALIDPARAMETER );
+  // SBC_CMD_COUNTERS takes no payload
+  CHECK( testRsp[2].type == ( SBC_CMD_COUNTERS | SBC_RSP_FLAG ) );
+  CHECK( testRsp[2].data[0] == bleInvalidRange );
+  testCountersRsp( &testRsp[3], 0 );
+}
+
+static void testCorrupted( void )
+{
+  uint8 good[16];
+  uint8 bad[32];
+  uint16 goodLen;
+  uint16 n;
+  uint16 errors = 0;
+
+  goodLen = testEncode( good, SBC_CMD_COUNTERS, NULL, 0 );
+  testReset();
+
+  // Bad FCS
+  n = testEncode( bad, TEST_CMD_UNKNOWN, (const uint8 *)"ab", 2 );
+  bad[n - 1] ^= 0x01;
+  testFeed( bad, n );
+  errors++;
+
+  // Invalid escape code
+  n = testEncode( bad, TEST_CMD_UNKNOWN, (const uint8 *)"ab", 2 );
+  bad[3] = SBC_FRAME_ESC;
+  bad[4] = 0x07;
+  testFeed( bad, n );
+  errors++;
+
+  // Unescaped EOF inside a frame
+  n = testEncode( bad, TEST_CMD_UNKNOWN, (const uint8 *)"ab", 2 );
+  bad[3] = SBC_FRAME_EOF;
+  testFeed( bad, n );
+  errors++;
+
+  // Length beyond the largest payload
+  bad[0] = SBC_FRAME_SOF;
+  bad[1] = TEST_CMD_UNKNOWN;
+  bad[2] = SBC_FRAME_MAX_PAYLOAD + 1;
+  testFeed( bad, 3 );
+  errors++;
+
+  // Frame cut short by the next SOF, which must still be parsed
+  n = testEncode( bad, TEST_CMD_UNKNOWN, (const uint8 *)"abcd", 4 );
+  testFeed( bad, n - 2 );
+  errors++;
+  testFeed( good, goodLen );
+
+  // Noise between frames is skipped without counting
+  bad[0] = 0x00;
+  bad[1] = 0x55;
+  bad[2] = SBC_FRAME_EOF;
+  testFeed( bad, 3 );
+
+  testFeed( good, goodLen );
+  testCollect();
+
+  CHECK( simpleBLECmdRxErrors == errors );
+  CHECK( testNumRsps == 2 );
+  testCountersRsp( &testRsp[0], errors );
+  testCountersRsp( &testRsp[1], errors );
+  CHECK( testDispatched == 2 );
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main( void )
+{
+  testWhole();
+  testFragmented();
+  testBackToBack();
+  testCorrupted();
+
+  return ( hostReport( "test_cmd_rx" ) );
+}
@@ -0,0 +1,460 @@
+/******************************************************************************
+
+ @file  test_gatt_queue.c
+
+ @brief Host test of the Simple BLE Central GATT request queue. Requests
+        are queued on two links against stubbed GATT client calls, and the
+        test checks that each link issues one request at a time in order,
+        that write commands do not wait, that the links do not hold each
+        other up, that requests the stack refuses for lack of buffers are
+        retried, and that a flush reports every request of its link only.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "simpleBLECentral.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_NUM_LINKS                        2
+#define TEST_MAX_CALLS                        32
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// GATT client call made by the queue
+typedef struct
+{
+  uint16 connHandle;
+  uint8  opcode;                      // ATT request opcode
+  uint16 handle;
+} testCall_t;
+
+// SBC_EVT_GATT_COMPLETE sent to the host
+typedef struct
+{
+  uint16 connHandle;
+  uint8  id;
+  uint8  op;
+  uint8  status;
+} testDone_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static simpleBLELink_t testLinks[TEST_NUM_LINKS];
+
+static testCall_t testCalls[TEST_MAX_CALLS];
+static uint8 testNumCalls;
+
+static testDone_t testDones[TEST_MAX_CALLS];
+static uint8 testNumDones;
+
+// Data frames sent to the host
+static uint8 testNumData;
+
+// Status the next GATT calls return
+static bStatus_t testGattStatus;
+
+// Stack buffers not yet freed
+static int testBmBlocks;
+
+/*********************************************************************
+ * GATT STAND-INS
+ */
+
+static bStatus_t testGattCall( uint16 connHandle, uint8 opcode, uint16 handle )
+{
+  if ( testGattStatus == SUCCESS && testNumCalls < TEST_MAX_CALLS )
+  {
+    testCalls[testNumCalls].connHandle = connHandle;
+    testCalls[testNumCalls].opcode = opcode;
+    testCalls[testNumCalls].handle = handle;
+    testNumCalls++;
+  }
+
+  return ( testGattStatus );
+}
+
+void *GATT_bm_alloc( uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc )
+{
+  (void)connHandle;
+  (void)opcode;
+  (void)pSizeAlloc;
+  testBmBlocks++;
+
+  return ( malloc( size ) );
+}
+
+void GATT_bm_free( gattMsg_t *pMsg, uint8 opcode )
+{
+  testBmBlocks--;
+
+  switch ( opcode )
+  {
+    case ATT_READ_MULTI_REQ:
+      free( pMsg->readMultiReq.pHandles );
+      break;
+
+    case ATT_PREPARE_WRITE_REQ:
+      free( pMsg->prepareWriteReq.pValue );
+      break;
+
+    default:
+      free( pMsg->writeReq.pValue );
+      break;
+  }
+}
+
+bStatus_t GATT_ReadCharValue( uint16 connHandle, attReadReq_t *pReq, uint8 taskId )
+{
+  (void)taskId;
+
+  return ( testGattCall( connHandle, ATT_READ_REQ, pReq->handle ) );
+}
+
+bStatus_t GATT_WriteCharValue( uint16 connHandle, attWriteReq_t *pReq, uint8 taskId )
+{
+  bStatus_t status = testGattCall( connHandle, ATT_WRITE_REQ, pReq->handle );
+
+  (void)taskId;
+
+  // The stack owns the buffer once the request is accepted
+  if ( status == SUCCESS )
+  {
+    testBmBlocks--;
+    free( pReq->pValue );
+  }
+
+  return ( status );
+}
+
+bStatus_t GATT_WriteNoRsp( uint16 connHandle, attWriteReq_t *pReq )
+{
+  bStatus_t status = testGattCall( connHandle, ATT_WRITE_CMD, pReq->handle );
+
+  if ( status == SUCCESS )
+  {
+    testBmBlocks--;
+    free( pReq->pValue );
+  }
+
+  return ( status );
+}
+
+bStatus_t GATT_ExchangeMTU( uint16 connHandle, attExchangeMTUReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ReadLongCharValue( uint16 connHandle, attReadBlobReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ReadUsingCharUUID( uint16 connHandle, attReadByTypeReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ReadMultiCharValues( uint16 connHandle, attReadMultiReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_WriteLongCharValue( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_PrepareWriteReq( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ExecuteWriteReq( uint16 connHandle, attExecuteWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+
+/*********************************************************************
+ * APPLICATION STAND-INS
+ */
+
+bStatus_t simpleBLECmdSendFrame( uint8 type, uint8 *pData, uint8 len )
+{
+  CHECK( type == SBC_EVT_GATT_COMPLETE && len == 6 );
+
+  if ( testNumDones < TEST_MAX_CALLS )
+  {
+    testDones[testNumDones].connHandle = BUILD_UINT16( pData[0], pData[1] );
+    testDones[testNumDones].id = pData[2];
+    testDones[testNumDones].op = pData[3];
+    testDones[testNumDones].status = pData[4];
+    testNumDones++;
+  }
+
+  return ( SUCCESS );
+}
+
+bStatus_t simpleBLECmdSendFrameParts( uint8 type, uint8 *pHdr, uint8 hdrLen,
+                                      uint8 *pData, uint8 len )
+{
+  (void)pHdr;
+  (void)hdrLen;
+  (void)pData;
+  (void)len;
+  CHECK( type == SBC_EVT_GATT_DATA );
+  testNumData++;
+
+  return ( SUCCESS );
+}
+
+simpleBLELink_t *simpleBLEFindLink( uint16 connHandle )
+{
+  return ( connHandle < TEST_NUM_LINKS ) ? &testLinks[connHandle] : NULL;
+}
+
+void simpleBLEConnBusy( simpleBLELink_t *pLink ) { (void)pLink; }
+void simpleBLELinkMtu( simpleBLELink_t *pLink, uint16 mtu ) { pLink->mtu = mtu; }
+void simpleBLEInfoValue( simpleBLELink_t *pLink, uint8 item, uint8 *pValue, uint8 len )
+{ (void)pLink; (void)item; (void)pValue; (void)len; }
+void simpleBLEInfoDone( simpleBLELink_t *pLink, uint8 status ) { (void)pLink; (void)status; }
+void simpleBLESubDone( simpleBLELink_t *pLink, uint8 status ) { (void)pLink; (void)status; }
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      testReset
+ *
+ * @brief   Start a test case with two idle, connected links.
+ */
+static void testReset( void )
+{
+  uint8 i;
+
+  hostReset();
+  memset( testLinks, 0, sizeof( testLinks ) );
+
+  for ( i = 0; i < TEST_NUM_LINKS; i++ )
+  {
+    testLinks[i].connHandle = i;
+    testLinks[i].state = BLE_STATE_CONNECTED;
+    testLinks[i].discState = BLE_DISC_STATE_IDLE;
+    testLinks[i].mtu = 23;
+  }
+
+  testNumCalls = 0;
+  testNumDones = 0;
+  testNumData = 0;
+  testGattStatus = SUCCESS;
+
+  simpleBLEGattInit( 0 );
+}
+
+/*********************************************************************
+ * @fn      testRespond
+ *
+ * @brief   Deliver a response to the request in progress on a link.
+ */
+static void testRespond( simpleBLELink_t *pLink, uint8 method )
+{
+  gattMsgEvent_t msg;
+  uint8 value[2] = { 0x12, 0x34 };
+
+  memset( &msg, 0, sizeof( msg ) );
+  msg.connHandle = pLink->connHandle;
+  msg.method = method;
+  msg.hdr.status = SUCCESS;
+
+  if ( method == ATT_READ_RSP )
+  {
+    msg.msg.readRsp.len = sizeof( value );
+    msg.msg.readRsp.pValue = value;
+  }
+  else if ( method == ATT_ERROR_RSP )
+  {
+    msg.msg.errorRsp.errCode = 0x0A;
+  }
+
+  simpleBLEGattMsg( pLink, &msg );
+}
+
+/*********************************************************************
+ * @fn      testFinish
+ *
+ * @brief   Flush both links and check nothing was left allocated.
+ */
+static void testFinish( void )
+{
+  uint8 i;
+
+  for ( i = 0; i < TEST_NUM_LINKS; i++ )
+  {
+    simpleBLEGattFlush( &testLinks[i], bleNotConnected );
+    CHECK( testLinks[i].gattQueued == 0 );
+    CHECK( testLinks[i].pGattHead == NULL && testLinks[i].pGattTail == NULL );
+    CHECK( testLinks[i].pGattActive == NULL );
+  }
+
+  CHECK( hostMemBlocks == 0 );
+  CHECK( testBmBlocks == 0 );
+}
+
+/*********************************************************************
+ * TEST CASES
+ */
+
+static void testTwoLinks( void )
+{
+  simpleBLELink_t *pLink0 = &testLinks[0];
+  simpleBLELink_t *pLink1 = &testLinks[1];
+  uint8 value[4] = { 1, 2, 3, 4 };
+
+  testReset();
+
+  // One request in progress per link, the links do not wait on each other
+  CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_READ, 1, 0x0010, 0, NULL, 0 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_WRITE, 2, 0x0011, 0, value, 2 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 3, 0x0020, 0, NULL, 0 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 4, 0x0021, 0, NULL, 0 ) == SUCCESS );
+
+  CHECK( testNumCalls == 2 );
+  CHECK( testCalls[0].connHandle == 0 && testCalls[0].handle == 0x0010 );
+  CHECK( testCalls[1].connHandle == 1 && testCalls[1].handle == 0x0020 );
+  CHECK( pLink0->gattQueued == 2 && pLink1->gattQueued == 2 );
+
+  // A write command keeps its place behind the queued read
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_WRITE_NO_RSP, 5, 0x0022, 0, value, 4 ) == SUCCESS );
+  CHECK( testNumCalls == 2 );
+
+  // Link 1 completes first. Its next read goes out, and the write
+  // command right after it without waiting for the read.
+  testRespond( pLink1, ATT_READ_RSP );
+  CHECK( testDones[0].connHandle == 1 && testDones[0].id == 3 && testDones[0].status == SUCCESS );
+  CHECK( testNumData == 1 );
+  CHECK( testNumCalls == 4 );
+  CHECK( testCalls[2].connHandle == 1 && testCalls[2].handle == 0x0021 );
+  CHECK( testCalls[3].connHandle == 1 && testCalls[3].opcode == ATT_WRITE_CMD );
+  CHECK( testNumDones == 2 && testDones[1].id == 5 && testDones[1].op == SBC_GATT_OP_WRITE_NO_RSP );
+
+  // Link 0 still waits on its read
+  CHECK( pLink0->pGattActive != NULL && pLink0->pGattActive->id == 1 );
+
+  testRespond( pLink0, ATT_READ_RSP );
+  CHECK( testNumCalls == 5 );
+  CHECK( testCalls[4].connHandle == 0 && testCalls[4].opcode == ATT_WRITE_REQ );
+
+  testRespond( pLink0, ATT_ERROR_RSP );
+  testRespond( pLink1, ATT_READ_RSP );
+  CHECK( testNumDones == 5 );
+  CHECK( testDones[3].connHandle == 0 && testDones[3].id == 2 && testDones[3].status == FAILURE );
+  CHECK( testDones[4].connHandle == 1 && testDones[4].id == 4 );
+
+  testFinish();
+  CHECK( testNumDones == 5 );
+}
+
+static void testRetry( void )
+{
+  simpleBLELink_t *pLink0 = &testLinks[0];
+  simpleBLELink_t *pLink1 = &testLinks[1];
+  uint8 value[2] = { 0xAA, 0x55 };
+
+  testReset();
+
+  // The stack is out of buffers, the requests stay queued
+  testGattStatus = MSG_BUFFER_NOT_AVAIL;
+  CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_WRITE, 1, 0x0030, 0, value, 2 ) == SUCCESS );
+  testGattStatus = blePending;
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 2, 0x0040, 0, NULL, 0 ) == SUCCESS );
+
+  CHECK( testNumCalls == 0 && testNumDones == 0 );
+  CHECK( hostTimers & SBC_GATT_RETRY_EVT );
+  CHECK( pLink0->pGattHead != NULL && pLink1->pGattHead != NULL );
+  CHECK( testBmBlocks == 0 );
+
+  testGattStatus = SUCCESS;
+  simpleBLEGattRetry();
+  CHECK( testNumCalls == 2 );
+  CHECK( testCalls[0].connHandle == 0 && testCalls[1].connHandle == 1 );
+  CHECK( pLink0->pGattActive != NULL && pLink1->pGattActive != NULL );
+
+  testFinish();
+}
+
+static void testFlush( void )
+{
+  simpleBLELink_t *pLink0 = &testLinks[0];
+  simpleBLELink_t *pLink1 = &testLinks[1];
+  uint8 i;
+
+  testReset();
+
+  for ( i = 0; i < 3; i++ )
+  {
+    CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_READ, 10 + i, 0x0050 + i, 0, NULL, 0 ) == SUCCESS );
+    CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 20 + i, 0x0060 + i, 0, NULL, 0 ) == SUCCESS );
+  }
+
+  // Link 0 goes down: its request in progress first, then the queue
+  simpleBLEGattFlush( pLink0, bleNotConnected );
+  CHECK( testNumDones == 3 );
+  for ( i = 0; i < 3; i++ )
+  {
+    CHECK( testDones[i].connHandle == 0 && testDones[i].id == 10 + i );
+    CHECK( testDones[i].status == bleNotConnected );
+  }
+  CHECK( pLink0->gattQueued == 0 );
+
+  // Link 1 carries on
+  CHECK( pLink1->gattQueued == 3 );
+  testRespond( pLink1, ATT_READ_RSP );
+  CHECK( testNumDones == 4 && testDones[3].connHandle == 1 && testDones[3].id == 20 );
+  CHECK( testCalls[testNumCalls - 1].connHandle == 1 &&
+         testCalls[testNumCalls - 1].handle == 0x0061 );
+
+  testFinish();
+}
+
+static void testLimits( void )
+{
+  simpleBLELink_t *pLink0 = &testLinks[0];
+  simpleBLELink_t *pLink1 = &testLinks[1];
+  uint8 value[32];
+  uint8 i;
+
+  testReset();
+  memset( value, 0, sizeof( value ) );
+
+  // The queue of one link fills up without touching the other
+  for ( i = 0; i < SBC_GATT_QUEUE_DEPTH; i++ )
+  {
+    CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_READ, i, 0x0070, 0, NULL, 0 ) == SUCCESS );
+  }
+  CHECK( simpleBLEGattQueue( pLink0, SBC_GATT_OP_READ, i, 0x0070, 0, NULL, 0 ) == bleNoResources );
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, i, 0x0070, 0, NULL, 0 ) == SUCCESS );
+
+  // Values are checked against the link MTU
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_WRITE, 0, 0x0071, 0, value, 20 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_WRITE, 0, 0x0071, 0, value, 21 ) == bleInvalidRange );
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 0, 0x0000, 0, NULL, 0 ) == INVALIDPARAMETER );
+
+  // Out of memory is reported, not queued
+  hostMemFailAfter = 0;
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 0, 0x0072, 0, NULL, 0 ) == bleMemAllocError );
+  hostMemFailAfter = 0xFFFF;
+
+  pLink1->state = BLE_STATE_DISCONNECTING;
+  CHECK( simpleBLEGattQueue( pLink1, SBC_GATT_OP_READ, 0, 0x0073, 0, NULL, 0 ) == bleNotConnected );
+  pLink1->state = BLE_STATE_CONNECTED;
+
+  testFinish();
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main( void )
+{
+  testTwoLinks();
+  testRetry();
+  testFlush();
+  testLimits();
+
+  return ( hostReport( "test_gatt_queue" ) );
+}
@@ -0,0 +1,481 @@
+/******************************************************************************
+
+ @file  test_link.c
+
+ @brief Host test of the Simple BLE Central link table. Link established
+        and terminated events are passed to the central role event
+        callback, and the test checks that each link gets its own entry,
+        that a link with a handle beyond the table is terminated and
+        reported, and that terminating a link flushes its GATT requests
+        and frees its entry without touching the other links.
+
+        The application is included so its role callback and link table
+        can be reached. The GATT request queue is linked in as is; the
+        stack and the other central modules are fakes.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "../Source/simpleBLECentral.c"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define TEST_MAX_EVTS                         32
+
+// Host request ids
+#define TEST_ID_FIRST                         0x21
+#define TEST_ID_SECOND                        0x22
+#define TEST_ID_OTHER                         0x31
+
+// Termination reason
+#define TEST_REASON                           0x13
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Frame sent to the host
+typedef struct
+{
+  uint8 type;
+  uint8 len;
+  uint8 data[16];
+} testEvt_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static testEvt_t testEvts[TEST_MAX_EVTS];
+static uint8 testNumEvts;
+
+// Links the fake central role was asked to terminate
+static uint16 testTerminated[TEST_MAX_EVTS];
+static uint8 testNumTerminated;
+
+// GATT requests the fake stack accepted
+static uint8 testGattCalls;
+
+/*********************************************************************
+ * STACK STAND-INS
+ */
+
+bStatus_t GAPCentralRole_TerminateLink( uint16 connHandle )
+{
+  if ( testNumTerminated < TEST_MAX_EVTS )
+  {
+    testTerminated[testNumTerminated++] = connHandle;
+  }
+
+  return ( SUCCESS );
+}
+
+bStatus_t GAPCentralRole_StartDevice( gapCentralRoleCB_t *pAppCallbacks )
+{ (void)pAppCallbacks; return ( SUCCESS ); }
+bStatus_t GAPCentralRole_SetParameter( uint16 param, uint8 len, void *pValue )
+{ (void)param; (void)len; (void)pValue; return ( SUCCESS ); }
+bStatus_t GAPCentralRole_GetParameter( uint16 param, void *pValue )
+{ (void)param; (void)pValue; return ( FAILURE ); }
+bStatus_t GAPCentralRole_EstablishLink( uint8 highDutyCycle, uint8 whiteList,
+                                        uint8 addrTypePeer, uint8 *peerAddr )
+{ (void)highDutyCycle; (void)whiteList; (void)addrTypePeer; (void)peerAddr; return ( SUCCESS ); }
+bStatus_t GAPCentralRole_StartDiscovery( uint8 mode, uint8 activeScan, uint8 whiteList )
+{ (void)mode; (void)activeScan; (void)whiteList; return ( SUCCESS ); }
+bStatus_t GAPCentralRole_CancelDiscovery( void ) { return ( SUCCESS ); }
+bStatus_t GAPCentralRole_CancelRssi( uint16 connHandle ) { (void)connHandle; return ( SUCCESS ); }
+bStatus_t GAPCentralRole_StartRssiMonitor( uint16 connHandle, uint16 period, uint8 reportSamples,
+                                           int8 lowThresh, int8 highThresh )
+{ (void)connHandle; (void)period; (void)reportSamples; (void)lowThresh; (void)highThresh; return ( SUCCESS ); }
+bStatus_t GAP_SetParamValue( uint16 paramID, uint16 paramValue )
+{ (void)paramID; (void)paramValue; return ( SUCCESS ); }
+bStatus_t GAPBondMgr_SetParameter( uint16 param, uint8 len, void *pValue )
+{ (void)param; (void)len; (void)pValue; return ( SUCCESS ); }
+void GAPBondMgr_Register( gapBondCBs_t *pCB ) { (void)pCB; }
+bStatus_t GAPBondMgr_PasscodeRsp( uint16 connectionHandle, uint8 status, uint32 passcode )
+{ (void)connectionHandle; (void)status; (void)passcode; return ( SUCCESS ); }
+bStatus_t GGS_SetParameter( uint8 param, uint8 len, void *value )
+{ (void)param; (void)len; (void)value; return ( SUCCESS ); }
+bStatus_t GGS_AddService( uint32 services ) { (void)services; return ( SUCCESS ); }
+bStatus_t GATTServApp_AddService( uint32 services ) { (void)services; return ( SUCCESS ); }
+bStatus_t GATT_InitClient( void ) { return ( SUCCESS ); }
+void GATT_RegisterForInd( uint8 taskId ) { (void)taskId; }
+void ATT_HandleValueCfm( uint16 connHandle ) { (void)connHandle; }
+uint8 *osal_msg_receive( uint8 task_id ) { (void)task_id; return ( NULL ); }
+uint8 osal_msg_deallocate( uint8 *msg_ptr ) { (void)msg_ptr; return ( SUCCESS ); }
+uint8 RegisterForKeys( uint8 task_id ) { (void)task_id; return ( SUCCESS ); }
+uint8 HalLedSet( uint8 led, uint8 mode ) { (void)led; (void)mode; return ( 0 ); }
+
+// Every request is taken, and its response never comes
+bStatus_t GATT_ExchangeMTU( uint16 connHandle, attExchangeMTUReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; testGattCalls++; return ( SUCCESS ); }
+bStatus_t GATT_ReadCharValue( uint16 connHandle, attReadReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; testGattCalls++; return ( SUCCESS ); }
+
+void *GATT_bm_alloc( uint16 connHandle, uint8 opcode, uint16 size, uint16 *pSizeAlloc )
+{ (void)connHandle; (void)opcode; (void)pSizeAlloc; return ( malloc( size ) ); }
+void GATT_bm_free( gattMsg_t *pMsg, uint8 opcode ) { (void)pMsg; (void)opcode; }
+bStatus_t GATT_ReadLongCharValue( uint16 connHandle, attReadBlobReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ReadUsingCharUUID( uint16 connHandle, attReadByTypeReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ReadMultiCharValues( uint16 connHandle, attReadMultiReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_WriteCharValue( uint16 connHandle, attWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_WriteNoRsp( uint16 connHandle, attWriteReq_t *pReq )
+{ (void)connHandle; (void)pReq; return ( FAILURE ); }
+bStatus_t GATT_WriteLongCharValue( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_PrepareWriteReq( uint16 connHandle, attPrepareWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+bStatus_t GATT_ExecuteWriteReq( uint16 connHandle, attExecuteWriteReq_t *pReq, uint8 taskId )
+{ (void)connHandle; (void)pReq; (void)taskId; return ( FAILURE ); }
+
+void NPI_LogRecord( uint16 id, uint8 numArgs, uint16 arg0, uint16 arg1 )
+{ (void)id; (void)numArgs; (void)arg0; (void)arg1; }
+uint8 AdvFilter_Active( void ) { return ( FALSE ); }
+uint8 AdvFilter_Match( int8 rssi, uint8 *pAddr, uint8 *pData, uint8 dataLen )
+{ (void)rssi; (void)pAddr; (void)pData; (void)dataLen; return ( TRUE ); }
+void ScanSched_Init( uint8 taskId, uint16 event, scanSchedStartCB_t pfnStart )
+{ (void)taskId; (void)event; (void)pfnStart; }
+uint8 ScanSched_Active( void ) { return ( FALSE ); }
+uint8 ScanSched_Report( uint8 *pAddr ) { (void)pAddr; return ( FALSE ); }
+void ScanSched_WindowDone( void ) { }
+void ScanSched_ProcessEvent( void ) { }
+
+/*********************************************************************
+ * CENTRAL MODULE STAND-INS
+ */
+
+bStatus_t simpleBLECmdSendFrame( uint8 type, uint8 *pData, uint8 len )
+{
+  if ( testNumEvts < TEST_MAX_EVTS && len <= sizeof( testEvts[0].data ) )
+  {
+    testEvts[testNumEvts].type = type;
+    testEvts[testNumEvts].len = len;
+    memcpy( testEvts[testNumEvts].data, pData, len );
+    testNumEvts++;
+  }
+
+  return ( SUCCESS );
+}
+
+bStatus_t simpleBLECmdSendFrameParts( uint8 type, uint8 *pHdr, uint8 hdrLen,
+                                      uint8 *pData, uint8 len )
+{ (void)type; (void)pHdr; (void)hdrLen; (void)pData; (void)len; return ( SUCCESS ); }
+void simpleBLECmdSendNotification( uint16 connHandle, attHandleValueNoti_t *pNoti )
+{ (void)connHandle; (void)pNoti; }
+void simpleBLECmdInit( uint8 task_id ) { (void)task_id; }
+void simpleBLECmdFlush( void ) { }
+
+// No peer is cached, so every link waits for discovery
+bStatus_t simpleBLECacheLoad( simpleBLELink_t *pLink ) { (void)pLink; return ( FAILURE ); }
+void simpleBLECacheSave( simpleBLELink_t *pLink ) { (void)pLink; }
+void simpleBLECacheInvalidate( simpleBLELink_t *pLink ) { (void)pLink; }
+simpleBLEChar_t *simpleBLECacheFindChar( simpleBLELink_t *pLink, uint16 uuid )
+{ (void)pLink; (void)uuid; return ( NULL ); }
+void simpleBLEDiscInit( uint8 task_id ) { (void)task_id; }
+uint8 simpleBLEDiscStart( simpleBLELink_t *pLink ) { (void)pLink; return ( BLE_DISC_STATE_IDLE ); }
+uint8 simpleBLEDiscGattMsg( simpleBLELink_t *pLink, gattMsgEvent_t *pMsg )
+{ (void)pMsg; return ( pLink->discState ); }
+bStatus_t simpleBLEDiscWatchSvcChanged( simpleBLELink_t *pLink ) { (void)pLink; return ( FAILURE ); }
+
+void simpleBLEConnInit( uint8 task_id ) { (void)task_id; }
+void simpleBLEConnBusy( simpleBLELink_t *pLink ) { (void)pLink; }
+void simpleBLEConnIdleCheck( void ) { }
+bStatus_t simpleBLEConnSetProfile( simpleBLELink_t *pLink, uint8 profile, uint8 autoSwitch )
+{ (void)pLink; (void)profile; (void)autoSwitch; return ( SUCCESS ); }
+void simpleBLEConnUpdated( simpleBLELink_t *pLink, uint8 status, uint16 interval,
+                           uint16 latency, uint16 timeout )
+{ (void)pLink; (void)status; (void)interval; (void)latency; (void)timeout; }
+
+bStatus_t simpleBLEInfoStart( simpleBLELink_t *pLink, uint16 mask ) { (void)pLink; (void)mask; return ( SUCCESS ); }
+void simpleBLEInfoValue( simpleBLELink_t *pLink, uint8 item, uint8 *pValue, uint8 len )
+{ (void)pLink; (void)item; (void)pValue; (void)len; }
+void simpleBLEInfoDone( simpleBLELink_t *pLink, uint8 status ) { (void)pLink; (void)status; }
+void simpleBLESubDone( simpleBLELink_t *pLink, uint8 status ) { (void)pLink; (void)status; }
+
+void simpleBLEReconInit( uint8 task_id ) { (void)task_id; }
+void simpleBLEReconLinkUp( uint8 status, uint8 *pAddr ) { (void)status; (void)pAddr; }
+void simpleBLEReconLinkDown( uint8 *pAddr ) { (void)pAddr; }
+void simpleBLEReconProcess( void ) { }
+
+uint8 simpleBLEScanStreaming( void ) { return ( FALSE ); }
+void simpleBLEScanReport( gapDeviceInfoEvent_t *pInfo ) { (void)pInfo; }
+
+void simpleBLEStatsConnect( void ) { }
+void simpleBLEStatsLinkUp( simpleBLELink_t *pLink, uint8 status ) { (void)pLink; (void)status; }
+void simpleBLEStatsPhase( simpleBLELink_t *pLink, uint8 phase ) { (void)pLink; (void)phase; }
+void simpleBLEStatsFailure( uint8 kind, uint8 reason ) { (void)kind; (void)reason; }
+void simpleBLEStatsLinkDown( simpleBLELink_t *pLink, uint8 reason ) { (void)pLink; (void)reason; }
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      testReset
+ *
+ * @brief   Start a test case with the application freshly initialized
+ *          and no link up.
+ */
+static void testReset( void )
+{
+  hostReset();
+  SimpleBLECentral_Init( 0 );
+
+  testNumEvts = 0;
+  testNumTerminated = 0;
+  testGattCalls = 0;
+}
+
+/*********************************************************************
+ * @fn      testLinkUp
+ *
+ * @brief   Pass a link established event to the role callback.
+ */
+static void testLinkUp( uint8 status, uint16 connHandle )
+{
+  gapCentralRoleEvent_t evt;
+
+  memset( &evt, 0, sizeof( evt ) );
+  evt.linkCmpl.hdr.status = status;
+  evt.linkCmpl.opcode = GAP_LINK_ESTABLISHED_EVENT;
+  evt.linkCmpl.devAddrType = ADDRTYPE_PUBLIC;
+  evt.linkCmpl.devAddr[0] = (uint8)connHandle;
+  evt.linkCmpl.devAddr[5] = 0xC0;
+  evt.linkCmpl.connectionHandle = connHandle;
+  evt.linkCmpl.connInterval = 80;
+  evt.linkCmpl.connTimeout = 600;
+
+  CHECK( simpleBLECentralEventCB( &evt ) == TRUE );
+}
+
+/*********************************************************************
+ * @fn      testLinkDown
+ *
+ * @brief   Pass a link terminated event to the role callback.
+ */
+static void testLinkDown( uint16 connHandle, uint8 reason )
+{
+  gapCentralRoleEvent_t evt;
+
+  memset( &evt, 0, sizeof( evt ) );
+  evt.linkTerminate.opcode = GAP_LINK_TERMINATED_EVENT;
+  evt.linkTerminate.connectionHandle = connHandle;
+  evt.linkTerminate.reason = reason;
+
+  CHECK( simpleBLECentralEventCB( &evt ) == TRUE );
+}
+
+/*********************************************************************
+ * @fn      testFindEvt
+ *
+ * @brief   Find the n-th frame of a type sent to the host.
+ *
+ * @return  the frame, NULL if there are not that many
+ */
+static const testEvt_t *testFindEvt( uint8 type, uint8 n )
+{
+  uint8 i;
+
+  for ( i = 0; i < testNumEvts; i++ )
+  {
+    if ( testEvts[i].type == type && n-- == 0 )
+    {
+      return ( &testEvts[i] );
+    }
+  }
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      testEstablish
+ *
+ * @brief   Links get an entry of their own, and a failed establishment
+ *          leaves the table alone.
+ */
+static void testEstablish( void )
+{
+  const testEvt_t *pEvt;
+  simpleBLELink_t *pLink;
+  uint16 i;
+
+  testReset();
+
+  for ( i = 0; i < SBC_MAX_LINKS; i++ )
+  {
+    CHECK( simpleBLEFindLink( i ) == NULL );
+    testLinkUp( SUCCESS, i );
+
+    pLink = simpleBLEFindLink( i );
+    CHECK( pLink != NULL );
+    if ( pLink != NULL )
+    {
+      CHECK( pLink->connHandle == i );
+      CHECK( pLink->state == BLE_STATE_CONNECTED );
+      CHECK( pLink->addr[0] == (uint8)i );
+      CHECK( pLink->discState == BLE_DISC_STATE_PENDING );
+
+      // The MTU exchange is in progress and internal
+      CHECK( pLink->pGattActive != NULL );
+      CHECK( pLink->pGattActive != NULL && pLink->pGattActive->internal );
+    }
+
+    pEvt = testFindEvt( SBC_EVT_LINK_ESTABLISHED, i );
+    CHECK( pEvt != NULL && pEvt->data[0] == SUCCESS &&
+           BUILD_UINT16( pEvt->data[1], pEvt->data[2] ) == i );
+  }
+
+  CHECK( testGattCalls == SBC_MAX_LINKS );
+  CHECK( testNumTerminated == 0 );
+
+  // Failed establishment, nothing to terminate and no entry
+  testLinkUp( bleTimeout, GAP_CONNHANDLE_INIT );
+  pEvt = testFindEvt( SBC_EVT_LINK_ESTABLISHED, SBC_MAX_LINKS );
+  CHECK( pEvt != NULL && pEvt->data[0] == bleTimeout );
+  CHECK( testNumTerminated == 0 );
+  CHECK( testFindEvt( SBC_EVT_GATT_COMPLETE, 0 ) == NULL );
+}
+
+/*********************************************************************
+ * @fn      testOutOfRange
+ *
+ * @brief   A link whose handle is beyond the table is terminated and
+ *          reported as failed, and its termination is reported too.
+ */
+static void testOutOfRange( void )
+{
+  const testEvt_t *pEvt;
+  uint16 connHandle = SBC_MAX_LINKS;
+  int blocks;
+
+  testReset();
+  blocks = hostMemBlocks;
+
+  testLinkUp( SUCCESS, connHandle );
+
+  CHECK( testNumTerminated == 1 && testTerminated[0] == connHandle );
+  CHECK( simpleBLEFindLink( connHandle ) == NULL );
+  CHECK( testGattCalls == 0 );
+  CHECK( hostMemBlocks == blocks );
+
+  pEvt = testFindEvt( SBC_EVT_LINK_ESTABLISHED, 0 );
+  CHECK( pEvt != NULL && pEvt->data[0] == bleNoResources &&
+         BUILD_UINT16( pEvt->data[1], pEvt->data[2] ) == connHandle );
+
+  // The stack then reports the link down
+  testLinkDown( connHandle, TEST_REASON );
+
+  pEvt = testFindEvt( SBC_EVT_LINK_TERMINATED, 0 );
+  CHECK( pEvt != NULL && BUILD_UINT16( pEvt->data[0], pEvt->data[1] ) == connHandle &&
+         pEvt->data[2] == TEST_REASON );
+
+  // The table is still usable
+  testLinkUp( SUCCESS, 0 );
+  CHECK( simpleBLEFindLink( 0 ) != NULL );
+  CHECK( testNumTerminated == 1 );
+}
+
+/*********************************************************************
+ * @fn      testTerminate
+ *
+ * @brief   Terminating a link reports each of its host requests as not
+ *          connected, drops its internal ones quietly, frees them all
+ *          and leaves the other link as it was.
+ */
+static void testTerminate( void )
+{
+  const testEvt_t *pEvt;
+  simpleBLELink_t *pLink;
+  simpleBLELink_t *pOther;
+  int blocks;
+  uint8 i;
+
+  testReset();
+  blocks = hostMemBlocks;
+
+  testLinkUp( SUCCESS, 0 );
+  testLinkUp( SUCCESS, 1 );
+  pLink = simpleBLEFindLink( 0 );
+  pOther = simpleBLEFindLink( 1 );
+  CHECK( pLink != NULL && pOther != NULL );
+  if ( pLink == NULL || pOther == NULL )
+  {
+    return;
+  }
+
+  // Behind the MTU exchange in progress
+  CHECK( simpleBLEGattQueue( pLink, SBC_GATT_OP_READ, TEST_ID_FIRST, 0x0010, 0, NULL, 0 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pLink, SBC_GATT_OP_READ, TEST_ID_SECOND, 0x0012, 0, NULL, 0 ) == SUCCESS );
+  CHECK( simpleBLEGattQueue( pOther, SBC_GATT_OP_READ, TEST_ID_OTHER, 0x0010, 0, NULL, 0 ) == SUCCESS );
+  CHECK( pLink->gattQueued == 3 );
+  CHECK( hostMemBlocks == blocks + 5 );
+
+  testNumEvts = 0;
+  testLinkDown( 0, TEST_REASON );
+
+  // Both host requests, in order, and nothing for the internal one
+  CHECK( testFindEvt( SBC_EVT_GATT_COMPLETE, 2 ) == NULL );
+  for ( i = 0; i < 2; i++ )
+  {
+    pEvt = testFindEvt( SBC_EVT_GATT_COMPLETE, i );
+    CHECK( pEvt != NULL );
+    if ( pEvt != NULL )
+    {
+      CHECK( BUILD_UINT16( pEvt->data[0], pEvt->data[1] ) == 0 );
+      CHECK( pEvt->data[2] == ( i == 0 ? TEST_ID_FIRST : TEST_ID_SECOND ) );
+      CHECK( pEvt->data[3] == SBC_GATT_OP_READ );
+      CHECK( pEvt->data[4] == bleNotConnected );
+    }
+  }
+
+  pEvt = testFindEvt( SBC_EVT_LINK_TERMINATED, 0 );
+  CHECK( pEvt != NULL && BUILD_UINT16( pEvt->data[0], pEvt->data[1] ) == 0 );
+
+  // Entry freed, requests freed, other link untouched
+  CHECK( simpleBLEFindLink( 0 ) == NULL );
+  CHECK( pLink->connHandle == GAP_CONNHANDLE_INIT );
+  CHECK( pLink->gattQueued == 0 && pLink->pGattHead == NULL && pLink->pGattActive == NULL );
+  CHECK( hostMemBlocks == blocks + 2 );
+  CHECK( simpleBLEFindLink( 1 ) == pOther );
+  CHECK( pOther->gattQueued == 2 && pOther->pGattActive != NULL );
+
+  // The entry comes back clean
+  testLinkUp( SUCCESS, 0 );
+  CHECK( simpleBLEFindLink( 0 ) == pLink );
+  CHECK( pLink->gattQueued == 1 );
+
+  testLinkDown( 0, TEST_REASON );
+  testLinkDown( 1, TEST_REASON );
+  CHECK( hostMemBlocks == blocks );
+
+  // A second termination of the same handle finds nothing to do
+  testNumEvts = 0;
+  testLinkDown( 1, TEST_REASON );
+  CHECK( testFindEvt( SBC_EVT_GATT_COMPLETE, 0 ) == NULL );
+  CHECK( hostMemBlocks == blocks );
+}
+
+/*********************************************************************
+ * @fn      main
+ */
+int main( void )
+{
+  testEstablish();
+  testOutOfRange();
+  testTerminate();
+
+  return ( hostReport( "test_link" ) );
+}
@@ -0,0 +1,601 @@
+/******************************************************************************
+
+ @file  test_npi_spi.c
+
+ @brief Host loopback test of NPI on the SPI transport. The real npi.c is
+        built with HAL_UART_SPI against a stand-in of the HAL SPI slave
+        driver, which frames every HalUARTWrite as SOF | LEN | DATA | FCS
+        and unframes the host's frames into the receive buffer. The host
+        side clocks every transfer after the MRDY/SRDY handshake, the way
+        npi_spi_host.py does. A device task echoes what NPI_ReadTransport
+        returns through NPI_QueueWrite, and the test checks that the echo
+        comes back whole and in order, that no frame is larger than the
+        transport allows, that a frame with a bad FCS is dropped, and that
+        a write the slave has no room for is finished once it drains.
+
+        The frames the host reads are also saved, with the payloads they
+        carry, for the Makefile to decode with npi_spi_host.py.
+
+ Group: WCS, BTS
+ Target Device: Linux host
+
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include <stdlib.h>
+#include "host_test.h"
+#include "npi.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Room for frames in the slave's transmit buffer, less than a few
+// largest blocks so that queued writes have to wait for the host
+#define TEST_SLAVE_TX_SIZE                    200
+
+#define TEST_HOST_RX_SIZE                     1024
+
+// Slave frame parser states
+#define TEST_RX_SOF                           0
+#define TEST_RX_LEN                           1
+#define TEST_RX_DATA                          2
+#define TEST_RX_FCS                           3
+
+#if ( NPI_SPI != TRUE )
+  #error "Build with HAL_UART_SPI"
+#endif
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Sleep timer registers read by NPI_StatsStamp
+uint8 ST0;
+uint8 ST1;
+uint8 ST2;
+
+// HAL SPI slave stand-in
+static halUARTCfg_t testCfg;
+static uint8  testPort;
+static uint8  testMrdy;               // Asserted by the host
+static uint8  testTx[TEST_SLAVE_TX_SIZE];
+static uint16 testTxLen;
+static uint8  testRx[NPI_UART_RX_BUF_SIZE];
+static uint16 testRxLen;
+static uint8  testRxState;
+static uint8  testRxFrame[NPI_SPI_MAX_DATA_LEN];
+static uint8  testRxFrameLen;
+static uint8  testRxFrameIdx;
+static uint8  testRxFcs;
+static uint16 testRxBadFcs;
+
+// Host side
+static uint8  testHostRx[TEST_HOST_RX_SIZE];
+static uint16 testHostRxLen;
+static uint16 testHostFrames;
+static uint8  testHostMaxFrame;
+static uint16 testHostBad;
+static FILE   *testWire;              // Frames read, as clocked in
+static FILE   *testExpect;            // Their payloads, one hex line each
+
+// Device task
+static uint8  testEvents;             // Events passed on by NPI
+
+/*********************************************************************
+ * HAL SPI SLAVE STAND-IN
+ */
+
+/*********************************************************************
+ * @fn      testSrdy
+ *
+ * @brief   SRDY, asserted in answer to MRDY and while the slave has a
+ *          frame for the host.
+ */
+static uint8 testSrdy( void )
+{
+  return ( testMrdy || testTxLen > 0 );
+}
+
+uint8 HalUARTOpen( uint8 port, halUARTCfg_t *config )
+{
+  testPort = port;
+  testCfg = *config;
+
+  return ( SUCCESS );
+}
+
+uint16 HalUARTRead( uint8 port, uint8 *buf, uint16 len )
+{
+  CHECK( port == testPort );
+
+  if ( len > testRxLen )
+  {
+    len = testRxLen;
+  }
+
+  memcpy( buf, testRx, len );
+  memmove( testRx, &testRx[len], testRxLen - len );
+  testRxLen -= len;
+
+  return ( len );
+}
+
+// One frame per write, taken whole or not at all
+uint16 HalUARTWrite( uint8 port, uint8 *buf, uint16 len )
+{
+  uint8 fcs = (uint8)len;
+  uint16 i;
+
+  CHECK( port == testPort );
+
+  if ( len == 0 || len > NPI_SPI_MAX_DATA_LEN ||
+       len + 3 > TEST_SLAVE_TX_SIZE - testTxLen )
+  {
+    return ( 0 );
+  }
+
+  testTx[testTxLen++] = NPI_SPI_SOF;
+  testTx[testTxLen++] = (uint8)len;
+  for ( i = 0; i < len; i++ )
+  {
+    testTx[testTxLen++] = buf[i];
+    fcs ^= buf[i];
+  }
+  testTx[testTxLen++] = fcs;
+
+  return ( len );
+}
+
+uint16 Hal_UART_RxBufLen( uint8 port )
+{
+  CHECK( port == testPort );
+
+  return ( testRxLen );
+}
+
+/*********************************************************************
+ * @fn      testSlaveRxByte
+ *
+ * @brief   Unframe a byte clocked in by the host. A whole frame with a
+ *          good FCS goes into the receive buffer, and the callback is
+ *          told there is data.
+ */
+static void testSlaveRxByte( uint8 b )
+{
+  switch ( testRxState )
+  {
+    case TEST_RX_SOF:
+      if ( b == NPI_SPI_SOF )
+      {
+        testRxState = TEST_RX_LEN;
+      }
+      break;
+
+    case TEST_RX_LEN:
+      testRxFrameLen = b;
+      testRxFrameIdx = 0;
+      testRxFcs = b;
+      testRxState = ( b == 0 ) ? TEST_RX_SOF : TEST_RX_DATA;
+      break;
+
+    case TEST_RX_DATA:
+      testRxFrame[testRxFrameIdx++] = b;
+      testRxFcs ^= b;
+      if ( testRxFrameIdx == testRxFrameLen )
+      {
+        testRxState = TEST_RX_FCS;
+      }
+      break;
+
+    default:
+      testRxState = TEST_RX_SOF;
+      if ( b != testRxFcs || testRxFrameLen > NPI_UART_RX_BUF_SIZE - testRxLen )
+      {
+        testRxBadFcs++;
+        break;
+      }
+
+      memcpy( &testRx[testRxLen], testRxFrame, testRxFrameLen );
+      testRxLen += testRxFrameLen;
+      testCfg.callBackFunc( testPort, HAL_UART_RX_TIMEOUT );
+      break;
+  }
+}
+
+/*********************************************************************
+ * HOST SIDE
+ */
+
+/*********************************************************************
+ * @fn      testHostWrite
+ *
+ * @brief   Send a frame the way npi_spi_host.py does: assert MRDY, wait
+ *          for SRDY, clock the frame out and release MRDY. A nonzero
+ *          fcsError is XOR'ed into the FCS.
+ */
+static void testHostWrite( const uint8 *pData, uint8 len, uint8 fcsError )
+{
+  uint8 fcs = len;
+  uint8 i;
+
+  testMrdy = TRUE;
+  CHECK( testSrdy() );
+
+  testSlaveRxByte( NPI_SPI_SOF );
+  testSlaveRxByte( len );
+  for ( i = 0; i < len; i++ )
+  {
+    testSlaveRxByte( pData[i] );
+    fcs ^= pData[i];
+  }
+  testSlaveRxByte( fcs ^ fcsError );
+
+  testMrdy = FALSE;
+}
+
+/*********************************************************************
+ * @fn      testHostClock
+ *
+ * @brief   Clock one byte in from the slave.
+ */
+static uint8 testHostClock( void )
+{
+  uint8 b = 0;
+
+  if ( testTxLen > 0 )
+  {
+    b = testTx[0];
+    memmove( testTx, &testTx[1], --testTxLen );
+  }
+
+  if ( testWire != NULL )
+  {
+    fputc( b, testWire );
+  }
+
+  return ( b );
+}
+
+/*********************************************************************
+ * @fn      testHostRead
+ *
+ * @brief   Read one frame if SRDY asks for it: assert MRDY, clock in
+ *          SOF and LEN, then the data and FCS, and release MRDY. The
+ *          slave reports HAL_UART_TX_EMPTY once it has nothing left.
+ *
+ * @return  TRUE if a frame was read.
+ */
+static uint8 testHostRead( void )
+{
+  uint8 len;
+  uint8 fcs;
+  uint8 i;
+  uint8 *p = &testHostRx[testHostRxLen];
+
+  if ( !testSrdy() )
+  {
+    return ( FALSE );
+  }
+
+  testMrdy = TRUE;
+
+  if ( testHostClock() != NPI_SPI_SOF )
+  {
+    testHostBad++;
+    testMrdy = FALSE;
+    return ( FALSE );
+  }
+
+  fcs = len = testHostClock();
+  for ( i = 0; i < len; i++ )
+  {
+    p[i] = testHostClock();
+    fcs ^= p[i];
+  }
+
+  if ( testHostClock() != fcs )
+  {
+    testHostBad++;
+  }
+  else
+  {
+    if ( testExpect != NULL )
+    {
+      for ( i = 0; i < len; i++ )
+      {
+        fprintf( testExpect, "%02x", p[i] );
+      }
+      fputc( '\n', testExpect );
+    }
+
+    testHostRxLen += len;
+    testHostFrames++;
+    testHostMaxFrame = MAX( testHostMaxFrame, len );
+  }
+
+  testMrdy = FALSE;
+
+  if ( testTxLen == 0 )
+  {
+    testCfg.callBackFunc( testPort, HAL_UART_TX_EMPTY );
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      testHostDrain
+ *
+ * @brief   Read frames for as long as the slave asserts SRDY.
+ */
+static void testHostDrain( void )
+{
+  uint16 guard = 0;
+
+  while ( testHostRead() && ++guard < 1000 )
+  {
+  }
+
+  CHECK( guard < 1000 );
+  CHECK( !testSrdy() );
+}
+
+/*********************************************************************
+ * DEVICE TASK
+ */
+
+static void testDone( npiTxReq_t *pReq )
+{
+  osal_mem_free( pReq );
+}
+
+/*********************************************************************
+ * @fn      testQueue
+ *
+ * @brief   Queue a copy of the data, freed when NPI is done with it.
+ */
+static void testQueue( const uint8 *pData, uint16 len )
+{
+  npiTxReq_t *pReq = osal_mem_alloc( sizeof( npiTxReq_t ) + len );
+
+  pReq->pBuf = (uint8 *)( pReq + 1 );
+  pReq->len = len;
+  pReq->pfnDone = testDone;
+  memcpy( pReq->pBuf, pData, len );
+
+  CHECK( NPI_QueueWrite( pReq ) == SUCCESS );
+}
+
+// Echo what is read
+static void testSerialCB( uint8 port, uint8 event )
+{
+  uint8 buf[NPI_UART_RX_BUF_SIZE];
+  uint16 len;
+
+  CHECK( port == NPI_UART_PORT );
+  testEvents |= event;
+
+  while ( (len = NPI_ReadTransport( buf, sizeof( buf ) )) > 0 )
+  {
+    testQueue( buf, len );
+  }
+}
+
+/*********************************************************************
+ * @fn      testReset
+ *
+ * @brief   Open the transport with nothing in flight.
+ */
+static void testReset( void )
+{
+  hostReset();
+
+  testMrdy = FALSE;
+  testTxLen = 0;
+  testRxLen = 0;
+  testRxState = TEST_RX_SOF;
+  testRxBadFcs = 0;
+  testHostRxLen = 0;
+  testHostFrames = 0;
+  testHostMaxFrame = 0;
+  testHostBad = 0;
+  testEvents = 0;
+
+  NPI_InitTransport( testSerialCB );
+  NPI_ResetStats();
+}
+
+/*********************************************************************
+ * @fn      testFinish
+ *
+ * @brief   Check that every write was sent and freed.
+ */
+static void testFinish( void )
+{
+  CHECK( NPI_TxQueued() == 0 );
+  CHECK( testTxLen == 0 && testRxLen == 0 );
+  CHECK( testHostBad == 0 );
+  CHECK( hostMemBlocks == 0 );
+}
+
+/*********************************************************************
+ * TEST CASES
+ */
+
+static void testOpen( void )
+{
+  testReset();
+
+  CHECK( testPort == NPI_UART_PORT );
+  CHECK( testCfg.configured == TRUE );
+  CHECK( testCfg.callBackFunc != NULL );
+  CHECK( testCfg.rx.maxBufSize == NPI_UART_RX_BUF_SIZE );
+  CHECK( testCfg.tx.maxBufSize == NPI_UART_TX_BUF_SIZE );
+  CHECK( NPI_UART_TX_MAX_BLOCK <= NPI_SPI_MAX_DATA_LEN );
+
+  // Nothing to read, SRDY stays released
+  CHECK( !testSrdy() );
+  CHECK( testHostRead() == FALSE );
+}
+
+static void testEcho( void )
+{
+  static const uint8 msg[] = { 0x01, 0xFE, 0x00, 0xFF, 0x55 };
+  npiStats_t stats;
+
+  testReset();
+
+  testHostWrite( msg, sizeof( msg ), 0 );
+  CHECK( testEvents & HAL_UART_RX_TIMEOUT );
+
+  // The echo is a single frame, SRDY asks the host to read it
+  CHECK( testSrdy() );
+  CHECK( testTxLen == sizeof( msg ) + 3 );
+  testHostDrain();
+
+  CHECK( testHostFrames == 1 );
+  CHECK( testHostRxLen == sizeof( msg ) );
+  CHECK( memcmp( testHostRx, msg, sizeof( msg ) ) == 0 );
+  CHECK( testEvents & HAL_UART_TX_EMPTY );
+
+  NPI_GetStats( &stats );
+  CHECK( stats.rxBytes == sizeof( msg ) && stats.txBytes == sizeof( msg ) );
+  CHECK( stats.txShortWrites == 0 );
+
+  testFinish();
+}
+
+static void testBurst( void )
+{
+  uint8 msg[100];
+  uint8 n;
+  uint8 i;
+  uint16 j;
+  npiStats_t stats;
+
+  testReset();
+
+  // More is echoed than the slave can hold, so the queue has to wait for
+  // the host to read, and resumes on HAL_UART_TX_EMPTY
+  for ( n = 0; n < 6; n++ )
+  {
+    for ( i = 0; i < sizeof( msg ); i++ )
+    {
+      msg[i] = (uint8)( n * sizeof( msg ) + i );
+    }
+    testHostWrite( msg, sizeof( msg ), 0 );
+  }
+
+  CHECK( NPI_TxQueued() > 0 );
+  testHostDrain();
+
+  CHECK( testHostRxLen == 6 * sizeof( msg ) );
+  for ( j = 0; j < testHostRxLen && testHostRx[j] == (uint8)j; j++ )
+  {
+  }
+  CHECK( j == testHostRxLen );
+  CHECK( testHostMaxFrame <= NPI_UART_TX_MAX_BLOCK );
+  CHECK( testHostFrames >= 6 );
+
+  NPI_GetStats( &stats );
+  CHECK( stats.rxBytes == 6 * sizeof( msg ) && stats.txBytes == 6 * sizeof( msg ) );
+  CHECK( stats.txShortWrites > 0 );
+
+  testFinish();
+}
+
+static void testLongWrite( void )
+{
+  uint8 msg[300];
+  uint16 i;
+
+  testReset();
+
+  // A write longer than a frame goes out as several, whole and in order
+  for ( i = 0; i < sizeof( msg ); i++ )
+  {
+    msg[i] = (uint8)( i * 7 );
+  }
+  testQueue( msg, sizeof( msg ) );
+  testHostDrain();
+
+  CHECK( testHostRxLen == sizeof( msg ) );
+  CHECK( memcmp( testHostRx, msg, sizeof( msg ) ) == 0 );
+  CHECK( testHostFrames >= 3 );
+  CHECK( testHostMaxFrame <= NPI_UART_TX_MAX_BLOCK );
+
+  testFinish();
+}
+
+static void testBadFcs( void )
+{
+  static const uint8 msg[] = { 0x10, 0x20, 0x30 };
+  static const uint8 noise[] = { 0x00, 0x12, 0xFF };
+  uint8 i;
+
+  testReset();
+
+  // A frame with a bad FCS is dropped and nothing is echoed
+  testHostWrite( msg, sizeof( msg ), 0x01 );
+  CHECK( testRxBadFcs == 1 );
+  CHECK( testEvents == 0 );
+  CHECK( !testSrdy() );
+
+  // Bytes ahead of SOF are skipped, the next frame goes through
+  testMrdy = TRUE;
+  for ( i = 0; i < sizeof( noise ); i++ )
+  {
+    testSlaveRxByte( noise[i] );
+  }
+  testMrdy = FALSE;
+  testHostWrite( msg, sizeof( msg ), 0 );
+  testHostDrain();
+
+  CHECK( testHostFrames == 1 );
+  CHECK( testHostRxLen == sizeof( msg ) );
+  CHECK( memcmp( testHostRx, msg, sizeof( msg ) ) == 0 );
+
+  testFinish();
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Run the cases. With a directory argument, the frames read and
+ *          their payloads are saved there as npi_spi.wire and
+ *          npi_spi.expect.
+ */
+int main( int argc, char **argv )
+{
+  char path[256];
+
+  if ( argc > 1 )
+  {
+    snprintf( path, sizeof( path ), "%s/npi_spi.wire", argv[1] );
+    testWire = fopen( path, "wb" );
+    snprintf( path, sizeof( path ), "%s/npi_spi.expect", argv[1] );
+    testExpect = fopen( path, "w" );
+    CHECK( testWire != NULL && testExpect != NULL );
+  }
+
+  testOpen();
+  testEcho();
+  testBurst();
+  testLongWrite();
+  testBadFcs();
+
+  if ( testWire != NULL )
+  {
+    fclose( testWire );
+  }
+  if ( testExpect != NULL )
+  {
+    fclose( testExpect );
+  }
+
+  return ( hostReport( "test_npi_spi" ) );
+}
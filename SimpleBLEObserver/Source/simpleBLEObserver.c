@@ -61,6 +61,8 @@
 #include "hci.h"
 
 #include "observer.h"
+#include "advfilter.h"
+#include "scansched.h"
 
 #include "simpleBLEObserver.h"
 
@@ -133,6 +135,7 @@ static uint8 simpleBLEObserverEventCB( gapObserverRoleEvent_t *pEvent );
 static void simpleBLEObserver_HandleKeys( uint8 shift, uint8 keys );
 static void simpleBLEObserver_ProcessOSALMsg( osal_event_hdr_t *pMsg );
 static void simpleBLEAddDeviceInfo( uint8 *pAddr, uint8 addrType );
+static bStatus_t simpleBLEObserverStartScan( void );
 char *bdAddr2Str ( uint8 *pAddr );
 
 /*********************************************************************
@@ -178,6 +181,10 @@ void SimpleBLEObserver_Init( uint8 task_id )
   GAP_SetParamValue( TGAP_GEN_DISC_SCAN, DEFAULT_SCAN_DURATION );
   GAP_SetParamValue( TGAP_LIM_DISC_SCAN, DEFAULT_SCAN_DURATION );
 
+  simpleBLEPresenceInit( simpleBLETaskId );
+  ScanSched_Init( simpleBLETaskId, SBO_SCAN_SCHED_EVT, simpleBLEObserverStartScan );
+  VOID ScanSched_SetParams( SBO_SCAN_WINDOW, SBO_SCAN_MIN_INTERVAL, SBO_SCAN_MAX_INTERVAL );
+
   // Register for all key events - This app will handle all key events
   RegisterForKeys( simpleBLETaskId );
   
@@ -229,6 +236,20 @@ uint16 SimpleBLEObserver_ProcessEvent( uint8 task_id, uint16 events )
 
     return ( events ^ START_DEVICE_EVT );
   }
+
+  if ( events & SBO_PRESENCE_AGE_EVT )
+  {
+    simpleBLEPresenceAge();
+
+    return ( events ^ SBO_PRESENCE_AGE_EVT );
+  }
+
+  if ( events & SBO_SCAN_SCHED_EVT )
+  {
+    ScanSched_ProcessEvent();
+
+    return ( events ^ SBO_SCAN_SCHED_EVT );
+  }
   
   // Discard unknown events
   return 0;
@@ -278,15 +299,7 @@ static void simpleBLEObserver_HandleKeys( uint8 shift, uint8 keys )
     // Start or stop discovery
     if ( !simpleBLEScanning )
     {
-      simpleBLEScanning = TRUE;
-      simpleBLEScanRes = 0;
-      
-      LCD_WRITE_STRING( "Discovering...", HAL_LCD_LINE_1 );
-      LCD_WRITE_STRING( "", HAL_LCD_LINE_2 );
-      
-      GAPObserverRole_StartDiscovery( DEFAULT_DISCOVERY_MODE,
-                                      DEFAULT_DISCOVERY_ACTIVE_SCAN,
-                                      DEFAULT_DISCOVERY_WHITE_LIST );      
+      VOID simpleBLEObserverStartScan();
     }
     else
     {
@@ -323,6 +336,24 @@ static void simpleBLEObserver_HandleKeys( uint8 shift, uint8 keys )
   
   if ( keys & HAL_KEY_DOWN )
   {
+    // Start or stop presence tracking
+    if ( !simpleBLEPresenceEnabled() )
+    {
+      simpleBLEPresenceEnable( TRUE );
+
+      LCD_WRITE_STRING( "Presence On", HAL_LCD_LINE_1 );
+
+      VOID ScanSched_Start();
+    }
+    else
+    {
+      simpleBLEPresenceEnable( FALSE );
+
+      LCD_WRITE_STRING( "Presence Off", HAL_LCD_LINE_1 );
+
+      ScanSched_Stop();
+      GAPObserverRole_CancelDiscovery();
+    }
   }
 }
 
@@ -343,12 +374,26 @@ static uint8 simpleBLEObserverEventCB( gapObserverRoleEvent_t *pEvent )
       {
         LCD_WRITE_STRING( "BLE Observer", HAL_LCD_LINE_1 );
         LCD_WRITE_STRING( bdAddr2Str( pEvent->initDone.devAddr ),  HAL_LCD_LINE_2 );
+
+#if ( SBO_PRESENCE_AUTO_START == TRUE )
+        simpleBLEPresenceEnable( TRUE );
+        VOID ScanSched_Start();
+#endif
       }
       break;
 
     case GAP_DEVICE_INFO_EVENT:
       {
-        simpleBLEAddDeviceInfo( pEvent->deviceInfo.addr, pEvent->deviceInfo.addrType );
+        if ( AdvFilter_Match( pEvent->deviceInfo.rssi, pEvent->deviceInfo.addr,
+                              pEvent->deviceInfo.pEvtData, pEvent->deviceInfo.dataLen ) )
+        {
+          simpleBLEAddDeviceInfo( pEvent->deviceInfo.addr, pEvent->deviceInfo.addrType );
+
+          VOID ScanSched_Report( pEvent->deviceInfo.addr );
+
+          simpleBLEPresenceUpdate( pEvent->deviceInfo.addrType, pEvent->deviceInfo.addr,
+                                   pEvent->deviceInfo.rssi );
+        }
       }
       break;
       
@@ -357,10 +402,20 @@ static uint8 simpleBLEObserverEventCB( gapObserverRoleEvent_t *pEvent )
         // discovery complete
         simpleBLEScanning = FALSE;
 
-        // Copy results
-        simpleBLEScanRes = pEvent->discCmpl.numDevs;
-        osal_memcpy( simpleBLEDevList, pEvent->discCmpl.pDevList,
-                     (sizeof( gapDevRec_t ) * pEvent->discCmpl.numDevs) );
+        // Presence tracking scans in windows set by the scheduler
+        if ( ScanSched_Active() )
+        {
+          ScanSched_WindowDone();
+          break;
+        }
+
+        // Copy results, unless filtered results were collected above
+        if ( !AdvFilter_Active() )
+        {
+          simpleBLEScanRes = pEvent->discCmpl.numDevs;
+          osal_memcpy( simpleBLEDevList, pEvent->discCmpl.pDevList,
+                       (sizeof( gapDevRec_t ) * pEvent->discCmpl.numDevs) );
+        }
         
         LCD_WRITE_STRING_VALUE( "Devices Found", simpleBLEScanRes,
                                 10, HAL_LCD_LINE_1 );
@@ -413,6 +468,37 @@ static void simpleBLEAddDeviceInfo( uint8 *pAddr, uint8 addrType )
   }
 }
 
+/*********************************************************************
+ * @fn      simpleBLEObserverStartScan
+ *
+ * @brief   Start a discovery window with a fresh result list.
+ *
+ * @return  SUCCESS if discovery started, otherwise the GAP status
+ */
+static bStatus_t simpleBLEObserverStartScan( void )
+{
+  bStatus_t status;
+
+  if ( simpleBLEScanning )
+  {
+    return ( bleAlreadyInRequestedMode );
+  }
+
+  status = GAPObserverRole_StartDiscovery( DEFAULT_DISCOVERY_MODE,
+                                           DEFAULT_DISCOVERY_ACTIVE_SCAN,
+                                           DEFAULT_DISCOVERY_WHITE_LIST );
+  if ( status == SUCCESS )
+  {
+    simpleBLEScanning = TRUE;
+    simpleBLEScanRes = 0;
+
+    LCD_WRITE_STRING( "Discovering...", HAL_LCD_LINE_1 );
+    LCD_WRITE_STRING( "", HAL_LCD_LINE_2 );
+  }
+
+  return ( status );
+}
+
 /*********************************************************************
  * @fn      bdAddr2Str
  *
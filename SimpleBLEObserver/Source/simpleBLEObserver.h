@@ -66,6 +66,72 @@ extern "C"
 // Simple BLE Observer Task Events
 #define START_DEVICE_EVT                              0x0001
 #define START_DISCOVERY_EVT                           0x0002
+#define SBO_PRESENCE_AGE_EVT                          0x0004
+#define SBO_SCAN_SCHED_EVT                            0x0008
+
+// Presence tracking configuration
+#if !defined( SBO_PRESENCE_TABLE_SIZE )
+#define SBO_PRESENCE_TABLE_SIZE                       64    // Devices tracked, power of 2
+#endif
+
+#if !defined( SBO_PRESENCE_LOST_TIMEOUT )
+#define SBO_PRESENCE_LOST_TIMEOUT                     10000 // ms without an advertisement before a device is lost
+#endif
+
+#if !defined( SBO_PRESENCE_AGE_PERIOD )
+#define SBO_PRESENCE_AGE_PERIOD                       1000  // ms between aging sweeps
+#endif
+
+#if !defined( SBO_PRESENCE_RSSI_HYST )
+#define SBO_PRESENCE_RSSI_HYST                        6     // dB change before an RSSI update is sent
+#endif
+
+// Presence scan schedule, in ms. A device that misses one window is
+// next heard up to two intervals and a window after it was last heard,
+// so that must stay under SBO_PRESENCE_LOST_TIMEOUT or it is reported
+// lost and new again.
+#if !defined( SBO_SCAN_WINDOW )
+#define SBO_SCAN_WINDOW                               1000
+#endif
+
+#if !defined( SBO_SCAN_MIN_INTERVAL )
+#define SBO_SCAN_MIN_INTERVAL                         1000
+#endif
+
+#if !defined( SBO_SCAN_MAX_INTERVAL )
+#define SBO_SCAN_MAX_INTERVAL                         4000
+#endif
+
+#if ( SBO_PRESENCE_LOST_TIMEOUT <= 2 * SBO_SCAN_MAX_INTERVAL + SBO_SCAN_WINDOW )
+#error "SBO_PRESENCE_LOST_TIMEOUT must exceed 2 * SBO_SCAN_MAX_INTERVAL + SBO_SCAN_WINDOW"
+#endif
+
+// TRUE to start presence tracking once the device is up
+#if !defined( SBO_PRESENCE_AUTO_START )
+#define SBO_PRESENCE_AUTO_START                       FALSE
+#endif
+
+/*
+ * Presence reports are sent over NPI in the central's host frame format:
+ *
+ *   SOF | TYPE | LEN | PAYLOAD[LEN] | FCS
+ *
+ * FCS is the 8-bit sum of TYPE, LEN and PAYLOAD. Any byte after SOF that
+ * equals SOF, ESC or EOF is sent as ESC followed by its escape code.
+ */
+#define SBO_FRAME_SOF                                 0xF0
+#define SBO_FRAME_ESC                                 0xF5
+#define SBO_FRAME_EOF                                 0xFA
+
+#define SBO_FRAME_ESC_SOF                             0x01
+#define SBO_FRAME_ESC_ESC                             0x02
+#define SBO_FRAME_ESC_EOF                             0x03
+
+// Presence deltas, addresses are sent most significant byte first
+#define SBO_EVT_DEV_NEW                               0x40  // addrType, addr[6], rssi
+#define SBO_EVT_DEV_LOST                              0x41  // addrType, addr[6], advCount[2]
+#define SBO_EVT_DEV_RSSI                              0x42  // addrType, addr[6], rssi
+#define SBO_EVT_PRESENCE                              0x43  // on, numDevs[2], overflows[2]
 
 /*********************************************************************
  * MACROS
@@ -96,6 +162,15 @@ extern void SimpleBLEObserver_Init( uint8 task_id );
  */
 extern uint16 SimpleBLEObserver_ProcessEvent( uint8 task_id, uint16 events );
 
+/*
+ * Presence tracking functions
+ */
+extern void simpleBLEPresenceInit( uint8 task_id );
+extern void simpleBLEPresenceEnable( uint8 enable );
+extern uint8 simpleBLEPresenceEnabled( void );
+extern void simpleBLEPresenceUpdate( uint8 addrType, uint8 *pAddr, int8 rssi );
+extern void simpleBLEPresenceAge( void );
+
 /*********************************************************************
 *********************************************************************/
 
@@ -0,0 +1,530 @@
+/******************************************************************************
+
+ @file  simpleBLEObserver_presence.c
+
+ @brief This file contains the presence tracker of the Simple BLE Observer.
+        It keeps a hashed table of the devices heard while scanning and sends
+        only the changes (new, lost, RSSI moved) to the host over NPI.
+
+ Group: WCS, BTS
+ Target Device: CC2540, CC2541
+
+ ******************************************************************************
+ 
+ Copyright (c) 2010-2016, Texas Instruments Incorporated
+ All rights reserved.
+
+ IMPORTANT: Your use of this Software is limited to those specific rights
+ granted under the terms of a software license agreement between the user
+ who downloaded the software, his/her employer (which must be your employer)
+ and Texas Instruments Incorporated (the "License"). You may not use this
+ Software unless you agree to abide by the terms of the License. The License
+ limits your use, and you acknowledge, that the Software may not be modified,
+ copied or distributed unless embedded on a Texas Instruments microcontroller
+ or used solely and exclusively in conjunction with a Texas Instruments radio
+ frequency transceiver, which is integrated into your product. Other than for
+ the foregoing purpose, you may not use, reproduce, copy, prepare derivative
+ works of, modify, distribute, perform, display or sell this Software and/or
+ its documentation for any purpose.
+
+ YOU FURTHER ACKNOWLEDGE AND AGREE THAT THE SOFTWARE AND DOCUMENTATION ARE
+ PROVIDED AS IS WITHOUT WARRANTY OF ANY KIND, EITHER EXPRESS OR IMPLIED,
+ INCLUDING WITHOUT LIMITATION, ANY WARRANTY OF MERCHANTABILITY, TITLE,
+ NON-INFRINGEMENT AND FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT SHALL
+ TEXAS INSTRUMENTS OR ITS LICENSORS BE LIABLE OR OBLIGATED UNDER CONTRACT,
+ NEGLIGENCE, STRICT LIABILITY, CONTRIBUTION, BREACH OF WARRANTY, OR OTHER
+ LEGAL EQUITABLE THEORY ANY DIRECT OR INDIRECT DAMAGES OR EXPENSES
+ INCLUDING BUT NOT LIMITED TO ANY INCIDENTAL, SPECIAL, INDIRECT, PUNITIVE
+ OR CONSEQUENTIAL DAMAGES, LOST PROFITS OR LOST DATA, COST OF PROCUREMENT
+ OF SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
+ (INCLUDING BUT NOT LIMITED TO ANY DEFENSE THEREOF), OR OTHER SIMILAR COSTS.
+
+ Should you have any questions regarding your right to use this Software,
+ contact Texas Instruments Incorporated at www.TI.com.
+
+ ******************************************************************************
+ Release Name: ble_sdk_1.4.2.2
+ Release Date: 2016-06-09 06:57:10
+ *****************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "bcomdef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "gap.h"
+#include "npi.h"
+
+#include "simpleBLEObserver.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Current time in presence ticks
+#define SBO_PRESENCE_NOW()                    ( (uint16)( osal_GetSystemClock() >> SBO_PRESENCE_TICK_SHIFT ) )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#if ( SBO_PRESENCE_TABLE_SIZE & ( SBO_PRESENCE_TABLE_SIZE - 1 ) ) || ( SBO_PRESENCE_TABLE_SIZE > 256 )
+#error "SBO_PRESENCE_TABLE_SIZE must be a power of 2 no larger than 256"
+#endif
+
+// Last-seen times are kept in 128ms ticks so they fit in 16 bits
+#define SBO_PRESENCE_TICK_SHIFT               7
+#define SBO_PRESENCE_LOST_TICKS               ( SBO_PRESENCE_LOST_TIMEOUT >> SBO_PRESENCE_TICK_SHIFT )
+
+// Devices admitted before the table counts as full, kept at 3/4 of the
+// slots so probe sequences stay short
+#define SBO_PRESENCE_MAX_DEVS                 ( SBO_PRESENCE_TABLE_SIZE - SBO_PRESENCE_TABLE_SIZE / 4 )
+
+// Device entry flags
+#define SBO_DEV_IN_USE                        0x01  // Slot holds a device
+#define SBO_DEV_REPORTED                      0x02  // Host has been told about the device
+
+// Longest presence payload and its worst case encoding
+#define SBO_PRESENCE_MAX_PAYLOAD              ( 3 + B_ADDR_LEN )
+#define SBO_PRESENCE_MAX_ENCODED              ( 1 + 2 * ( SBO_PRESENCE_MAX_PAYLOAD + 3 ) )
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Tracked device
+typedef struct
+{
+  uint8  addr[B_ADDR_LEN];            // Device address
+  uint8  addrType;                    // Address type
+  uint8  flags;                       // SBO_DEV_*
+  int8   rssi;                        // Last RSSI
+  int8   rptRssi;                     // RSSI last sent to the host
+  uint16 advCount;                    // Advertisements heard, saturates
+  uint16 lastSeen;                    // Tick of the last advertisement
+} simpleBLEPresenceDev_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL VARIABLES
+ */
+
+/*********************************************************************
+ * EXTERNAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Task that receives SBO_PRESENCE_AGE_EVT
+static uint8 simpleBLEPresenceTaskId;
+
+// TRUE while tracking
+static uint8 simpleBLEPresenceOn = FALSE;
+
+// Device table, open addressed with linear probing
+static simpleBLEPresenceDev_t simpleBLEPresenceTable[SBO_PRESENCE_TABLE_SIZE];
+
+// Number of devices in the table
+static uint16 simpleBLEPresenceNumDevs = 0;
+
+// Number of devices not tracked because the table was full
+static uint16 simpleBLEPresenceOverflows = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static uint8 simpleBLEPresenceHash( uint8 *pAddr );
+static void simpleBLEPresenceRemove( uint8 idx );
+static uint8 simpleBLEPresenceReport( uint8 type, simpleBLEPresenceDev_t *pDev );
+static uint8 simpleBLEPresenceSendStatus( void );
+static uint8 simpleBLEPresenceSendFrame( uint8 type, uint8 *pData, uint8 len );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceInit
+ *
+ * @brief   Initialize presence tracking and open the NPI transport.
+ *
+ * @param   task_id - task that receives SBO_PRESENCE_AGE_EVT
+ *
+ * @return  none
+ */
+void simpleBLEPresenceInit( uint8 task_id )
+{
+  simpleBLEPresenceTaskId = task_id;
+
+  // Reports only go out, nothing is read back
+  NPI_InitTransport( NULL );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceEnable
+ *
+ * @brief   Turn presence tracking on or off. Turning it on starts
+ *          from an empty table. The caller keeps discovery running
+ *          while tracking is on.
+ *
+ * @param   enable - TRUE to track, FALSE to stop
+ *
+ * @return  none
+ */
+void simpleBLEPresenceEnable( uint8 enable )
+{
+  if ( enable )
+  {
+    osal_memset( simpleBLEPresenceTable, 0, sizeof( simpleBLEPresenceTable ) );
+    simpleBLEPresenceNumDevs = 0;
+    simpleBLEPresenceOverflows = 0;
+
+    // Every advertisement counts towards presence, so the controller
+    // must not filter repeats
+    GAP_SetParamValue( TGAP_FILTER_ADV_REPORTS, FALSE );
+
+    osal_start_timerEx( simpleBLEPresenceTaskId, SBO_PRESENCE_AGE_EVT, SBO_PRESENCE_AGE_PERIOD );
+  }
+  else
+  {
+    GAP_SetParamValue( TGAP_FILTER_ADV_REPORTS, TRUE );
+
+    VOID osal_stop_timerEx( simpleBLEPresenceTaskId, SBO_PRESENCE_AGE_EVT );
+  }
+
+  simpleBLEPresenceOn = enable;
+
+  VOID simpleBLEPresenceSendStatus();
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceEnabled
+ *
+ * @brief   Check whether presence tracking is on.
+ *
+ * @return  TRUE if tracking
+ */
+uint8 simpleBLEPresenceEnabled( void )
+{
+  return ( simpleBLEPresenceOn );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceUpdate
+ *
+ * @brief   Record an advertisement. A device seen for the first time
+ *          is reported as new, and a known device is reported again
+ *          when its RSSI has moved by SBO_PRESENCE_RSSI_HYST or more
+ *          since the last report. A report the UART cannot take is
+ *          retried on the device's next advertisement.
+ *
+ * @param   addrType - address type
+ * @param   pAddr - device address
+ * @param   rssi - RSSI of the advertisement
+ *
+ * @return  none
+ */
+void simpleBLEPresenceUpdate( uint8 addrType, uint8 *pAddr, int8 rssi )
+{
+  simpleBLEPresenceDev_t *pDev;
+  uint8 idx;
+  uint16 probes;
+
+  if ( !simpleBLEPresenceOn )
+  {
+    return;
+  }
+
+  idx = simpleBLEPresenceHash( pAddr );
+
+  for ( probes = 0; probes < SBO_PRESENCE_TABLE_SIZE; probes++ )
+  {
+    pDev = &simpleBLEPresenceTable[idx];
+
+    if ( !( pDev->flags & SBO_DEV_IN_USE ) )
+    {
+      break;
+    }
+
+    if ( pDev->addrType == addrType && osal_memcmp( pDev->addr, pAddr, B_ADDR_LEN ) )
+    {
+      pDev->lastSeen = SBO_PRESENCE_NOW();
+      pDev->rssi = rssi;
+      if ( pDev->advCount < 0xFFFF )
+      {
+        pDev->advCount++;
+      }
+
+      if ( !( pDev->flags & SBO_DEV_REPORTED ) )
+      {
+        if ( simpleBLEPresenceReport( SBO_EVT_DEV_NEW, pDev ) )
+        {
+          pDev->flags |= SBO_DEV_REPORTED;
+        }
+      }
+      else if ( rssi - pDev->rptRssi >= SBO_PRESENCE_RSSI_HYST ||
+                pDev->rptRssi - rssi >= SBO_PRESENCE_RSSI_HYST )
+      {
+        VOID simpleBLEPresenceReport( SBO_EVT_DEV_RSSI, pDev );
+      }
+
+      return;
+    }
+
+    idx = ( idx + 1 ) & ( SBO_PRESENCE_TABLE_SIZE - 1 );
+  }
+
+  if ( simpleBLEPresenceNumDevs >= SBO_PRESENCE_MAX_DEVS )
+  {
+    simpleBLEPresenceOverflows++;
+    return;
+  }
+
+  // New device, idx is the first free slot of its probe sequence
+  osal_memcpy( pDev->addr, pAddr, B_ADDR_LEN );
+  pDev->addrType = addrType;
+  pDev->flags = SBO_DEV_IN_USE;
+  pDev->rssi = rssi;
+  pDev->advCount = 1;
+  pDev->lastSeen = SBO_PRESENCE_NOW();
+  simpleBLEPresenceNumDevs++;
+
+  if ( simpleBLEPresenceReport( SBO_EVT_DEV_NEW, pDev ) )
+  {
+    pDev->flags |= SBO_DEV_REPORTED;
+  }
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceAge
+ *
+ * @brief   Handle SBO_PRESENCE_AGE_EVT. Remove devices that have not
+ *          advertised for SBO_PRESENCE_LOST_TIMEOUT ms and report them
+ *          as lost. A device whose lost report the UART cannot take
+ *          stays in the table until the next sweep.
+ *
+ * @return  none
+ */
+void simpleBLEPresenceAge( void )
+{
+  simpleBLEPresenceDev_t *pDev;
+  uint16 now = SBO_PRESENCE_NOW();
+  uint16 idx = 0;
+
+  if ( !simpleBLEPresenceOn )
+  {
+    return;
+  }
+
+  while ( idx < SBO_PRESENCE_TABLE_SIZE )
+  {
+    pDev = &simpleBLEPresenceTable[idx];
+
+    if ( ( pDev->flags & SBO_DEV_IN_USE ) &&
+         (uint16)( now - pDev->lastSeen ) > SBO_PRESENCE_LOST_TICKS &&
+         ( !( pDev->flags & SBO_DEV_REPORTED ) ||
+           simpleBLEPresenceReport( SBO_EVT_DEV_LOST, pDev ) ) )
+    {
+      // Another device may move into this slot, look at it again
+      simpleBLEPresenceRemove( (uint8)idx );
+    }
+    else
+    {
+      idx++;
+    }
+  }
+
+  osal_start_timerEx( simpleBLEPresenceTaskId, SBO_PRESENCE_AGE_EVT, SBO_PRESENCE_AGE_PERIOD );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceHash
+ *
+ * @brief   Home slot of an address.
+ *
+ * @param   pAddr - device address
+ *
+ * @return  table index
+ */
+static uint8 simpleBLEPresenceHash( uint8 *pAddr )
+{
+  uint8 hash = 0;
+  uint8 i;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    hash = (uint8)( ( hash << 1 ) | ( hash >> 7 ) ) ^ pAddr[i];
+  }
+
+  return ( hash & ( SBO_PRESENCE_TABLE_SIZE - 1 ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceRemove
+ *
+ * @brief   Remove a device from the table. Later devices of the same
+ *          probe run are shifted back into the hole so lookups never
+ *          need tombstones.
+ *
+ * @param   idx - slot to empty
+ *
+ * @return  none
+ */
+static void simpleBLEPresenceRemove( uint8 idx )
+{
+  uint8 next = idx;
+  uint8 home;
+
+  for ( ;; )
+  {
+    next = ( next + 1 ) & ( SBO_PRESENCE_TABLE_SIZE - 1 );
+
+    if ( !( simpleBLEPresenceTable[next].flags & SBO_DEV_IN_USE ) )
+    {
+      break;
+    }
+
+    home = simpleBLEPresenceHash( simpleBLEPresenceTable[next].addr );
+
+    // Move the device unless its home lies cyclically in (idx, next]
+    if ( ( next > idx && ( home <= idx || home > next ) ) ||
+         ( next < idx && ( home <= idx && home > next ) ) )
+    {
+      simpleBLEPresenceTable[idx] = simpleBLEPresenceTable[next];
+      idx = next;
+    }
+  }
+
+  simpleBLEPresenceTable[idx].flags = 0;
+  simpleBLEPresenceNumDevs--;
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceReport
+ *
+ * @brief   Send a presence delta for a device.
+ *
+ * @param   type - SBO_EVT_DEV_NEW, SBO_EVT_DEV_LOST or SBO_EVT_DEV_RSSI
+ * @param   pDev - device
+ *
+ * @return  TRUE if the UART took the report
+ */
+static uint8 simpleBLEPresenceReport( uint8 type, simpleBLEPresenceDev_t *pDev )
+{
+  uint8 buf[SBO_PRESENCE_MAX_PAYLOAD];
+  uint8 len = 1 + B_ADDR_LEN;
+  uint8 i;
+
+  buf[0] = pDev->addrType;
+
+  for ( i = 0; i < B_ADDR_LEN; i++ )
+  {
+    buf[1 + i] = pDev->addr[B_ADDR_LEN - 1 - i];
+  }
+
+  if ( type == SBO_EVT_DEV_LOST )
+  {
+    buf[len++] = LO_UINT16( pDev->advCount );
+    buf[len++] = HI_UINT16( pDev->advCount );
+  }
+  else
+  {
+    buf[len++] = (uint8)pDev->rssi;
+  }
+
+  if ( !simpleBLEPresenceSendFrame( type, buf, len ) )
+  {
+    return ( FALSE );
+  }
+
+  pDev->rptRssi = pDev->rssi;
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceSendStatus
+ *
+ * @brief   Send SBO_EVT_PRESENCE, which tells the host to start its
+ *          view of the table over.
+ *
+ * @return  TRUE if the UART took the report
+ */
+static uint8 simpleBLEPresenceSendStatus( void )
+{
+  uint8 buf[5];
+
+  buf[0] = simpleBLEPresenceOn;
+  buf[1] = LO_UINT16( simpleBLEPresenceNumDevs );
+  buf[2] = HI_UINT16( simpleBLEPresenceNumDevs );
+  buf[3] = LO_UINT16( simpleBLEPresenceOverflows );
+  buf[4] = HI_UINT16( simpleBLEPresenceOverflows );
+
+  return ( simpleBLEPresenceSendFrame( SBO_EVT_PRESENCE, buf, sizeof( buf ) ) );
+}
+
+/*********************************************************************
+ * @fn      simpleBLEPresenceSendFrame
+ *
+ * @brief   Encode a frame and hand it to the UART. HalUARTWrite takes
+ *          a block whole or not at all, so a frame is never split.
+ *
+ * @param   type - frame type
+ * @param   pData - frame payload
+ * @param   len - payload length, at most SBO_PRESENCE_MAX_PAYLOAD
+ *
+ * @return  TRUE if the UART took the frame
+ */
+static uint8 simpleBLEPresenceSendFrame( uint8 type, uint8 *pData, uint8 len )
+{
+  uint8 buf[SBO_PRESENCE_MAX_ENCODED];
+  uint8 frameLen = 0;
+  uint8 fcs = type + len;
+  uint8 value;
+  uint8 i;
+
+  buf[frameLen++] = SBO_FRAME_SOF;
+
+  // TYPE, LEN, PAYLOAD and FCS, escaped
+  for ( i = 0; i < len + 3; i++ )
+  {
+    if ( i == 0 )
+    {
+      value = type;
+    }
+    else if ( i == 1 )
+    {
+      value = len;
+    }
+    else if ( i < len + 2 )
+    {
+      value = pData[i - 2];
+      fcs += value;
+    }
+    else
+    {
+      value = fcs;
+    }
+
+    if ( value == SBO_FRAME_SOF || value == SBO_FRAME_ESC || value == SBO_FRAME_EOF )
+    {
+      buf[frameLen++] = SBO_FRAME_ESC;
+      value = ( value == SBO_FRAME_SOF ) ? SBO_FRAME_ESC_SOF :
+              ( value == SBO_FRAME_ESC ) ? SBO_FRAME_ESC_ESC : SBO_FRAME_ESC_EOF;
+    }
+
+    buf[frameLen++] = value;
+  }
+
+  return ( NPI_WriteTransport( buf, frameLen ) == frameLen );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -65,6 +65,12 @@
  * CONSTANTS
  */
 
+#define NPI_LOG_RING_MASK              (NPI_LOG_RING_SIZE - 1)
+
+#if ( NPI_LOG_RING_SIZE > 256 ) || ( NPI_LOG_RING_SIZE & NPI_LOG_RING_MASK )
+  #error "NPI_LOG_RING_SIZE must be a power of two of at most 256"
+#endif
+
 /*******************************************************************************
  * TYPEDEFS
  */
@@ -73,6 +79,42 @@
  * LOCAL VARIABLES
  */
 
+// Client transport callback
+static npiCBack_t npiCB = NULL;
+
+// Queued writes, oldest first, and the bytes in them not yet sent
+static npiTxReq_t *npiTxHead = NULL;
+static npiTxReq_t *npiTxTail = NULL;
+static uint16 npiTxQueued = 0;
+
+// TRUE while the queue is being sent, so a completion callback that
+// queues the next write does not send from within the callback
+static uint8 npiTxServicing = FALSE;
+
+// Queued write water marks
+static uint16 npiTxHighMark = 0xFFFF;
+static uint16 npiTxLowMark = 0;
+static uint8 npiTxAboveHigh = FALSE;
+static npiTxFlowCBack_t npiTxFlowCB = NULL;
+
+// Transport statistics
+static npiStats_t npiStats;
+
+// Log ring. The head is only moved by the logger and the tail only by the
+// drain, each with a single byte write.
+static uint8 npiLogRing[NPI_LOG_RING_SIZE];
+static volatile uint8 npiLogHead = 0;
+static volatile uint8 npiLogTail = 0;
+
+// Records dropped since the last NPI_LOG_ID_DROPPED record
+static uint16 npiLogDropped = 0;
+
+// Drain callback
+static npiLogCBack_t npiLogCB = NULL;
+
+// TRUE if NPI drains the log itself, see NPI_LogInit
+static uint8 npiLogSelfDrain = FALSE;
+
 /*******************************************************************************
  * GLOBAL VARIABLES
  */
@@ -81,6 +123,13 @@
  * PROTOTYPES
  */
 
+static void  npiSerialCB( uint8 port, uint8 event );
+static uint16 npiWrite( uint8 *buf, uint16 len );
+static void  npiTxService( void );
+static void  npiTxCheckMarks( void );
+static uint8 npiLogFree( void );
+static void  npiLogPut( uint16 id, uint8 *pData, uint8 len );
+
 /*******************************************************************************
  * FUNCTIONS
  */
@@ -90,7 +139,12 @@
  *
  * @brief       This routine initializes the transport layer and opens the port
  *              of the device. Note that based on project defines, either the
- *              UART, USB (CDC), or SPI driver can be used.
+ *              UART, USB (CDC), or SPI driver can be used. With HAL_UART_DMA
+ *              the UART runs on DMA (see NPI_UART_DMA), with the buffer
+ *              sizes the HAL DMA driver was built with. With HAL_UART_SPI
+ *              the port is the SPI slave (see NPI_SPI), and every read and
+ *              write goes through the HAL's frames. The callback gets the
+ *              HAL_UART_* events.
  *
  * input parameters
  *
@@ -115,7 +169,9 @@ void NPI_InitTransport( npiCBack_t npiCBack )
   uartConfig.tx.maxBufSize        = NPI_UART_TX_BUF_SIZE;
   uartConfig.idleTimeout          = NPI_UART_IDLE_TIMEOUT;
   uartConfig.intEnable            = NPI_UART_INT_ENABLE;
-  uartConfig.callBackFunc         = (halUARTCBack_t)npiCBack;
+  uartConfig.callBackFunc         = npiSerialCB;
+
+  npiCB = npiCBack;
 
   // start UART
   // Note: Assumes no issue opening UART port.
@@ -144,7 +200,11 @@ void NPI_InitTransport( npiCBack_t npiCBack )
  */
 uint16 NPI_ReadTransport( uint8 *buf, uint16 len )
 {
-  return( HalUARTRead( NPI_UART_PORT, buf, len ) );
+  uint16 numBytes = HalUARTRead( NPI_UART_PORT, buf, len );
+
+  npiStats.rxBytes += numBytes;
+
+  return( numBytes );
 }
 
 
@@ -152,6 +212,13 @@ uint16 NPI_ReadTransport( uint8 *buf, uint16 len )
  * @fn          NPI_WriteTransport
  *
  * @brief       This routine writes data from the buffer to the transport layer.
+ *              The data is handed to the HAL in blocks of at most
+ *              NPI_UART_TX_MAX_BLOCK, halved as needed to fit the room the
+ *              HAL has, so a write larger than the transmit buffer is
+ *              chained over as many blocks as there is room for.
+ *              If not everything is taken, the rest may be retried once
+ *              the callback gets HAL_UART_TX_EMPTY. Nothing is taken while
+ *              queued writes are pending, so the two keep their order.
  *
  * input parameters
  *
@@ -166,7 +233,12 @@ uint16 NPI_ReadTransport( uint8 *buf, uint16 len )
  */
 uint16 NPI_WriteTransport( uint8 *buf, uint16 len )
 {
-  return( HalUARTWrite( NPI_UART_PORT, buf, len ) );
+  if ( npiTxHead != NULL )
+  {
+    return( 0 );
+  }
+
+  return( npiWrite( buf, len ) );
 }
 
 
@@ -233,6 +305,743 @@ uint16 NPI_GetMaxTxBufSize( void )
 }
 
 
+/*******************************************************************************
+ * @fn          NPI_QueueWrite
+ *
+ * @brief       This routine queues a write by reference. The buffer is sent
+ *              as the transport takes it, after every write queued before
+ *              it, and the request's completion callback is called once the
+ *              last byte has been handed to the HAL. The request and its
+ *              buffer belong to NPI until then.
+ *
+ * input parameters
+ *
+ * @param       pReq - Request with pBuf, len and pfnDone set. pfnDone may be
+ *                     NULL.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      SUCCESS, or INVALIDPARAMETER if there is nothing to send.
+ */
+uint8 NPI_QueueWrite( npiTxReq_t *pReq )
+{
+  if ( pReq == NULL || pReq->pBuf == NULL || pReq->len == 0 )
+  {
+    return( INVALIDPARAMETER );
+  }
+
+  pReq->pNext = NULL;
+  pReq->sent = 0;
+
+  if ( npiTxTail == NULL )
+  {
+    npiTxHead = pReq;
+  }
+  else
+  {
+    npiTxTail->pNext = pReq;
+  }
+  npiTxTail = pReq;
+  npiTxQueued += pReq->len;
+
+  npiTxService();
+
+  return( SUCCESS );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_TxQueued
+ *
+ * @brief       This routine returns the number of queued bytes not yet
+ *              handed to the HAL.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Returns the number of bytes waiting in queued writes.
+ */
+uint16 NPI_TxQueued( void )
+{
+  return( npiTxQueued );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_SetTxWatermarks
+ *
+ * @brief       This routine sets the queued write water marks. The callback
+ *              is called with TRUE when the queued bytes reach the high
+ *              mark, and with FALSE when they are back down to the low mark,
+ *              so producers can hold back in between.
+ *
+ * input parameters
+ *
+ * @param       high    - High water mark in bytes.
+ * @param       low     - Low water mark in bytes, below the high mark.
+ * @param       pfnFlow - Water mark callback, NULL for none.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_SetTxWatermarks( uint16 high, uint16 low, npiTxFlowCBack_t pfnFlow )
+{
+  npiTxHighMark = high;
+  npiTxLowMark = low;
+  npiTxFlowCB = pfnFlow;
+  npiTxAboveHigh = FALSE;
+
+  npiTxCheckMarks();
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_GetStats
+ *
+ * @brief       This routine copies out the transport statistics.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       pStats - Statistics.
+ *
+ * @return      None.
+ */
+void NPI_GetStats( npiStats_t *pStats )
+{
+  VOID osal_memcpy( pStats, &npiStats, sizeof( npiStats_t ) );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_ResetStats
+ *
+ * @brief       This routine clears the transport statistics.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_ResetStats( void )
+{
+  VOID osal_memset( &npiStats, 0, sizeof( npiStats_t ) );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_StatsStamp
+ *
+ * @brief       This routine reads the sleep timer, which runs at 32.768 kHz,
+ *              as the start of a latency sample. A client takes it when the
+ *              first byte of a message is parsed.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Sleep timer count, 24 bits.
+ */
+uint32 NPI_StatsStamp( void )
+{
+  halIntState_t intState;
+  uint32 ticks;
+
+  // Reading ST0 latches ST1 and ST2, and interrupt handlers read ST0 too
+  HAL_ENTER_CRITICAL_SECTION( intState );
+  ticks = ST0;
+  ticks |= (uint32)ST1 << 8;
+  ticks |= (uint32)ST2 << 16;
+  HAL_EXIT_CRITICAL_SECTION( intState );
+
+  return( ticks );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_StatsLatency
+ *
+ * @brief       This routine ends a latency sample, taken when the message is
+ *              dispatched, and counts it in its log2 bin.
+ *
+ * input parameters
+ *
+ * @param       stamp - Start of the sample, from NPI_StatsStamp.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_StatsLatency( uint32 stamp )
+{
+  uint32 elapsed = ( NPI_StatsStamp() - stamp ) & NPI_STATS_TICK_MASK;
+  uint8 bin = 0;
+
+  while ( elapsed != 0 && bin < NPI_STATS_LAT_BINS - 1 )
+  {
+    elapsed >>= 1;
+    bin++;
+  }
+
+  if ( npiStats.rxLatency[bin] != 0xFFFF )
+  {
+    npiStats.rxLatency[bin]++;
+  }
+}
+
+
+/*******************************************************************************
+ * @fn          npiSerialCB
+ *
+ * @brief       This routine is the HAL UART callback. It counts the
+ *              receive events, sends more of the queued writes and of a
+ *              self-drained log once the transmit buffer has drained, and
+ *              passes the events on to the client.
+ *
+ * input parameters
+ *
+ * @param       port  - UART port.
+ * @param       event - HAL_UART_* events.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+static void npiSerialCB( uint8 port, uint8 event )
+{
+  if ( event & (HAL_UART_RX_TIMEOUT | HAL_UART_RX_ABOUT_FULL | HAL_UART_RX_FULL) )
+  {
+    uint16 fill = Hal_UART_RxBufLen( port );
+
+    if ( fill > npiStats.rxMaxFill )
+    {
+      npiStats.rxMaxFill = fill;
+    }
+
+    if ( event & HAL_UART_RX_FULL )
+    {
+      npiStats.rxFullEvts++;
+    }
+
+    if ( event & HAL_UART_RX_TIMEOUT )
+    {
+      npiStats.rxTimeouts++;
+    }
+  }
+
+  if ( event & HAL_UART_TX_EMPTY )
+  {
+    npiTxService();
+
+    // With no drain callback the log owns the port, keep it going
+    if ( npiLogSelfDrain && npiLogTail != npiLogHead )
+    {
+      NPI_LogFlush();
+    }
+  }
+
+  if ( npiCB != NULL )
+  {
+    npiCB( port, event );
+  }
+}
+
+
+/*******************************************************************************
+ * @fn          npiWrite
+ *
+ * @brief       This routine hands data to the HAL in blocks of at most
+ *              NPI_UART_TX_MAX_BLOCK, as many as there is room for, and
+ *              counts a write of which not everything is taken.
+ *              The HAL takes a block whole or not at all and does not say
+ *              how much room it has, so a block it refuses is halved until
+ *              it fits or nothing more does.
+ *
+ * input parameters
+ *
+ * @param       buf - Pointer to buffer to write data from.
+ * @param       len - Number of bytes to write.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Returns the number of bytes written to transport.
+ */
+static uint16 npiWrite( uint8 *buf, uint16 len )
+{
+  uint16 total = 0;
+  uint16 block = NPI_UART_TX_MAX_BLOCK;
+  uint16 written;
+
+  while ( total < len && block > 0 )
+  {
+    if ( block > len - total )
+    {
+      block = len - total;
+    }
+
+    written = HalUARTWrite( NPI_UART_PORT, &buf[total], block );
+    if ( written == 0 )
+    {
+      block >>= 1;
+    }
+    else
+    {
+      total += written;
+    }
+  }
+
+  npiStats.txBytes += total;
+
+  if ( total < len )
+  {
+    npiStats.txShortWrites++;
+  }
+
+  return( total );
+}
+
+
+/*******************************************************************************
+ * @fn          npiTxService
+ *
+ * @brief       This routine sends queued writes, in order, until the
+ *              transport stops taking data, and completes each one that
+ *              is sent in full. A completion callback may queue the next
+ *              write; it is picked up by the same loop.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+static void npiTxService( void )
+{
+  npiTxReq_t *pReq;
+  uint16 written;
+
+  if ( npiTxServicing )
+  {
+    return;
+  }
+  npiTxServicing = TRUE;
+
+  while ( (pReq = npiTxHead) != NULL )
+  {
+    written = npiWrite( &pReq->pBuf[pReq->sent], pReq->len - pReq->sent );
+    pReq->sent += written;
+    npiTxQueued -= written;
+
+    if ( pReq->sent < pReq->len )
+    {
+      // The rest goes once the HAL reports room
+      break;
+    }
+
+    npiTxHead = pReq->pNext;
+    if ( npiTxHead == NULL )
+    {
+      npiTxTail = NULL;
+    }
+
+    if ( pReq->pfnDone != NULL )
+    {
+      pReq->pfnDone( pReq );
+    }
+  }
+
+  npiTxServicing = FALSE;
+
+  npiTxCheckMarks();
+}
+
+
+/*******************************************************************************
+ * @fn          npiTxCheckMarks
+ *
+ * @brief       This routine calls the water mark callback when the queued
+ *              bytes cross a water mark.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+static void npiTxCheckMarks( void )
+{
+  if ( npiTxFlowCB == NULL )
+  {
+    return;
+  }
+
+  if ( !npiTxAboveHigh && npiTxQueued >= npiTxHighMark )
+  {
+    npiTxAboveHigh = TRUE;
+    npiTxFlowCB( TRUE );
+  }
+  else if ( npiTxAboveHigh && npiTxQueued <= npiTxLowMark )
+  {
+    npiTxAboveHigh = FALSE;
+    npiTxFlowCB( FALSE );
+  }
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogInit
+ *
+ * @brief       This routine empties the log ring and registers the callback
+ *              that gets it drained.
+ *
+ *              A client that frames the log with its own traffic passes a
+ *              callback and drains the ring with NPI_LogRead from its own
+ *              task, since NPI has no task and OSAL has no idle hook. With
+ *              no callback the port carries nothing but the log and NPI
+ *              drains the ring itself: the record that goes into an empty
+ *              ring is written at once and the rest follows each time the
+ *              UART transmit buffer empties.
+ *
+ * input parameters
+ *
+ * @param       npiLogCBack - Called when a record goes into an empty ring,
+ *                            or NULL for NPI to drain the ring itself.
+ *                            The transport must be open for the latter.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_LogInit( npiLogCBack_t npiLogCBack )
+{
+  npiLogHead = 0;
+  npiLogTail = 0;
+  npiLogDropped = 0;
+  npiLogCB = npiLogCBack;
+  npiLogSelfDrain = ( npiLogCBack == NULL );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogRecord
+ *
+ * @brief       This routine puts a record with up to two 16-bit arguments
+ *              into the log ring. Nothing is formatted or written to the
+ *              transport here. A record that does not fit is dropped and
+ *              counted, and the count is logged once there is room again.
+ *
+ *              Records may only be logged from one context, the OSAL task
+ *              context, and drained from one context. The ring needs no
+ *              critical section then, since each index has a single writer.
+ *
+ * input parameters
+ *
+ * @param       id      - Format ID.
+ * @param       numArgs - Number of arguments, 0 to 2.
+ * @param       arg0    - First argument.
+ * @param       arg1    - Second argument.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_LogRecord( uint16 id, uint8 numArgs, uint16 arg0, uint16 arg1 )
+{
+  uint8 args[4];
+
+  args[0] = LO_UINT16( arg0 );
+  args[1] = HI_UINT16( arg0 );
+  args[2] = LO_UINT16( arg1 );
+  args[3] = HI_UINT16( arg1 );
+
+  NPI_LogData( id, args, ( numArgs > 2 ) ? 4 : numArgs * 2 );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogData
+ *
+ * @brief       This routine puts a record with raw argument bytes into the
+ *              log ring. See NPI_LogRecord.
+ *
+ * input parameters
+ *
+ * @param       id    - Format ID.
+ * @param       pData - Argument bytes.
+ * @param       len   - Number of argument bytes, cut to NPI_LOG_MAX_DATA_LEN.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_LogData( uint16 id, uint8 *pData, uint8 len )
+{
+  uint8 wasEmpty = ( npiLogHead == npiLogTail );
+
+  if ( len > NPI_LOG_MAX_DATA_LEN )
+  {
+    len = NPI_LOG_MAX_DATA_LEN;
+  }
+
+  // Report earlier drops first, so the host sees them in order
+  if ( npiLogDropped != 0 )
+  {
+    uint8 count[2];
+
+    if ( npiLogFree() < 2 * NPI_LOG_HDR_LEN + sizeof( count ) + len )
+    {
+      npiLogDropped++;
+      npiStats.logDropped++;
+      return;
+    }
+
+    count[0] = LO_UINT16( npiLogDropped );
+    count[1] = HI_UINT16( npiLogDropped );
+    npiLogPut( NPI_LOG_ID_DROPPED, count, sizeof( count ) );
+    npiLogDropped = 0;
+  }
+
+  if ( npiLogFree() < NPI_LOG_HDR_LEN + len )
+  {
+    npiLogDropped++;
+    npiStats.logDropped++;
+    return;
+  }
+
+  npiLogPut( id, pData, len );
+
+  if ( wasEmpty )
+  {
+    if ( npiLogCB != NULL )
+    {
+      npiLogCB();
+    }
+    else if ( npiLogSelfDrain )
+    {
+      NPI_LogFlush();
+    }
+  }
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogPending
+ *
+ * @brief       This routine returns the number of bytes in the log ring.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Returns the number of bytes waiting to be drained.
+ */
+uint8 NPI_LogPending( void )
+{
+  return( (uint8)( ( npiLogHead - npiLogTail ) & NPI_LOG_RING_MASK ) );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogRead
+ *
+ * @brief       This routine takes whole records out of the log ring, for a
+ *              client that wraps them in its own framing.
+ *
+ * input parameters
+ *
+ * @param       buf    - Pointer to buffer to place the records.
+ * @param       maxLen - Size of the buffer.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Returns the number of bytes placed in the buffer, 0 if no
+ *              whole record fits.
+ */
+uint8 NPI_LogRead( uint8 *buf, uint8 maxLen )
+{
+  uint8 len = 0;
+  uint8 recLen;
+
+  while ( npiLogTail != npiLogHead )
+  {
+    // The length follows the SOF
+    recLen = 2 + npiLogRing[(npiLogTail + 1) & NPI_LOG_RING_MASK];
+
+    if ( recLen > maxLen - len )
+    {
+      break;
+    }
+
+    while ( recLen-- > 0 )
+    {
+      buf[len++] = npiLogRing[npiLogTail];
+      npiLogTail = (npiLogTail + 1) & NPI_LOG_RING_MASK;
+    }
+  }
+
+  return( len );
+}
+
+
+/*******************************************************************************
+ * @fn          NPI_LogFlush
+ *
+ * @brief       This routine writes the log ring to the transport as is, for
+ *              a port that carries nothing but the log. The UART takes a
+ *              block whole or not at all, so a refused block is retried in
+ *              smaller pieces. What the transport does not take now stays in
+ *              the ring for the next call, which NPI makes itself once the
+ *              transmit buffer empties if no drain callback is registered.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+void NPI_LogFlush( void )
+{
+  uint16 len;
+  uint16 written;
+
+  while ( npiLogTail != npiLogHead )
+  {
+    // Largest contiguous block
+    len = ( npiLogHead > npiLogTail ) ? npiLogHead - npiLogTail
+                                      : NPI_LOG_RING_SIZE - npiLogTail;
+
+    while ( (written = NPI_WriteTransport( &npiLogRing[npiLogTail], len )) == 0 &&
+            len > NPI_LOG_HDR_LEN )
+    {
+      len >>= 1;
+    }
+
+    if ( written == 0 )
+    {
+      break;
+    }
+
+    npiLogTail = (npiLogTail + written) & NPI_LOG_RING_MASK;
+  }
+}
+
+
+/*******************************************************************************
+ * @fn          npiLogFree
+ *
+ * @brief       This routine returns the room left in the log ring. One byte
+ *              is kept free to tell a full ring from an empty one.
+ *
+ * input parameters
+ *
+ * @param       None.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      Returns the number of bytes that can be added.
+ */
+static uint8 npiLogFree( void )
+{
+  return( (uint8)( NPI_LOG_RING_SIZE - 1 - NPI_LogPending() ) );
+}
+
+
+/*******************************************************************************
+ * @fn          npiLogPut
+ *
+ * @brief       This routine copies a record into the log ring, then makes it
+ *              visible to the drain by moving the head. The caller checks
+ *              that it fits.
+ *
+ * input parameters
+ *
+ * @param       id    - Format ID.
+ * @param       pData - Argument bytes.
+ * @param       len   - Number of argument bytes.
+ *
+ * output parameters
+ *
+ * @param       None.
+ *
+ * @return      None.
+ */
+static void npiLogPut( uint16 id, uint8 *pData, uint8 len )
+{
+  uint8 head = npiLogHead;
+
+  npiLogRing[head] = NPI_LOG_SOF;
+  head = (head + 1) & NPI_LOG_RING_MASK;
+  npiLogRing[head] = 2 + len;
+  head = (head + 1) & NPI_LOG_RING_MASK;
+  npiLogRing[head] = LO_UINT16( id );
+  head = (head + 1) & NPI_LOG_RING_MASK;
+  npiLogRing[head] = HI_UINT16( id );
+  head = (head + 1) & NPI_LOG_RING_MASK;
+
+  while ( len-- > 0 )
+  {
+    npiLogRing[head] = *pData++;
+    head = (head + 1) & NPI_LOG_RING_MASK;
+  }
+
+  npiLogHead = head;
+}
+
+
 /*******************************************************************************
  ******************************************************************************/
 //******************************************************************************  
@@ -256,14 +1065,11 @@ void NPI_PrintString(uint8 *str)
 //******************************************************************************  
 void NPI_PrintValue(char *title, uint16 value, uint8 format)  
 {  
-  uint8 tmpLen;  
-  uint8 buf[128];  
-  uint32 err;  
+  // Room for a 16-bit value in base 2 and the terminator, the title  
+  // goes out on its own  
+  uint8 buf[17];  
   
-  tmpLen = (uint8)osal_strlen( (char*)title );  
-  osal_memcpy( buf, title, tmpLen );  
-  //buf[tmpLen] = ' ';  
-  err = (uint32)(value);  
-  _ltoa( err, &buf[tmpLen], format );  
-  NPI_PrintString(buf);       
+  NPI_PrintString( (uint8 *)title );  
+  _ltoa( (uint32)value, buf, format );  
+  NPI_PrintString( buf );  
 }  
\ No newline at end of file
@@ -69,6 +69,23 @@ extern "C"
  * MACROS
  */
 
+/*
+ * Deferred binary log. A call site emits a record of a format ID and raw
+ * arguments instead of text; the text is put back together on the host
+ * from the ID. Set NPI_LOG to FALSE to compile every record out.
+ */
+#if ( !defined( NPI_LOG ) || ( NPI_LOG == TRUE ) )
+#define NPI_LOG0( id )                 NPI_LogRecord( (id), 0, 0, 0 )
+#define NPI_LOG1( id, a )              NPI_LogRecord( (id), 1, (a), 0 )
+#define NPI_LOG2( id, a, b )           NPI_LogRecord( (id), 2, (a), (b) )
+#define NPI_LOG_DATA( id, p, len )     NPI_LogData( (id), (p), (len) )
+#else
+#define NPI_LOG0( id )
+#define NPI_LOG1( id, a )
+#define NPI_LOG2( id, a, b )
+#define NPI_LOG_DATA( id, p, len )
+#endif
+
 /*******************************************************************************
  * CONSTANTS
  */
@@ -93,26 +110,165 @@ extern "C"
 #endif // Endif for HAL_UART_SPI/DMA 
 #endif //Endif for NPI_UART_PORT
 
+/* DMA transport: the HAL DMA UART driver receives into a circular DMA
+ * buffer and transmits from two buffers in turn, one filled while the
+ * other is sent. Selected with HAL_UART_DMA on a UART port. */
+#if ((defined HAL_UART_DMA) && (HAL_UART_DMA != 0) && \
+     !((defined HAL_UART_SPI) && (HAL_UART_SPI != 0)))
+#define NPI_UART_DMA                   TRUE
+#else
+#define NPI_UART_DMA                   FALSE
+#endif
+
+/* SPI transport: the HAL SPI slave driver, selected with HAL_UART_SPI,
+ * sends each block NPI hands it as one frame and takes the host's frames
+ * the same way:
+ *
+ *   SOF (0xFE) | LEN | DATA[LEN] | FCS
+ *
+ * FCS is the XOR of LEN and DATA. The host clocks every transfer: it
+ * asserts MRDY and waits for SRDY before it writes, and the slave asserts
+ * SRDY on its own when it has a frame for the host to read.
+ * npi_spi_host.py, next to this file, is a Linux spidev host driver. */
+#if ((defined HAL_UART_SPI) && (HAL_UART_SPI != 0))
+#define NPI_SPI                        TRUE
+#else
+#define NPI_SPI                        FALSE
+#endif
+
+#define NPI_SPI_SOF                    0xFE
+#define NPI_SPI_MAX_DATA_LEN           255
+
+/* Flow control is on by default with DMA, which is meant to be run at
+ * sustained high rates; the RTS/CTS lines must be wired. */
 #if !defined( NPI_UART_FC )
+#if ( NPI_UART_DMA == TRUE )
+#define NPI_UART_FC                    TRUE
+#else
 #define NPI_UART_FC                    FALSE
+#endif
 #endif // !NPI_UART_FC
 
+#if !defined( NPI_UART_FC_THRESHOLD )
 #define NPI_UART_FC_THRESHOLD          48
+#endif // !NPI_UART_FC_THRESHOLD
+
+/* DMA buffer sizes. The HAL DMA driver allocates its receive buffer and
+ * each of its two transmit buffers from these at build time, so they are
+ * set for the whole project and NPI configures the port to match. */
+#if ( NPI_UART_DMA == TRUE )
+#if !defined( HAL_UART_DMA_RX_MAX )
+#define HAL_UART_DMA_RX_MAX            128
+#endif // !HAL_UART_DMA_RX_MAX
+
+#if !defined( HAL_UART_DMA_TX_MAX )
+#define HAL_UART_DMA_TX_MAX            HAL_UART_DMA_RX_MAX
+#endif // !HAL_UART_DMA_TX_MAX
+
+#define NPI_UART_RX_BUF_SIZE           HAL_UART_DMA_RX_MAX
+#define NPI_UART_TX_BUF_SIZE           HAL_UART_DMA_TX_MAX
+#endif // NPI_UART_DMA
+
+#if !defined( NPI_UART_RX_BUF_SIZE )
 #define NPI_UART_RX_BUF_SIZE           128
+#endif // !NPI_UART_RX_BUF_SIZE
+
+#if !defined( NPI_UART_TX_BUF_SIZE )
 #define NPI_UART_TX_BUF_SIZE           128
+#endif // !NPI_UART_TX_BUF_SIZE
+
+/* Largest block first offered to the HAL, larger writes are split. The HAL
+ * drivers keep one byte of their ring free, so a block the size of the
+ * buffer would never be taken. A block that is refused is halved until it
+ * fits the room left, so a HAL buffer smaller than this costs retries but
+ * never stalls. */
+#if !defined( NPI_UART_TX_MAX_BLOCK )
+#define NPI_UART_TX_MAX_BLOCK          (NPI_UART_TX_BUF_SIZE - 1)
+#endif // !NPI_UART_TX_MAX_BLOCK
+
+#if ( NPI_SPI == TRUE ) && ( NPI_UART_TX_MAX_BLOCK > NPI_SPI_MAX_DATA_LEN )
+  #error "NPI_UART_TX_MAX_BLOCK does not fit in one SPI frame"
+#endif
+
 #define NPI_UART_IDLE_TIMEOUT          6
 #define NPI_UART_INT_ENABLE            TRUE
 
+/* DMA with flow control keeps up with the fastest rate the HAL offers,
+ * without DMA the interrupt driver is held to 115200 */
 #if !defined( NPI_UART_BR )
+#if ( NPI_UART_DMA == TRUE ) && defined( HAL_UART_BR_230400 )
+#define NPI_UART_BR                    HAL_UART_BR_230400
+#else
 #define NPI_UART_BR                    HAL_UART_BR_115200
+#endif
 #endif // !NPI_UART_BR
 
+/*
+ * Log record, as held in the log ring and as sent to the host:
+ *
+ *   SOF | LEN | ID[2] | ARGS[LEN - 2]
+ *
+ * ID and 16-bit arguments are least significant byte first. There is no
+ * escaping; a decoder resyncs on the next SOF whose LEN is in range.
+ * npi_log_decode.py, next to this file, prints the records as text.
+ */
+#define NPI_LOG_SOF                    0xA5
+#define NPI_LOG_HDR_LEN                4
+#define NPI_LOG_MAX_DATA_LEN           16
+
+// Size of the log ring, a power of two of at most 256
+#if !defined( NPI_LOG_RING_SIZE )
+#define NPI_LOG_RING_SIZE              128
+#endif // !NPI_LOG_RING_SIZE
+
+/* Receive latency histogram bins, see npiStats_t, and the sleep timer
+ * width the samples are taken with */
+#define NPI_STATS_LAT_BINS             12
+#define NPI_STATS_TICK_MASK            0x00FFFFFF
+
+// Record reporting how many records were dropped for lack of room, arg: count
+#define NPI_LOG_ID_DROPPED             0xFFFF
+
 /*******************************************************************************
  * TYPEDEFS
  */
 
 typedef void (*npiCBack_t) ( uint8 port, uint8 event );
 
+// Queued write. NPI owns it from NPI_QueueWrite until pfnDone is called.
+typedef struct npiTxReq
+{
+  struct npiTxReq *pNext;              // Next queued write, set by NPI
+  uint8  *pBuf;                        // Data to send, by reference
+  uint16 len;                          // Number of bytes to send
+  uint16 sent;                         // Bytes handed to the HAL so far, set by NPI
+  void   (*pfnDone)( struct npiTxReq *pReq ); // Called once every byte is sent
+} npiTxReq_t;
+
+// Called with TRUE at the high water mark and FALSE back at the low mark
+typedef void (*npiTxFlowCBack_t) ( uint8 full );
+
+// Transport statistics, cleared by NPI_ResetStats. rxLatency counts, per
+// log2 bin, the time from the first byte of a message being parsed to the
+// message being dispatched, as sampled by the client with NPI_StatsStamp
+// and NPI_StatsLatency, in 32.768 kHz sleep timer ticks: bin 0 is under
+// one tick, bin n is 2^(n-1) to 2^n - 1 ticks, and the last bin takes
+// everything from 1024 ticks (31 ms) up.
+typedef struct
+{
+  uint32 rxBytes;                      // Bytes read by the client
+  uint32 txBytes;                      // Bytes taken by the HAL
+  uint16 rxFullEvts;                   // HAL_UART_RX_FULL events, data may be lost
+  uint16 rxTimeouts;                   // HAL_UART_RX_TIMEOUT events
+  uint16 txShortWrites;                // Writes the HAL did not take in full
+  uint16 logDropped;                   // Log records dropped for lack of room
+  uint16 rxMaxFill;                    // Most bytes seen in the receive buffer
+  uint16 rxLatency[NPI_STATS_LAT_BINS];
+} npiStats_t;
+
+// Called when a record goes into an empty log ring, so it gets drained
+typedef void (*npiLogCBack_t) ( void );
+
 /*******************************************************************************
  * LOCAL VARIABLES
  */
@@ -136,10 +292,38 @@ extern uint16 NPI_RxBufLen( void );
 extern uint16 NPI_GetMaxRxBufSize( void );
 extern uint16 NPI_GetMaxTxBufSize( void );
 
+//
+// Queued Write APIs
+//
+
+extern uint8  NPI_QueueWrite( npiTxReq_t *pReq );
+extern uint16 NPI_TxQueued( void );
+extern void   NPI_SetTxWatermarks( uint16 high, uint16 low, npiTxFlowCBack_t pfnFlow );
+
+//
+// Statistics APIs
+//
+
+extern void NPI_GetStats( npiStats_t *pStats );
+extern void NPI_ResetStats( void );
+extern uint32 NPI_StatsStamp( void );
+extern void NPI_StatsLatency( uint32 stamp );
+
 extern void NPI_PrintString(uint8 *str);  
 
 extern void NPI_PrintValue(char *title, uint16 value, uint8 format);
 
+//
+// Deferred Binary Log APIs
+//
+
+extern void  NPI_LogInit( npiLogCBack_t npiLogCBack );
+extern void  NPI_LogRecord( uint16 id, uint8 numArgs, uint16 arg0, uint16 arg1 );
+extern void  NPI_LogData( uint16 id, uint8 *pData, uint8 len );
+extern uint8 NPI_LogPending( void );
+extern uint8 NPI_LogRead( uint8 *buf, uint8 maxLen );
+extern void  NPI_LogFlush( void );
+
 /*******************************************************************************
 */
 
@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Decode the NPI deferred binary log on the host.
+
+Records are laid out as described in npi.h:
+
+    SOF (0xA5) | LEN | ID[2] | ARGS[LEN - 2]
+
+ID and 16-bit arguments are least significant byte first. There is no
+escaping, so the decoder resyncs on the next SOF whose LEN is in range.
+
+The input is either the raw byte stream of a port that carries only the
+log, or, with --framed, the Simple BLE Central host interface stream, in
+which case the records are taken out of SBC_EVT_LOG frames.
+
+Format strings come from the headers that define the IDs. A define of the
+form
+
+    #define NAME   0x0400  //!< "Start scanning, mode %u, active %u". ...
+
+gives ID 0x0400 the quoted format. The headers of this tree are read by
+default; more may be given with -d.
+
+Usage:
+    npi_log_decode.py [-f] [-d HEADER]... [FILE]
+
+FILE is a capture or a serial device set up beforehand with stty, stdin
+if left out.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+NPI_LOG_SOF = 0xA5
+NPI_LOG_MAX_DATA_LEN = 16
+NPI_LOG_ID_DROPPED = 0xFFFF
+
+# Simple BLE Central host interface framing, see simpleBLECentral.h
+SBC_FRAME_SOF = 0xF0
+SBC_FRAME_ESC = 0xF5
+SBC_FRAME_EOF = 0xFA
+SBC_FRAME_UNESC = {0x01: SBC_FRAME_SOF, 0x02: SBC_FRAME_ESC, 0x03: SBC_FRAME_EOF}
+SBC_EVT_LOG = 0x4F
+
+TREE = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                     '..', '..', '..'))
+DEFAULT_HEADERS = [
+    os.path.join(TREE, 'Profiles', 'Roles', 'CC254x', 'central.h'),
+    os.path.join(TREE, 'SimpleBLECentral', 'Source', 'simpleBLECentral.h'),
+]
+
+DEFINE_RE = re.compile(r'#define\s+(\w+)\s+(0x[0-9A-Fa-f]+)\s*//!?<?\s*"([^"]*)"')
+CONV_RE = re.compile(r'%([-+ 0#]*\d*)([udxXc])')
+
+
+def load_formats(headers):
+    """Map format IDs to (name, format) from the given headers."""
+    formats = {NPI_LOG_ID_DROPPED: ('NPI_LOG_ID_DROPPED', 'Dropped %u records')}
+    for path in headers:
+        try:
+            with open(path, 'rb') as f:
+                text = f.read().decode('latin-1')
+        except OSError:
+            continue
+        for name, value, fmt in DEFINE_RE.findall(text):
+            formats[int(value, 16)] = (name, fmt)
+    return formats
+
+
+def format_record(formats, rec_id, args):
+    """Render one record as text."""
+    if rec_id not in formats:
+        return '[0x%04X] %s' % (rec_id, args.hex(' '))
+
+    name, fmt = formats[rec_id]
+    words = [args[i] | (args[i + 1] << 8) for i in range(0, len(args) - 1, 2)]
+    values = iter(words)
+
+    def conv(match):
+        flags, kind = match.groups()
+        value = next(values, None)
+        if value is None:
+            return '?'
+        if kind == 'd' and value & 0x8000:
+            value -= 0x10000
+        return ('%' + flags + kind) % value
+
+    text = CONV_RE.sub(conv, fmt.replace('%%', '\0')).replace('\0', '%')
+    if len(args) & 1 or len(words) > len(CONV_RE.findall(fmt)):
+        text += ' [%s]' % args.hex(' ')
+    return '%s: %s' % (name, text)
+
+
+class RecordDecoder:
+    """Pull records out of a raw log stream, resyncing on SOF."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.skipped = 0
+
+    def feed(self, data):
+        self.buf += data
+        records = []
+        while True:
+            start = self.buf.find(NPI_LOG_SOF)
+            if start < 0:
+                self.skipped += len(self.buf)
+                self.buf.clear()
+                break
+            self.skipped += start
+            del self.buf[:start]
+            if len(self.buf) < 2:
+                break
+            length = self.buf[1]
+            if length < 2 or length > 2 + NPI_LOG_MAX_DATA_LEN:
+                # Not a record, look for the next SOF
+                self.skipped += 1
+                del self.buf[:1]
+                continue
+            if len(self.buf) < 2 + length:
+                break
+            rec_id = self.buf[2] | (self.buf[3] << 8)
+            records.append((rec_id, bytes(self.buf[4:2 + length])))
+            del self.buf[:2 + length]
+        return records
+
+
+class FrameDecoder:
+    """Pull SBC_EVT_LOG payloads out of the central's framed stream."""
+
+    def __init__(self):
+        self.frame = None
+        self.esc = False
+        self.bad = 0
+
+    def feed(self, data):
+        payloads = []
+        for byte in data:
+            if byte == SBC_FRAME_SOF:
+                self.frame = bytearray()
+                self.esc = False
+                continue
+            if self.frame is None:
+                continue
+            if self.esc:
+                self.esc = False
+                if byte not in SBC_FRAME_UNESC:
+                    self.bad += 1
+                    self.frame = None
+                    continue
+                byte = SBC_FRAME_UNESC[byte]
+            elif byte == SBC_FRAME_ESC:
+                self.esc = True
+                continue
+            elif byte == SBC_FRAME_EOF:
+                self.frame = None
+                continue
+            self.frame.append(byte)
+            payload = self._complete()
+            if payload is not None:
+                payloads.append(payload)
+        return payloads
+
+    def _complete(self):
+        frame = self.frame
+        if len(frame) < 3 or len(frame) < frame[1] + 3:
+            return None
+        self.frame = None
+        if sum(frame[:-1]) & 0xFF != frame[-1]:
+            self.bad += 1
+            return None
+        if frame[0] != SBC_EVT_LOG:
+            return None
+        return bytes(frame[2:-1])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Decode the NPI binary log.')
+    parser.add_argument('-f', '--framed', action='store_true',
+                        help='input is the Simple BLE Central framed stream')
+    parser.add_argument('-d', '--defs', action='append', default=[],
+                        help='extra header with log format ID defines')
+    parser.add_argument('file', nargs='?', help='capture or serial device')
+    opts = parser.parse_args()
+
+    formats = load_formats(DEFAULT_HEADERS + opts.defs)
+    records = RecordDecoder()
+    frames = FrameDecoder() if opts.framed else None
+    src = open(opts.file, 'rb', buffering=0) if opts.file else sys.stdin.buffer
+
+    try:
+        while True:
+            data = src.read1(256) if hasattr(src, 'read1') else src.read(256)
+            if not data:
+                break
+            if frames is not None:
+                for payload in frames.feed(data):
+                    # Each frame holds whole records
+                    records.buf.clear()
+                    for rec in records.feed(payload):
+                        print(format_record(formats, *rec), flush=True)
+            else:
+                for rec in records.feed(data):
+                    print(format_record(formats, *rec), flush=True)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if src is not sys.stdin.buffer:
+            src.close()
+
+    if records.skipped or (frames is not None and frames.bad):
+        print('%d bytes skipped, %d bad frames'
+              % (records.skipped, frames.bad if frames is not None else 0),
+              file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""Host side of the NPI SPI transport, for Linux spidev.
+
+The network processor is the SPI slave, built with HAL_UART_SPI (see
+NPI_SPI in npi.h). Each message goes either way as one frame:
+
+    SOF (0xFE) | LEN | DATA[LEN] | FCS
+
+FCS is the XOR of LEN and DATA. The host clocks every transfer, and two
+GPIO lines hand it the bus:
+
+    MRDY  host output, active low. The host asserts it to start a
+          transfer and releases it when done.
+    SRDY  slave output, active low. The slave asserts it in answer to
+          MRDY once it is ready, and on its own when it has a frame for
+          the host, which then reads it.
+
+To write, the host asserts MRDY, waits for SRDY and clocks the frame out.
+To read, it asserts MRDY, clocks in SOF and LEN and then LEN + 1 more
+bytes. Bytes clocked in ahead of SOF are skipped, and a frame with a bad
+FCS is dropped.
+
+The bus goes through /dev/spidevB.C, the GPIO lines through sysfs; export
+them beforehand, MRDY as an output at 1.
+
+Usage:
+    npi_spi_host.py -D DEV --mrdy N --srdy N [-s HZ] send HEX...
+    npi_spi_host.py -D DEV --mrdy N --srdy N [-s HZ] listen
+    npi_spi_host.py -D DEV --mrdy N --srdy N [-s HZ] loopback [COUNT]
+    npi_spi_host.py --decode FILE
+
+send writes each HEX argument as a frame, listen prints the payload of
+every frame read, and loopback sends random frames to a device that
+echoes them and checks what comes back. --decode prints the payloads of
+the frames in a capture of the bytes clocked in, one hex line each.
+"""
+
+import argparse
+import array
+import fcntl
+import os
+import struct
+import sys
+import time
+
+NPI_SPI_SOF = 0xFE
+NPI_SPI_MAX_DATA_LEN = 255
+
+# linux/spi/spidev.h
+SPI_IOC_MAGIC = ord('k')
+
+
+def _iow(nr, size):
+    return (1 << 30) | (size << 16) | (SPI_IOC_MAGIC << 8) | nr
+
+
+SPI_IOC_WR_MODE = _iow(1, 1)
+SPI_IOC_WR_BITS_PER_WORD = _iow(3, 1)
+SPI_IOC_WR_MAX_SPEED_HZ = _iow(4, 4)
+SPI_IOC_TRANSFER_FMT = '=QQIIHBBBBBB'
+SPI_IOC_MESSAGE_1 = _iow(0, struct.calcsize(SPI_IOC_TRANSFER_FMT))
+
+
+def fcs(data):
+    """XOR of the bytes, the frame check sequence over LEN and DATA."""
+    value = 0
+    for byte in data:
+        value ^= byte
+    return value
+
+
+def encode_frame(payload):
+    """Frame a payload of at most NPI_SPI_MAX_DATA_LEN bytes."""
+    if not 0 < len(payload) <= NPI_SPI_MAX_DATA_LEN:
+        raise ValueError('payload of %d bytes does not fit a frame' % len(payload))
+    body = bytes([len(payload)]) + bytes(payload)
+    return bytes([NPI_SPI_SOF]) + body + bytes([fcs(body)])
+
+
+class FrameDecoder:
+    """Pull payloads out of the bytes clocked in from the slave."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.skipped = 0
+        self.bad = 0
+
+    def needed(self):
+        """Bytes still to be clocked in to finish the frame under way."""
+        if not self.buf:
+            return 0
+        if len(self.buf) < 2:
+            return 1
+        return self.buf[1] + 3 - len(self.buf)
+
+    def feed(self, data):
+        self.buf += data
+        payloads = []
+        while True:
+            start = self.buf.find(NPI_SPI_SOF)
+            if start < 0:
+                self.skipped += len(self.buf)
+                self.buf.clear()
+                break
+            self.skipped += start
+            del self.buf[:start]
+            if len(self.buf) < 2 or len(self.buf) < self.buf[1] + 3:
+                break
+            length = self.buf[1]
+            if length == 0 or fcs(self.buf[1:length + 3]) != 0:
+                # Not a frame, look for the next SOF
+                self.bad += 1
+                del self.buf[:1]
+                continue
+            payloads.append(bytes(self.buf[2:length + 2]))
+            del self.buf[:length + 3]
+        return payloads
+
+
+class SpiDev:
+    """Full duplex transfers on a spidev device."""
+
+    def __init__(self, path, speed, mode=0):
+        self.fd = os.open(path, os.O_RDWR)
+        self.speed = speed
+        fcntl.ioctl(self.fd, SPI_IOC_WR_MODE, struct.pack('=B', mode))
+        fcntl.ioctl(self.fd, SPI_IOC_WR_BITS_PER_WORD, struct.pack('=B', 8))
+        fcntl.ioctl(self.fd, SPI_IOC_WR_MAX_SPEED_HZ, struct.pack('=I', speed))
+
+    def transfer(self, data):
+        tx = array.array('B', data)
+        rx = array.array('B', bytes(len(data)))
+        xfer = struct.pack(SPI_IOC_TRANSFER_FMT,
+                           tx.buffer_info()[0], rx.buffer_info()[0],
+                           len(data), self.speed, 0, 8, 0, 0, 0, 0, 0)
+        fcntl.ioctl(self.fd, SPI_IOC_MESSAGE_1, xfer)
+        return rx.tobytes()
+
+    def close(self):
+        os.close(self.fd)
+
+
+class Gpio:
+    """A GPIO line exported through sysfs."""
+
+    def __init__(self, number):
+        self.path = '/sys/class/gpio/gpio%d/value' % number
+
+    def get(self):
+        with open(self.path, 'rb') as f:
+            return f.read(1) == b'1'
+
+    def set(self, level):
+        with open(self.path, 'wb') as f:
+            f.write(b'1' if level else b'0')
+
+
+class NpiSpiHost:
+    """NPI SPI master: the MRDY/SRDY handshake and the frames."""
+
+    def __init__(self, spi, mrdy, srdy, timeout=1.0):
+        self.spi = spi
+        self.mrdy = mrdy
+        self.srdy = srdy
+        self.timeout = timeout
+        self.decoder = FrameDecoder()
+        self.mrdy.set(1)
+
+    def _wait_srdy(self, level):
+        deadline = time.monotonic() + self.timeout
+        while self.srdy.get() != level:
+            if time.monotonic() > deadline:
+                raise TimeoutError('SRDY did not go %d' % level)
+
+    def _begin(self):
+        self.mrdy.set(0)
+        try:
+            self._wait_srdy(0)
+        except TimeoutError:
+            self.mrdy.set(1)
+            raise
+
+    def _end(self):
+        self.mrdy.set(1)
+
+    def write(self, payload):
+        """Send one frame, and keep anything clocked in for read."""
+        self._begin()
+        try:
+            rx = self.spi.transfer(encode_frame(payload))
+        finally:
+            self._end()
+        return self.decoder.feed(rx)
+
+    def pending(self):
+        """True while the slave asks to be read."""
+        return not self.srdy.get()
+
+    def read(self):
+        """Read the frame the slave has, return the payloads completed."""
+        self._begin()
+        try:
+            payloads = self.decoder.feed(self.spi.transfer(bytes(2)))
+            while self.decoder.needed():
+                payloads += self.decoder.feed(
+                    self.spi.transfer(bytes(self.decoder.needed())))
+        finally:
+            self._end()
+        return payloads
+
+    def poll(self, wait=0.0):
+        """Read frames while SRDY asks, waiting up to wait for the first."""
+        deadline = time.monotonic() + wait
+        while not self.pending():
+            if time.monotonic() >= deadline:
+                return []
+        payloads = []
+        while self.pending():
+            payloads += self.read()
+        return payloads
+
+
+def decode_file(path):
+    decoder = FrameDecoder()
+    with open(path, 'rb') as f:
+        for payload in decoder.feed(f.read()):
+            print(payload.hex())
+    return 0 if decoder.bad == 0 else 1
+
+
+def loopback(host, count):
+    failed = 0
+    for n in range(count):
+        sent = os.urandom(1 + n % 120)
+        received = bytearray()
+        for payload in host.write(sent):
+            received += payload
+        while len(received) < len(sent):
+            payloads = host.poll(host.timeout)
+            if not payloads:
+                break
+            for payload in payloads:
+                received += payload
+        if bytes(received) != sent:
+            failed += 1
+            print('frame %d: sent %s, got %s' % (n, sent.hex(), received.hex()))
+    print('%d frames, %d failed' % (count, failed))
+    return 0 if failed == 0 else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description='NPI SPI host driver.')
+    parser.add_argument('-D', '--device', help='spidev device, e.g. /dev/spidev0.0')
+    parser.add_argument('-s', '--speed', type=int, default=4000000, help='clock in Hz')
+    parser.add_argument('--mrdy', type=int, help='MRDY GPIO number')
+    parser.add_argument('--srdy', type=int, help='SRDY GPIO number')
+    parser.add_argument('--decode', metavar='FILE', help='decode a capture and exit')
+    parser.add_argument('command', nargs='?', choices=['send', 'listen', 'loopback'])
+    parser.add_argument('args', nargs='*')
+    opts = parser.parse_args()
+
+    if opts.decode:
+        return decode_file(opts.decode)
+
+    if not opts.device or opts.mrdy is None or opts.srdy is None or not opts.command:
+        parser.error('-D, --mrdy, --srdy and a command are needed')
+
+    spi = SpiDev(opts.device, opts.speed)
+    host = NpiSpiHost(spi, Gpio(opts.mrdy), Gpio(opts.srdy))
+    try:
+        if opts.command == 'send':
+            for arg in opts.args:
+                for payload in host.write(bytes.fromhex(arg)):
+                    print(payload.hex(), flush=True)
+            for payload in host.poll(host.timeout):
+                print(payload.hex(), flush=True)
+        elif opts.command == 'listen':
+            while True:
+                for payload in host.poll(1.0):
+                    print(payload.hex(), flush=True)
+        else:
+            return loopback(host, int(opts.args[0]) if opts.args else 100)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        spi.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())